@@ -0,0 +1,297 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ADDRESSINDEX_H
+#define BITCOIN_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * Database records of the address, spent and timestamp indexes. Keys that
+ * are iterated by range store heights and timestamps big endian so that
+ * LevelDB orders them numerically.
+ */
+
+/** Kind of script an indexed address hash was taken from. */
+enum class AddressType : uint8_t {
+    NONE = 0,
+    PUBKEYHASH = 1, //!< P2PKH, and P2PK outputs indexed under the key id
+    SCRIPTHASH = 2,
+    WITNESS_V0_KEYHASH = 3,
+};
+
+struct CAddressIndexKey
+{
+    AddressType type;
+    uint160 hashBytes;
+    int blockHeight;
+    unsigned int txindex;
+    uint256 txhash;
+    unsigned int index;
+    bool spending;
+
+    CAddressIndexKey() { SetNull(); }
+    CAddressIndexKey(AddressType typeIn, const uint160& hashIn, int height, unsigned int blockindex,
+                     const uint256& txid, unsigned int indexIn, bool isSpending) :
+        type(typeIn), hashBytes(hashIn), blockHeight(height), txindex(blockindex),
+        txhash(txid), index(indexIn), spending(isSpending) {}
+
+    void SetNull()
+    {
+        type = AddressType::NONE;
+        hashBytes.SetNull();
+        blockHeight = 0;
+        txindex = 0;
+        txhash.SetNull();
+        index = 0;
+        spending = false;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, static_cast<uint8_t>(type));
+        hashBytes.Serialize(s);
+        ser_writedata32be(s, blockHeight);
+        ser_writedata32be(s, txindex);
+        txhash.Serialize(s);
+        ser_writedata32(s, index);
+        ser_writedata8(s, spending);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        type = static_cast<AddressType>(ser_readdata8(s));
+        hashBytes.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+        txindex = ser_readdata32be(s);
+        txhash.Unserialize(s);
+        index = ser_readdata32(s);
+        spending = ser_readdata8(s) != 0;
+    }
+};
+
+/** Prefix of CAddressIndexKey used to seek to the first entry of an address. */
+struct CAddressIndexIteratorKey
+{
+    AddressType type;
+    uint160 hashBytes;
+
+    CAddressIndexIteratorKey() : type(AddressType::NONE) {}
+    CAddressIndexIteratorKey(AddressType typeIn, const uint160& hashIn) : type(typeIn), hashBytes(hashIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, static_cast<uint8_t>(type));
+        hashBytes.Serialize(s);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        type = static_cast<AddressType>(ser_readdata8(s));
+        hashBytes.Unserialize(s);
+    }
+};
+
+/** Prefix of CAddressIndexKey used to seek to the first entry of an address at a height. */
+struct CAddressIndexIteratorHeightKey
+{
+    AddressType type;
+    uint160 hashBytes;
+    int blockHeight;
+
+    CAddressIndexIteratorHeightKey() : type(AddressType::NONE), blockHeight(0) {}
+    CAddressIndexIteratorHeightKey(AddressType typeIn, const uint160& hashIn, int height) :
+        type(typeIn), hashBytes(hashIn), blockHeight(height) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, static_cast<uint8_t>(type));
+        hashBytes.Serialize(s);
+        ser_writedata32be(s, blockHeight);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        type = static_cast<AddressType>(ser_readdata8(s));
+        hashBytes.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+    }
+};
+
+struct CAddressUnspentKey
+{
+    AddressType type;
+    uint160 hashBytes;
+    uint256 txhash;
+    unsigned int index;
+
+    CAddressUnspentKey() : type(AddressType::NONE), index(0) {}
+    CAddressUnspentKey(AddressType typeIn, const uint160& hashIn, const uint256& txid, unsigned int indexIn) :
+        type(typeIn), hashBytes(hashIn), txhash(txid), index(indexIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, static_cast<uint8_t>(type));
+        hashBytes.Serialize(s);
+        txhash.Serialize(s);
+        ser_writedata32(s, index);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        type = static_cast<AddressType>(ser_readdata8(s));
+        hashBytes.Unserialize(s);
+        txhash.Unserialize(s);
+        index = ser_readdata32(s);
+    }
+};
+
+struct CAddressUnspentValue
+{
+    CAmount satoshis;
+    CScript script;
+    int blockHeight;
+
+    CAddressUnspentValue() : satoshis(-1), blockHeight(0) {}
+    CAddressUnspentValue(CAmount amount, const CScript& scriptPubKey, int height) :
+        satoshis(amount), script(scriptPubKey), blockHeight(height) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(satoshis);
+        READWRITE(*(CScriptBase*)(&script));
+        READWRITE(blockHeight);
+    }
+};
+
+struct CSpentIndexKey
+{
+    uint256 txid;
+    unsigned int outputIndex;
+
+    CSpentIndexKey() : outputIndex(0) {}
+    CSpentIndexKey(const uint256& hash, unsigned int n) : txid(hash), outputIndex(n) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(outputIndex);
+    }
+};
+
+struct CSpentIndexValue
+{
+    uint256 txid;
+    unsigned int inputIndex;
+    int blockHeight;
+    CAmount satoshis;
+    AddressType addressType;
+    uint160 addressHash;
+
+    CSpentIndexValue() : inputIndex(0), blockHeight(0), satoshis(0), addressType(AddressType::NONE) {}
+    CSpentIndexValue(const uint256& hash, unsigned int n, int height, CAmount amount,
+                     AddressType type, const uint160& addressHashIn) :
+        txid(hash), inputIndex(n), blockHeight(height), satoshis(amount),
+        addressType(type), addressHash(addressHashIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        txid.Serialize(s);
+        ser_writedata32(s, inputIndex);
+        ser_writedata32(s, blockHeight);
+        ser_writedata64(s, satoshis);
+        ser_writedata8(s, static_cast<uint8_t>(addressType));
+        addressHash.Serialize(s);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        txid.Unserialize(s);
+        inputIndex = ser_readdata32(s);
+        blockHeight = ser_readdata32(s);
+        satoshis = ser_readdata64(s);
+        addressType = static_cast<AddressType>(ser_readdata8(s));
+        addressHash.Unserialize(s);
+    }
+};
+
+struct CTimestampIndexKey
+{
+    unsigned int timestamp;
+    uint256 blockHash;
+
+    CTimestampIndexKey() : timestamp(0) {}
+    CTimestampIndexKey(unsigned int time, const uint256& hash) : timestamp(time), blockHash(hash) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata32be(s, timestamp);
+        blockHash.Serialize(s);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        timestamp = ser_readdata32be(s);
+        blockHash.Unserialize(s);
+    }
+};
+
+/** Prefix of CTimestampIndexKey used to seek to the first block at or after a time. */
+struct CTimestampIndexIteratorKey
+{
+    unsigned int timestamp;
+
+    CTimestampIndexIteratorKey() : timestamp(0) {}
+    explicit CTimestampIndexIteratorKey(unsigned int time) : timestamp(time) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata32be(s, timestamp);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        timestamp = ser_readdata32be(s);
+    }
+};
+
+/**
+ * Index updates derived from one block. Unspent updates are kept in block
+ * order because an output may be created and spent in the same block.
+ */
+struct CAddressIndexEntries
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount>> vAddress;
+    /** Unspent outputs to add (true) or remove (false). */
+    std::vector<std::tuple<CAddressUnspentKey, CAddressUnspentValue, bool>> vUnspent;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue>> vSpent;
+    std::vector<CTimestampIndexKey> vTimestamp;
+};
+
+#endif // BITCOIN_ADDRESSINDEX_H
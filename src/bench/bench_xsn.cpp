@@ -4,6 +4,7 @@
 
 #include <bench/bench.h>
 
+#include <chainparams.h>
 #include <crypto/sha256.h>
 #include <key.h>
 #include <validation.h>
@@ -59,6 +60,7 @@ int main(int argc, char** argv)
     RandomInit();
     ECC_Start();
     SetupEnvironment();
+    SelectParams(CBaseChainParams::MAIN);
 
     int64_t evaluations = gArgs.GetArg("-evals", DEFAULT_BENCH_EVALUATIONS);
     std::string regex_filter = gArgs.GetArg("-filter", DEFAULT_BENCH_FILTER);
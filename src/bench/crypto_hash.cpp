@@ -60,6 +60,16 @@ static void SHA512(benchmark::State& state)
         CSHA512().Write(in.data(), in.size()).Finalize(hash);
 }
 
+static void X11_80b(benchmark::State& state)
+{
+    // Block header sized input, the unit X11 is computed over.
+    std::vector<uint8_t> in(80, 0);
+    while (state.KeepRunning()) {
+        uint256 hash = HashX11(in.begin(), in.end());
+        memcpy(in.data(), hash.begin(), hash.size());
+    }
+}
+
 static void SipHash_32b(benchmark::State& state)
 {
     uint256 x;
@@ -93,6 +103,7 @@ BENCHMARK(SHA256, 340);
 BENCHMARK(SHA512, 330);
 
 BENCHMARK(SHA256_32b, 4700 * 1000);
+BENCHMARK(X11_80b, 30 * 1000);
 BENCHMARK(SipHash_32b, 40 * 1000 * 1000);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -0,0 +1,52 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <clientversion.h>
+#include <governance/governance-object.h>
+#include <governance/governance-vote.h>
+#include <governance/governance-votedb.h>
+#include <random.h>
+#include <streams.h>
+
+// Number of masternodes that voted on the benchmarked object.
+static const int GOV_BENCH_VOTERS = 5000;
+
+// Vote tallying over a proposal every masternode has voted on. This is what
+// UpdateSentinelVariables runs for each signal of each object, and what
+// gobject list/getcurrentvotes pay per object. Votes are loaded from the
+// disk format, like governance.dat at startup, because recording them
+// through CGovernanceManager needs a synced masternode list.
+static void GovernanceVoteTally(benchmark::State& state)
+{
+    FastRandomContext rng(true);
+
+    CGovernanceObject::vote_m_t mapVotes;
+    for (int i = 0; i < GOV_BENCH_VOTERS; ++i) {
+        vote_rec_t rec;
+        vote_outcome_enum_t eOutcome = (vote_outcome_enum_t)(VOTE_OUTCOME_YES + rng.randrange(3));
+        rec.mapInstances[VOTE_SIGNAL_FUNDING] = vote_instance_t(eOutcome, 1540000000, 1540000000);
+        if (rng.randbool()) {
+            rec.mapInstances[VOTE_SIGNAL_VALID] = vote_instance_t(VOTE_OUTCOME_YES, 1540000000, 1540000000);
+        }
+        mapVotes[COutPoint(rng.rand256(), 0)] = rec;
+    }
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << uint256() << 1 << (int64_t)1540000000 << rng.rand256() << std::string() << (int)GOVERNANCE_OBJECT_PROPOSAL;
+    ss << CTxIn() << std::vector<unsigned char>();
+    ss << (int64_t)0 << false << mapVotes << CGovernanceObjectVoteFile();
+    CGovernanceObject govobj;
+    ss >> govobj;
+
+    while (state.KeepRunning()) {
+        int nYes = govobj.GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING);
+        int nNo = govobj.GetAbsoluteNoCount(VOTE_SIGNAL_FUNDING);
+        int nValid = govobj.GetAbsoluteYesCount(VOTE_SIGNAL_VALID);
+        assert(nYes == -nNo && nValid > 0);
+    }
+}
+
+BENCHMARK(GovernanceVoteTally, 500);
@@ -0,0 +1,42 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <activemasternode.h>
+#include <instantx.h>
+#include <key.h>
+#include <masternode.h>
+#include <masternodeman.h>
+#include <random.h>
+
+// Signature check of an incoming lock vote, the bulk of the work done by
+// CInstantSend::ProcessTxLockVote for every vote a node receives. The voting
+// masternode is registered in the global list so the lookup of its key is
+// part of the measurement.
+static void TxLockVoteVerify(benchmark::State& state)
+{
+    FastRandomContext rng(true);
+
+    activeMasternode.keyMasternode.MakeNewKey(true);
+    activeMasternode.pubKeyMasternode = activeMasternode.keyMasternode.GetPubKey();
+
+    COutPoint outpointMasternode(rng.rand256(), 0);
+    CMasternode mn(CService(CNetAddr(), 62583), outpointMasternode, activeMasternode.pubKeyMasternode,
+                   activeMasternode.pubKeyMasternode, PROTOCOL_VERSION);
+    mnodeman.Add(mn);
+
+    CTxLockVote vote(rng.rand256(), COutPoint(rng.rand256(), 0), outpointMasternode);
+    bool fSigned = vote.Sign();
+    assert(fSigned);
+
+    while (state.KeepRunning()) {
+        bool fValid = vote.CheckSignature();
+        assert(fValid);
+    }
+
+    mnodeman.Clear();
+}
+
+BENCHMARK(TxLockVoteVerify, 1000);
@@ -0,0 +1,169 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <coins.h>
+#include <fs.h>
+#include <flat-database.h>
+#include <key.h>
+#include <masternode.h>
+#include <masternode-sync.h>
+#include <masternodeman.h>
+#include <net.h>
+#include <random.h>
+#include <script/standard.h>
+#include <util.h>
+#include <validation.h>
+
+#include <vector>
+
+// Size of the simulated masternode list, roughly the size of the mainnet list.
+static const int MN_BENCH_COUNT = 5000;
+
+static void AddMasternodes(CMasternodeMan& man, FastRandomContext& rng, int nCount)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CPubKey pubKey = key.GetPubKey();
+    for (int i = 0; i < nCount; ++i) {
+        CService addr(CNetAddr(), 62583);
+        CMasternode mn(addr, COutPoint(rng.rand256(), 0), pubKey, pubKey, PROTOCOL_VERSION);
+        man.Add(mn);
+    }
+}
+
+/**
+ * What CMasternodeMan needs to rank masternodes and select the next payee:
+ * an active chain long enough for every collateral to be mature, the
+ * collateral coins and a masternode list that counts as synced. The global
+ * mnodeman is filled with MN_BENCH_COUNT masternodes and everything is
+ * reset again on destruction.
+ */
+class MasternodeManagerSetup
+{
+public:
+    std::vector<COutPoint> vOutpoints;
+
+    explicit MasternodeManagerSetup(FastRandomContext& rng) : connman(0x1337, 0x1337)
+    {
+        const int nChainLength = MN_BENCH_COUNT + 200;
+        vBlockHashes.reserve(nChainLength);
+        vBlockIndex.resize(nChainLength);
+        for (int i = 0; i < nChainLength; ++i) {
+            vBlockHashes.push_back(rng.rand256());
+            vBlockIndex[i].phashBlock = &vBlockHashes[i];
+            vBlockIndex[i].nHeight = i;
+            vBlockIndex[i].pprev = i > 0 ? &vBlockIndex[i - 1] : nullptr;
+        }
+        pcoinsTip.reset(new CCoinsViewCache(&viewDummy));
+        {
+            LOCK(cs_main);
+            chainActive.SetTip(&vBlockIndex.back());
+        }
+
+        // Switch to the winners list sync, past the list itself
+        while (!masternodeSync.IsWinnersListSynced()) {
+            masternodeSync.SwitchToNextAsset(connman);
+        }
+
+        CKey key;
+        key.MakeNewKey(true);
+        CPubKey pubKey = key.GetPubKey();
+        for (int i = 0; i < MN_BENCH_COUNT; ++i) {
+            COutPoint outpoint(rng.rand256(), 0);
+            CService addr(CNetAddr(), 62583);
+            CMasternode mn(addr, outpoint, pubKey, pubKey, PROTOCOL_VERSION);
+            // Old enough not to be filtered out as just started
+            mn.sigTime = GetAdjustedTime() - MN_BENCH_COUNT * 3 * 60;
+            mn.nBlockLastPaid = rng.randrange(nChainLength);
+            mnodeman.Add(mn);
+            pcoinsTip->AddCoin(outpoint, Coin(CTxOut(1000 * COIN, GetScriptForDestination(pubKey.GetID())), 1, false, false), false);
+            vOutpoints.push_back(outpoint);
+        }
+    }
+
+    ~MasternodeManagerSetup()
+    {
+        mnodeman.Clear();
+        masternodeSync.Reset();
+        {
+            LOCK(cs_main);
+            chainActive.SetTip(nullptr);
+        }
+        pcoinsTip.reset();
+    }
+
+    int Height() const { return vBlockIndex.back().nHeight; }
+
+private:
+    CConnman connman;
+    CCoinsView viewDummy;
+    std::vector<uint256> vBlockHashes;
+    std::vector<CBlockIndex> vBlockIndex;
+};
+
+// Score and rank every masternode for a block through
+// CMasternodeMan::GetMasternodeRank, as done for every masternode ping,
+// payment vote and InstantSend lock that needs a rank.
+static void MasternodeScores(benchmark::State& state)
+{
+    FastRandomContext rng(true);
+    MasternodeManagerSetup setup(rng);
+    const COutPoint outpointRanked = setup.vOutpoints[MN_BENCH_COUNT / 2];
+
+    int nHeight = 0;
+    while (state.KeepRunning()) {
+        int nRank;
+        nHeight = nHeight % setup.Height() + 1;
+        bool fFound = mnodeman.GetMasternodeRank(outpointRanked, nRank, nHeight);
+        assert(fFound && nRank > 0);
+    }
+}
+
+// Payee selection through CMasternodeMan::GetNextMasternodeInQueueForPayment:
+// order the list by last paid block and pick the best scoring node among the
+// oldest tenth.
+static void MasternodePaymentQueue(benchmark::State& state)
+{
+    FastRandomContext rng(true);
+    MasternodeManagerSetup setup(rng);
+
+    while (state.KeepRunning()) {
+        int nCount;
+        masternode_info_t mnInfo;
+        bool fFound = mnodeman.GetNextMasternodeInQueueForPayment(setup.Height() + 1, true, nCount, mnInfo);
+        assert(fFound && nCount > 0);
+    }
+}
+
+// Write and read back mncache.dat with a full list through CFlatDB, the cost
+// paid on every shutdown and startup.
+static void MasternodeCacheRoundTrip(benchmark::State& state)
+{
+    const fs::path pathTemp = fs::temp_directory_path() / strprintf("bench_xsn_%lu_%i", (unsigned long)GetTime(), (int)GetRand(100000));
+    fs::create_directories(pathTemp);
+    gArgs.ForceSetArg("-datadir", pathTemp.string());
+    ClearDatadirCache();
+
+    FastRandomContext rng(true);
+    CMasternodeMan manSaved;
+    AddMasternodes(manSaved, rng, MN_BENCH_COUNT);
+
+    CFlatDB<CMasternodeMan> flatdb("mncache.dat", "magicMasternodeCache");
+    while (state.KeepRunning()) {
+        CMasternodeMan manLoaded;
+        bool fOk = flatdb.Dump(manSaved) && flatdb.Load(manLoaded);
+        assert(fOk && manLoaded.size() == manSaved.size());
+    }
+
+    fs::remove_all(pathTemp);
+    gArgs.ForceSetArg("-datadir", "");
+    ClearDatadirCache();
+}
+
+BENCHMARK(MasternodeScores, 50);
+BENCHMARK(MasternodePaymentQueue, 200);
+BENCHMARK(MasternodeCacheRoundTrip, 2);
@@ -0,0 +1,61 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <kernel.h>
+#include <primitives/transaction.h>
+#include <random.h>
+
+#include <vector>
+
+// Number of stakeable outputs and timestamps tried per output, matching
+// the default CWallet::nHashDrift used when searching for a kernel.
+static const int STAKE_BENCH_UTXOS = 1000;
+static const unsigned int STAKE_BENCH_HASH_DRIFT = 45;
+
+// Kernel search as done by CWallet::CreateCoinStakeKernel for every
+// stakeable output on every staking round. The target is set so low that
+// no kernel is ever found, which is the common case and makes every output
+// go through all of its drift timestamps.
+static void StakeKernelSearch(benchmark::State& state)
+{
+    const Consensus::Params& consensus = Params().GetConsensus();
+    FastRandomContext rng(true);
+
+    CBlockIndex indexPrev;
+    indexPrev.nHeight = consensus.nPoSUpdgradeHFHeight + 1;
+    indexPrev.hashStakeModifierV3 = rng.rand256();
+
+    const unsigned int nBits = 0x03000001;
+    const unsigned int nTimeTx = 1540000000;
+    const int64_t blockFromTime = nTimeTx - consensus.nStakeMinAge - 60 * 60;
+
+    std::vector<CTransactionRef> vTxPrev;
+    std::vector<uint256> vBlockFrom;
+    for (int i = 0; i < STAKE_BENCH_UTXOS; ++i) {
+        CMutableTransaction tx;
+        tx.nLockTime = i;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = (1 + rng.randrange(10000)) * COIN;
+        vTxPrev.push_back(MakeTransactionRef(std::move(tx)));
+        vBlockFrom.push_back(rng.rand256());
+    }
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < STAKE_BENCH_UTXOS; ++i) {
+            COutPoint prevout(vTxPrev[i]->GetHash(), 0);
+            for (unsigned int j = 0; j < STAKE_BENCH_HASH_DRIFT; ++j) {
+                uint256 hashProofOfStake;
+                bool fFound = CheckStakeKernelHash(&indexPrev, nBits, vBlockFrom[i], blockFromTime, vTxPrev[i], prevout,
+                                                   nTimeTx + STAKE_BENCH_HASH_DRIFT - j, hashProofOfStake, true, false);
+                assert(!fFound);
+            }
+        }
+    }
+}
+
+BENCHMARK(StakeKernelSearch, 5);
@@ -0,0 +1,92 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockcache.h>
+
+#include <core_memusage.h>
+#include <memusage.h>
+
+CBlockCache blockcache(DEFAULT_BLOCK_CACHE_SIZE << 20);
+
+CBlockCache::CBlockCache(size_t nMaxBytesIn) :
+    nBytes(0),
+    nMaxBytes(nMaxBytesIn),
+    nHits(0),
+    nMisses(0)
+{}
+
+void CBlockCache::SetMaxBytes(size_t nMaxBytesIn)
+{
+    LOCK(cs);
+    nMaxBytes = nMaxBytesIn;
+    Trim(nMaxBytes);
+}
+
+std::shared_ptr<const CBlock> CBlockCache::Get(const uint256& hash)
+{
+    LOCK(cs);
+    auto it = mapEntries.find(hash);
+    if (it == mapEntries.end()) {
+        ++nMisses;
+        return nullptr;
+    }
+    ++nHits;
+    listEntries.splice(listEntries.begin(), listEntries, it->second);
+    return it->second->pblock;
+}
+
+void CBlockCache::Insert(const uint256& hash, const std::shared_ptr<const CBlock>& pblock)
+{
+    // Roughly what the entry keeps alive, including the map and list nodes
+    const size_t nEntryBytes = RecursiveDynamicUsage(*pblock) + sizeof(CBlock) + 2 * sizeof(Entry);
+
+    LOCK(cs);
+    if (nEntryBytes > nMaxBytes) return;
+
+    auto it = mapEntries.find(hash);
+    if (it != mapEntries.end()) {
+        listEntries.splice(listEntries.begin(), listEntries, it->second);
+        return;
+    }
+
+    Trim(nMaxBytes - nEntryBytes);
+    listEntries.push_front(Entry{hash, pblock, nEntryBytes});
+    mapEntries.emplace(hash, listEntries.begin());
+    nBytes += nEntryBytes;
+}
+
+void CBlockCache::Erase(const uint256& hash)
+{
+    LOCK(cs);
+    auto it = mapEntries.find(hash);
+    if (it == mapEntries.end()) return;
+    nBytes -= it->second->nBytes;
+    listEntries.erase(it->second);
+    mapEntries.erase(it);
+}
+
+void CBlockCache::Clear()
+{
+    LOCK(cs);
+    listEntries.clear();
+    mapEntries.clear();
+    nBytes = 0;
+}
+
+CBlockCache::Stats CBlockCache::GetStats() const
+{
+    LOCK(cs);
+    return Stats{mapEntries.size(), nBytes, nMaxBytes, nHits, nMisses};
+}
+
+void CBlockCache::Trim(size_t nBytesWanted)
+{
+    AssertLockHeld(cs);
+    while (nBytes > nBytesWanted && !listEntries.empty()) {
+        const Entry& entry = listEntries.back();
+        nBytes -= entry.nBytes;
+        mapEntries.erase(entry.hash);
+        listEntries.pop_back();
+    }
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKCACHE_H
+#define BITCOIN_BLOCKCACHE_H
+
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <stdint.h>
+
+/** Default for -blockcachesize, in MiB */
+static const int64_t DEFAULT_BLOCK_CACHE_SIZE = 32;
+
+/**
+ * Recently connected or read blocks, keyed by block hash.
+ *
+ * Validation, the RPC and REST interfaces and the masternode, payment and
+ * staking code all read the blocks near the tip over and over again. This
+ * keeps the deserialized blocks around, least recently used first out once
+ * their memory usage exceeds the limit. Blocks are immutable and shared, so a
+ * hit costs neither disk access nor deserialization.
+ */
+class CBlockCache
+{
+public:
+    struct Stats
+    {
+        size_t nEntries;
+        size_t nBytes;
+        size_t nMaxBytes;
+        uint64_t nHits;
+        uint64_t nMisses;
+    };
+
+    explicit CBlockCache(size_t nMaxBytesIn);
+
+    /** Change the memory limit, a limit of 0 disables the cache */
+    void SetMaxBytes(size_t nMaxBytesIn);
+
+    /** The cached block with this hash, or null */
+    std::shared_ptr<const CBlock> Get(const uint256& hash);
+    void Insert(const uint256& hash, const std::shared_ptr<const CBlock>& pblock);
+    void Erase(const uint256& hash);
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct Entry
+    {
+        uint256 hash;
+        std::shared_ptr<const CBlock> pblock;
+        size_t nBytes;
+    };
+    typedef std::list<Entry> EntryList;
+
+    mutable CCriticalSection cs;
+    /// Most recently used first
+    EntryList listEntries;
+    std::map<uint256, EntryList::iterator> mapEntries;
+    size_t nBytes;
+    size_t nMaxBytes;
+    uint64_t nHits;
+    uint64_t nMisses;
+
+    void Trim(size_t nBytesWanted);
+};
+
+extern CBlockCache blockcache;
+
+#endif // BITCOIN_BLOCKCACHE_H
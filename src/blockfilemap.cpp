@@ -0,0 +1,191 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockfilemap.h>
+
+#include <consensus/consensus.h>
+#include <crypto/common.h>
+#include <fs.h>
+#include <util.h>
+#include <validation.h>
+
+#include <algorithm>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CBlockFileMap blockfilemap;
+
+CMappedBlockFile::~CMappedBlockFile()
+{
+#ifndef WIN32
+    munmap(const_cast<unsigned char*>(pdata), nSize);
+    close(fd);
+#endif
+}
+
+bool CMappedBlockFile::GetFileSize(size_t& nSizeRet) const
+{
+#ifdef WIN32
+    return false;
+#else
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0) {
+        return false;
+    }
+    nSizeRet = st.st_size;
+    return true;
+#endif
+}
+
+/** Map a whole block file read-only, null if it does not exist or cannot be mapped */
+static std::shared_ptr<const CMappedBlockFile> MapBlockFile(int nFile)
+{
+#ifdef WIN32
+    return nullptr;
+#else
+    const fs::path path = GetBlockPosFilename(CDiskBlockPos(nFile, 0), "blk");
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* pdata = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (pdata == MAP_FAILED) {
+        close(fd);
+        LogPrint(BCLog::BENCH, "%s: unable to map %s\n", __func__, path.string());
+        return nullptr;
+    }
+    return std::make_shared<const CMappedBlockFile>(static_cast<const unsigned char*>(pdata), st.st_size, fd);
+#endif
+}
+
+/** Size of the block at pos, false if the block does not lie within the first nLimit bytes of the mapping */
+static bool GetMappedBlockSize(const CMappedBlockFile& file, size_t nLimit, const CDiskBlockPos& pos, uint32_t& nSizeRet)
+{
+    if (pos.nPos > nLimit) {
+        return false;
+    }
+    nSizeRet = ReadLE32(file.data() + pos.nPos - 4);
+    return nSizeRet <= MAX_BLOCK_SERIALIZED_SIZE && nSizeRet <= nLimit - pos.nPos;
+}
+
+CBlockFileMap::CBlockFileMap() :
+    fEnabled(DEFAULT_MMAP_BLOCKS),
+    nUseCounter(0)
+{}
+
+void CBlockFileMap::SetEnabled(bool fEnabledIn)
+{
+    LOCK(cs);
+    fEnabled = fEnabledIn;
+    if (!fEnabled) {
+        mapFiles.clear();
+    }
+}
+
+bool CBlockFileMap::IsEnabled() const
+{
+    LOCK(cs);
+    return fEnabled;
+}
+
+std::shared_ptr<const CMappedBlockFile> CBlockFileMap::Remap(int nFile)
+{
+    AssertLockHeld(cs);
+    mapFiles.erase(nFile);
+    std::shared_ptr<const CMappedBlockFile> file = MapBlockFile(nFile);
+    if (!file) {
+        return nullptr;
+    }
+
+    if (mapFiles.size() >= MAX_MAPPED_BLOCK_FILES) {
+        auto itOldest = mapFiles.begin();
+        for (auto it = mapFiles.begin(); it != mapFiles.end(); ++it) {
+            if (it->second.nLastUsed < itOldest->second.nLastUsed) itOldest = it;
+        }
+        mapFiles.erase(itOldest);
+    }
+    mapFiles.emplace(nFile, MappedFile{file, nUseCounter});
+    return file;
+}
+
+bool CBlockFileMap::GetBlock(const CDiskBlockPos& pos, BlockData& blockRet)
+{
+    // Blocks are preceded by the network magic and their size
+    if (pos.IsNull() || pos.nPos < 8) {
+        return false;
+    }
+
+    LOCK(cs);
+    if (!fEnabled) {
+        return false;
+    }
+
+    ++nUseCounter;
+    std::shared_ptr<const CMappedBlockFile> file;
+    auto it = mapFiles.find(pos.nFile);
+    if (it != mapFiles.end()) {
+        it->second.nLastUsed = nUseCounter;
+        file = it->second.file;
+    } else {
+        file = Remap(pos.nFile);
+    }
+    if (!file) {
+        return false;
+    }
+
+    // Only the part of the mapping that the file still covers can be read
+    // without risking SIGBUS
+    size_t nFileSize;
+    if (!file->GetFileSize(nFileSize)) {
+        mapFiles.erase(pos.nFile);
+        return false;
+    }
+    if (nFileSize < file->size()) {
+        // Truncated since it was mapped, e.g. when the file was finished
+        file = Remap(pos.nFile);
+        if (!file || !file->GetFileSize(nFileSize)) {
+            return false;
+        }
+    }
+
+    // Blocks appended after the file was mapped are read from the file
+    uint32_t nSize = 0;
+    if (!GetMappedBlockSize(*file, std::min(file->size(), nFileSize), pos, nSize)) {
+        return false;
+    }
+
+    blockRet.file = file;
+    blockRet.data = Span<const unsigned char>(file->data() + pos.nPos, nSize);
+    return true;
+}
+
+void CBlockFileMap::Close(const std::set<int>& setFiles)
+{
+    LOCK(cs);
+    for (int nFile : setFiles) {
+        mapFiles.erase(nFile);
+    }
+}
+
+void CBlockFileMap::Clear()
+{
+    LOCK(cs);
+    mapFiles.clear();
+}
+
+size_t CBlockFileMap::GetMappedFileCount() const
+{
+    LOCK(cs);
+    return mapFiles.size();
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKFILEMAP_H
+#define BITCOIN_BLOCKFILEMAP_H
+
+#include <chain.h>
+#include <span.h>
+#include <sync.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <stdint.h>
+
+/** Default for -mmapblocks, only on 64 bit systems where mapping block files cannot exhaust the address space */
+static const bool DEFAULT_MMAP_BLOCKS = sizeof(void*) >= 8;
+/** Number of block files kept mapped at the same time */
+static const size_t MAX_MAPPED_BLOCK_FILES = 32;
+
+/** Read-only memory mapping of a whole block file, keeping the file open to check its size */
+class CMappedBlockFile
+{
+public:
+    CMappedBlockFile(const unsigned char* pdataIn, size_t nSizeIn, int fdIn) : pdata(pdataIn), nSize(nSizeIn), fd(fdIn) {}
+    ~CMappedBlockFile();
+
+    CMappedBlockFile(const CMappedBlockFile&) = delete;
+    CMappedBlockFile& operator=(const CMappedBlockFile&) = delete;
+
+    const unsigned char* data() const { return pdata; }
+    size_t size() const { return nSize; }
+
+    /** Current size of the file, which may differ from the mapped size */
+    bool GetFileSize(size_t& nSizeRet) const;
+
+private:
+    const unsigned char* const pdata;
+    const size_t nSize;
+    const int fd;
+};
+
+/**
+ * Gives access to serialized blocks in the blk?????.dat files through
+ * read-only memory mappings.
+ *
+ * Reading a block or a single transaction from a mapping needs no file to
+ * be opened and no seek or read calls, and the data is deserialized straight
+ * from the page cache. Mappings are shared by all readers and unmapped once
+ * the least recently used file has to make room, the file is finished or it
+ * is pruned. Where mapping is not available (Windows, 32 bit,
+ * -mmapblocks=0) callers read the file as before.
+ *
+ * Touching a mapped page that the file no longer covers, or one the disk
+ * fails to read, raises SIGBUS instead of failing a read. The file size is
+ * therefore checked before every read, blocks appended after the file was
+ * mapped are left to the regular file reads, and a file is remapped once it
+ * was truncated. An I/O error while reading a mapped page still terminates
+ * the process, which is why mapping can be turned off with -mmapblocks=0.
+ */
+class CBlockFileMap
+{
+public:
+    /** A serialized block inside a mapped file, which stays mapped while this is held */
+    struct BlockData
+    {
+        std::shared_ptr<const CMappedBlockFile> file;
+        Span<const unsigned char> data;
+    };
+
+    CBlockFileMap();
+
+    void SetEnabled(bool fEnabledIn);
+    bool IsEnabled() const;
+
+    /** Serialized block stored at pos, bounded by the size written in front of it.
+     * False if the block does not lie within both the mapping and the file. */
+    bool GetBlock(const CDiskBlockPos& pos, BlockData& blockRet);
+
+    /** Unmap the given files, e.g. before they are removed */
+    void Close(const std::set<int>& setFiles);
+    void Clear();
+
+    size_t GetMappedFileCount() const;
+
+private:
+    struct MappedFile
+    {
+        std::shared_ptr<const CMappedBlockFile> file;
+        uint64_t nLastUsed;
+    };
+
+    mutable CCriticalSection cs;
+    bool fEnabled;
+    std::map<int, MappedFile> mapFiles;
+    uint64_t nUseCounter;
+
+    /** Map the file again, e.g. because it was truncated, evicting another file if needed */
+    std::shared_ptr<const CMappedBlockFile> Remap(int nFile);
+};
+
+extern CBlockFileMap blockfilemap;
+
+#endif // BITCOIN_BLOCKFILEMAP_H
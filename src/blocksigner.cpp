@@ -112,8 +112,29 @@ bool CBlockSigner::CheckBlockSignature() const
 
     std::string strError;
     if (IsTPoSNewSignaturesHardForkActivated(nChainHeight)) {
+        if (!refBlock.IsTPoSBlock() && refBlock.nSigCheckMessage >= 0) {
+            return refBlock.nSigCheckMessage;
+        }
         return CMessageSigner::VerifyMessage(destination, refBlock.vchBlockSig, std::string(hashMessage.begin(), hashMessage.end()), strError);
     } else {
+        if (!refBlock.IsTPoSBlock() && refBlock.nSigCheckLegacy >= 0) {
+            return refBlock.nSigCheckLegacy;
+        }
         return CHashSigner::VerifyHash(hashMessage, destination, refBlock.vchBlockSig, strError);
     }
 }
+
+void CBlockSigner::PrecheckBlockSignature(const CBlock &block)
+{
+    if (!block.IsProofOfStake() || block.IsTPoSBlock() || block.vchBlockSig.empty())
+        return;
+
+    CTxDestination destination;
+    if (!ExtractDestination(block.vtx[1]->vout[1].scriptPubKey, destination))
+        return;
+
+    const uint256 hashMessage = block.GetHash();
+    std::string strError;
+    block.nSigCheckMessage = CMessageSigner::VerifyMessage(destination, block.vchBlockSig, std::string(hashMessage.begin(), hashMessage.end()), strError);
+    block.nSigCheckLegacy = CHashSigner::VerifyHash(hashMessage, destination, block.vchBlockSig, strError);
+}
@@ -14,6 +14,13 @@ struct CBlockSigner {
     bool SignBlock();
     bool CheckBlockSignature() const;
 
+    /// Verify the signature of a PoS block that does not depend on a TPoS
+    /// contract under both signature schemes and cache the outcome in the
+    /// block, so CheckBlockSignature only has to pick the one for its height.
+    /// Used by the reindex pipeline, which sees blocks before their height is
+    /// known.
+    static void PrecheckBlockSignature(const CBlock &block);
+
     CBlock &refBlock;
     const CKeyStore *refKeystore;
     const TPoSContract &refContract;
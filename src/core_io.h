@@ -12,6 +12,7 @@
 
 class CBlock;
 class CScript;
+class JSONStreamWriter;
 class CTransaction;
 struct CMutableTransaction;
 class uint256;
@@ -32,5 +33,8 @@ std::string FormatScript(const CScript& script);
 std::string EncodeHexTx(const CTransaction& tx, const int serializeFlags = 0);
 void ScriptPubKeyToUniv(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
 void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex = true, int serialize_flags = 0);
+/** Streaming counterparts of the above: write the same keys into the object currently open in writer */
+void ScriptPubKeyToStream(const CScript& scriptPubKey, JSONStreamWriter& writer, bool fIncludeHex);
+void TxToStream(const CTransaction& tx, const uint256& hashBlock, JSONStreamWriter& writer, bool include_hex = true, int serialize_flags = 0);
 
 #endif // BITCOIN_CORE_IO_H
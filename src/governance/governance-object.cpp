@@ -13,6 +13,7 @@
 #include <messagesigner.h>
 #include <util.h>
 #include <txdb.h>
+#include <validationinterface.h>
 
 #include <univalue.h>
 
@@ -195,6 +196,7 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         fileVotes.AddVote(vote);
     }
     fDirtyCache = true;
+    GetMainSignals().NotifyGovernanceVote(vote);
     return true;
 }
 
@@ -13,6 +13,7 @@
 #include <messagesigner.h>
 #include <netfulfilledman.h>
 #include <util.h>
+#include <validationinterface.h>
 #include <netmessagemaker.h>
 
 CGovernanceManager governance;
@@ -154,7 +155,7 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
 
         uint256 nHash = govobj.GetHash();
 
-        pfrom->setAskFor.erase(nHash);
+        pfrom->RemoveAskFor(nHash);
 
         if(!masternodeSync.IsMasternodeListSynced()) {
             LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECT -- masternode list not synced\n");
@@ -238,7 +239,7 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
 
         uint256 nHash = vote.GetHash();
 
-        pfrom->setAskFor.erase(nHash);
+        pfrom->RemoveAskFor(nHash);
 
         // Ignore such messages until masternode list is synced
         if(!masternodeSync.IsMasternodeListSynced()) {
@@ -374,6 +375,7 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
 
     LogPrintf("AddGovernanceObject -- %s new, received form %s\n", strHash, pfrom ? pfrom->GetAddrName() : "NULL");
     govobj.Relay(connman);
+    GetMainSignals().NotifyGovernanceObject(govobj);
 
     // Update the rate buffer
     MasternodeRateUpdate(govobj);
@@ -1217,7 +1219,11 @@ int CGovernanceManager::RequestGovernanceObjectVotes(const std::vector<CNode*>&
             // only use up to date peers
             if(pnode->nVersion < MIN_GOVERNANCE_PEER_PROTO_VERSION) continue;
             // stop early to prevent setAskFor overflow
-            size_t nProjectedSize = pnode->setAskFor.size() + nProjectedVotes;
+            size_t nProjectedSize;
+            {
+                LOCK(pnode->cs_askfor);
+                nProjectedSize = pnode->setAskFor.size() + nProjectedVotes;
+            }
             if(nProjectedSize > SETASKFOR_MAX_SZ/2) continue;
             // to early to ask the same node
             if(mapAskedRecently[nHashGovobj].count(pnode->addr)) continue;
@@ -6,6 +6,7 @@
 
 #include <chainparams.h>
 #include <httpserver.h>
+#include <jsonwriter.h>
 #include <key_io.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
@@ -144,6 +145,57 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+/** Reply to a singleton request through the streaming variant of its method,
+ * see CRPCTable::executeStream. The reply is sent in chunks as the result is
+ * written, unless it is small enough to go out in one piece. Returns false,
+ * with nothing sent, if the call has to go through the regular path.
+ */
+static bool StreamJSONRPCReply(HTTPRequest* req, const JSONRPCRequest& jreq)
+{
+    bool fStarted = false;
+    JSONStreamWriter writer([req, &fStarted](const std::string& strChunk) {
+        // The reply is only started by the first flush, so that errors thrown
+        // before that can still be sent as a regular error reply
+        if (!fStarted) {
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReplyStart(HTTP_OK);
+            fStarted = true;
+        }
+        req->WriteReplyChunk(strChunk);
+    });
+
+    // Same layout as JSONRPCReply
+    writer.BeginObject();
+    writer.Key("result");
+    try {
+        if (!tableRPC.executeStream(jreq, writer))
+            return false;
+    } catch (...) {
+        if (!writer.HasFlushed())
+            throw;
+        // Part of the result is already on its way, all that can be done is
+        // cutting the reply short
+        LogPrintf("%s: %s failed after streaming had started\n", __func__, jreq.strMethod);
+        req->WriteReplyEnd();
+        return true;
+    }
+    writer.Key("error");
+    writer.Null();
+    writer.Key("id");
+    writer.Value(jreq.id);
+    writer.EndObject();
+    writer.Raw("\n");
+
+    if (writer.HasFlushed()) {
+        writer.Flush();
+        req->WriteReplyEnd();
+    } else {
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, writer.GetBuffer());
+    }
+    return true;
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -188,6 +240,9 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
+            if (StreamJSONRPCReply(req, jreq))
+                return true;
+
             UniValue result = tableRPC.execute(jreq);
 
             // Send reply
@@ -211,6 +266,87 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
     return true;
 }
 
+/** Read-only RPCs that can keep a worker busy for a long time. They get
+ * their own work queue so they cannot starve cheap calls like getblockcount.
+ */
+static const char* const HEAVY_RPC_METHODS[] = {
+    "masternodelist",
+    "merchantnodelist",
+    "masternode",
+    "merchantnode",
+    "gobject",
+    "getgovernanceinfo",
+    "getblock",
+    "getblockheader",
+    "getchaintips",
+    "getchaintxstats",
+    "getrawmempool",
+    "getrawtransaction",
+    "gettxoutsetinfo",
+    "gettxoutproof",
+    "verifytxoutproof",
+    "verifychain",
+    "scantxoutset",
+    "decoderawtransaction",
+};
+
+/** Body size above which a request is treated as heavy without parsing it */
+static const size_t MAX_CLASSIFY_BODY_SIZE = 64 * 1024;
+
+static HTTPWorkClass RPCMethodWorkClass(const std::string& strMethod)
+{
+    const CRPCCommand* pcmd = tableRPC[strMethod];
+    if (pcmd && pcmd->category == "wallet")
+        return HTTPWorkClass::WALLET;
+    for (const char* pszHeavy : HEAVY_RPC_METHODS) {
+        if (strMethod == pszHeavy)
+            return HTTPWorkClass::HEAVY;
+    }
+    return HTTPWorkClass::CHEAP;
+}
+
+static HTTPWorkClass RPCRequestWorkClass(const UniValue& valRequest)
+{
+    if (!valRequest.isObject())
+        return HTTPWorkClass::CHEAP;
+    const UniValue& valMethod = find_value(valRequest, "method");
+    if (!valMethod.isStr())
+        return HTTPWorkClass::CHEAP;
+    return RPCMethodWorkClass(valMethod.get_str());
+}
+
+/** Pick the work queue for a JSON-RPC request. Batches go to the queue of
+ * their most expensive member. Malformed and unauthenticated requests are
+ * cheap to reject, the body is only parsed once the credentials check out so
+ * anonymous clients cannot keep the event thread busy parsing JSON.
+ */
+static HTTPWorkClass HTTPReq_JSONRPCClassify(HTTPRequest* req, const std::string &)
+{
+    if (req->GetRequestMethod() != HTTPRequest::POST)
+        return HTTPWorkClass::CHEAP;
+    std::pair<bool, std::string> authHeader = req->GetHeader("authorization");
+    std::string strAuthUser;
+    if (!authHeader.first || !RPCAuthorized(authHeader.second, strAuthUser))
+        return HTTPWorkClass::CHEAP;
+    std::string strBody = req->PeekBody(MAX_CLASSIFY_BODY_SIZE + 1);
+    if (strBody.size() > MAX_CLASSIFY_BODY_SIZE)
+        return HTTPWorkClass::HEAVY;
+    UniValue valRequest;
+    if (!valRequest.read(strBody))
+        return HTTPWorkClass::CHEAP;
+    if (!valRequest.isArray())
+        return RPCRequestWorkClass(valRequest);
+    HTTPWorkClass workClass = HTTPWorkClass::CHEAP;
+    for (size_t i = 0; i < valRequest.size(); i++) {
+        HTTPWorkClass requestClass = RPCRequestWorkClass(valRequest[i]);
+        if (requestClass == HTTPWorkClass::WALLET)
+            return requestClass;
+        if (requestClass == HTTPWorkClass::HEAVY)
+            workClass = requestClass;
+    }
+    return workClass;
+}
+
 static bool InitRPCAuthentication()
 {
     if (gArgs.GetArg("-rpcpassword", "") == "")
@@ -235,10 +371,10 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, HTTPReq_JSONRPCClassify);
 #ifdef ENABLE_WALLET
     // ifdef can be removed once we switch to better endpoint support and API versioning
-    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC, HTTPReq_JSONRPCClassify);
 #endif
     assert(EventBase());
     httpRPCTimerInterface = MakeUnique<HTTPRPCTimerInterface>(EventBase());
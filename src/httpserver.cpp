@@ -6,6 +6,7 @@
 
 #include <chainparamsbase.h>
 #include <compat.h>
+#include <mpmcqueue.h>
 #include <util.h>
 #include <utilstrencodings.h>
 #include <netbase.h>
@@ -13,8 +14,12 @@
 #include <sync.h>
 #include <ui_interface.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <thread>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -62,56 +67,136 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
+/** Work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
+ *
+ * Items travel through a lock-free MPMCQueue, so producers (the libevent
+ * thread) never contend with busy workers. The mutex and condition variable
+ * are only used to park workers when the queue runs dry.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
-    /** Mutex protects entire object */
+    struct Entry
+    {
+        WorkItem* item;
+        int64_t nTimeQueued;
+    };
+
+    MPMCQueue<Entry> queue;
+    /** Number of queued items, enforces maxDepth independent of the ring capacity */
+    std::atomic<size_t> depth;
+    size_t maxDepth;
+    std::atomic<bool> running;
+
+    /** Parking lot for idle workers */
     std::mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
-    bool running;
-    size_t maxDepth;
+    std::atomic<int> nIdle;
+
+    std::atomic<uint64_t> nProcessed;
+    std::atomic<uint64_t> nRejected;
+    std::atomic<int64_t> nTotalWaitMicros;
+    std::atomic<int64_t> nMaxWaitMicros;
+    std::atomic<int64_t> nTotalRunMicros;
+    std::atomic<int64_t> nMaxRunMicros;
+
+    static void UpdateMax(std::atomic<int64_t>& max, int64_t value)
+    {
+        int64_t cur = max.load(std::memory_order_relaxed);
+        while (value > cur && !max.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+    }
+
+    /** Block until an item is available. Returns false when interrupted. */
+    bool Pop(Entry& entry)
+    {
+        if (!running)
+            return false;
+        if (queue.TryPop(entry))
+            return true;
+        std::unique_lock<std::mutex> lock(cs);
+        ++nIdle;
+        // Pairs with the fence in Enqueue: either the producer sees us idle
+        // and notifies, or we see its item here.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool fGot = false;
+        while (running) {
+            if (queue.TryPop(entry)) {
+                fGot = true;
+                break;
+            }
+            cond.wait(lock);
+        }
+        --nIdle;
+        if (fGot && !running) {
+            depth--;
+            delete entry.item;
+            fGot = false;
+        }
+        return fGot;
+    }
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : running(true),
-                                 maxDepth(_maxDepth)
+    explicit WorkQueue(size_t _maxDepth) : queue(_maxDepth),
+                                 depth(0),
+                                 maxDepth(_maxDepth),
+                                 running(true),
+                                 nIdle(0),
+                                 nProcessed(0),
+                                 nRejected(0),
+                                 nTotalWaitMicros(0),
+                                 nMaxWaitMicros(0),
+                                 nTotalRunMicros(0),
+                                 nMaxRunMicros(0)
     {
     }
     /** Precondition: worker threads have all stopped (they have been joined).
      */
     ~WorkQueue()
     {
+        Entry entry;
+        while (queue.TryPop(entry))
+            delete entry.item;
     }
     /** Enqueue a work item */
     bool Enqueue(WorkItem* item)
     {
-        std::unique_lock<std::mutex> lock(cs);
-        if (queue.size() >= maxDepth) {
+        if (depth.fetch_add(1) >= maxDepth) {
+            depth--;
+            nRejected++;
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
+        // The ring is at least maxDepth large, so it can only be full for
+        // the instant between a consumer claiming a slot and releasing it.
+        Entry entry{item, GetTimeMicros()};
+        while (!queue.TryPush(entry))
+            std::this_thread::yield();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (nIdle.load() > 0) {
+            std::lock_guard<std::mutex> lock(cs);
+            cond.notify_one();
+        }
         return true;
     }
     /** Thread function */
     void Run()
     {
-        while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
-                std::unique_lock<std::mutex> lock(cs);
-                while (running && queue.empty())
-                    cond.wait(lock);
-                if (!running)
-                    break;
-                i = std::move(queue.front());
-                queue.pop_front();
-            }
+        Entry entry;
+        while (Pop(entry)) {
+            depth--;
+            std::unique_ptr<WorkItem> i(entry.item);
+            int64_t nStart = GetTimeMicros();
+            int64_t nWait = nStart - entry.nTimeQueued;
+            nTotalWaitMicros += nWait;
+            UpdateMax(nMaxWaitMicros, nWait);
+
             (*i)();
+
+            int64_t nRun = GetTimeMicros() - nStart;
+            nTotalRunMicros += nRun;
+            UpdateMax(nMaxRunMicros, nRun);
+            nProcessed++;
         }
     }
     /** Interrupt and exit loops */
@@ -121,18 +206,31 @@ public:
         running = false;
         cond.notify_all();
     }
+    /** Fill in queue statistics */
+    void GetStats(HTTPWorkQueueStats& stats) const
+    {
+        stats.nDepth = depth.load();
+        stats.nMaxDepth = maxDepth;
+        stats.nProcessed = nProcessed.load();
+        stats.nRejected = nRejected.load();
+        stats.nAvgWaitMicros = stats.nProcessed ? nTotalWaitMicros.load() / (int64_t)stats.nProcessed : 0;
+        stats.nMaxWaitMicros = nMaxWaitMicros.load();
+        stats.nAvgRunMicros = stats.nProcessed ? nTotalRunMicros.load() / (int64_t)stats.nProcessed : 0;
+        stats.nMaxRunMicros = nMaxRunMicros.load();
+    }
 };
 
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
 };
 
 /** HTTP module state */
@@ -143,8 +241,10 @@ static struct event_base* eventBase = nullptr;
 struct evhttp* eventHTTP = nullptr;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure>* workQueue = nullptr;
+//! Work queues for handling longer requests off the event loop thread, one per HTTPWorkClass
+static WorkQueue<HTTPClosure>* workQueues[HTTP_WORK_CLASS_COUNT] = {};
+//! Number of worker threads serving each work queue
+static int workQueueThreads[HTTP_WORK_CLASS_COUNT] = {};
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
@@ -257,14 +357,16 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
         }
     }
 
-    // Dispatch to worker thread
+    // Dispatch to worker thread of the request's cost class
     if (i != iend) {
+        HTTPWorkClass workClass = i->classifier ? i->classifier(hreq.get(), path) : HTTPWorkClass::CHEAP;
+        WorkQueue<HTTPClosure>* workQueue = workQueues[(int)workClass];
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(workQueue);
         if (workQueue->Enqueue(item.get()))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: request rejected because http %s work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n", HTTPWorkClassName(workClass));
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -399,7 +501,9 @@ bool InitHTTPServer()
     int workQueueDepth = std::max((long)gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
     LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    for (int i = 0; i < HTTP_WORK_CLASS_COUNT; i++) {
+        workQueues[i] = new WorkQueue<HTTPClosure>(workQueueDepth);
+    }
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -427,14 +531,18 @@ static std::vector<std::thread> g_thread_http_workers;
 bool StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
+    workQueueThreads[(int)HTTPWorkClass::CHEAP] = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    workQueueThreads[(int)HTTPWorkClass::HEAVY] = std::max((long)gArgs.GetArg("-rpcheavythreads", DEFAULT_HTTP_HEAVY_THREADS), 1L);
+    workQueueThreads[(int)HTTPWorkClass::WALLET] = std::max((long)gArgs.GetArg("-rpcwalletthreads", DEFAULT_HTTP_WALLET_THREADS), 1L);
+    LogPrintf("HTTP: starting %d/%d/%d cheap/heavy/wallet worker threads\n", workQueueThreads[0], workQueueThreads[1], workQueueThreads[2]);
     std::packaged_task<bool(event_base*, evhttp*)> task(ThreadHTTP);
     threadResult = task.get_future();
     threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue);
+    for (int i = 0; i < HTTP_WORK_CLASS_COUNT; i++) {
+        for (int j = 0; j < workQueueThreads[i]; j++) {
+            g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueues[i]);
+        }
     }
     return true;
 }
@@ -450,21 +558,25 @@ void InterruptHTTPServer()
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
     }
-    if (workQueue)
-        workQueue->Interrupt();
+    for (WorkQueue<HTTPClosure>* workQueue : workQueues) {
+        if (workQueue)
+            workQueue->Interrupt();
+    }
 }
 
 void StopHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
-    if (workQueue) {
+    if (workQueues[0]) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
         for (auto& thread: g_thread_http_workers) {
             thread.join();
         }
         g_thread_http_workers.clear();
-        delete workQueue;
-        workQueue = nullptr;
+        for (WorkQueue<HTTPClosure>*& workQueue : workQueues) {
+            delete workQueue;
+            workQueue = nullptr;
+        }
     }
     if (eventBase) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
@@ -525,12 +637,18 @@ void HTTPEvent::trigger(struct timeval* tv)
         evtimer_add(ev, tv); // trigger after timeval passed
 }
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       replyStarted(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (replyStarted && !replySent) {
+        // Handler bailed out in the middle of a chunked reply: terminate it so
+        // that evhttp releases the request.
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        WriteReplyEnd();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -569,6 +687,20 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t nMaxSize)
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    size_t size = std::min(evbuffer_get_length(buf), nMaxSize);
+    std::string rv(size, '\0');
+    ev_ssize_t copied = evbuffer_copyout(buf, &rv[0], size);
+    if (copied < 0)
+        return "";
+    rv.resize(copied);
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -608,6 +740,119 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+/** Flow control state of a chunked reply, shared between the worker
+ * producing the chunks and the http thread sending them.
+ */
+struct HTTPReplyFlow
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t nQueued; //!< bytes handed to the http thread but not yet to evhttp
+    size_t nSent; //!< bytes handed to evhttp that may still be in its output buffer
+    bool fAborted;
+    int64_t nTimeout;
+
+    explicit HTTPReplyFlow(int64_t nTimeoutIn) : nQueued(0), nSent(0), fAborted(false), nTimeout(nTimeoutIn) {}
+};
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+/** Called by evhttp once the output buffer of the connection has drained */
+static void HTTPReplyChunkWritten(struct evhttp_connection* conn, void* arg)
+{
+    HTTPReplyFlow* flow = static_cast<HTTPReplyFlow*>(arg);
+    std::lock_guard<std::mutex> lock(flow->mutex);
+    flow->nSent = 0;
+    flow->cond.notify_all();
+}
+#endif
+
+void HTTPRequest::WriteReplyStart(int nStatus)
+{
+    assert(!replySent && !replyStarted && req);
+    replyFlow = std::make_shared<HTTPReplyFlow>(std::max<int64_t>(gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT), 1));
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+    replyStarted = true;
+}
+
+void HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(replyStarted && !replySent && req);
+    if (strChunk.empty())
+        return;
+    {
+        // Wait for the client to catch up instead of queueing the whole
+        // reply in memory.
+        std::unique_lock<std::mutex> lock(replyFlow->mutex);
+        if (replyFlow->fAborted)
+            return;
+        auto predicate = [this] { return replyFlow->nQueued + replyFlow->nSent < MAX_HTTP_REPLY_BUFFER; };
+        if (!replyFlow->cond.wait_for(lock, std::chrono::seconds(replyFlow->nTimeout), predicate)) {
+            LogPrint(BCLog::HTTP, "Client stalled, dropping rest of chunked reply to %s\n", GetPeer().ToString());
+            replyFlow->fAborted = true;
+            return;
+        }
+        replyFlow->nQueued += strChunk.size();
+    }
+    // The output buffer of the request belongs to the http thread once the
+    // reply has started, so hand over a private copy of the data.
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, strChunk.data(), strChunk.size());
+    auto req_copy = req;
+    auto flow = replyFlow;
+    size_t nSize = strChunk.size();
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, evb, flow, nSize]{
+        {
+            std::lock_guard<std::mutex> lock(flow->mutex);
+            flow->nQueued -= nSize;
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+            flow->nSent += nSize;
+#else
+            flow->cond.notify_all();
+#endif
+        }
+        // A no-op when the client has gone away in the meantime
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+        evhttp_send_reply_chunk_with_cb(req_copy, evb, HTTPReplyChunkWritten, flow.get());
+#else
+        evhttp_send_reply_chunk(req_copy, evb);
+#endif
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WriteReplyEnd()
+{
+    assert(replyStarted && !replySent && req);
+    auto req_copy = req;
+    // The flow state must outlive the last chunk callback, which ending the
+    // reply replaces.
+    auto flow = replyFlow;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, flow]{
+        // See the libevent workaround in WriteReply. This has to happen
+        // first, as ending the reply can free both request and connection.
+        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+            if (conn) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+        // Frees the request if the connection was closed before the end
+        evhttp_send_reply_end(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -648,10 +893,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -668,6 +913,31 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
     }
 }
 
+std::string HTTPWorkClassName(HTTPWorkClass workClass)
+{
+    switch (workClass) {
+    case HTTPWorkClass::CHEAP: return "cheap";
+    case HTTPWorkClass::HEAVY: return "heavy";
+    case HTTPWorkClass::WALLET: return "wallet";
+    }
+    assert(false);
+}
+
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats()
+{
+    std::vector<HTTPWorkQueueStats> vStats;
+    for (int i = 0; i < HTTP_WORK_CLASS_COUNT; i++) {
+        if (!workQueues[i])
+            continue;
+        HTTPWorkQueueStats stats;
+        stats.workClass = (HTTPWorkClass)i;
+        stats.nThreads = workQueueThreads[i];
+        workQueues[i]->GetStats(stats);
+        vStats.push_back(stats);
+    }
+    return vStats;
+}
+
 std::string urlDecode(const std::string &urlEncoded) {
     std::string res;
     if (!urlEncoded.empty()) {
@@ -8,15 +8,22 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
+static const int DEFAULT_HTTP_HEAVY_THREADS=2;
+static const int DEFAULT_HTTP_WALLET_THREADS=2;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+/** Maximum number of bytes of a chunked reply that may be waiting to be sent */
+static const size_t MAX_HTTP_REPLY_BUFFER = 1024 * 1024;
 
 struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPReplyFlow;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -36,13 +43,48 @@ void StopHTTPServer();
  * libevent doesn't support debug logging.*/
 bool UpdateHTTPServerLogging(bool enable);
 
+/** Cost class of a request. Every class has its own work queue and worker
+ * threads, so a slow request can only hold up requests of the same class.
+ */
+enum class HTTPWorkClass {
+    CHEAP,  //!< quick reads, e.g. getblockcount (-rpcthreads workers)
+    HEAVY,  //!< expensive reads, e.g. masternodelist full (-rpcheavythreads workers)
+    WALLET, //!< wallet calls (-rpcwalletthreads workers)
+};
+static const int HTTP_WORK_CLASS_COUNT = 3;
+
+std::string HTTPWorkClassName(HTTPWorkClass workClass);
+
+/** Snapshot of a work queue's counters */
+struct HTTPWorkQueueStats
+{
+    HTTPWorkClass workClass;
+    int nThreads;
+    size_t nDepth;
+    size_t nMaxDepth;
+    uint64_t nProcessed;
+    uint64_t nRejected;
+    int64_t nAvgWaitMicros;
+    int64_t nMaxWaitMicros;
+    int64_t nAvgRunMicros;
+    int64_t nMaxRunMicros;
+};
+
+/** Return statistics for all work queues, empty if the HTTP server is not running */
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Picks the work class for a request. Runs on the libevent thread, so it
+ * must be cheap and must not consume the request body.
+ */
+typedef std::function<HTTPWorkClass(HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests are dispatched to the CHEAP work queue unless a
+ * classifier is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -59,6 +101,8 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyStarted;
+    std::shared_ptr<HTTPReplyFlow> replyFlow;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req);
@@ -98,6 +142,11 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Copy up to nMaxSize bytes of the request body without consuming it.
+     */
+    std::string PeekBody(size_t nMaxSize);
+
     /**
      * Write output header.
      *
@@ -114,6 +163,34 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply with status nStatus. Headers must be written
+     * before calling this. The body is then sent with WriteReplyChunk and the
+     * reply completed with WriteReplyEnd.
+     *
+     * @note Use this instead of WriteReply for large bodies that are produced
+     * incrementally, so they never have to be held in memory as a whole.
+     */
+    void WriteReplyStart(int nStatus);
+
+    /**
+     * Send a chunk of a reply started with WriteReplyStart. Empty chunks are
+     * ignored, as an empty chunk would terminate the reply.
+     *
+     * @note Blocks while more than MAX_HTTP_REPLY_BUFFER bytes are waiting to
+     * be written to the client. If the client does not read anything for
+     * -rpcservertimeout seconds, the rest of the reply is dropped.
+     */
+    void WriteReplyChunk(const std::string& strChunk);
+
+    /**
+     * Complete a reply started with WriteReplyStart.
+     *
+     * @note As with WriteReply, do not call any other HTTPRequest methods
+     * after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Event handler closure.
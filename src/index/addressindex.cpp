@@ -0,0 +1,417 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/addressindex.h>
+#include <init.h>
+#include <pubkey.h>
+#include <script/standard.h>
+#include <tinyformat.h>
+#include <ui_interface.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+#include <warnings.h>
+
+constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
+constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+template<typename... Args>
+static void FatalError(const char* fmt, const Args&... args)
+{
+    std::string strMessage = tfm::format(fmt, args...);
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        "Error: A fatal internal error occurred, see debug.log for details",
+        "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+}
+
+AddressIndex::AddressIndex(std::unique_ptr<AddressIndexDB> db, uint32_t flags) :
+    m_db(std::move(db)), m_flags(flags), m_synced(false), m_best_block_index(nullptr)
+{}
+
+AddressIndex::~AddressIndex()
+{
+    Interrupt();
+    Stop();
+}
+
+bool AddressIndex::GetAddressKey(const CScript& script, AddressType& type, uint160& hash)
+{
+    CTxDestination dest;
+    if (!ExtractDestination(script, dest)) {
+        return false;
+    }
+
+    // P2PK outputs, as used by coinstakes, resolve to the key id so staking
+    // rewards show up under the owner's regular address.
+    if (const CKeyID* id = boost::get<CKeyID>(&dest)) {
+        type = AddressType::PUBKEYHASH;
+        hash = *id;
+    } else if (const CScriptID* id = boost::get<CScriptID>(&dest)) {
+        type = AddressType::SCRIPTHASH;
+        hash = *id;
+    } else if (const WitnessV0KeyHash* id = boost::get<WitnessV0KeyHash>(&dest)) {
+        type = AddressType::WITNESS_V0_KEYHASH;
+        hash = *id;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool AddressIndex::Init()
+{
+    LOCK(cs_main);
+
+    CBlockLocator locator;
+    if (!m_db->ReadBestBlock(locator) || locator.IsNull()) {
+        m_best_block_index = nullptr;
+    } else {
+        // Start from the exact block the index was written up to, even if it
+        // has since left the active chain, so ThreadSync can revert it.
+        const CBlockIndex* pindex = LookupBlockIndex(locator.vHave.front());
+        if (!pindex) {
+            pindex = FindForkInGlobalIndex(chainActive, locator);
+        }
+        m_best_block_index = pindex;
+    }
+    m_synced = m_best_block_index.load() == chainActive.Tip();
+
+    if (!m_db->WriteIndexFlags(m_flags)) {
+        return error("%s: Failed to write index flags", __func__);
+    }
+    return true;
+}
+
+void AddressIndex::ThreadSync()
+{
+    const CBlockIndex* pindex = m_best_block_index.load();
+    if (!m_synced) {
+        auto& consensus_params = Params().GetConsensus();
+
+        int64_t last_log_time = 0;
+        int64_t last_locator_write_time = 0;
+        while (true) {
+            if (m_interrupt) {
+                WriteBestBlock(pindex);
+                return;
+            }
+
+            const CBlockIndex* pindex_block;
+            bool fConnect;
+            {
+                LOCK(cs_main);
+                if (pindex && !chainActive.Contains(pindex)) {
+                    pindex_block = pindex;
+                    fConnect = false;
+                } else {
+                    pindex_block = pindex ? chainActive.Next(pindex) : chainActive.Genesis();
+                    fConnect = true;
+                    if (!pindex_block) {
+                        WriteBestBlock(pindex);
+                        m_best_block_index = pindex;
+                        m_synced = true;
+                        break;
+                    }
+                }
+            }
+
+            int64_t current_time = GetTime();
+            if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
+                LogPrintf("Syncing addressindex with block chain from height %d\n", pindex_block->nHeight);
+                last_log_time = current_time;
+            }
+
+            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
+                WriteBestBlock(pindex);
+                last_locator_write_time = current_time;
+            }
+
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindex_block, consensus_params)) {
+                FatalError("%s: Failed to read block %s from disk",
+                           __func__, pindex_block->GetBlockHash().ToString());
+                return;
+            }
+            if (!WriteBlock(block, pindex_block, fConnect)) {
+                FatalError("%s: Failed to write block %s to address index database",
+                           __func__, pindex_block->GetBlockHash().ToString());
+                return;
+            }
+            pindex = fConnect ? pindex_block : pindex_block->pprev;
+            m_best_block_index = pindex;
+        }
+    }
+
+    if (pindex) {
+        LogPrintf("addressindex is enabled at height %d\n", pindex->nHeight);
+    } else {
+        LogPrintf("addressindex is enabled\n");
+    }
+}
+
+bool AddressIndex::GetBlockEntries(const CBlock& block, const CBlockIndex* pindex, CAddressIndexEntries& entries) const
+{
+    if (m_flags & TIMESTAMP) {
+        entries.vTimestamp.emplace_back(pindex->nTime, pindex->GetBlockHash());
+    }
+
+    // The genesis block has no undo data and its outputs are not spendable.
+    if (!(m_flags & (ADDRESS | SPENT)) || pindex->nHeight == 0) {
+        return true;
+    }
+
+    CBlockUndo blockundo;
+    if (!UndoReadFromDisk(blockundo, pindex)) {
+        return error("%s: Failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: Undo data of block %s does not match", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    const int nHeight = pindex->nHeight;
+    for (unsigned int i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txhash = tx.GetHash();
+
+        if (i > 0) {
+            const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+            if (txundo.vprevout.size() != tx.vin.size()) {
+                return error("%s: Undo data of tx %s does not match", __func__, txhash.ToString());
+            }
+            for (unsigned int j = 0; j < tx.vin.size(); ++j) {
+                const COutPoint& prevout = tx.vin[j].prevout;
+                const Coin& coin = txundo.vprevout[j];
+
+                AddressType type = AddressType::NONE;
+                uint160 hash;
+                bool fHasAddress = GetAddressKey(coin.out.scriptPubKey, type, hash);
+
+                if ((m_flags & ADDRESS) && fHasAddress) {
+                    entries.vAddress.emplace_back(CAddressIndexKey(type, hash, nHeight, i, txhash, j, true),
+                                                  -coin.out.nValue);
+                    entries.vUnspent.emplace_back(CAddressUnspentKey(type, hash, prevout.hash, prevout.n),
+                                                  CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight),
+                                                  false);
+                }
+                if (m_flags & SPENT) {
+                    entries.vSpent.emplace_back(CSpentIndexKey(prevout.hash, prevout.n),
+                                                CSpentIndexValue(txhash, j, nHeight, coin.out.nValue, type, hash));
+                }
+            }
+        }
+
+        if (!(m_flags & ADDRESS)) {
+            continue;
+        }
+        for (unsigned int k = 0; k < tx.vout.size(); ++k) {
+            const CTxOut& out = tx.vout[k];
+            AddressType type;
+            uint160 hash;
+            if (!GetAddressKey(out.scriptPubKey, type, hash)) {
+                continue;
+            }
+            entries.vAddress.emplace_back(CAddressIndexKey(type, hash, nHeight, i, txhash, k, false), out.nValue);
+            entries.vUnspent.emplace_back(CAddressUnspentKey(type, hash, txhash, k),
+                                          CAddressUnspentValue(out.nValue, out.scriptPubKey, nHeight),
+                                          true);
+        }
+    }
+    return true;
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex, bool fConnect)
+{
+    CAddressIndexEntries entries;
+    if (!GetBlockEntries(block, pindex, entries)) {
+        return false;
+    }
+    return m_db->WriteBlock(entries, fConnect);
+}
+
+bool AddressIndex::WriteBestBlock(const CBlockIndex* block_index)
+{
+    if (!block_index) {
+        return true;
+    }
+
+    LOCK(cs_main);
+    if (!m_db->WriteBestBlock(chainActive.GetLocator(block_index))) {
+        return error("%s: Failed to write locator to disk", __func__);
+    }
+    return true;
+}
+
+void AddressIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                                  const std::vector<CTransactionRef>& txn_conflicted)
+{
+    if (!m_synced) {
+        return;
+    }
+
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (!best_block_index) {
+        if (pindex->nHeight != 0) {
+            FatalError("%s: First block connected is not the genesis block (height=%d)",
+                       __func__, pindex->nHeight);
+            return;
+        }
+    } else if (best_block_index->GetAncestor(pindex->nHeight) == pindex) {
+        // Already indexed by the sync thread.
+        return;
+    } else if (pindex->pprev != best_block_index) {
+        // Blocks of a stale branch may still be in the ValidationInterface
+        // queue right after the sync thread caught up; let the queue clear.
+        LogPrintf("%s: WARNING: Block %s does not connect to the address index tip " /* Continued */
+                  "(tip=%s); not updating addressindex\n",
+                  __func__, pindex->GetBlockHash().ToString(),
+                  best_block_index->GetBlockHash().ToString());
+        return;
+    }
+
+    if (WriteBlock(*block, pindex, true)) {
+        m_best_block_index = pindex;
+    } else {
+        FatalError("%s: Failed to write block %s to addressindex",
+                   __func__, pindex->GetBlockHash().ToString());
+    }
+}
+
+void AddressIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    if (!m_synced) {
+        return;
+    }
+
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        pindex = LookupBlockIndex(block->GetHash());
+    }
+
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (!pindex || pindex != best_block_index) {
+        LogPrintf("%s: WARNING: Disconnected block %s is not the address index tip; " /* Continued */
+                  "not updating addressindex\n",
+                  __func__, block->GetHash().ToString());
+        return;
+    }
+
+    if (WriteBlock(*block, pindex, false)) {
+        m_best_block_index = pindex->pprev;
+    } else {
+        FatalError("%s: Failed to revert block %s in addressindex",
+                   __func__, pindex->GetBlockHash().ToString());
+    }
+}
+
+void AddressIndex::ChainStateFlushed(const CBlockLocator& locator)
+{
+    if (!m_synced || locator.IsNull()) {
+        return;
+    }
+
+    const uint256& locator_tip_hash = locator.vHave.front();
+    const CBlockIndex* locator_tip_index;
+    {
+        LOCK(cs_main);
+        locator_tip_index = LookupBlockIndex(locator_tip_hash);
+    }
+
+    if (!locator_tip_index) {
+        FatalError("%s: First block (hash=%s) in locator was not found",
+                   __func__, locator_tip_hash.ToString());
+        return;
+    }
+
+    // Only persist locators the index has actually caught up with, the
+    // flush notification may overtake queued block notifications.
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (!best_block_index || best_block_index->GetAncestor(locator_tip_index->nHeight) != locator_tip_index) {
+        return;
+    }
+
+    if (!m_db->WriteBestBlock(locator)) {
+        error("%s: Failed to write locator to disk", __func__);
+    }
+}
+
+bool AddressIndex::BlockUntilSyncedToCurrentChain()
+{
+    AssertLockNotHeld(cs_main);
+
+    if (!m_synced) {
+        return false;
+    }
+
+    {
+        // Skip the queue-draining stuff if we know we're caught up with
+        // chainActive.Tip().
+        LOCK(cs_main);
+        const CBlockIndex* chain_tip = chainActive.Tip();
+        const CBlockIndex* best_block_index = m_best_block_index.load();
+        if (best_block_index == chain_tip) {
+            return true;
+        }
+    }
+
+    SyncWithValidationInterfaceQueue();
+    return true;
+}
+
+bool AddressIndex::GetAddressIndex(AddressType type, const uint160& hash,
+                                   std::vector<std::pair<CAddressIndexKey, CAmount>>& vAddressIndex,
+                                   int nStart, int nEnd)
+{
+    return m_db->ReadAddressIndex(type, hash, vAddressIndex, nStart, nEnd);
+}
+
+bool AddressIndex::GetAddressUnspent(AddressType type, const uint160& hash,
+                                     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& vUnspent)
+{
+    return m_db->ReadAddressUnspentIndex(type, hash, vUnspent);
+}
+
+bool AddressIndex::GetSpentInfo(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    return m_db->ReadSpentIndex(key, value);
+}
+
+bool AddressIndex::GetTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes)
+{
+    return m_db->ReadTimestampIndex(nHigh, nLow, vHashes);
+}
+
+void AddressIndex::Interrupt()
+{
+    m_interrupt();
+}
+
+void AddressIndex::Start()
+{
+    // Need to register this ValidationInterface before running Init(), so that
+    // callbacks are not missed if Init sets m_synced to true.
+    RegisterValidationInterface(this);
+    if (!Init()) {
+        FatalError("%s: addressindex failed to initialize", __func__);
+        return;
+    }
+
+    m_thread_sync = std::thread(&TraceThread<std::function<void()>>, "addressindex",
+                                std::bind(&AddressIndex::ThreadSync, this));
+}
+
+void AddressIndex::Stop()
+{
+    UnregisterValidationInterface(this);
+
+    if (m_thread_sync.joinable()) {
+        m_thread_sync.join();
+    }
+}
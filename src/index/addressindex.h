@@ -0,0 +1,121 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <addressindex.h>
+#include <primitives/block.h>
+#include <threadinterrupt.h>
+#include <txdb.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <thread>
+
+class CBlockIndex;
+class CBlockUndo;
+class CScript;
+
+/**
+ * AddressIndex maintains the optional address, spent and timestamp indexes
+ * used by explorers and exchanges to answer per-address queries without
+ * scanning the chain. Like TxIndex it is built by a background thread from
+ * the blocks on disk and then follows the chain through ValidationInterface
+ * notifications. Unlike TxIndex it also reverts disconnected blocks, since a
+ * stale entry would show up as a wrong balance.
+ */
+class AddressIndex final : public CValidationInterface
+{
+public:
+    enum Flags : uint32_t {
+        ADDRESS = (1 << 0),
+        SPENT = (1 << 1),
+        TIMESTAMP = (1 << 2),
+    };
+
+private:
+    const std::unique_ptr<AddressIndexDB> m_db;
+    const uint32_t m_flags;
+
+    /// Whether the index is in sync with the main chain. The flag is flipped
+    /// from false to true once, after which point this starts processing
+    /// ValidationInterface notifications to stay in sync.
+    std::atomic<bool> m_synced;
+
+    /// The last block in the chain that the index is in sync with.
+    std::atomic<const CBlockIndex*> m_best_block_index;
+
+    std::thread m_thread_sync;
+    CThreadInterrupt m_interrupt;
+
+    /// Initialize internal state from the database and block index.
+    bool Init();
+
+    /// Sync the index with the block index starting from the current best
+    /// block, first reverting blocks that left the active chain while the node
+    /// was down. Runs in m_thread_sync and can be interrupted with m_interrupt.
+    void ThreadSync();
+
+    /// Compute the index entries of a block from the block and its undo data.
+    bool GetBlockEntries(const CBlock& block, const CBlockIndex* pindex, CAddressIndexEntries& entries) const;
+
+    /// Apply (fConnect) or revert the index entries of a block.
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex, bool fConnect);
+
+    /// Write the current chain block locator to the DB.
+    bool WriteBestBlock(const CBlockIndex* block_index);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                        const std::vector<CTransactionRef>& txn_conflicted) override;
+
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
+    void ChainStateFlushed(const CBlockLocator& locator) override;
+
+public:
+    /// Constructs the index for the given combination of Flags.
+    AddressIndex(std::unique_ptr<AddressIndexDB> db, uint32_t flags);
+
+    /// Destructor interrupts sync thread if running and blocks until it exits.
+    ~AddressIndex();
+
+    bool IsAddressIndexEnabled() const { return m_flags & ADDRESS; }
+    bool IsSpentIndexEnabled() const { return m_flags & SPENT; }
+    bool IsTimestampIndexEnabled() const { return m_flags & TIMESTAMP; }
+
+    /// Returns true once the index covers the active chain.
+    bool IsSynced() const { return m_synced; }
+
+    /// Blocks the current thread until the index has processed the
+    /// ValidationInterface queue. Returns false if the index is still
+    /// catching up from far behind.
+    bool BlockUntilSyncedToCurrentChain();
+
+    /// Map an output script to the address it is indexed under.
+    static bool GetAddressKey(const CScript& script, AddressType& type, uint160& hash);
+
+    bool GetAddressIndex(AddressType type, const uint160& hash,
+                         std::vector<std::pair<CAddressIndexKey, CAmount>>& vAddressIndex,
+                         int nStart = 0, int nEnd = 0);
+    bool GetAddressUnspent(AddressType type, const uint160& hash,
+                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& vUnspent);
+    bool GetSpentInfo(const CSpentIndexKey& key, CSpentIndexValue& value) const;
+    bool GetTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes);
+
+    void Interrupt();
+
+    /// Start initializes the sync state and registers the instance as a
+    /// ValidationInterface so that it stays in sync with blockchain updates.
+    void Start();
+
+    /// Stops the instance from staying in sync with blockchain updates.
+    void Stop();
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <blockfilemap.h>
 #include <chainparams.h>
 #include <index/txindex.h>
 #include <init.h>
@@ -29,17 +30,15 @@ static void FatalError(const char* fmt, const Args&... args)
 }
 
 TxIndex::TxIndex(std::unique_ptr<TxIndexDB> db) :
-    m_db(std::move(db))//, m_synced(false), m_best_block_index(nullptr)
+    m_db(std::move(db)), m_synced(false), m_best_block_index(nullptr)
 {}
 
 TxIndex::~TxIndex()
 {
-//    Interrupt();
-//    Stop();
+    Interrupt();
+    Stop();
 }
 
-#if 0
-
 bool TxIndex::Init()
 {
     LOCK(cs_main);
@@ -51,12 +50,26 @@ bool TxIndex::Init()
         return false;
     }
 
+    // Previous versions wrote the entries of every connected block from
+    // ConnectBlock but never a locator. Such an index is complete up to the
+    // tip, so record that once instead of rebuilding it.
     CBlockLocator locator;
-    if (!m_db->ReadBestBlock(locator)) {
-        locator.SetNull();
+    if ((!m_db->ReadBestBlock(locator) || locator.IsNull()) && chainActive.Tip() && !m_db->IsEmpty()) {
+        LogPrintf("txindex has entries but no best block, assuming it is in sync at height %d\n", chainActive.Height());
+        locator = chainActive.GetLocator();
+        if (!m_db->WriteBestBlock(locator)) {
+            return error("%s: Failed to write locator to disk", __func__);
+        }
     }
 
-    m_best_block_index = FindForkInGlobalIndex(chainActive, locator);
+    // Without a locator nothing is known about the index contents, e.g. it
+    // was enabled on a node that already has the chain, so it is rebuilt
+    // from genesis in the background.
+    if (locator.IsNull()) {
+        m_best_block_index = nullptr;
+    } else {
+        m_best_block_index = FindForkInGlobalIndex(chainActive, locator);
+    }
     m_synced = m_best_block_index.load() == chainActive.Tip();
     return true;
 }
@@ -95,7 +108,8 @@ void TxIndex::ThreadSync()
                 LOCK(cs_main);
                 const CBlockIndex* pindex_next = NextSyncBlock(pindex);
                 if (!pindex_next) {
-                    WriteBestBlock(pindex);
+                    // Blocks connected from now on are indexed by ConnectBlock,
+                    // which runs under cs_main as well, so nothing is missed.
                     m_best_block_index = pindex;
                     m_synced = true;
                     break;
@@ -110,7 +124,7 @@ void TxIndex::ThreadSync()
             }
 
             if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
-                WriteBestBlock(pindex);
+                WriteBestBlock(pindex->pprev);
                 last_locator_write_time = current_time;
             }
 
@@ -125,7 +139,9 @@ void TxIndex::ThreadSync()
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             }
+            m_best_block_index = pindex;
         }
+        WriteBestBlock(pindex);
     }
 
     if (pindex) {
@@ -149,6 +165,10 @@ bool TxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
 
 bool TxIndex::WriteBestBlock(const CBlockIndex* block_index)
 {
+    if (!block_index) {
+        return true;
+    }
+
     LOCK(cs_main);
     if (!m_db->WriteBestBlock(chainActive.GetLocator(block_index))) {
         return error("%s: Failed to write locator to disk", __func__);
@@ -156,74 +176,12 @@ bool TxIndex::WriteBestBlock(const CBlockIndex* block_index)
     return true;
 }
 
-void TxIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
-                    const std::vector<CTransactionRef>& txn_conflicted)
-{
-    if (!m_synced) {
-        return;
-    }
-
-    const CBlockIndex* best_block_index = m_best_block_index.load();
-    if (!best_block_index) {
-        if (pindex->nHeight != 0) {
-            FatalError("%s: First block connected is not the genesis block (height=%d)",
-                       __func__, pindex->nHeight);
-            return;
-        }
-    } else {
-        // Ensure block connects to an ancestor of the current best block. This should be the case
-        // most of the time, but may not be immediately after the the sync thread catches up and sets
-        // m_synced. Consider the case where there is a reorg and the blocks on the stale branch are
-        // in the ValidationInterface queue backlog even after the sync thread has caught up to the
-        // new chain tip. In this unlikely event, log a warning and let the queue clear.
-        if (best_block_index->GetAncestor(pindex->nHeight - 1) != pindex->pprev) {
-            LogPrintf("%s: WARNING: Block %s does not connect to an ancestor of " /* Continued */
-                      "known best chain (tip=%s); not updating txindex\n",
-                      __func__, pindex->GetBlockHash().ToString(),
-                      best_block_index->GetBlockHash().ToString());
-            return;
-        }
-    }
-
-    if (WriteBlock(*block, pindex)) {
-        m_best_block_index = pindex;
-    } else {
-        FatalError("%s: Failed to write block %s to txindex",
-                   __func__, pindex->GetBlockHash().ToString());
-        return;
-    }
-}
-
 void TxIndex::ChainStateFlushed(const CBlockLocator& locator)
 {
-    if (!m_synced) {
-        return;
-    }
-
-    const uint256& locator_tip_hash = locator.vHave.front();
-    const CBlockIndex* locator_tip_index;
-    {
-        LOCK(cs_main);
-        locator_tip_index = LookupBlockIndex(locator_tip_hash);
-    }
-
-    if (!locator_tip_index) {
-        FatalError("%s: First block (hash=%s) in locator was not found",
-                   __func__, locator_tip_hash.ToString());
-        return;
-    }
-
-    // This checks that ChainStateFlushed callbacks are received after BlockConnected. The check may fail
-    // immediately after the the sync thread catches up and sets m_synced. Consider the case where
-    // there is a reorg and the blocks on the stale branch are in the ValidationInterface queue
-    // backlog even after the sync thread has caught up to the new chain tip. In this unlikely
-    // event, log a warning and let the queue clear.
-    const CBlockIndex* best_block_index = m_best_block_index.load();
-    if (best_block_index->GetAncestor(locator_tip_index->nHeight) != locator_tip_index) {
-        LogPrintf("%s: WARNING: Locator contains block (hash=%s) not on known best " /* Continued */
-                  "chain (tip=%s); not writing txindex locator\n",
-                  __func__, locator_tip_hash.ToString(),
-                  best_block_index->GetBlockHash().ToString());
+    // While back-filling, the locator is owned by the sync thread. Once in
+    // sync every block of the flushed chain state went through ConnectBlock
+    // and is already indexed.
+    if (!m_synced || locator.IsNull()) {
         return;
     }
 
@@ -232,32 +190,6 @@ void TxIndex::ChainStateFlushed(const CBlockLocator& locator)
     }
 }
 
-bool TxIndex::BlockUntilSyncedToCurrentChain()
-{
-    AssertLockNotHeld(cs_main);
-
-    if (!m_synced) {
-        return false;
-    }
-
-    {
-        // Skip the queue-draining stuff if we know we're caught up with
-        // chainActive.Tip().
-        LOCK(cs_main);
-        const CBlockIndex* chain_tip = chainActive.Tip();
-        const CBlockIndex* best_block_index = m_best_block_index.load();
-        if (best_block_index->GetAncestor(chain_tip->nHeight) == chain_tip) {
-            return true;
-        }
-    }
-
-    LogPrintf("%s: txindex is catching up on block notifications\n", __func__);
-    SyncWithValidationInterfaceQueue();
-    return true;
-}
-
-#endif
-
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
 {
     CDiskTxPos postx;
@@ -265,17 +197,30 @@ bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRe
         return error("%s: failed to read tx pos", __func__);
     }
 
-    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-    if (file.IsNull()) {
-        return error("%s: OpenBlockFile failed", __func__);
-    }
     CBlockHeader header;
-    try {
-        file >> header;
-        fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-        file >> tx;
-    } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    CBlockFileMap::BlockData blockData;
+    if (blockfilemap.GetBlock(postx, blockData)) {
+        // Only the header and the transaction are deserialized from the mapped block
+        try {
+            CSpanReader reader(SER_DISK, CLIENT_VERSION, blockData.data);
+            reader >> header;
+            reader.ignore(postx.nTxOffset);
+            reader >> tx;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize error - %s", __func__, e.what());
+        }
+    } else {
+        CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+        if (file.IsNull()) {
+            return error("%s: OpenBlockFile failed", __func__);
+        }
+        try {
+            file >> header;
+            fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+            file >> tx;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        }
     }
     if (tx->GetHash() != tx_hash) {
         return error("%s: txid mismatch", __func__);
@@ -289,30 +234,30 @@ bool TxIndex::WriteIndex(const std::vector<TxIndex::IndexEntry> &list)
     return m_db->WriteTxs(list);
 }
 
-//void TxIndex::Interrupt()
-//{
-//    m_interrupt();
-//}
-
-//void TxIndex::Start()
-//{
-//    // Need to register this ValidationInterface before running Init(), so that
-//    // callbacks are not missed if Init sets m_synced to true.
-//    RegisterValidationInterface(this);
-//    if (!Init()) {
-//        FatalError("%s: txindex failed to initialize", __func__);
-//        return;
-//    }
-
-//    m_thread_sync = std::thread(&TraceThread<std::function<void()>>, "txindex",
-//                                std::bind(&TxIndex::ThreadSync, this));
-//}
-
-//void TxIndex::Stop()
-//{
-//    UnregisterValidationInterface(this);
-
-//    if (m_thread_sync.joinable()) {
-//        m_thread_sync.join();
-//    }
-//}
+void TxIndex::Interrupt()
+{
+    m_interrupt();
+}
+
+void TxIndex::Start()
+{
+    // Need to register this ValidationInterface before running Init(), so that
+    // callbacks are not missed if Init sets m_synced to true.
+    RegisterValidationInterface(this);
+    if (!Init()) {
+        FatalError("%s: txindex failed to initialize", __func__);
+        return;
+    }
+
+    m_thread_sync = std::thread(&TraceThread<std::function<void()>>, "txindex",
+                                std::bind(&TxIndex::ThreadSync, this));
+}
+
+void TxIndex::Stop()
+{
+    UnregisterValidationInterface(this);
+
+    if (m_thread_sync.joinable()) {
+        m_thread_sync.join();
+    }
+}
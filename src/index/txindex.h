@@ -12,6 +12,9 @@
 #include <uint256.h>
 #include <validationinterface.h>
 
+#include <atomic>
+#include <thread>
+
 class CBlockIndex;
 
 /**
@@ -24,38 +27,37 @@ class TxIndex final : public CValidationInterface
 private:
     const std::unique_ptr<TxIndexDB> m_db;
 
-    /// Whether the index is in sync with the main chain. The flag is flipped
-    /// from false to true once, after which point this starts processing
-    /// ValidationInterface notifications to stay in sync.
-//    std::atomic<bool> m_synced;
+    /// Whether the index is in sync with the main chain. Blocks connected to
+    /// the active chain are always indexed from ConnectBlock, because PoS and
+    /// masternode validation look transactions up through the index. The
+    /// flag tells whether the historical part of the chain, which was
+    /// connected while the index was disabled, has been back-filled as well.
+    std::atomic<bool> m_synced;
 
     /// The last block in the chain that the TxIndex is in sync with.
-//    std::atomic<const CBlockIndex*> m_best_block_index;
+    std::atomic<const CBlockIndex*> m_best_block_index;
 
-//    std::thread m_thread_sync;
-//    CThreadInterrupt m_interrupt;
+    std::thread m_thread_sync;
+    CThreadInterrupt m_interrupt;
 
     /// Initialize internal state from the database and block index.
-//    bool Init();
+    bool Init();
 
-    /// Sync the tx index with the block index starting from the current best
-    /// block. Intended to be run in its own thread, m_thread_sync, and can be
-    /// interrupted with m_interrupt. Once the txindex gets in sync, the
-    /// m_synced flag is set and the BlockConnected ValidationInterface callback
-    /// takes over and the sync thread exits.
-//    void ThreadSync();
+    /// Back-fill the tx index from the current best block up to the chain
+    /// tip. Intended to be run in its own thread, m_thread_sync, and can be
+    /// interrupted with m_interrupt. The node keeps running while this
+    /// happens; once the txindex gets in sync, the m_synced flag is set and
+    /// the sync thread exits.
+    void ThreadSync();
 
     /// Write update index entries for a newly connected block.
-//    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex);
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex);
 
     /// Write the current chain block locator to the DB.
-//    bool WriteBestBlock(const CBlockIndex* block_index);
+    bool WriteBestBlock(const CBlockIndex* block_index);
 
 protected:
-//    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
-//                        const std::vector<CTransactionRef>& txn_conflicted) override;
-
-//    void ChainStateFlushed(const CBlockLocator& locator) override;
+    void ChainStateFlushed(const CBlockLocator& locator) override;
 
 public:
     /// Constructs the TxIndex, which becomes available to be queried.
@@ -64,11 +66,9 @@ public:
     /// Destructor interrupts sync thread if running and blocks until it exits.
     ~TxIndex();
 
-    /// Blocks the current thread until the transaction index is caught up to
-    /// the current state of the block chain. This only blocks if the index has gotten in sync once
-    /// and only needs to process blocks in the ValidationInterface queue. If the index is catching
-    /// up from far behind, this method does not block and immediately returns false.
-//    bool BlockUntilSyncedToCurrentChain();
+    /// Returns true once every block of the active chain has been indexed.
+    /// Until then lookups of transactions from older blocks may fail.
+    bool IsSynced() const { return m_synced; }
 
     /// Look up a transaction by hash.
     ///
@@ -80,14 +80,15 @@ public:
     using IndexEntry = std::pair<uint256, CDiskTxPos>;
     bool WriteIndex(const std::vector<IndexEntry> &list);
 
-//    void Interrupt();
+    void Interrupt();
 
-    /// Start initializes the sync state and registers the instance as a
-    /// ValidationInterface so that it stays in sync with blockchain updates.
-//    void Start();
+    /// Start initializes the sync state, registers the instance as a
+    /// ValidationInterface and starts back-filling the index in the
+    /// background if it is behind the active chain.
+    void Start();
 
-    /// Stops the instance from staying in sync with blockchain updates.
-//    void Stop();
+    /// Stops the background sync and unregisters the instance.
+    void Stop();
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
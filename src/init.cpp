@@ -11,6 +11,8 @@
 
 #include <addrman.h>
 #include <amount.h>
+#include <blockcache.h>
+#include <blockfilemap.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
@@ -20,6 +22,7 @@
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
 #include <key.h>
 #include <validation.h>
@@ -44,6 +47,7 @@
 #include <ui_interface.h>
 #include <util.h>
 #include <utilmoneystr.h>
+#include <utxosnapshot.h>
 #include <validationinterface.h>
 #include <warnings.h>
 #include <walletinitinterface.h>
@@ -59,6 +63,7 @@
 #include <net_processing_xsn.h>
 #include <masternodeman.h>
 #include <masternode-payments.h>
+#include <masternode-registry.h>
 #include <tpos/merchantnodeman.h>
 #include <netfulfilledman.h>
 #include <governance/governance.h>
@@ -202,6 +207,55 @@ void Interrupt()
     InterruptMapPort();
     if (g_connman)
         g_connman->Interrupt();
+    if (g_txindex) {
+        g_txindex->Interrupt();
+    }
+    if (g_addressindex) {
+        g_addressindex->Interrupt();
+    }
+}
+
+/** Fill the empty chainstate from the -loadtxoutset snapshot and check it against the snapshot hash */
+static bool LoadTxOutSetSnapshot(const CChainParams& chainparams, std::string& strError)
+{
+    if (fReindex) {
+        strError = _("A UTXO snapshot cannot be loaded while reindexing the block files");
+        return false;
+    }
+
+    const fs::path path = fs::absolute(gArgs.GetArg("-loadtxoutset", ""), GetDataDir());
+    CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        strError = strprintf(_("Unable to open UTXO snapshot %s"), path.string());
+        return false;
+    }
+
+    CUTXOSnapshotMetadata metadata;
+    try {
+        file >> metadata;
+    } catch (const std::exception& e) {
+        strError = strprintf(_("Unable to read UTXO snapshot %s: %s"), path.string(), e.what());
+        return false;
+    }
+    if (memcmp(metadata.pchMessageStart, chainparams.MessageStart(), sizeof(metadata.pchMessageStart)) != 0) {
+        strError = _("The UTXO snapshot is for a different network");
+        return false;
+    }
+
+    if (!LoadUTXOSnapshot(file, metadata, strError)) {
+        return false;
+    }
+
+    CCoinsStats stats;
+    if (!GetUTXOStats(pcoinsdbview.get(), stats) || stats.hashBlock != metadata.hashBaseBlock ||
+        stats.nTransactionOutputs != metadata.nCoinsCount || stats.hashSerialized != metadata.hashSerialized) {
+        strError = _("The loaded UTXO snapshot does not match its hash. You will need to rebuild the database using -reindex-chainstate.");
+        return false;
+    }
+    pblocktree->WriteFlag(UTXO_SNAPSHOT_LOADING_FLAG, false);
+
+    LogPrintf("Loaded UTXO snapshot %s at height %d, hash_serialized_2 %s\n", path.string(), metadata.nBaseHeight, metadata.hashSerialized.ToString());
+    return true;
 }
 
 static bool LoadExtensionsDataCaches()
@@ -298,12 +352,19 @@ void Shutdown()
     // Because these depend on each-other, we make sure that neither can be
     // using the other before destroying them.
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
+    net_processing_xsn::StopExtensionWorkers();
     if (g_connman) g_connman->Stop();
     peerLogic.reset();
     g_connman.reset();
     if (g_txindex) {
+        g_txindex->Stop();
         g_txindex.reset();
     }
+    if (g_addressindex) {
+        g_addressindex->Stop();
+        g_addressindex.reset();
+    }
+    mnregistry.Stop();
 
     StoreExtensionsDataCaches();
 
@@ -385,6 +446,7 @@ void Shutdown()
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    g_logger->StopAsyncWriter();
 }
 
 /**
@@ -443,8 +505,10 @@ void SetupServerArgs()
     // When adding new options to the categories, please keep and ensure alphabetical ordering.
     gArgs.AddArg("-?", "Print this help message and exit", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-version", "Print version and exit", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-addressindex", strprintf("Maintain an index of outputs and spends by address, used by the getaddress* rpc calls (default: %u)", DEFAULT_ADDRESSINDEX), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-alertnotify=<cmd>", "Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex()), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-blockcachesize=<n>", strprintf("Keep up to <n> MiB of recently used blocks in memory, 0 to disable (default: %d)", DEFAULT_BLOCK_CACHE_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blocksdir=<dir>", "Specify blocks directory (default: <datadir>/blocks)", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), false, OptionsCategory::OPTIONS);
@@ -457,11 +521,13 @@ void SetupServerArgs()
     gArgs.AddArg("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-loadblock=<file>", "Imports blocks from external blk000??.dat file on startup", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-loadtxoutset=<file>", "Start from the UTXO snapshot written by dumptxoutset instead of connecting every block again. Needs an empty chainstate (e.g. -reindex-chainstate) and the blocks up to the snapshot on disk", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()), true, OptionsCategory::OPTIONS);
-    gArgs.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+    gArgs.AddArg("-mmapblocks", strprintf("Read blocks through read-only memory mappings of the block files. A disk error while reading a mapped block terminates the process with SIGBUS instead of failing the read (default: %u)", DEFAULT_MMAP_BLOCKS), true, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-par=<n>", strprintf("Set the number of script and message signature verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), false, OptionsCategory::OPTIONS);
 #ifndef WIN32
@@ -469,16 +535,19 @@ void SetupServerArgs()
 #else
     hidden_args.emplace_back("-pid");
 #endif
-    gArgs.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks, and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex and -rescan. "
+    gArgs.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks, and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex, -addressindex, -spentindex, -timestampindex and -rescan. "
             "Warning: Reverting this setting requires re-downloading the entire blockchain. "
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-schedulerthreads=<n>", strprintf("Number of threads running background tasks and validation notifications (1 to %d, default: %d)", MAX_SCHEDULER_THREADS, DEFAULT_SCHEDULER_THREADS), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-spentindex", strprintf("Maintain an index of which input spends each output, used by the getspentinfo rpc call (default: %u)", DEFAULT_SPENTINDEX), false, OptionsCategory::OPTIONS);
 #ifndef WIN32
     gArgs.AddArg("-sysperms", "Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)", false, OptionsCategory::OPTIONS);
 #else
     hidden_args.emplace_back("-sysperms");
 #endif
+    gArgs.AddArg("-timestampindex", strprintf("Maintain an index of block hashes by timestamp, used by the getblockhashes rpc call (default: %u)", DEFAULT_TIMESTAMPINDEX), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info)", false, OptionsCategory::CONNECTION);
@@ -506,6 +575,7 @@ void SetupServerArgs()
     gArgs.AddArg("-proxy=<ip:port>", "Connect through SOCKS5 proxy", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-proxyrandomize", strprintf("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)", DEFAULT_PROXYRANDOMIZE), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-seednode=<ip>", "Connect to a node to retrieve peer addresses, and disconnect", false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-socketevents=<mode>", strprintf("Socket events mode, which must be one of: %s (default: %s)", GetSocketEventsModesList(), DEFAULT_SOCKETEVENTS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-timeout=<n>", strprintf("Specify connection timeout in milliseconds (minimum: 1, default: %d)", DEFAULT_CONNECT_TIMEOUT), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-torcontrol=<ip>:<port>", strprintf("Tor control port to use if onion listening enabled (default: %s)", DEFAULT_TOR_CONTROL), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-torpassword=<pass>", "Tor control port password (default: empty)", false, OptionsCategory::CONNECTION);
@@ -526,14 +596,32 @@ void SetupServerArgs()
 
 #if ENABLE_ZMQ
     gArgs.AddArg("-zmqpubhashblock=<address>", "Enable publish hash block in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubhashgovernanceobject=<address>", "Enable publish hash of governance objects (like proposals) in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubhashgovernancevote=<address>", "Enable publish hash of governance votes in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubhashtposblock=<address>", "Enable publish hash of TPoS blocks and their contract transaction in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashtx=<address>", "Enable publish hash transaction in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubhashtxlock=<address>", "Enable publish hash of transactions locked via InstantSend in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubmasternode=<address>", "Enable publish masternode list additions, removals and state changes in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubmerchantnode=<address>", "Enable publish merchantnode list additions, removals and state changes in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubrawgovernanceobject=<address>", "Enable publish raw governance objects (like proposals) in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubrawgovernancevote=<address>", "Enable publish raw governance votes in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubrawtxlock=<address>", "Enable publish raw transactions locked via InstantSend in <address>", false, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
+    hidden_args.emplace_back("-zmqpubhashgovernanceobject=<address>");
+    hidden_args.emplace_back("-zmqpubhashgovernancevote=<address>");
+    hidden_args.emplace_back("-zmqpubhashtposblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
+    hidden_args.emplace_back("-zmqpubhashtxlock=<address>");
+    hidden_args.emplace_back("-zmqpubmasternode=<address>");
+    hidden_args.emplace_back("-zmqpubmerchantnode=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
+    hidden_args.emplace_back("-zmqpubrawgovernanceobject=<address>");
+    hidden_args.emplace_back("-zmqpubrawgovernancevote=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
+    hidden_args.emplace_back("-zmqpubrawtxlock=<address>");
 #endif
 
     gArgs.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), true, OptionsCategory::DEBUG_TEST);
@@ -555,7 +643,10 @@ void SetupServerArgs()
         "If <category> is not supplied or if <category> = 1, output all debugging information. <category> can be: " + ListLogCategories() + ".", false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-debugexclude=<category>", strprintf("Exclude debugging information for a category. Can be used in conjunction with -debug=1 to output debug logs for all categories except one or more specified categories."), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-help-debug", "Show all debugging options (usage: --help -help-debug)", false, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-lockprofiling", strprintf("Record how long each LOCK site waits for and holds its lock, see getlockstats (default: %u)", DEFAULT_LOCK_PROFILING), false, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-logasync", strprintf("Write the debug log from a background thread, dropping messages when it falls behind (default: %u)", DEFAULT_LOGASYNC), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logips", strprintf("Include IP addresses in debug output (default: %u)", DEFAULT_LOGIPS), false, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-logratelimit=<n>", strprintf("Limit the debug output of every category, and of uncategorized messages, to <n> KiB per second. Bursts of up to %d seconds worth are allowed, 0 disables the limit (default: %d)", LOG_RATE_LIMIT_BURST_SECONDS, DEFAULT_LOGRATELIMIT), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logtimestamps", strprintf("Prepend debug output with timestamp (default: %u)", DEFAULT_LOGTIMESTAMPS), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)", true, OptionsCategory::DEBUG_TEST);
@@ -592,13 +683,15 @@ void SetupServerArgs()
     gArgs.AddArg("-rpcauth=<userpw>", "Username and hashed password for JSON-RPC connections. The field <userpw> comes in the format: <USERNAME>:<SALT>$<HASH>. A canonical python script is included in share/rpcuser. The client then connects normally using the rpcuser=<USERNAME>/rpcpassword=<PASSWORD> pair of arguments. This option can be specified multiple times", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcbind=<addr>[:port]", "Bind to given address to listen for JSON-RPC connections. This option is ignored unless -rpcallowip is also passed. Port is optional and overrides -rpcport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost, or if -rpcallowip has been specified, 0.0.0.0 and :: i.e., all addresses)", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcheavythreads=<n>", strprintf("Set the number of threads to service expensive read-only RPC calls such as masternodelist or getblock (default: %d)", DEFAULT_HTTP_HEAVY_THREADS), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcpassword=<pw>", "Password for JSON-RPC connections", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcport=<port>", strprintf("Listen for JSON-RPC connections on <port> (default: %u or testnet: %u)", defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort()), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcserialversion", strprintf("Sets the serialization of raw transaction or block hex returned in non-verbose mode, non-segwit(0) or segwit(1) (default: %d)", DEFAULT_RPC_SERIALIZE_VERSION), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT), true, OptionsCategory::RPC);
-    gArgs.AddArg("-rpcthreads=<n>", strprintf("Set the number of threads to service RPC calls (default: %d)", DEFAULT_HTTP_THREADS), false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcthreads=<n>", strprintf("Set the number of threads to service cheap RPC calls (default: %d)", DEFAULT_HTTP_THREADS), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcuser=<user>", "Username for JSON-RPC connections", false, OptionsCategory::RPC);
-    gArgs.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), true, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcwalletthreads=<n>", strprintf("Set the number of threads to service wallet RPC calls (default: %d)", DEFAULT_HTTP_WALLET_THREADS), false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of each of the work queues to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), true, OptionsCategory::RPC);
     gArgs.AddArg("-server", "Accept command line and JSON-RPC commands", false, OptionsCategory::RPC);
 
     gArgs.AddArg("-sporkkey", "Private key to send spork messages", false, OptionsCategory::OPTIONS);
@@ -608,6 +701,8 @@ void SetupServerArgs()
     gArgs.AddArg("-mnconflock=<n>", "Lock masternodes from masternode configuration file (default: %u)", false, OptionsCategory::MASTERNODE);
     gArgs.AddArg("-masternodeprivkey=<n>", "Set the masternode private key", false, OptionsCategory::MASTERNODE);
     gArgs.AddArg("-clearmncache", "Clears mncache on startup", false, OptionsCategory::MASTERNODE);
+    gArgs.AddArg("-masternoderegistry", strprintf("Keep the set of masternode collaterals in the UTXO set for the masternoderegistry RPC (default: %u)", DEFAULT_MASTERNODE_REGISTRY), false, OptionsCategory::MASTERNODE);
+    gArgs.AddArg("-xsnmsgthreads=<n>", strprintf("Number of threads handling masternode, merchantnode, governance, InstantSend and spork messages off the main message handler (0 to %d, 0 = handle inline, default: %d)", MAX_XSN_MSG_THREADS, DEFAULT_XSN_MSG_THREADS), false, OptionsCategory::MASTERNODE);
 
     gArgs.AddArg("-merchantnode=<n>", "Enable the client to act as a merchantnode (0-1, default: false", false, OptionsCategory::MERCHANTNODE);
     gArgs.AddArg("-merchantnodeprivkey=<n>", "Set the masternode private key", false, OptionsCategory::MERCHANTNODE);
@@ -936,7 +1031,10 @@ void InitLogging()
     g_logger->m_log_timestamps = gArgs.GetBoolArg("-logtimestamps", DEFAULT_LOGTIMESTAMPS);
     g_logger->m_log_time_micros = gArgs.GetBoolArg("-logtimemicros", DEFAULT_LOGTIMEMICROS);
 
+    g_logger->SetRateLimit(gArgs.GetArg("-logratelimit", DEFAULT_LOGRATELIMIT) * 1024);
+
     fLogIPs = gArgs.GetBoolArg("-logips", DEFAULT_LOGIPS);
+    g_lock_profiling = gArgs.GetBoolArg("-lockprofiling", DEFAULT_LOCK_PROFILING);
 
     std::string version_string = FormatFullVersion();
 #ifdef DEBUG
@@ -952,6 +1050,7 @@ namespace { // Variables internal to initialization process only
 int nMaxConnections;
 int nUserMaxConnections;
 int nFD;
+SocketEventsMode socketEventsMode = SocketEventsMode::SELECT;
 ServiceFlags nLocalServices = ServiceFlags(NODE_NETWORK | NODE_NETWORK_LIMITED);
 
 } // namespace
@@ -1032,6 +1131,10 @@ bool AppInitParameterInteraction()
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
+                gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
+                gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX))
+            return InitError(_("Prune mode is incompatible with -addressindex, -spentindex and -timestampindex."));
     }
 
     // -bind and -whitebind can't be set when not listening
@@ -1045,8 +1148,16 @@ bool AppInitParameterInteraction()
     nUserMaxConnections = gArgs.GetArg("-maxconnections", DEFAULT_MAX_PEER_CONNECTIONS);
     nMaxConnections = std::max(nUserMaxConnections, 0);
 
+    std::string strSocketEventsMode = gArgs.GetArg("-socketevents", DEFAULT_SOCKETEVENTS);
+    if (!ParseSocketEventsMode(strSocketEventsMode, socketEventsMode)) {
+        return InitError(strprintf(_("Invalid -socketevents ('%s') specified. Only these modes are supported: %s"), strSocketEventsMode, GetSocketEventsModesList()));
+    }
+
     // Trim requested connection counts, to fit into system limitations
-    nMaxConnections = std::max(std::min(nMaxConnections, FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS), 0);
+    // (only select() is bound by FD_SETSIZE)
+    if (socketEventsMode == SocketEventsMode::SELECT) {
+        nMaxConnections = std::max(std::min(nMaxConnections, FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS), 0);
+    }
     nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS + MAX_ADDNODE_CONNECTIONS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
@@ -1344,8 +1455,8 @@ bool AppInitPrivateSend()
 
     //    if((fMasterNode || masternodeConfig.getCount() > 0) && fTxIndex == false) {
     if((fMasterNode || masternodeConfig.getCount() > 0) && !g_txindex) {
-        return InitError("Enabling Masternode support requires turning on transaction indexing."
-                         "Please add txindex=1 to your configuration and start with -reindex");
+        return InitError("Enabling Masternode support requires turning on transaction indexing. "
+                         "Please add txindex=1 to your configuration, the index is built in the background");
     }
 
     if(fMasterNode) {
@@ -1456,6 +1567,9 @@ bool AppInitMain()
                                        g_logger->m_file_path.string()));
         }
     }
+    if (gArgs.GetBoolArg("-logasync", DEFAULT_LOGASYNC)) {
+        g_logger->StartAsyncWriter();
+    }
 
     if (!g_logger->m_log_timestamps)
         LogPrintf("Startup time: %s\n", FormatISO8601DateTime(GetTime()));
@@ -1478,13 +1592,20 @@ bool AppInitMain()
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            // batches of masternode/governance message signatures get as many helpers
+            threadGroup.create_thread(&ThreadMessageSignatureCheck);
+        }
     }
 
-    // Start the lightweight task scheduler thread
+    // Start the lightweight task scheduler threads
+    int nSchedulerThreads = std::max(1, std::min(MAX_SCHEDULER_THREADS, (int)gArgs.GetArg("-schedulerthreads", DEFAULT_SCHEDULER_THREADS)));
+    LogPrintf("Using %d threads for background tasks\n", nSchedulerThreads);
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
-    threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
+    for (int i = 0; i < nSchedulerThreads; i++) {
+        threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
+    }
 
     GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
     GetMainSignals().RegisterWithMempoolSignals(mempool);
@@ -1643,18 +1764,31 @@ bool AppInitMain()
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    uint32_t nAddressIndexFlags = 0;
+    if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) nAddressIndexFlags |= AddressIndex::ADDRESS;
+    if (gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) nAddressIndexFlags |= AddressIndex::SPENT;
+    if (gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) nAddressIndexFlags |= AddressIndex::TIMESTAMP;
+    int64_t nAddressIndexCache = std::min(nTotalCache / 8, nAddressIndexFlags ? nMaxAddressIndexCache << 20 : 0);
+    nTotalCache -= nAddressIndexCache;
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
     nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
     int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+    int64_t nBlockCache = std::max<int64_t>(gArgs.GetArg("-blockcachesize", DEFAULT_BLOCK_CACHE_SIZE), 0) << 20;
+    blockcache.SetMaxBytes(nBlockCache);
+    blockfilemap.SetEnabled(gArgs.GetBoolArg("-mmapblocks", DEFAULT_MMAP_BLOCKS));
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1fMiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (nAddressIndexFlags) {
+        LogPrintf("* Using %.1fMiB for address index database\n", nAddressIndexCache * (1.0 / 1024 / 1024));
+    }
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for recently used blocks\n", nBlockCache * (1.0 / 1024 / 1024));
 
     // ********************************************************* Step 8: start indexers
     // we need to do this here, because we relly on txindex during VerifyDb
@@ -1663,6 +1797,17 @@ bool AppInitMain()
         g_txindex = MakeUnique<TxIndex>(std::move(txindex_db));
     }
 
+    if (nAddressIndexFlags) {
+        auto addressindex_db = MakeUnique<AddressIndexDB>(nAddressIndexCache, false, fReindex);
+        uint32_t nStoredFlags;
+        if (addressindex_db->ReadIndexFlags(nStoredFlags) && nStoredFlags != nAddressIndexFlags) {
+            LogPrintf("Address index options changed, rebuilding the address index\n");
+            addressindex_db.reset();
+            addressindex_db = MakeUnique<AddressIndexDB>(nAddressIndexCache, false, true);
+        }
+        g_addressindex = MakeUnique<AddressIndex>(std::move(addressindex_db), nAddressIndexFlags);
+    }
+
     bool fLoaded = false;
     while (!fLoaded && !fRequestShutdown) {
         bool fReset = fReindex;
@@ -1747,6 +1892,23 @@ bool AppInitMain()
                 pcoinsTip.reset(new CCoinsViewCache(pcoinscatcher.get()));
 
                 bool is_coinsview_empty = fReset || fReindexChainState || pcoinsTip->GetBestBlock().IsNull();
+
+                bool fSnapshotLoading = false;
+                pblocktree->ReadFlag(UTXO_SNAPSHOT_LOADING_FLAG, fSnapshotLoading);
+                if (fSnapshotLoading && !is_coinsview_empty) {
+                    strLoadError = _("Loading a UTXO snapshot was interrupted. You will need to rebuild the database using -reindex-chainstate.");
+                    break;
+                }
+                if (is_coinsview_empty && gArgs.IsArgSet("-loadtxoutset")) {
+                    uiInterface.InitMessage(_("Loading UTXO snapshot..."));
+                    if (!LoadTxOutSetSnapshot(chainparams, strLoadError)) {
+                        break;
+                    }
+                    is_coinsview_empty = false;
+                } else if (fSnapshotLoading) {
+                    pblocktree->WriteFlag(UTXO_SNAPSHOT_LOADING_FLAG, false);
+                }
+
                 if (!is_coinsview_empty) {
                     // LoadChainTip sets chainActive based on pcoinsTip's best block
                     if (!LoadChainTip(chainparams)) {
@@ -1837,6 +1999,15 @@ bool AppInitMain()
         ::feeEstimator.Read(est_filein);
     fFeeEstimatesInitialized = true;
 
+    // Back-fill the tx index in the background if it was enabled on a node
+    // that already has (part of) the chain, instead of requiring -reindex.
+    if (g_txindex) {
+        g_txindex->Start();
+    }
+    if (g_addressindex) {
+        g_addressindex->Start();
+    }
+
 
     // ********************************************************* Step 9: load wallet
     if (!g_wallet_init_interface.Open()) return false;
@@ -1911,6 +2082,11 @@ bool AppInitMain()
 
     LoadExtensionsDataCaches();
 
+    if (!fLiteMode && gArgs.GetBoolArg("-masternoderegistry", DEFAULT_MASTERNODE_REGISTRY)) {
+        uiInterface.InitMessage(_("Loading masternode collaterals..."));
+        mnregistry.Start();
+    }
+
     // ********************************************************* Step 11c: update block tip in XSN modules
 
     // force UpdatedBlockTip to initialize nCachedBlockHeight for DS, MN payments and budgets
@@ -1921,6 +2097,10 @@ bool AppInitMain()
     // ********************************************************* Step 11d: start thread for xsn extensions
 
     threadGroup.create_thread(boost::bind(net_processing_xsn::ThreadProcessExtensions, g_connman.get()));
+    if (!fLiteMode) {
+        int nMsgThreads = std::max(0, std::min<int>(gArgs.GetArg("-xsnmsgthreads", DEFAULT_XSN_MSG_THREADS), MAX_XSN_MSG_THREADS));
+        net_processing_xsn::StartExtensionWorkers(nMsgThreads, g_connman.get());
+    }
 
     // ********************************************************* Step 12: start node
 
@@ -1956,6 +2136,7 @@ bool AppInitMain()
     connOptions.nSendBufferMaxSize = 1000*gArgs.GetArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER);
     connOptions.nReceiveFloodSize = 1000*gArgs.GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
     connOptions.m_added_nodes = gArgs.GetArgs("-addnode");
+    connOptions.socketEventsMode = socketEventsMode;
 
     connOptions.nMaxOutboundTimeframe = nMaxOutboundTimeframe;
     connOptions.nMaxOutboundLimit = nMaxOutboundLimit;
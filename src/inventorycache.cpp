@@ -0,0 +1,121 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <inventorycache.h>
+
+#include <utiltime.h>
+
+CRelayInventoryCache::CRelayInventoryCache(size_t nMaxBytesIn, int64_t nExpiryIn) :
+    nMaxShardBytes(nMaxBytesIn / RELAY_INV_CACHE_SHARDS),
+    nExpiry(nExpiryIn)
+{
+}
+
+CRelayInventoryCache::Shard& CRelayInventoryCache::GetShard(const CInv& inv)
+{
+    return shards[inv.hash.GetCheapHash() % RELAY_INV_CACHE_SHARDS];
+}
+
+void CRelayInventoryCache::Trim(Shard& shard, size_t nBytesWanted, int64_t nNow)
+{
+    while (!shard.deqOrder.empty()) {
+        auto it = shard.mapEntries.find(shard.deqOrder.front().second);
+        if (it != shard.mapEntries.end() && it->second.nSequence == shard.deqOrder.front().first) {
+            if (shard.nBytes <= nBytesWanted && it->second.nTimeExpire > nNow) break;
+            shard.nBytes -= EntryBytes(it->second);
+            shard.mapEntries.erase(it);
+        }
+        shard.deqOrder.pop_front();
+    }
+}
+
+void CRelayInventoryCache::Insert(const CInv& inv, int nVersion, const CSerializedNetMsg& msg)
+{
+    Entry entry{nVersion, msg.command, msg.data, 0, 0};
+    size_t nEntryBytes = EntryBytes(entry);
+    if (nEntryBytes > nMaxShardBytes) return;
+
+    Shard& shard = GetShard(inv);
+    int64_t nNow = GetTime();
+
+    LOCK(shard.cs);
+    auto it = shard.mapEntries.find(inv);
+    if (it != shard.mapEntries.end()) {
+        shard.nBytes -= EntryBytes(it->second);
+        shard.mapEntries.erase(it);
+    }
+    Trim(shard, nMaxShardBytes - nEntryBytes, nNow);
+
+    entry.nTimeExpire = nNow + nExpiry;
+    entry.nSequence = ++shard.nSequence;
+    shard.deqOrder.emplace_back(entry.nSequence, inv);
+    shard.nBytes += nEntryBytes;
+    shard.mapEntries.emplace(inv, std::move(entry));
+}
+
+bool CRelayInventoryCache::Get(const CInv& inv, int nVersion, CSerializedNetMsg& msgRet)
+{
+    Shard& shard = GetShard(inv);
+
+    LOCK(shard.cs);
+    auto it = shard.mapEntries.find(inv);
+    if (it == shard.mapEntries.end() || it->second.nVersion != nVersion || it->second.nTimeExpire <= GetTime()) {
+        return false;
+    }
+
+    msgRet.command = it->second.command;
+    msgRet.data = it->second.data;
+    return true;
+}
+
+bool CRelayInventoryCache::Contains(const CInv& inv)
+{
+    Shard& shard = GetShard(inv);
+
+    LOCK(shard.cs);
+    auto it = shard.mapEntries.find(inv);
+    return it != shard.mapEntries.end() && it->second.nTimeExpire > GetTime();
+}
+
+void CRelayInventoryCache::Erase(const CInv& inv)
+{
+    Shard& shard = GetShard(inv);
+
+    LOCK(shard.cs);
+    auto it = shard.mapEntries.find(inv);
+    if (it != shard.mapEntries.end()) {
+        shard.nBytes -= EntryBytes(it->second);
+        shard.mapEntries.erase(it);
+    }
+}
+
+void CRelayInventoryCache::Clear()
+{
+    for (Shard& shard : shards) {
+        LOCK(shard.cs);
+        shard.mapEntries.clear();
+        shard.deqOrder.clear();
+        shard.nBytes = 0;
+    }
+}
+
+size_t CRelayInventoryCache::Size()
+{
+    size_t nSize = 0;
+    for (Shard& shard : shards) {
+        LOCK(shard.cs);
+        nSize += shard.mapEntries.size();
+    }
+    return nSize;
+}
+
+size_t CRelayInventoryCache::GetTotalBytes()
+{
+    size_t nTotal = 0;
+    for (Shard& shard : shards) {
+        LOCK(shard.cs);
+        nTotal += shard.nBytes;
+    }
+    return nTotal;
+}
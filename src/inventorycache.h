@@ -0,0 +1,85 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INVENTORYCACHE_H
+#define BITCOIN_INVENTORYCACHE_H
+
+#include <net.h>
+#include <protocol.h>
+#include <sync.h>
+
+#include <array>
+#include <deque>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** Number of independently locked parts of the relay inventory cache */
+static const size_t RELAY_INV_CACHE_SHARDS = 16;
+/** Total size of cached messages the relay inventory cache keeps at most */
+static const size_t DEFAULT_RELAY_INV_CACHE_BYTES = 32 << 20;
+/** Seconds a message stays in the relay inventory cache, same as mapRelay for transactions */
+static const int64_t RELAY_INV_CACHE_TIME = 15 * 60;
+
+/**
+ * Serialized XSN inventory messages (masternode broadcasts and pings, payment
+ * votes, governance objects, sporks, InstantSend messages, ...) that were
+ * recently sent to a peer, keyed by inventory type and hash.
+ *
+ * Those objects are requested by most peers shortly after they are
+ * announced. Answering a getdata from here needs neither the owning
+ * manager's lock nor another serialization. Entries expire after
+ * RELAY_INV_CACHE_TIME, or earlier in insertion order when a shard runs
+ * out of space. The cache is split into shards by hash so concurrent
+ * lookups rarely meet on the same lock.
+ */
+class CRelayInventoryCache
+{
+public:
+    explicit CRelayInventoryCache(size_t nMaxBytesIn = DEFAULT_RELAY_INV_CACHE_BYTES, int64_t nExpiryIn = RELAY_INV_CACHE_TIME);
+
+    /** Remember msg as the answer to inv for peers with send version nVersion */
+    void Insert(const CInv& inv, int nVersion, const CSerializedNetMsg& msg);
+    /** Copy of the cached answer to inv, false if there is none for nVersion */
+    bool Get(const CInv& inv, int nVersion, CSerializedNetMsg& msgRet);
+    /** Whether there is a cached answer to inv for any version */
+    bool Contains(const CInv& inv);
+    void Erase(const CInv& inv);
+    void Clear();
+
+    size_t Size();
+    size_t GetTotalBytes();
+
+private:
+    struct Entry
+    {
+        int nVersion;
+        std::string command;
+        std::vector<unsigned char> data;
+        int64_t nTimeExpire;
+        uint64_t nSequence;
+    };
+
+    struct Shard
+    {
+        CCriticalSection cs;
+        std::map<CInv, Entry> mapEntries;
+        // (sequence, inventory) in insertion order, stale records are skipped when popped
+        std::deque<std::pair<uint64_t, CInv>> deqOrder;
+        size_t nBytes = 0;
+        uint64_t nSequence = 0;
+    };
+
+    const size_t nMaxShardBytes;
+    const int64_t nExpiry;
+    std::array<Shard, RELAY_INV_CACHE_SHARDS> shards;
+
+    Shard& GetShard(const CInv& inv);
+    /** Drop entries from the front of the shard until it is below nBytesWanted and nothing expired is left */
+    void Trim(Shard& shard, size_t nBytesWanted, int64_t nNow);
+    static size_t EntryBytes(const Entry& entry) { return entry.data.size() + entry.command.size(); }
+};
+
+#endif // BITCOIN_INVENTORYCACHE_H
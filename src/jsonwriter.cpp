@@ -0,0 +1,174 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <jsonwriter.h>
+
+#include <tinyformat.h>
+
+#include <assert.h>
+
+#include <univalue.h>
+
+JSONStreamWriter::JSONStreamWriter(FlushFn flushIn, size_t nFlushSizeIn) :
+    flush(flushIn),
+    nFlushSize(nFlushSizeIn),
+    fFlushed(false),
+    fAfterKey(false)
+{
+}
+
+void JSONStreamWriter::BeginValue()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!vFirst.empty()) {
+        if (!vFirst.back())
+            strBuffer += ',';
+        vFirst.back() = false;
+    }
+}
+
+void JSONStreamWriter::AppendString(const std::string& str)
+{
+    // Same escaping as UniValue's json_escape
+    strBuffer += '"';
+    for (unsigned char ch : str) {
+        switch (ch) {
+        case '"': strBuffer += "\\\""; break;
+        case '\\': strBuffer += "\\\\"; break;
+        case '\b': strBuffer += "\\b"; break;
+        case '\t': strBuffer += "\\t"; break;
+        case '\n': strBuffer += "\\n"; break;
+        case '\f': strBuffer += "\\f"; break;
+        case '\r': strBuffer += "\\r"; break;
+        default:
+            if (ch < 0x20 || ch == 0x7f)
+                strBuffer += strprintf("\\u%04x", (int)ch);
+            else
+                strBuffer += ch;
+        }
+    }
+    strBuffer += '"';
+}
+
+void JSONStreamWriter::MaybeFlush()
+{
+    if (flush && strBuffer.size() >= nFlushSize)
+        Flush();
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    BeginValue();
+    strBuffer += '{';
+    vFirst.push_back(true);
+}
+
+void JSONStreamWriter::EndObject()
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    vFirst.pop_back();
+    strBuffer += '}';
+    MaybeFlush();
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    BeginValue();
+    strBuffer += '[';
+    vFirst.push_back(true);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    vFirst.pop_back();
+    strBuffer += ']';
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Key(const std::string& key)
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    BeginValue();
+    AppendString(key);
+    strBuffer += ':';
+    fAfterKey = true;
+}
+
+void JSONStreamWriter::Null()
+{
+    BeginValue();
+    strBuffer += "null";
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Value(const std::string& val)
+{
+    BeginValue();
+    AppendString(val);
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Value(const char* val)
+{
+    Value(std::string(val));
+}
+
+void JSONStreamWriter::Value(bool val)
+{
+    BeginValue();
+    strBuffer += val ? "true" : "false";
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Value(int val)
+{
+    Value((int64_t)val);
+}
+
+void JSONStreamWriter::Value(int64_t val)
+{
+    BeginValue();
+    strBuffer += strprintf("%d", val);
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Value(uint64_t val)
+{
+    BeginValue();
+    strBuffer += strprintf("%u", val);
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Value(double val)
+{
+    // Let UniValue pick the representation, its float formatting is not
+    // something worth duplicating
+    Value(UniValue(val));
+}
+
+void JSONStreamWriter::Value(const UniValue& val)
+{
+    BeginValue();
+    strBuffer += val.write();
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Raw(const std::string& str)
+{
+    strBuffer += str;
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (!flush || strBuffer.empty())
+        return;
+    flush(strBuffer);
+    strBuffer.clear();
+    fFlushed = true;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_JSONWRITER_H
+#define BITCOIN_JSONWRITER_H
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class UniValue;
+
+/** Default number of buffered bytes after which JSONStreamWriter hands output to its sink */
+static const size_t DEFAULT_JSON_FLUSH_SIZE = 64 * 1024;
+
+/**
+ * Writes JSON as it is produced instead of building a UniValue tree first.
+ *
+ * Output matches UniValue::write() without indentation byte for byte, so a
+ * streamed result is indistinguishable from the UniValue one. Output is
+ * buffered and handed to the sink whenever the buffer grows past the flush
+ * size; without a sink everything stays in the buffer.
+ */
+class JSONStreamWriter
+{
+public:
+    typedef std::function<void(const std::string&)> FlushFn;
+
+    explicit JSONStreamWriter(FlushFn flushIn = nullptr, size_t nFlushSizeIn = DEFAULT_JSON_FLUSH_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write an object key. Must be followed by exactly one value. */
+    void Key(const std::string& key);
+
+    void Null();
+    void Value(const std::string& val);
+    void Value(const char* val);
+    void Value(bool val);
+    void Value(int val);
+    void Value(int64_t val);
+    void Value(uint64_t val);
+    void Value(double val);
+    /** Write an already built value, e.g. the result of ValueFromAmount */
+    void Value(const UniValue& val);
+
+    template <typename T>
+    void KV(const std::string& key, const T& val)
+    {
+        Key(key);
+        Value(val);
+    }
+
+    /** Append text outside of the JSON structure, such as a trailing newline */
+    void Raw(const std::string& str);
+
+    /** Hand everything buffered so far to the sink */
+    void Flush();
+
+    /** True once output has been handed to the sink */
+    bool HasFlushed() const { return fFlushed; }
+
+    /** Output not yet handed to the sink */
+    const std::string& GetBuffer() const { return strBuffer; }
+
+private:
+    FlushFn flush;
+    const size_t nFlushSize;
+    std::string strBuffer;
+    bool fFlushed;
+    /// Per open object/array: whether no element has been written yet
+    std::vector<bool> vFirst;
+    /// Whether the next value completes a key/value pair
+    bool fAfterKey;
+
+    void BeginValue();
+    void AppendString(const std::string& str);
+    void MaybeFlush();
+};
+
+#endif // BITCOIN_JSONWRITER_H
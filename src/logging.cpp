@@ -4,8 +4,12 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <logging.h>
+#include <util.h>
 #include <utiltime.h>
 
+#include <algorithm>
+#include <chrono>
+
 const char * const DEFAULT_DEBUGLOGFILE = "debug.log";
 
 /**
@@ -114,6 +118,16 @@ const CLogCategoryDesc LogCategories[] =
     {BCLog::ALL, "all"},
 };
 
+static std::string LogCategoryToStr(uint32_t flag)
+{
+    for (const CLogCategoryDesc& category_desc : LogCategories) {
+        if (category_desc.flag == flag) {
+            return category_desc.category;
+        }
+    }
+    return strprintf("0x%08x", flag);
+}
+
 bool GetLogCategory(BCLog::LogFlags& flag, const std::string& str)
 {
     if (str == "") {
@@ -233,10 +247,131 @@ void BCLog::Logger::RotateLogs()
     }
 }
 
-void BCLog::Logger::LogPrintStr(const std::string &str)
+void BCLog::Logger::SetRateLimit(int64_t nBytesPerSecond)
 {
-    std::string strTimestamped = LogTimestampStr(str);
+    m_rate_limit = std::max<int64_t>(0, nBytesPerSecond);
+}
+
+bool BCLog::Logger::CheckRateLimit(LogFlags category, size_t nBytes, std::string& strNotice)
+{
+    const int64_t nRateLimit = m_rate_limit.load(std::memory_order_relaxed);
+    if (nRateLimit == 0) {
+        return true;
+    }
+
+    // Messages logged under several categories count against the lowest one
+    size_t nBucket = LOG_RATE_LIMIT_BUCKETS - 1;
+    for (size_t i = 0; i + 1 < LOG_RATE_LIMIT_BUCKETS; i++) {
+        if (category & (1U << i)) {
+            nBucket = i;
+            break;
+        }
+    }
+
+    const int64_t nNow = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    const double dCapacity = nRateLimit * LOG_RATE_LIMIT_BURST_SECONDS;
+
+    std::lock_guard<std::mutex> scoped_lock(m_rate_limit_mutex);
+    RateLimitBucket& bucket = m_rate_limit_buckets[nBucket];
+    if (bucket.nLastRefillMicros == 0) {
+        bucket.dTokens = dCapacity;
+    } else {
+        bucket.dTokens = std::min(dCapacity, bucket.dTokens + (nNow - bucket.nLastRefillMicros) * 1e-6 * nRateLimit);
+    }
+    bucket.nLastRefillMicros = nNow;
+
+    if (bucket.dTokens < nBytes) {
+        bucket.nDroppedUnreported++;
+        m_dropped_rate_limit++;
+        return false;
+    }
+    bucket.dTokens -= nBytes;
 
+    if (bucket.nDroppedUnreported != 0) {
+        const std::string strCategory = nBucket + 1 < LOG_RATE_LIMIT_BUCKETS ? LogCategoryToStr(1U << nBucket) : "uncategorized";
+        strNotice = strprintf("Dropped %u log messages of category %s over the rate limit\n", bucket.nDroppedUnreported, strCategory);
+        bucket.nDroppedUnreported = 0;
+    }
+    return true;
+}
+
+void BCLog::Logger::LogPrintStr(const std::string &str, LogFlags category)
+{
+    std::string strNotice;
+    if (!CheckRateLimit(category, str.size(), strNotice)) {
+        return;
+    }
+    if (!strNotice.empty()) {
+        Output(LogTimestampStr(strNotice));
+    }
+    Output(LogTimestampStr(str));
+}
+
+void BCLog::Logger::Output(std::string&& str)
+{
+    if (m_async.load(std::memory_order_acquire)) {
+        if (!m_queue->TryPush(std::move(str))) {
+            m_dropped_queue_full++;
+        }
+        m_writer_cond.notify_one();
+        return;
+    }
+    WriteStr(str);
+}
+
+void BCLog::Logger::WriterThread()
+{
+    RenameThread("xsn-logger");
+    std::string str;
+    while (true) {
+        while (m_queue->TryPop(str)) {
+            WriteStr(str);
+        }
+        if (m_writer_stop) {
+            break;
+        }
+        // Producers notify without holding the mutex, the timeout bounds a missed wakeup
+        std::unique_lock<std::mutex> lock(m_writer_mutex);
+        m_writer_cond.wait_for(lock, std::chrono::milliseconds(100));
+    }
+}
+
+void BCLog::Logger::StartAsyncWriter()
+{
+    if (m_async) {
+        return;
+    }
+    if (!m_queue) {
+        m_queue.reset(new MPMCQueue<std::string>(LOG_QUEUE_SIZE));
+    }
+    m_writer_stop = false;
+    m_writer_thread = std::thread(&BCLog::Logger::WriterThread, this);
+    m_async.store(true, std::memory_order_release);
+}
+
+void BCLog::Logger::StopAsyncWriter()
+{
+    if (!m_async) {
+        return;
+    }
+    m_async = false;
+    m_writer_stop = true;
+    m_writer_cond.notify_one();
+    m_writer_thread.join();
+    // Messages queued while the writer was stopping
+    std::string str;
+    while (m_queue->TryPop(str)) {
+        WriteStr(str);
+    }
+}
+
+BCLog::Logger::Stats BCLog::Logger::GetStats() const
+{
+    return Stats{m_dropped_rate_limit.load(), m_dropped_queue_full.load()};
+}
+
+void BCLog::Logger::WriteStr(const std::string &strTimestamped)
+{
     if (m_print_to_console) {
         // print to console
         fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
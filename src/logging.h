@@ -7,18 +7,30 @@
 #define BITCOIN_LOGGING_H
 
 #include <fs.h>
+#include <mpmcqueue.h>
 #include <tinyformat.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
+/** Default for -logasync */
+static const bool DEFAULT_LOGASYNC      = true;
+/** Default for -logratelimit, in KiB per second and category */
+static const int64_t DEFAULT_LOGRATELIMIT = 1024;
+/** Seconds worth of the rate limit a category can log in a burst */
+static const int64_t LOG_RATE_LIMIT_BURST_SECONDS = 10;
+/** Messages the asynchronous writer can fall behind before new ones are dropped */
+static const size_t LOG_QUEUE_SIZE = 16384;
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -65,13 +77,51 @@ namespace BCLog {
         ALL          = ~(uint32_t)0,
     };
 
+    /** Number of rate limit buckets: one per category bit and one for uncategorized messages */
+    static const size_t LOG_RATE_LIMIT_BUCKETS = 33;
+
     class Logger
     {
+    public:
+        struct Stats
+        {
+            uint64_t nDroppedRateLimit;
+            uint64_t nDroppedQueueFull;
+        };
+
     private:
         FILE* m_fileout = nullptr;
         std::mutex m_file_mutex;
         std::list<std::string> m_msgs_before_open;
 
+        /** Token bucket limiting the bytes a category logs */
+        struct RateLimitBucket
+        {
+            double dTokens = 0;
+            int64_t nLastRefillMicros = 0;
+            uint64_t nDroppedUnreported = 0;
+        };
+
+        std::mutex m_rate_limit_mutex;
+        RateLimitBucket m_rate_limit_buckets[LOG_RATE_LIMIT_BUCKETS];
+        /** Bytes per second and category, 0 for no limit */
+        std::atomic<int64_t> m_rate_limit{0};
+        std::atomic<uint64_t> m_dropped_rate_limit{0};
+
+        /**
+         * Asynchronous writing: messages are pushed into a lock-free queue and
+         * written by a background thread, so a slow disk or console never
+         * stalls the thread that logs. Messages are dropped when the writer
+         * falls too far behind.
+         */
+        std::unique_ptr<MPMCQueue<std::string>> m_queue;
+        std::atomic<bool> m_async{false};
+        std::atomic<bool> m_writer_stop{false};
+        std::thread m_writer_thread;
+        std::mutex m_writer_mutex;
+        std::condition_variable m_writer_cond;
+        std::atomic<uint64_t> m_dropped_queue_full{0};
+
         /**
          * m_started_new_line is a state variable that will suppress printing of
          * the timestamp when multiple calls are made that don't end in a
@@ -86,6 +136,14 @@ namespace BCLog {
         bool OpenDebugLogHelper();
         void RotateLogs();
 
+        /** Whether a message of nBytes fits the category's rate limit, sets strNotice when earlier messages were dropped */
+        bool CheckRateLimit(LogFlags category, size_t nBytes, std::string& strNotice);
+        /** Queue or write a timestamped message */
+        void Output(std::string&& str);
+        /** Write a timestamped message to the console and debug log */
+        void WriteStr(const std::string& str);
+        void WriterThread();
+
     public:
         bool m_print_to_console = false;
         bool m_print_to_file = false;
@@ -97,7 +155,17 @@ namespace BCLog {
         std::atomic<bool> m_reopen_file{false};
 
         /** Send a string to the log output */
-        void LogPrintStr(const std::string &str);
+        void LogPrintStr(const std::string &str, LogFlags category = BCLog::NONE);
+
+        /** Start writing from a background thread, see -logasync */
+        void StartAsyncWriter();
+        /** Write out all queued messages and go back to writing on the calling thread */
+        void StopAsyncWriter();
+
+        /** Limit every category to nBytesPerSecond, 0 removes the limit */
+        void SetRateLimit(int64_t nBytesPerSecond);
+
+        Stats GetStats() const;
 
         /** Returns whether logs will be written to any output */
         bool Enabled() const { return m_print_to_console || m_print_to_file; }
@@ -154,7 +222,7 @@ template<typename T, typename... Args> static inline void MarkUsed(const T& t, c
 #define LogPrintf(...) do { MarkUsed(__VA_ARGS__); } while(0)
 #define LogPrint(category, ...) do { MarkUsed(__VA_ARGS__); } while(0)
 #else
-#define LogPrintf(...) do { \
+#define LogPrintCategory(category, ...) do { \
     if (g_logger->Enabled()) { \
         std::string _log_msg_; /* Unlikely name to avoid shadowing variables */ \
         try { \
@@ -163,13 +231,15 @@ template<typename T, typename... Args> static inline void MarkUsed(const T& t, c
             /* Original format string will have newline so don't add one here */ \
             _log_msg_ = "Error \"" + std::string(fmterr.what()) + "\" while formatting log message: " + FormatStringFromLogArgs(__VA_ARGS__); \
         } \
-        g_logger->LogPrintStr(_log_msg_); \
+        g_logger->LogPrintStr(_log_msg_, (category)); \
     } \
 } while(0)
 
+#define LogPrintf(...) LogPrintCategory(BCLog::NONE, __VA_ARGS__)
+
 #define LogPrint(category, ...) do { \
     if (LogAcceptCategory((category))) { \
-        LogPrintf(__VA_ARGS__); \
+        LogPrintCategory((category), __VA_ARGS__); \
     } \
 } while(0)
 #endif
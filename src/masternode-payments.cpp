@@ -23,7 +23,9 @@ CMasternodePayments mnpayments;
 
 CCriticalSection cs_vecPayees;
 CCriticalSection cs_mapMasternodeBlocks;
-static CCriticalSection cs_mapMasternodePaymentVotes;
+static CCriticalSection cs_mapMasternodesLastVote;
+
+const std::string CMasternodePayments::SERIALIZATION_VERSION_STRING = "CMasternodePayments-Version-2";
 
 static std::pair<CAmount, std::string> HardForkPayment()
 {
@@ -322,14 +324,13 @@ std::string GetRequiredPaymentsString(int nBlockHeight)
 
 void CMasternodePayments::Clear()
 {
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
-    mapMasternodeBlocks.clear();
-    mapMasternodePaymentVotes.clear();
+    LOCK(cs_mapMasternodeBlocks);
+    paymentStore.Clear();
 }
 
 bool CMasternodePayments::CanVote(COutPoint outMasternode, int nBlockHeight)
 {
-    LOCK(cs_mapMasternodePaymentVotes);
+    LOCK(cs_mapMasternodesLastVote);
 
     if (mapMasternodesLastVote.count(outMasternode) && mapMasternodesLastVote[outMasternode] == nBlockHeight) {
         return false;
@@ -418,31 +419,33 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
 
         uint256 nHash = vote.GetHash();
 
-        pfrom->setAskFor.erase(nHash);
+        pfrom->RemoveAskFor(nHash);
 
         // TODO: clear setAskFor for MSG_MASTERNODE_PAYMENT_BLOCK too
 
         // Ignore any payments messages until masternode list is synced
         if(!masternodeSync.IsMasternodeListSynced()) return;
 
+        // Only votes within the stored range get a bucket, check it before remembering the vote
+        int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
+        if(vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > nCachedBlockHeight+20) {
+            LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, nCachedBlockHeight);
+            return;
+        }
+
         {
-            LOCK(cs_mapMasternodePaymentVotes);
-            if(mapMasternodePaymentVotes.count(nHash)) {
+            LOCK(cs_mapMasternodeBlocks);
+            if(paymentStore.GetVote(nHash)) {
                 LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- hash=%s, nHeight=%d seen\n", nHash.ToString(), nCachedBlockHeight);
                 return;
             }
 
             // Avoid processing same vote multiple times
-            mapMasternodePaymentVotes[nHash] = vote;
             // but first mark vote as non-verified,
             // AddPaymentVote() below should take care of it if vote is actually ok
-            mapMasternodePaymentVotes[nHash].MarkAsNotVerified();
-        }
-
-        int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
-        if(vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > nCachedBlockHeight+20) {
-            LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, nCachedBlockHeight);
-            return;
+            CMasternodePaymentVote voteSeen = vote;
+            voteSeen.MarkAsNotVerified();
+            paymentStore.AddVote(voteSeen, GetStorageLimit() + 21);
         }
 
         std::string strError = "";
@@ -517,11 +520,24 @@ bool CMasternodePaymentVote::Sign()
 
 bool CMasternodePayments::GetBlockPayee(int nBlockHeight, CScript& payee)
 {
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].GetBestPayee(payee);
-    }
+    LOCK(cs_mapMasternodeBlocks);
 
-    return false;
+    const CMasternodeBlockPayees* pPayees = paymentStore.GetPayees(nBlockHeight);
+    return pPayees && pPayees->GetBestPayee(payee);
+}
+
+bool CMasternodePayments::HasBlockPayees(int nBlockHeight)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return paymentStore.GetPayees(nBlockHeight) != nullptr;
+}
+
+bool CMasternodePayments::HasPayeeWithVotes(int nBlockHeight, const CScript& payee, int nVotesReq)
+{
+    LOCK(cs_mapMasternodeBlocks);
+
+    const CMasternodeBlockPayees* pPayees = paymentStore.GetPayees(nBlockHeight);
+    return pPayees && pPayees->HasPayeeWithVotes(payee, nVotesReq);
 }
 
 // Is this masternode scheduled to get paid soon?
@@ -536,9 +552,10 @@ bool CMasternodePayments::IsScheduled(const CMasternode& mn, int nNotBlockHeight
     mnpayee = GetScriptForDestination(mn.pubKeyCollateralAddress.GetID());
 
     CScript payee;
-    for(int64_t h = nCachedBlockHeight; h <= nCachedBlockHeight + 8; h++){
+    for(int h = nCachedBlockHeight; h <= nCachedBlockHeight + 8; h++){
         if(h == nNotBlockHeight) continue;
-        if(mapMasternodeBlocks.count(h) && mapMasternodeBlocks.at(h).GetBestPayee(payee) && mnpayee == payee) {
+        const CMasternodeBlockPayees* pPayees = paymentStore.GetPayees(h);
+        if(pPayees && pPayees->GetBestPayee(payee) && mnpayee == payee) {
             return true;
         }
     }
@@ -553,25 +570,50 @@ bool CMasternodePayments::AddPaymentVote(const CMasternodePaymentVote& vote)
 
     if(HasVerifiedPaymentVote(vote.GetHash())) return false;
 
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+    LOCK(cs_mapMasternodeBlocks);
 
-    mapMasternodePaymentVotes[vote.GetHash()] = vote;
+    if(!paymentStore.AddVote(vote, GetStorageLimit() + 21)) return false;
+    paymentStore.AddPayee(vote);
 
-    if(!mapMasternodeBlocks.count(vote.nBlockHeight)) {
-        CMasternodeBlockPayees blockPayees(vote.nBlockHeight);
-        mapMasternodeBlocks[vote.nBlockHeight] = blockPayees;
-    }
+    return true;
+}
+
+bool CMasternodePayments::HasPaymentVote(const uint256& hashIn)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return paymentStore.GetVote(hashIn) != nullptr;
+}
+
+bool CMasternodePayments::HasVerifiedPaymentVote(uint256 hashIn)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    const CMasternodePaymentVote* pVote = paymentStore.GetVote(hashIn);
+    return pVote && pVote->IsVerified();
+}
 
-    mapMasternodeBlocks[vote.nBlockHeight].AddPayee(vote);
+bool CMasternodePayments::GetPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet)
+{
+    LOCK(cs_mapMasternodeBlocks);
+
+    const CMasternodePaymentVote* pVote = paymentStore.GetVote(hashIn);
+    if(!pVote || !pVote->IsVerified()) return false;
 
+    voteRet = *pVote;
     return true;
 }
 
-bool CMasternodePayments::HasVerifiedPaymentVote(uint256 hashIn)
+bool CMasternodePayments::GetBlockPaymentVotes(int nBlockHeight, std::vector<CMasternodePaymentVote>& vecVotesRet)
 {
-    LOCK(cs_mapMasternodePaymentVotes);
-    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.find(hashIn);
-    return it != mapMasternodePaymentVotes.end() && it->second.IsVerified();
+    LOCK(cs_mapMasternodeBlocks);
+
+    vecVotesRet.clear();
+    const CMasternodePaymentStore::Bucket* pBucket = paymentStore.GetBucket(nBlockHeight);
+    if(!pBucket) return false;
+
+    for(const CMasternodePaymentVote& vote : pBucket->vecVotes) {
+        if(vote.IsVerified()) vecVotesRet.push_back(vote);
+    }
+    return !vecVotesRet.empty();
 }
 
 void CMasternodeBlockPayees::AddPayee(const CMasternodePaymentVote& vote)
@@ -687,12 +729,143 @@ std::string CMasternodeBlockPayees::GetRequiredPaymentsString() const
     return strRequiredPayments;
 }
 
+void CMasternodePaymentStore::Clear()
+{
+    nFirstHeight = 0;
+    deqBuckets.clear();
+    mapVoteIndex.clear();
+    nBlockCount = 0;
+}
+
+bool CMasternodePaymentStore::AddVote(const CMasternodePaymentVote& vote, int nMaxHeights)
+{
+    const int nHeight = vote.nBlockHeight;
+
+    if(deqBuckets.empty()) {
+        nFirstHeight = nHeight;
+        deqBuckets.emplace_back(nHeight);
+    } else if(nHeight < nFirstHeight) {
+        if(GetLastHeight() - nHeight >= nMaxHeights) return false;
+        while(nFirstHeight > nHeight) {
+            deqBuckets.emplace_front(--nFirstHeight);
+        }
+    } else if(nHeight > GetLastHeight()) {
+        while(!deqBuckets.empty() && nHeight - nFirstHeight >= nMaxHeights) {
+            PopFront();
+        }
+        if(deqBuckets.empty()) {
+            nFirstHeight = nHeight;
+        }
+        while(GetLastHeight() < nHeight) {
+            deqBuckets.emplace_back(GetLastHeight() + 1);
+        }
+    }
+
+    Bucket& bucket = deqBuckets[nHeight - nFirstHeight];
+    const uint256 hash = vote.GetHash();
+
+    auto it = mapVoteIndex.find(hash);
+    if(it != mapVoteIndex.end()) {
+        bucket.vecVotes[it->second.second] = vote;
+        return true;
+    }
+
+    mapVoteIndex.emplace(hash, std::make_pair(nHeight, (uint32_t)bucket.vecVotes.size()));
+    bucket.vecVotes.push_back(vote);
+    return true;
+}
+
+void CMasternodePaymentStore::AddPayee(const CMasternodePaymentVote& vote)
+{
+    Bucket* pBucket = FindBucket(vote.nBlockHeight);
+    if(!pBucket) return;
+
+    if(pBucket->payees.vecPayees.empty()) nBlockCount++;
+    pBucket->payees.AddPayee(vote);
+}
+
+void CMasternodePaymentStore::Prune(int nMinHeight)
+{
+    while(!deqBuckets.empty() && nFirstHeight < nMinHeight) {
+        LogPrint(BCLog::MNPAYMENTS, "CMasternodePaymentStore::Prune -- Removing old Masternode payments: nBlockHeight=%d, votes=%d\n",
+                 nFirstHeight, deqBuckets.front().vecVotes.size());
+        PopFront();
+    }
+}
+
+void CMasternodePaymentStore::PopFront()
+{
+    const Bucket& bucket = deqBuckets.front();
+    for(const CMasternodePaymentVote& vote : bucket.vecVotes) {
+        mapVoteIndex.erase(vote.GetHash());
+    }
+    if(!bucket.payees.vecPayees.empty()) nBlockCount--;
+
+    deqBuckets.pop_front();
+    nFirstHeight++;
+}
+
+void CMasternodePaymentStore::RebuildIndex()
+{
+    mapVoteIndex.clear();
+    nBlockCount = 0;
+
+    for(size_t i = 0; i < deqBuckets.size(); i++) {
+        const Bucket& bucket = deqBuckets[i];
+        for(size_t j = 0; j < bucket.vecVotes.size(); j++) {
+            mapVoteIndex.emplace(bucket.vecVotes[j].GetHash(), std::make_pair(nFirstHeight + (int)i, (uint32_t)j));
+        }
+        if(!bucket.payees.vecPayees.empty()) nBlockCount++;
+    }
+}
+
+const CMasternodePaymentVote* CMasternodePaymentStore::GetVote(const uint256& hash) const
+{
+    auto it = mapVoteIndex.find(hash);
+    if(it == mapVoteIndex.end()) return nullptr;
+
+    return &GetBucket(it->second.first)->vecVotes[it->second.second];
+}
+
+const CMasternodePaymentStore::Bucket* CMasternodePaymentStore::GetBucket(int nBlockHeight) const
+{
+    if(deqBuckets.empty() || nBlockHeight < nFirstHeight || nBlockHeight > GetLastHeight()) return nullptr;
+    return &deqBuckets[nBlockHeight - nFirstHeight];
+}
+
+CMasternodePaymentStore::Bucket* CMasternodePaymentStore::FindBucket(int nBlockHeight)
+{
+    if(deqBuckets.empty() || nBlockHeight < nFirstHeight || nBlockHeight > GetLastHeight()) return nullptr;
+    return &deqBuckets[nBlockHeight - nFirstHeight];
+}
+
+const CMasternodeBlockPayees* CMasternodePaymentStore::GetPayees(int nBlockHeight) const
+{
+    const Bucket* pBucket = GetBucket(nBlockHeight);
+    if(!pBucket || pBucket->payees.vecPayees.empty()) return nullptr;
+    return &pBucket->payees;
+}
+
+bool CMasternodePayments::GetBlockPayees(int nBlockHeight, CMasternodeBlockPayees& payeesRet)
+{
+    LOCK2(cs_mapMasternodeBlocks, cs_vecPayees);
+
+    const CMasternodeBlockPayees* pPayees = paymentStore.GetPayees(nBlockHeight);
+    if (!pPayees) {
+        return false;
+    }
+
+    payeesRet = *pPayees;
+    return true;
+}
+
 std::string CMasternodePayments::GetRequiredPaymentsString(int nBlockHeight)
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].GetRequiredPaymentsString();
+    const CMasternodeBlockPayees* pPayees = paymentStore.GetPayees(nBlockHeight);
+    if(pPayees){
+        return pPayees->GetRequiredPaymentsString();
     }
 
     return "Unknown";
@@ -702,8 +875,9 @@ bool CMasternodePayments::IsTransactionValid(const CTransactionRef& txNew, int n
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].IsTransactionValid(txNew);
+    const CMasternodeBlockPayees* pPayees = paymentStore.GetPayees(nBlockHeight);
+    if(pPayees){
+        return pPayees->IsTransactionValid(txNew);
     }
 
     return true;
@@ -713,22 +887,10 @@ void CMasternodePayments::CheckAndRemove()
 {
     if(!masternodeSync.IsBlockchainSynced()) return;
 
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
-
-    int nLimit = GetStorageLimit();
+    LOCK(cs_mapMasternodeBlocks);
 
-    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.begin();
-    while(it != mapMasternodePaymentVotes.end()) {
-        CMasternodePaymentVote vote = (*it).second;
+    paymentStore.Prune(nCachedBlockHeight - GetStorageLimit());
 
-        if(nCachedBlockHeight - vote.nBlockHeight > nLimit) {
-            LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::CheckAndRemove -- Removing old Masternode payment: nBlockHeight=%d\n", vote.nBlockHeight);
-            mapMasternodePaymentVotes.erase(it++);
-            mapMasternodeBlocks.erase(vote.nBlockHeight);
-        } else {
-            ++it;
-        }
-    }
     LogPrintf("CMasternodePayments::CheckAndRemove -- %s\n", ToString());
 }
 
@@ -868,27 +1030,21 @@ void CMasternodePayments::CheckPreviousBlockVotes(int nPrevBlockHeight)
         return;
     }
 
-    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodesLastVote);
+
+    const CMasternodePaymentStore::Bucket* pBucket = paymentStore.GetBucket(nPrevBlockHeight);
 
     for (int i = 0; i < MNPAYMENTS_SIGNATURES_TOTAL && i < (int)mns.size(); i++) {
         auto mn = mns[i];
         CScript payee;
         bool found = false;
 
-        if (mapMasternodeBlocks.count(nPrevBlockHeight)) {
-            for (auto &p : mapMasternodeBlocks[nPrevBlockHeight].vecPayees) {
-                for (auto &voteHash : p.GetVoteHashes()) {
-                    if (!mapMasternodePaymentVotes.count(voteHash)) {
-                        debugStr += strprintf("CMasternodePayments::CheckPreviousBlockVotes --   could not find vote %s\n",
-                                              voteHash.ToString());
-                        continue;
-                    }
-                    auto vote = mapMasternodePaymentVotes[voteHash];
-                    if (vote.vinMasternode.prevout == mn.second.vin.prevout) {
-                        payee = vote.payee;
-                        found = true;
-                        break;
-                    }
+        if (pBucket) {
+            for (const auto &vote : pBucket->vecVotes) {
+                if (vote.IsVerified() && vote.vinMasternode.prevout == mn.second.vin.prevout) {
+                    payee = vote.payee;
+                    found = true;
+                    break;
                 }
             }
         }
@@ -974,15 +1130,12 @@ void CMasternodePayments::Sync(CNode* pnode, CConnman& connman)
     int nInvCount = 0;
 
     for(int h = nCachedBlockHeight; h < nCachedBlockHeight + 20; h++) {
-        if(mapMasternodeBlocks.count(h)) {
-            for(CMasternodePayee& payee : mapMasternodeBlocks[h].vecPayees) {
-                std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
-                for(const uint256& hash : vecVoteHashes) {
-                    if(!HasVerifiedPaymentVote(hash)) continue;
-                    pnode->PushInventory(CInv(MSG_MASTERNODE_PAYMENT_VOTE, hash));
-                    nInvCount++;
-                }
-            }
+        const CMasternodePaymentStore::Bucket* pBucket = paymentStore.GetBucket(h);
+        if(!pBucket) continue;
+        for(const CMasternodePaymentVote& vote : pBucket->vecVotes) {
+            if(!vote.IsVerified()) continue;
+            pnode->PushInventory(CInv(MSG_MASTERNODE_PAYMENT_VOTE, vote.GetHash()));
+            nInvCount++;
         }
     }
 
@@ -1003,7 +1156,7 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
     const CBlockIndex *pindex = chainActive.Tip();
 
     while(nCachedBlockHeight - pindex->nHeight < nLimit) {
-        if(!mapMasternodeBlocks.count(pindex->nHeight)) {
+        if(!paymentStore.GetPayees(pindex->nHeight)) {
             // We have no idea about this block height, let's ask
             vToFetch.push_back(CInv(MSG_MASTERNODE_PAYMENT_BLOCK, pindex->GetBlockHash()));
             // We should not violate GETDATA rules
@@ -1018,12 +1171,14 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
         pindex = pindex->pprev;
     }
 
-    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.begin();
-
-    while(it != mapMasternodeBlocks.end()) {
+    // Only heights within the storage limit that already have payees, missing ones were requested above
+    int nLastHeight = std::min(paymentStore.GetLastHeight(), nCachedBlockHeight);
+    for(int h = std::max(paymentStore.GetFirstHeight(), nCachedBlockHeight - nLimit); h <= nLastHeight; h++) {
+        const CMasternodeBlockPayees* pPayees = paymentStore.GetPayees(h);
+        if(!pPayees) continue;
         int nTotalVotes = 0;
         bool fFound = false;
-        for(const CMasternodePayee& payee : it->second.vecPayees) {
+        for(const CMasternodePayee& payee : pPayees->vecPayees) {
             if(payee.GetVoteCount() >= MNPAYMENTS_SIGNATURES_REQUIRED) {
                 fFound = true;
                 break;
@@ -1034,21 +1189,20 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
         // or no clear winner was found but there are at least avg number of votes
         if(fFound || nTotalVotes >= (MNPAYMENTS_SIGNATURES_TOTAL + MNPAYMENTS_SIGNATURES_REQUIRED)/2) {
             // so just move to the next block
-            ++it;
             continue;
         }
         // DEBUG
         // Let's see why this failed
-        for(const CMasternodePayee& payee : it->second.vecPayees) {
+        for(const CMasternodePayee& payee : pPayees->vecPayees) {
             CTxDestination address1;
             ExtractDestination(payee.GetPayee(), address1);
             LogPrint(BCLog::MNPAYMENTS, "payee %s votes %d\n", EncodeDestination(address1), payee.GetVoteCount());
         }
-        LogPrint(BCLog::MNPAYMENTS, "block %d votes total %d\n", it->first, nTotalVotes);
+        LogPrint(BCLog::MNPAYMENTS, "block %d votes total %d\n", h, nTotalVotes);
         // END DEBUG
         // Low data block found, let's try to sync it
         uint256 hash;
-        if(GetBlockHash(hash, it->first)) {
+        if(GetBlockHash(hash, h)) {
             vToFetch.push_back(CInv(MSG_MASTERNODE_PAYMENT_BLOCK, hash));
         }
         // We should not violate GETDATA rules
@@ -1058,7 +1212,6 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
             // Start filling new batch
             vToFetch.clear();
         }
-        ++it;
     }
     // Ask for the rest of it
     if(!vToFetch.empty()) {
@@ -1071,8 +1224,8 @@ std::string CMasternodePayments::ToString() const
 {
     std::ostringstream info;
 
-    info << "Votes: " << (int)mapMasternodePaymentVotes.size() <<
-            ", Blocks: " << (int)mapMasternodeBlocks.size();
+    info << "Votes: " << paymentStore.GetVoteCount() <<
+            ", Blocks: " << paymentStore.GetBlockCount();
 
     return info.str();
 }
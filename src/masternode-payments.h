@@ -12,6 +12,8 @@
 #include <net_processing.h>
 #include <utilstrencodings.h>
 
+#include <deque>
+
 class CMasternodePayments;
 class CMasternodePaymentVote;
 class CMasternodeBlockPayees;
@@ -155,12 +157,106 @@ public:
     bool IsValid(CNode* pnode, int nValidationHeight, std::string& strError, CConnman& connman);
     void Relay(CConnman& connman);
 
-    bool IsVerified() { return !vchSig.empty(); }
+    bool IsVerified() const { return !vchSig.empty(); }
     void MarkAsNotVerified() { vchSig.clear(); }
 
     std::string ToString() const;
 };
 
+//
+// Payment votes grouped by block height
+//
+// Heights are kept as consecutive buckets starting at nFirstHeight, each one
+// holding the payees of that block next to the votes cast for it. Old heights
+// are dropped from the front of the ring, so pruning never has to look at
+// the votes themselves, and ranges of heights can be walked without touching
+// the rest of the store. A hash index points at each vote for single lookups.
+//
+
+class CMasternodePaymentStore
+{
+public:
+    struct Bucket
+    {
+        CMasternodeBlockPayees payees;
+        std::vector<CMasternodePaymentVote> vecVotes;
+
+        Bucket() {}
+        Bucket(int nBlockHeightIn) : payees(nBlockHeightIn), vecVotes() {}
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action) {
+            READWRITE(payees);
+            READWRITE(vecVotes);
+        }
+    };
+
+private:
+    int nFirstHeight;
+    std::deque<Bucket> deqBuckets;
+    // vote hash -> (block height, position in that bucket's vecVotes)
+    std::map<uint256, std::pair<int, uint32_t>> mapVoteIndex;
+    // number of buckets with at least one payee
+    int nBlockCount;
+
+public:
+    CMasternodePaymentStore() : nFirstHeight(0), deqBuckets(), mapVoteIndex(), nBlockCount(0) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << nFirstHeight;
+        WriteCompactSize(s, deqBuckets.size());
+        for (const Bucket& bucket : deqBuckets) {
+            s << bucket;
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        Clear();
+        s >> nFirstHeight;
+        uint64_t nBuckets = ReadCompactSize(s);
+        for (uint64_t i = 0; i < nBuckets; i++) {
+            deqBuckets.emplace_back();
+            s >> deqBuckets.back();
+        }
+        RebuildIndex();
+    }
+
+    void Clear();
+
+    /**
+     * Store vote in the bucket of its height, replacing an earlier copy with the same hash.
+     * The store never spans more than nMaxHeights heights: buckets at the old end are
+     * dropped to make room for newer heights, and votes older than the span are refused.
+     */
+    bool AddVote(const CMasternodePaymentVote& vote, int nMaxHeights);
+    /// Count vote for its payee, vote must have been stored with AddVote first
+    void AddPayee(const CMasternodePaymentVote& vote);
+    /// Drop all heights below nMinHeight
+    void Prune(int nMinHeight);
+
+    const CMasternodePaymentVote* GetVote(const uint256& hash) const;
+    /// Bucket for nBlockHeight, nullptr if that height is not stored
+    const Bucket* GetBucket(int nBlockHeight) const;
+    /// Payees for nBlockHeight, nullptr unless there is at least one
+    const CMasternodeBlockPayees* GetPayees(int nBlockHeight) const;
+
+    int GetFirstHeight() const { return nFirstHeight; }
+    int GetLastHeight() const { return nFirstHeight + (int)deqBuckets.size() - 1; }
+    int GetBlockCount() const { return nBlockCount; }
+    int GetVoteCount() const { return mapVoteIndex.size(); }
+
+private:
+    Bucket* FindBucket(int nBlockHeight);
+    void PopFront();
+    void RebuildIndex();
+};
+
 //
 // Masternode Payments Class
 // Keeps track of who should get paid for which blocks
@@ -177,26 +273,48 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    // Votes and payees by height, guarded by cs_mapMasternodeBlocks
+    CMasternodePaymentStore paymentStore;
+
 public:
-    std::map<uint256, CMasternodePaymentVote> mapMasternodePaymentVotes;
-    std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
+    static const std::string SERIALIZATION_VERSION_STRING;
+
     std::map<COutPoint, int> mapMasternodesLastVote;
     std::map<COutPoint, int> mapMasternodesDidNotVote;
 
-    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000) {}
+    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000), nCachedBlockHeight(0) {}
 
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(mapMasternodePaymentVotes);
-        READWRITE(mapMasternodeBlocks);
+        LOCK(cs_mapMasternodeBlocks);
+        std::string strVersion;
+        if(ser_action.ForRead()) {
+            READWRITE(strVersion);
+            // files written before the height buckets hold plain vote and block maps
+            if(strVersion != SERIALIZATION_VERSION_STRING) {
+                Clear();
+                return;
+            }
+        }
+        else {
+            strVersion = SERIALIZATION_VERSION_STRING;
+            READWRITE(strVersion);
+        }
+
+        READWRITE(paymentStore);
     }
 
     void Clear();
 
     bool AddPaymentVote(const CMasternodePaymentVote& vote);
+    bool HasPaymentVote(const uint256& hashIn);
     bool HasVerifiedPaymentVote(uint256 hashIn);
+    /// Copy of the verified vote with hash hashIn
+    bool GetPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet);
+    /// Copies of all verified votes for nBlockHeight
+    bool GetBlockPaymentVotes(int nBlockHeight, std::vector<CMasternodePaymentVote>& vecVotesRet);
     bool ProcessBlock(int nBlockHeight, CConnman& connman);
     void CheckPreviousBlockVotes(int nPrevBlockHeight);
 
@@ -205,6 +323,10 @@ public:
     void CheckAndRemove();
 
     bool GetBlockPayee(int nBlockHeight, CScript& payee);
+    bool HasBlockPayees(int nBlockHeight);
+    bool HasPayeeWithVotes(int nBlockHeight, const CScript& payee, int nVotesReq);
+    /// Copy of the payee votes recorded for nBlockHeight, false if there are none
+    bool GetBlockPayees(int nBlockHeight, CMasternodeBlockPayees& payeesRet);
     bool IsTransactionValid(const CTransactionRef &txNew, int nBlockHeight);
     bool IsScheduled(const CMasternode &mn, int nNotBlockHeight) const;
 
@@ -216,8 +338,8 @@ public:
     void FillBlockPayee(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutMasternodeRet);
     std::string ToString() const;
 
-    int GetBlockCount() { return mapMasternodeBlocks.size(); }
-    int GetVoteCount() { return mapMasternodePaymentVotes.size(); }
+    int GetBlockCount() { LOCK(cs_mapMasternodeBlocks); return paymentStore.GetBlockCount(); }
+    int GetVoteCount() { LOCK(cs_mapMasternodeBlocks); return paymentStore.GetVoteCount(); }
 
     bool IsEnoughData();
     int GetStorageLimit();
@@ -0,0 +1,204 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-registry.h>
+
+#include <chain.h>
+#include <masternode.h>
+#include <txdb.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+CMasternodeRegistry mnregistry;
+
+CMasternodeRegistry::CMasternodeRegistry() :
+    pindexBest(nullptr),
+    fRegistered(false)
+{}
+
+void CMasternodeRegistry::Start()
+{
+    // Registered before the scan, so that every block connected after the
+    // snapshot is announced to us
+    if (!fRegistered) {
+        RegisterValidationInterface(this);
+        fRegistered = true;
+    }
+    Rebuild();
+}
+
+void CMasternodeRegistry::Stop()
+{
+    if (fRegistered) {
+        UnregisterValidationInterface(this);
+        fRegistered = false;
+    }
+}
+
+bool CMasternodeRegistry::IsRunning() const
+{
+    return fRegistered;
+}
+
+bool CMasternodeRegistry::Rebuild()
+{
+    int64_t nStart = GetTimeMillis();
+
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    const CBlockIndex* pindexScan;
+    {
+        LOCK(cs_main);
+        // Write out the cache so the cursor sees the current tip. The cursor
+        // reads from a snapshot of the database, which stays at this block.
+        FlushStateToDisk();
+        pcursor.reset(pcoinsdbview->Cursor());
+        pindexScan = LookupBlockIndex(pcursor->GetBestBlock());
+    }
+
+    std::map<COutPoint, CMasternodeCollateral> mapScanned;
+    while (pcursor->Valid()) {
+        COutPoint key;
+        Coin coin;
+        if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+            LogPrintf("CMasternodeRegistry::%s -- unable to read UTXO set\n", __func__);
+            return false;
+        }
+        if (coin.out.nValue == MASTERNODE_COLLATERAL_AMOUNT) {
+            mapScanned.emplace(key, CMasternodeCollateral(coin.nHeight, coin.out.scriptPubKey));
+        }
+        pcursor->Next();
+    }
+
+    LOCK(cs);
+    // Blocks connected during the scan were either applied to the old state
+    // or skipped while stale. Both are replaced here, and the next block
+    // that does not extend the snapshot marks the registry stale again.
+    mapCollaterals.swap(mapScanned);
+    deqChanges.clear();
+    pindexBest = pindexScan;
+
+    LogPrint(BCLog::MASTERNODE, "CMasternodeRegistry::%s -- %d collaterals at height %d, %dms\n", __func__,
+             mapCollaterals.size(), pindexBest ? pindexBest->nHeight : -1, GetTimeMillis() - nStart);
+    return pindexBest != nullptr;
+}
+
+void CMasternodeRegistry::MarkStale(const char* pszReason, const uint256& hashBlock)
+{
+    AssertLockHeld(cs);
+    LogPrint(BCLog::MASTERNODE, "CMasternodeRegistry -- block %s %s, marking stale\n", hashBlock.ToString(), pszReason);
+    mapCollaterals.clear();
+    deqChanges.clear();
+    pindexBest = nullptr;
+}
+
+void CMasternodeRegistry::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                                         const std::vector<CTransactionRef>& txnConflicted)
+{
+    ConnectBlock(*block, pindex);
+}
+
+void CMasternodeRegistry::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    DisconnectBlock(*block);
+}
+
+void CMasternodeRegistry::ConnectBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    LOCK(cs);
+    if (!pindexBest) return;
+
+    // Notifications are queued, so the scan may already include this block
+    if (pindexBest->GetAncestor(pindex->nHeight) == pindex) return;
+
+    if (pindex->pprev == pindexBest) {
+        BlockChanges changes;
+        changes.hashBlock = pindex->GetBlockHash();
+        for (const CTransactionRef& tx : block.vtx) {
+            if (!tx->IsCoinBase()) {
+                for (const CTxIn& txin : tx->vin) {
+                    auto it = mapCollaterals.find(txin.prevout);
+                    if (it == mapCollaterals.end()) continue;
+                    changes.vSpent.push_back(*it);
+                    mapCollaterals.erase(it);
+                }
+            }
+            const uint256& txid = tx->GetHash();
+            for (size_t i = 0; i < tx->vout.size(); i++) {
+                const CTxOut& txout = tx->vout[i];
+                if (txout.nValue != MASTERNODE_COLLATERAL_AMOUNT) continue;
+                std::pair<COutPoint, CMasternodeCollateral> entry(COutPoint(txid, i), CMasternodeCollateral(pindex->nHeight, txout.scriptPubKey));
+                mapCollaterals.insert(entry);
+                changes.vAdded.push_back(entry);
+            }
+        }
+
+        deqChanges.push_back(std::move(changes));
+        if (deqChanges.size() > MASTERNODE_REGISTRY_UNDO_DEPTH) {
+            deqChanges.pop_front();
+        }
+        pindexBest = pindex;
+        return;
+    }
+
+    MarkStale("does not extend the registry", pindex->GetBlockHash());
+}
+
+void CMasternodeRegistry::DisconnectBlock(const CBlock& block)
+{
+    const uint256 hashBlock = block.GetHash();
+    LOCK(cs);
+    // A block we are not at was either never applied or already covered by a rescan
+    if (!pindexBest || pindexBest->GetBlockHash() != hashBlock) return;
+
+    if (!deqChanges.empty() && deqChanges.back().hashBlock == hashBlock) {
+        const BlockChanges& changes = deqChanges.back();
+        // Restore spent outputs before removing created ones, so that an
+        // output created and spent within the block ends up absent
+        for (auto it = changes.vSpent.rbegin(); it != changes.vSpent.rend(); ++it) {
+            mapCollaterals.insert(*it);
+        }
+        for (auto it = changes.vAdded.rbegin(); it != changes.vAdded.rend(); ++it) {
+            mapCollaterals.erase(it->first);
+        }
+        deqChanges.pop_back();
+        pindexBest = pindexBest->pprev;
+        return;
+    }
+
+    MarkStale("was disconnected with unknown changes", hashBlock);
+}
+
+bool CMasternodeRegistry::GetCollateral(const COutPoint& outpoint, CMasternodeCollateral& collateralRet) const
+{
+    LOCK(cs);
+    auto it = mapCollaterals.find(outpoint);
+    if (it == mapCollaterals.end()) return false;
+    collateralRet = it->second;
+    return true;
+}
+
+bool CMasternodeRegistry::Has(const COutPoint& outpoint) const
+{
+    LOCK(cs);
+    return mapCollaterals.count(outpoint) != 0;
+}
+
+std::map<COutPoint, CMasternodeCollateral> CMasternodeRegistry::GetCollaterals() const
+{
+    LOCK(cs);
+    return mapCollaterals;
+}
+
+size_t CMasternodeRegistry::size() const
+{
+    LOCK(cs);
+    return mapCollaterals.size();
+}
+
+const CBlockIndex* CMasternodeRegistry::GetBestBlock() const
+{
+    LOCK(cs);
+    return pindexBest;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MASTERNODE_REGISTRY_H
+#define BITCOIN_MASTERNODE_REGISTRY_H
+
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <validationinterface.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+
+/** Number of connected blocks whose registry changes are kept to revert a reorg without rescanning */
+static const size_t MASTERNODE_REGISTRY_UNDO_DEPTH = 100;
+/** Default for -masternoderegistry */
+static const bool DEFAULT_MASTERNODE_REGISTRY = false;
+
+/** An unspent output that can back a masternode */
+struct CMasternodeCollateral
+{
+    int nHeight;
+    CScript scriptPubKey;
+
+    CMasternodeCollateral() : nHeight(0) {}
+    CMasternodeCollateral(int nHeightIn, const CScript& scriptPubKeyIn) :
+        nHeight(nHeightIn),
+        scriptPubKey(scriptPubKeyIn)
+    {}
+};
+
+/**
+ * Set of masternode collaterals derived from the chain itself.
+ *
+ * The gossip list in CMasternodeMan only learns about a masternode once its
+ * broadcast reaches us, and has to be resynced from peers after every start.
+ * The collaterals on the other hand follow from the UTXO set alone: every
+ * unspent output of exactly MASTERNODE_COLLATERAL_AMOUNT is listed here with
+ * the height it confirmed at and the script it pays to. The registry is built
+ * from the chainstate at startup and then kept up to date with
+ * ValidationInterface notifications, keeping the changes of recent blocks so
+ * that a reorg can be reverted without another scan. A block that cannot be
+ * applied marks the registry stale instead of scanning on the scheduler
+ * thread; the next Rebuild, done by the caller that needs the data, brings it
+ * back in sync.
+ */
+class CMasternodeRegistry : public CValidationInterface
+{
+private:
+    struct BlockChanges
+    {
+        uint256 hashBlock;
+        std::vector<std::pair<COutPoint, CMasternodeCollateral>> vAdded;
+        std::vector<std::pair<COutPoint, CMasternodeCollateral>> vSpent;
+    };
+
+    mutable CCriticalSection cs;
+    std::map<COutPoint, CMasternodeCollateral> mapCollaterals;
+    std::deque<BlockChanges> deqChanges;
+    /// Block the registry is in sync with, null until the first scan or while stale
+    const CBlockIndex* pindexBest;
+    bool fRegistered;
+
+    void MarkStale(const char* pszReason, const uint256& hashBlock);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                        const std::vector<CTransactionRef>& txnConflicted) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
+public:
+    CMasternodeRegistry();
+
+    /// Start following the chain and scan the chainstate
+    void Start();
+    void Stop();
+    bool IsRunning() const;
+
+    /// Replace the registry with the collaterals in the chainstate. Only
+    /// takes cs_main to snapshot the chainstate, the scan runs without it.
+    bool Rebuild();
+
+    /// Apply the outputs created and spent by a block connected on top of the registry
+    void ConnectBlock(const CBlock& block, const CBlockIndex* pindex);
+    /// Revert the tip block, marking the registry stale if its changes are no longer known
+    void DisconnectBlock(const CBlock& block);
+
+    bool GetCollateral(const COutPoint& outpoint, CMasternodeCollateral& collateralRet) const;
+    bool Has(const COutPoint& outpoint) const;
+    std::map<COutPoint, CMasternodeCollateral> GetCollaterals() const;
+    size_t size() const;
+
+    /// Block the registry is in sync with, null before the first scan or while stale
+    const CBlockIndex* GetBestBlock() const;
+};
+
+extern CMasternodeRegistry mnregistry;
+
+#endif // BITCOIN_MASTERNODE_REGISTRY_H
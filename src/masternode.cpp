@@ -13,6 +13,7 @@
 #include <messagesigner.h>
 #include <script/standard.h>
 #include <util.h>
+#include <validationinterface.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
 #endif // ENABLE_WALLET
@@ -125,7 +126,7 @@ CMasternode::CollateralStatus CMasternode::CheckCollateral(const COutPoint& outp
         return COLLATERAL_UTXO_NOT_FOUND;
     }
 
-    if(coin.out.nValue != 15000 * COIN) {
+    if(coin.out.nValue != MASTERNODE_COLLATERAL_AMOUNT) {
         return COLLATERAL_INVALID_AMOUNT;
     }
 
@@ -133,10 +134,22 @@ CMasternode::CollateralStatus CMasternode::CheckCollateral(const COutPoint& outp
     return COLLATERAL_OK;
 }
 
-void CMasternode::Check(bool fForce)
+void CMasternode::Check(bool fForce, bool fNotify)
 {
     LOCK2(cs_main, cs);
 
+    int nActiveStateOrig = nActiveState;
+    CheckState(fForce);
+    if(fNotify && nActiveState != nActiveStateOrig) {
+        GetMainSignals().NotifyMasternodeChanged(vin.prevout, GetStatus());
+    }
+}
+
+void CMasternode::CheckState(bool fForce)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs);
+
     if(ShutdownRequested()) return;
 
     if(!fForce && (GetTime() - nTimeLastChecked < MASTERNODE_CHECK_SECONDS)) return;
@@ -276,7 +289,7 @@ bool CMasternode::IsInputAssociatedWithPubkey() const
     uint256 hash;
     if(GetTransaction(vin.prevout.hash, tx, Params().GetConsensus(), hash, true)) {
         for(const CTxOut &out : tx->vout)
-            if(out.nValue == 15000 * COIN && out.scriptPubKey == payee) return true;
+            if(out.nValue == MASTERNODE_COLLATERAL_AMOUNT && out.scriptPubKey == payee) return true;
     }
 
     return false;
@@ -342,8 +355,7 @@ void CMasternode::UpdateLastPaid(const CBlockIndex *pindex, int nMaxBlocksToScan
     LOCK(cs_mapMasternodeBlocks);
 
     for (int i = 0; BlockReading && BlockReading->nHeight > nBlockLastPaid && i < nMaxBlocksToScanBack; i++) {
-        if(mnpayments.mapMasternodeBlocks.count(BlockReading->nHeight) &&
-            mnpayments.mapMasternodeBlocks[BlockReading->nHeight].HasPayeeWithVotes(mnpayee, 2))
+        if(mnpayments.HasPayeeWithVotes(BlockReading->nHeight, mnpayee, 2))
         {
             CBlock block;
             if(!ReadBlockFromDisk(block, BlockReading, Params().GetConsensus())) // shouldn't really happen
@@ -634,16 +646,20 @@ bool CMasternodeBroadcast::CheckOutpoint(int& nDos)
     return true;
 }
 
+std::string CMasternodeBroadcast::GetSignatureMessage() const
+{
+    return addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
+                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
+                    boost::lexical_cast<std::string>(nProtocolVersion);
+}
+
 bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
 {
     std::string strError;
-    std::string strMessage;
 
     sigTime = GetAdjustedTime();
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                    boost::lexical_cast<std::string>(nProtocolVersion);
+    std::string strMessage = GetSignatureMessage();
 
     if(!CMessageSigner::SignMessage(strMessage, vchSig, keyCollateralAddress, CPubKey::InputScriptType::SPENDP2PKH)) {
         LogPrintf("CMasternodeBroadcast::Sign -- SignMessage() failed\n");
@@ -660,13 +676,11 @@ bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
 
 bool CMasternodeBroadcast::CheckSignature(int& nDos)
 {
-    std::string strMessage;
-    std::string strError = "";
     nDos = 0;
+    if(fSignatureVerified) return true;
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                    boost::lexical_cast<std::string>(nProtocolVersion);
+    std::string strMessage = GetSignatureMessage();
+    std::string strError = "";
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyCollateralAddress.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
 
@@ -704,14 +718,18 @@ CMasternodePing::CMasternodePing(const COutPoint& outpoint)
     sigTime = GetAdjustedTime();
 }
 
+std::string CMasternodePing::GetSignatureMessage() const
+{
+    // TODO: add sentinel data
+    return vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+}
+
 bool CMasternodePing::Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode)
 {
     std::string strError;
-    std::string strMasterNodeSignMessage;
 
-    // TODO: add sentinel data
     sigTime = GetAdjustedTime();
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+    std::string strMessage = GetSignatureMessage();
 
     if(!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode, CPubKey::InputScriptType::SPENDP2PKH)) {
         LogPrintf("CMasternodePing::Sign -- SignMessage() failed\n");
@@ -728,10 +746,11 @@ bool CMasternodePing::Sign(const CKey& keyMasternode, const CPubKey& pubKeyMaste
 
 bool CMasternodePing::CheckSignature(CPubKey& pubKeyMasternode, int &nDos)
 {
-    // TODO: add sentinel data
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
-    std::string strError = "";
     nDos = 0;
+    if(!keyIDSignatureVerified.IsNull() && keyIDSignatureVerified == pubKeyMasternode.GetID()) return true;
+
+    std::string strMessage = GetSignatureMessage();
+    std::string strError = "";
 
     if(!CMessageSigner::VerifyMessage(pubKeyMasternode.GetID(), vchSig, strMessage, strError)) {
         LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", vin.prevout.ToString(), strError);
@@ -23,6 +23,9 @@ static const int MASTERNODE_NEW_START_REQUIRED_SECONDS  = 180 * 60;
 
 static const int MASTERNODE_POSE_BAN_MAX_SCORE          = 5;
 
+/** Value of the unspent output a masternode has to be backed by */
+static const CAmount MASTERNODE_COLLATERAL_AMOUNT       = 15000 * COIN;
+
 //
 // The Masternode Ping Class : Contains a different serialize method for sending pings from masternodes throughout the network
 //
@@ -40,6 +43,8 @@ public:
     bool fSentinelIsCurrent = false; // true if last sentinel ping was actual
     // MSB is always 0, other 3 bits corresponds to x.x.x version scheme
     uint32_t nSentinelVersion{DEFAULT_SENTINEL_VERSION};
+    // key the signature was already verified against by batch verification, not serialized
+    CKeyID keyIDSignatureVerified{};
 
     CMasternodePing() = default;
 
@@ -73,6 +78,8 @@ public:
 
     bool IsExpired() const { return GetAdjustedTime() - sigTime > MASTERNODE_NEW_START_REQUIRED_SECONDS; }
 
+    /// Message covered by vchSig
+    std::string GetSignatureMessage() const;
     bool Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode);
     bool CheckSignature(CPubKey& pubKeyMasternode, int &nDos);
     bool SimpleCheck(int& nDos);
@@ -135,6 +142,8 @@ private:
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
 
+    void CheckState(bool fForce);
+
 public:
     enum state {
         MASTERNODE_PRE_ENABLED,
@@ -206,7 +215,9 @@ public:
 
     static CollateralStatus CheckCollateral(const COutPoint& outpoint);
     static CollateralStatus CheckCollateral(const COutPoint& outpoint, int& nHeightRet);
-    void Check(bool fForce = false);
+    /// Update nActiveState and, unless fNotify is false (e.g. when checking a
+    /// temporary copy), tell listeners about a state transition.
+    void Check(bool fForce = false, bool fNotify = true);
 
     bool IsBroadcastedWithin(int nSeconds) const { return GetAdjustedTime() - sigTime < nSeconds; }
 
@@ -305,11 +316,13 @@ class CMasternodeBroadcast : public CMasternode
 public:
 
     bool fRecovery;
+    // signature was already verified by batch verification, not serialized
+    bool fSignatureVerified;
 
-    CMasternodeBroadcast() : CMasternode(), fRecovery(false) {}
-    CMasternodeBroadcast(const CMasternode& mn) : CMasternode(mn), fRecovery(false) {}
+    CMasternodeBroadcast() : CMasternode(), fRecovery(false), fSignatureVerified(false) {}
+    CMasternodeBroadcast(const CMasternode& mn) : CMasternode(mn), fRecovery(false), fSignatureVerified(false) {}
     CMasternodeBroadcast(CService addrNew, COutPoint outpointNew, CPubKey pubKeyCollateralAddressNew, CPubKey pubKeyMasternodeNew, int nProtocolVersionIn) :
-        CMasternode(addrNew, outpointNew, pubKeyCollateralAddressNew, pubKeyMasternodeNew, nProtocolVersionIn), fRecovery(false) {}
+        CMasternode(addrNew, outpointNew, pubKeyCollateralAddressNew, pubKeyMasternodeNew, nProtocolVersionIn), fRecovery(false), fSignatureVerified(false) {}
 
     ADD_SERIALIZE_METHODS;
 
@@ -342,6 +355,8 @@ public:
     bool Update(CMasternode* pmn, int& nDos, CConnman& connman);
     bool CheckOutpoint(int& nDos);
 
+    /// Message covered by vchSig
+    std::string GetSignatureMessage() const;
     bool Sign(const CKey& keyCollateralAddress);
     bool CheckSignature(int& nDos);
     void Relay(CConnman& connman);
@@ -13,6 +13,10 @@
 #include <netmessagemaker.h>
 #include <script/standard.h>
 #include <util.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <tuple>
 
 /** Masternode manager */
 CMasternodeMan mnodeman;
@@ -83,6 +87,16 @@ struct CompareByAddr
     }
 };
 
+/** The parts of an entry that change while it is in the list, see CMasternodeMan::nListVersion */
+typedef std::tuple<int, int, int64_t, int64_t, int64_t, int, int, int, int64_t, bool> masternode_list_state_t;
+
+static masternode_list_state_t GetListState(const CMasternode& mn)
+{
+    return std::make_tuple(mn.nActiveState, mn.nProtocolVersion, mn.sigTime, mn.lastPing.sigTime,
+                           mn.nTimeLastPaid, mn.nBlockLastPaid, mn.nPoSeBanScore, mn.nPoSeBanHeight,
+                           mn.nTimeLastWatchdogVote, mn.fAllowMixingTx);
+}
+
 CMasternodeMan::CMasternodeMan()
     : cs(),
       mapMasternodes(),
@@ -97,6 +111,8 @@ CMasternodeMan::CMasternodeMan()
       fMasternodesRemoved(false),
       vecDirtyGovernanceObjectHashes(),
       nLastWatchdogVoteTime(0),
+      nListVersion(0),
+      listSnapshot(),
       mapSeenMasternodeBroadcast(),
       mapSeenMasternodePing(),
       nDsqCount(0)
@@ -108,9 +124,12 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     if (Has(mn.vin.prevout)) return false;
 
+    nListVersion++;
+
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.vin.prevout] = mn;
     fMasternodesAdded = true;
+    GetMainSignals().NotifyMasternodeChanged(mn.vin.prevout, mn.GetStatus());
     return true;
 }
 
@@ -150,6 +169,7 @@ bool CMasternodeMan::AllowMixing(const COutPoint &outpoint)
     if (!pmn) {
         return false;
     }
+    nListVersion++;
     nDsqCount++;
     pmn->nLastDsq = nDsqCount;
     pmn->fAllowMixingTx = true;
@@ -164,6 +184,7 @@ bool CMasternodeMan::DisallowMixing(const COutPoint &outpoint)
     if (!pmn) {
         return false;
     }
+    nListVersion++;
     pmn->fAllowMixingTx = false;
 
     return true;
@@ -176,6 +197,7 @@ bool CMasternodeMan::PoSeBan(const COutPoint &outpoint)
     if (!pmn) {
         return false;
     }
+    nListVersion++;
     pmn->PoSeBan();
 
     return true;
@@ -188,7 +210,11 @@ void CMasternodeMan::Check()
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Check -- nLastWatchdogVoteTime=%d, IsWatchdogActive()=%d\n", nLastWatchdogVoteTime, IsWatchdogActive());
 
     for (auto& mnpair : mapMasternodes) {
+        const masternode_list_state_t stateBefore = GetListState(mnpair.second);
         mnpair.second.Check();
+        if (GetListState(mnpair.second) != stateBefore) {
+            nListVersion++;
+        }
     }
 }
 
@@ -223,7 +249,9 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
 
                 // and finally remove it from the list
                 it->second.FlagGovernanceItemsAsDirty();
+                GetMainSignals().NotifyMasternodeChanged(it->first, "REMOVED");
                 mapMasternodes.erase(it++);
+                nListVersion++;
                 fMasternodesRemoved = true;
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
@@ -378,6 +406,7 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
 void CMasternodeMan::Clear()
 {
     LOCK(cs);
+    nListVersion++;
     mapMasternodes.clear();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
@@ -388,6 +417,30 @@ void CMasternodeMan::Clear()
     nLastWatchdogVoteTime = 0;
 }
 
+std::shared_ptr<const CMasternodeListSnapshot> CMasternodeMan::GetListSnapshot()
+{
+    std::shared_ptr<const CMasternodeListSnapshot> snapshot = std::atomic_load(&listSnapshot);
+    if (snapshot && snapshot->nVersion == nListVersion) {
+        return snapshot;
+    }
+
+    LOCK(cs);
+    // version only changes under cs, so it is consistent with the map here
+    uint64_t nVersion = nListVersion;
+    snapshot = std::atomic_load(&listSnapshot);
+    if (snapshot && snapshot->nVersion == nVersion) {
+        // rebuilt by another thread while we were waiting for cs
+        return snapshot;
+    }
+
+    std::shared_ptr<CMasternodeListSnapshot> newSnapshot = std::make_shared<CMasternodeListSnapshot>();
+    newSnapshot->nVersion = nVersion;
+    newSnapshot->vMasternodes.assign(mapMasternodes.begin(), mapMasternodes.end());
+    snapshot = newSnapshot;
+    std::atomic_store(&listSnapshot, snapshot);
+    return snapshot;
+}
+
 int CMasternodeMan::CountMasternodes(int nProtocolVersion) const
 {
     LOCK(cs);
@@ -783,12 +836,27 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         CMasternodeBroadcast mnb;
         vRecv >> mnb;
 
-        pfrom->setAskFor.erase(mnb.GetHash());
+        pfrom->RemoveAskFor(mnb.GetHash());
 
         if(!masternodeSync.IsBlockchainSynced()) return;
 
         LogPrint(BCLog::MASTERNODE, "MNANNOUNCE -- Masternode announce, masternode=%s\n", mnb.vin.prevout.ToString());
 
+        if(!masternodeSync.IsMasternodeListSynced()) {
+            // initial list sync, verify broadcasts in bulk (see ProcessPendingMnbs)
+            bool fBatchFull;
+            {
+                LOCK(cs_pendingMnbs);
+                if(!setPendingMnbHashes.insert(mnb.GetHash()).second) return;
+                vecPendingMnbs.push_back(CPendingMnb{pfrom->GetId(), pfrom->addr, mnb});
+                fBatchFull = vecPendingMnbs.size() >= MNB_BATCH_SIZE;
+            }
+            if(fBatchFull) {
+                ProcessPendingMnbs(connman);
+            }
+            return;
+        }
+
         int nDos = 0;
 
         if (CheckMnbAndUpdateMasternodeList(pfrom, mnb, nDos, connman)) {
@@ -808,7 +876,7 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
 
         uint256 nHash = mnp.GetHash();
 
-        pfrom->setAskFor.erase(nHash);
+        pfrom->RemoveAskFor(nHash);
 
         if(!masternodeSync.IsBlockchainSynced()) return;
 
@@ -835,7 +903,11 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         if(pmn && pmn->IsNewStartRequired()) return;
 
         int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        masternode_list_state_t stateBefore;
+        if(pmn) stateBefore = GetListState(*pmn);
+        bool fRelayed = mnp.CheckAndUpdate(pmn, false, nDos, connman);
+        if(pmn && GetListState(*pmn) != stateBefore) nListVersion++;
+        if(fRelayed) return;
 
         if(nDos > 0) {
             // if anything significant failed, mark that node
@@ -919,7 +991,7 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         CMasternodeVerification mnv;
         vRecv >> mnv;
 
-        pfrom->setAskFor.erase(mnv.GetHash());
+        pfrom->RemoveAskFor(mnv.GetHash());
 
         if(!masternodeSync.IsMasternodeListSynced()) return;
 
@@ -1070,6 +1142,10 @@ void CMasternodeMan::CheckSameAddr()
         LogPrintf("CMasternodeMan::CheckSameAddr -- increasing PoSe ban score for masternode %s\n", pmn->vin.prevout.ToString());
         pmn->IncreasePoSeBanScore();
     }
+    if(!vBan.empty()) {
+        LOCK(cs);
+        nListVersion++;
+    }
 }
 
 bool CMasternodeMan::SendVerifyRequest(const CAddress& addr, const std::vector<CMasternode*>& vSortedByAddr, CConnman& connman)
@@ -1190,6 +1266,7 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
                     prealMasternode = &mnpair.second;
                     if(!mnpair.second.IsPoSeVerified()) {
                         mnpair.second.DecreasePoSeBanScore();
+                        nListVersion++;
                     }
                     netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
 
@@ -1236,6 +1313,7 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         // increase ban score for everyone else
         for(CMasternode* pmn : vpMasternodesToBan) {
             pmn->IncreasePoSeBanScore();
+            nListVersion++;
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyReply -- increased PoSe ban score for %s addr %s, new score %d\n",
                      prealMasternode->vin.prevout.ToString(), pnode->addr.ToString(), pmn->nPoSeBanScore);
         }
@@ -1328,6 +1406,7 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
 
         if(!pmn1->IsPoSeVerified()) {
             pmn1->DecreasePoSeBanScore();
+            nListVersion++;
         }
         mnv.Relay();
 
@@ -1339,6 +1418,7 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
         for (auto& mnpair : mapMasternodes) {
             if(mnpair.second.addr != mnv.addr || mnpair.first == mnv.vin1.prevout) continue;
             mnpair.second.IncreasePoSeBanScore();
+            nListVersion++;
             nCount++;
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
                      mnpair.first.ToString(), mnpair.second.addr.ToString(), mnpair.second.nPoSeBanScore);
@@ -1365,6 +1445,7 @@ std::string CMasternodeMan::ToString() const
 void CMasternodeMan::UpdateMasternodeList(CMasternodeBroadcast mnb, CConnman& connman)
 {
     LOCK2(cs_main, cs);
+    nListVersion++;
     mapSeenMasternodePing.insert(std::make_pair(mnb.lastPing.GetHash(), mnb.lastPing));
     mapSeenMasternodeBroadcast.insert(std::make_pair(mnb.GetHash(), std::make_pair(GetTime(), mnb)));
 
@@ -1411,7 +1492,7 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
                     if(mnb.lastPing.sigTime > mapSeenMasternodeBroadcast[hash].second.lastPing.sigTime) {
                         // simulate Check
                         CMasternode mnTemp = CMasternode(mnb);
-                        mnTemp.Check();
+                        mnTemp.Check(false, false);
                         LogPrint(BCLog::MASTERNODE, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- mnb=%s seen request, addr=%s, better lastPing: %d min ago, projected mn state: %s\n", hash.ToString(), pfrom->addr.ToString(), (GetAdjustedTime() - mnb.lastPing.sigTime)/60, mnTemp.GetStateString());
                         if(mnTemp.IsValidStateForAutoStart(mnTemp.nActiveState)) {
                             // this node thinks it's a good one
@@ -1440,6 +1521,7 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         CMasternode* pmn = Find(mnb.vin.prevout);
         if(pmn) {
             CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
+            nListVersion++;
             if(!mnb.Update(pmn, nDos, connman)) {
                 LogPrint(BCLog::MASTERNODE, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- Update() failed, masternode=%s\n", mnb.vin.prevout.ToString());
                 return false;
@@ -1478,6 +1560,87 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
     return true;
 }
 
+bool CMasternodeMan::IsMnbPending(const uint256& hash)
+{
+    LOCK(cs_pendingMnbs);
+    return setPendingMnbHashes.count(hash);
+}
+
+void CMasternodeMan::ProcessPendingMnbs(CConnman& connman)
+{
+    std::vector<CPendingMnb> vecBatch;
+    {
+        LOCK(cs_pendingMnbs);
+        vecBatch.swap(vecPendingMnbs);
+    }
+    if(vecBatch.empty()) return;
+
+    int64_t nTimeStart = GetTimeMicros();
+
+    // Signatures first, spread over the message signature check threads and without
+    // holding any lock. Only successful checks are remembered, failures go through
+    // the usual path below so that they are logged and punished as before.
+    std::vector<CHashSignatureCheck> vChecks;
+    vChecks.reserve(vecBatch.size() * 2);
+    for(const auto& pending : vecBatch) {
+        const CMasternodeBroadcast& mnb = pending.mnb;
+        vChecks.emplace_back(CMessageSigner::GetMessageHash(mnb.GetSignatureMessage()), mnb.pubKeyCollateralAddress.GetID(), mnb.vchSig);
+        if(mnb.lastPing != CMasternodePing()) {
+            vChecks.emplace_back(CMessageSigner::GetMessageHash(mnb.lastPing.GetSignatureMessage()), mnb.pubKeyMasternode.GetID(), mnb.lastPing.vchSig);
+        } else {
+            vChecks.emplace_back();
+        }
+    }
+    CHashSigner::VerifyHashes(vChecks);
+    for(size_t i = 0; i < vecBatch.size(); i++) {
+        CMasternodeBroadcast& mnb = vecBatch[i].mnb;
+        mnb.fSignatureVerified = vChecks[2 * i].fValid;
+        if(vChecks[2 * i + 1].fValid) {
+            mnb.lastPing.keyIDSignatureVerified = mnb.pubKeyMasternode.GetID();
+        }
+    }
+    int64_t nTimeVerified = GetTimeMicros();
+
+    std::vector<std::pair<CService, CAddress> > vecAccepted;
+    {
+        // commit the whole batch at once, readers never see half of it
+        LOCK2(cs_main, cs);
+
+        // one pass over the coins view pulls all collaterals into the cache
+        for(const auto& pending : vecBatch) {
+            pcoinsTip->HaveCoin(pending.mnb.vin.prevout);
+        }
+
+        for(auto& pending : vecBatch) {
+            int nDos = 0;
+            if(CheckMnbAndUpdateMasternodeList(nullptr, pending.mnb, nDos, connman)) {
+                vecAccepted.emplace_back(pending.mnb.addr, pending.addrFrom);
+            } else if(nDos > 0) {
+                Misbehaving(pending.nodeFrom, nDos);
+            }
+        }
+    }
+
+    {
+        LOCK(cs_pendingMnbs);
+        for(const auto& pending : vecBatch) {
+            setPendingMnbHashes.erase(pending.mnb.GetHash());
+        }
+    }
+
+    // use announced Masternodes as peers
+    for(const auto& accepted : vecAccepted) {
+        connman.AddNewAddresses({CAddress(accepted.first, NODE_NETWORK)}, accepted.second, 2*60*60);
+    }
+
+    LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessPendingMnbs -- %u broadcasts (%u accepted), signatures %.2fms, commit %.2fms\n",
+             vecBatch.size(), vecAccepted.size(), (nTimeVerified - nTimeStart) * 0.001, (GetTimeMicros() - nTimeVerified) * 0.001);
+
+    if(fMasternodesAdded) {
+        NotifyMasternodeUpdates(connman);
+    }
+}
+
 void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
 {
     LOCK2(cs_main, cs);
@@ -1493,7 +1656,11 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
     //                         nCachedBlockHeight, nMaxBlocksToScanBack, IsFirstRun ? "true" : "false");
 
     for (auto& mnpair: mapMasternodes) {
+        const masternode_list_state_t stateBefore = GetListState(mnpair.second);
         mnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+        if (GetListState(mnpair.second) != stateBefore) {
+            nListVersion++;
+        }
     }
 
     IsFirstRun = false;
@@ -1506,6 +1673,7 @@ void CMasternodeMan::UpdateWatchdogVoteTime(const COutPoint& outpoint, uint64_t
     if(!pmn) {
         return;
     }
+    nListVersion++;
     pmn->UpdateWatchdogVoteTime(nVoteTime);
     nLastWatchdogVoteTime = GetTime();
 }
@@ -1541,7 +1709,11 @@ void CMasternodeMan::CheckMasternode(const CPubKey& pubKeyMasternode, bool fForc
     LOCK2(cs_main, cs);
     for (auto& mnpair : mapMasternodes) {
         if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
+            const masternode_list_state_t stateBefore = GetListState(mnpair.second);
             mnpair.second.Check(fForce);
+            if (GetListState(mnpair.second) != stateBefore) {
+                nListVersion++;
+            }
             return;
         }
     }
@@ -1561,6 +1733,7 @@ void CMasternodeMan::SetMasternodeLastPing(const COutPoint& outpoint, const CMas
     if(!pmn) {
         return;
     }
+    nListVersion++;
     pmn->lastPing = mnp;
     // if masternode uses sentinel ping instead of watchdog
     // we shoud update nTimeLastWatchdogVote here if sentinel
@@ -8,6 +8,9 @@
 #include <masternode.h>
 #include <sync.h>
 
+#include <atomic>
+#include <memory>
+
 using namespace std;
 
 class CMasternodeMan;
@@ -15,6 +18,17 @@ class CConnman;
 
 extern CMasternodeMan mnodeman;
 
+/** Immutable copy of the masternode list. Readers such as the masternodelist RPC
+ *  hold on to it without taking CMasternodeMan::cs; a new one is only built after
+ *  the list has changed.
+ */
+struct CMasternodeListSnapshot
+{
+    /// Value of the list version this snapshot was built from
+    uint64_t nVersion;
+    std::vector<std::pair<COutPoint, CMasternode> > vMasternodes;
+};
+
 class CMasternodeMan
 {
 public:
@@ -41,6 +55,9 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    // broadcasts received during initial list sync are verified in batches of this size
+    static const int MNB_BATCH_SIZE                 = 500;
+
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -74,6 +91,23 @@ private:
 
     int64_t nLastWatchdogVoteTime;
 
+    /// Bumped under cs whenever an entry is added or removed, or one of the fields the list shows changes
+    std::atomic<uint64_t> nListVersion;
+    /// Latest list snapshot, accessed with std::atomic_load/atomic_store
+    std::shared_ptr<const CMasternodeListSnapshot> listSnapshot;
+
+    struct CPendingMnb
+    {
+        NodeId nodeFrom;
+        CAddress addrFrom;
+        CMasternodeBroadcast mnb;
+    };
+    // protects the pending broadcast batch, never held together with cs
+    CCriticalSection cs_pendingMnbs;
+    // broadcasts received during list sync and not yet verified
+    std::vector<CPendingMnb> vecPendingMnbs;
+    std::set<uint256> setPendingMnbHashes;
+
     friend class CMasternodeSync;
     /// Find an entry
     CMasternode* Find(const COutPoint& outpoint);
@@ -106,6 +140,7 @@ public:
         }
 
         READWRITE(mapMasternodes);
+        if(ser_action.ForRead()) nListVersion++;
         READWRITE(mAskedUsForMasternodeList);
         READWRITE(mWeAskedForMasternodeList);
         READWRITE(mWeAskedForMasternodeListEntry);
@@ -174,6 +209,8 @@ public:
     masternode_info_t FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion = -1);
 
     std::map<COutPoint, CMasternode> GetFullMasternodeMap() { return mapMasternodes; }
+    /// Return the current list snapshot, rebuilding it first if the list has changed since
+    std::shared_ptr<const CMasternodeListSnapshot> GetListSnapshot();
 
     bool GetMasternodeRanks(rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight = -1, int nMinProtocol = 0);
     bool GetMasternodeRank(const COutPoint &outpoint, int& nRankRet, int nBlockHeight = -1, int nMinProtocol = 0);
@@ -200,6 +237,10 @@ public:
     /// Perform complete check and only then update list and maps
     bool CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBroadcast mnb, int& nDos, CConnman& connman);
     bool IsMnbRecoveryRequested(const uint256& hash) { return mMnbRecoveryRequests.count(hash); }
+    /// Check if a broadcast is waiting in the pending batch
+    bool IsMnbPending(const uint256& hash);
+    /// Verify and apply all broadcasts queued during list sync as one batch
+    void ProcessPendingMnbs(CConnman& connman);
 
     void UpdateLastPaid(const CBlockIndex* pindex);
 
@@ -3,12 +3,101 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <messagesigner.h>
+#include <checkqueue.h>
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
 #include <key_io.h>
 #include <hash.h>
+#include <random.h>
+#include <script/sigcache.h>
 #include <validation.h> // For strMessageMagic
 #include <tinyformat.h>
+#include <util.h>
 #include <utilstrencodings.h>
-#include <key_io.h>
+
+#include <boost/thread.hpp>
+
+namespace {
+/**
+ * Valid message signature cache. Masternode, governance and InstantSend objects
+ * are relayed by every peer and re-checked whenever they are seen again, so
+ * remembering recent successful checks saves most of the key recoveries
+ * during list sync.
+ */
+class CMessageSignatureCache
+{
+private:
+    //! Entries are SHA256(nonce || hash || address script || signature)
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_msgsigcache;
+
+public:
+    CMessageSignatureCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+        setValid.setup_bytes(MESSAGE_SIGNATURE_CACHE_BYTES);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256& hash, const CTxDestination& address, const std::vector<unsigned char>& vchSig)
+    {
+        CScript script = GetScriptForDestination(address);
+        CSHA256 sha;
+        sha.Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(script.data(), script.size());
+        if (!vchSig.empty()) {
+            sha.Write(vchSig.data(), vchSig.size());
+        }
+        sha.Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_msgsigcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_msgsigcache);
+        setValid.insert(entry);
+    }
+};
+
+static CMessageSignatureCache messageSignatureCache;
+
+/** Check of a single CHashSignatureCheck on the check queue, the result goes back into the entry */
+class CQueuedHashSignatureCheck
+{
+private:
+    CHashSignatureCheck* pcheck;
+
+public:
+    CQueuedHashSignatureCheck() : pcheck(nullptr) {}
+    explicit CQueuedHashSignatureCheck(CHashSignatureCheck* pcheckIn) : pcheck(pcheckIn) {}
+
+    bool operator()()
+    {
+        std::string strError;
+        pcheck->fValid = CHashSigner::VerifyHash(pcheck->hash, pcheck->address, pcheck->vchSig, strError);
+        // a bad signature only fails its own entry, never the whole batch
+        return true;
+    }
+
+    void swap(CQueuedHashSignatureCheck& check)
+    {
+        std::swap(pcheck, check.pcheck);
+    }
+};
+
+static CCheckQueue<CQueuedHashSignatureCheck> messageSignatureCheckQueue(128);
+} // namespace
+
+void ThreadMessageSignatureCheck()
+{
+    RenameThread("xsn-msgsigcheck");
+    messageSignatureCheckQueue.Thread();
+}
 
 bool CMessageSigner::GetKeysFromSecret(const std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {   
@@ -23,22 +112,23 @@ bool CMessageSigner::GetKeysFromSecret(const std::string strSecret, CKey& keyRet
     return true;
 }
 
-bool CMessageSigner::SignMessage(const std::string strMessage, std::vector<unsigned char>& vchSigRet, const CKey &key, CPubKey::InputScriptType scriptType)
+uint256 CMessageSigner::GetMessageHash(const std::string& strMessage)
 {
     CHashWriter ss(SER_GETHASH, 0);
     ss << strMessageMagic;
     ss << strMessage;
 
-    return CHashSigner::SignHash(ss.GetHash(), key, scriptType, vchSigRet);
+    return ss.GetHash();
 }
 
-bool CMessageSigner::VerifyMessage(const CTxDestination &address, const std::vector<unsigned char>& vchSig, const std::string strMessage, std::string& strErrorRet)
+bool CMessageSigner::SignMessage(const std::string strMessage, std::vector<unsigned char>& vchSigRet, const CKey &key, CPubKey::InputScriptType scriptType)
 {
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << strMessageMagic;
-    ss << strMessage;
+    return CHashSigner::SignHash(GetMessageHash(strMessage), key, scriptType, vchSigRet);
+}
 
-    return CHashSigner::VerifyHash(ss.GetHash(), address, vchSig, strErrorRet);
+bool CMessageSigner::VerifyMessage(const CTxDestination &address, const std::vector<unsigned char>& vchSig, const std::string strMessage, std::string& strErrorRet)
+{
+    return CHashSigner::VerifyHash(GetMessageHash(strMessage), address, vchSig, strErrorRet);
 }
 
 bool CHashSigner::SignHash(const uint256& hash, const CKey &key, CPubKey::InputScriptType scriptType, std::vector<unsigned char>& vchSigRet)
@@ -48,6 +138,12 @@ bool CHashSigner::SignHash(const uint256& hash, const CKey &key, CPubKey::InputS
 
 bool CHashSigner::VerifyHash(const uint256& hash, const CTxDestination &address, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
 {
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, address, vchSig);
+    if(messageSignatureCache.Get(entry)) {
+        return true;
+    }
+
     CPubKey pubkeyFromSig;
     CPubKey::InputScriptType inputScriptType;
     if(!pubkeyFromSig.RecoverCompact(hash, vchSig, inputScriptType)) {
@@ -84,5 +180,22 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CTxDestination &address,
         return false;
     }
 
+    messageSignatureCache.Set(entry);
     return true;
 }
+
+void CHashSigner::VerifyHashes(std::vector<CHashSignatureCheck>& vChecks)
+{
+    std::vector<CQueuedHashSignatureCheck> vQueued;
+    vQueued.reserve(vChecks.size());
+    for(CHashSignatureCheck& check : vChecks) {
+        check.fValid = false;
+        if(check.vchSig.empty()) continue;
+        vQueued.emplace_back(&check);
+    }
+
+    // without check threads the calling thread works through the whole batch
+    CCheckQueueControl<CQueuedHashSignatureCheck> control(&messageSignatureCheckQueue);
+    control.Add(vQueued);
+    control.Wait();
+}
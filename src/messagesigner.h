@@ -8,11 +8,31 @@
 #include <key.h>
 #include <script/standard.h>
 
+/** Memory used by the cache of successfully verified message signatures */
+static const size_t MESSAGE_SIGNATURE_CACHE_BYTES = 4 << 20;
+
+/** A signature to be checked as part of a batch, see CHashSigner::VerifyHashes
+ */
+struct CHashSignatureCheck
+{
+    uint256 hash;
+    CTxDestination address;
+    std::vector<unsigned char> vchSig;
+    /// Result, filled in by CHashSigner::VerifyHashes
+    bool fValid;
+
+    CHashSignatureCheck() : hash(), address(), vchSig(), fValid(false) {}
+    CHashSignatureCheck(const uint256& hashIn, const CTxDestination& addressIn, const std::vector<unsigned char>& vchSigIn) :
+        hash(hashIn), address(addressIn), vchSig(vchSigIn), fValid(false) {}
+};
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
 {
 public:
+    /// Hash that is actually signed for strMessage
+    static uint256 GetMessageHash(const std::string& strMessage);
     /// Set the private/public key values, returns true if successful
     static bool GetKeysFromSecret(const std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet);
     /// Sign the message, returns true if successful
@@ -31,6 +51,11 @@ public:
     static bool SignHash(const uint256& hash, const CKey &key, CPubKey::InputScriptType scriptType, std::vector<unsigned char>& vchSigRet);
     /// Verify the hash signature, returns true if succcessful
     static bool VerifyHash(const uint256& hash, const CTxDestination &address, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+    /// Verify many hash signatures at once, spread over the message signature check threads
+    static void VerifyHashes(std::vector<CHashSignatureCheck>& vChecks);
 };
 
+/** Run a message signature check thread, started once per script check thread */
+void ThreadMessageSignatureCheck();
+
 #endif
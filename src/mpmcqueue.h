@@ -0,0 +1,119 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MPMCQUEUE_H
+#define BITCOIN_MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdint.h>
+#include <utility>
+
+/**
+ * Bounded lock-free multi-producer multi-consumer queue.
+ *
+ * This is Dmitry Vyukov's array based queue: every slot carries a sequence
+ * number which tells producers and consumers whether the slot is ready for
+ * them, so a push or pop costs a single CAS on the shared position plus one
+ * release store on the slot. Neither operation ever blocks; TryPush fails
+ * when the queue is full and TryPop fails when it is empty, and callers
+ * decide whether to spin, park or give up.
+ *
+ * The capacity is rounded up to the next power of two.
+ */
+template <typename T>
+class MPMCQueue
+{
+private:
+    struct Slot
+    {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    // Keep producer and consumer positions on separate cache lines, they are
+    // hammered by different threads. Padding rather than alignas so the queue
+    // can be heap allocated without aligned new.
+    char pad0[CACHE_LINE_SIZE];
+    std::atomic<size_t> enqueuePos;
+    char pad1[CACHE_LINE_SIZE];
+    std::atomic<size_t> dequeuePos;
+
+    static size_t RoundUpCapacity(size_t n)
+    {
+        size_t cap = 2;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+public:
+    explicit MPMCQueue(size_t capacity) :
+        mask(RoundUpCapacity(capacity) - 1),
+        slots(new Slot[mask + 1]),
+        enqueuePos(0),
+        dequeuePos(0)
+    {
+        for (size_t i = 0; i <= mask; ++i) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    size_t Capacity() const { return mask + 1; }
+
+    /** Append an element. Returns false if the queue is full. */
+    bool TryPush(T value)
+    {
+        Slot* slot;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            slot = &slots[pos & mask];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Remove the oldest element into value. Returns false if the queue is empty. */
+    bool TryPop(T& value)
+    {
+        Slot* slot;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+            slot = &slots[pos & mask];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(slot->value);
+        slot->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif // BITCOIN_MPMCQUEUE_H
@@ -26,6 +26,10 @@
 #include <fcntl.h>
 #endif
 
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -1108,7 +1112,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
         return;
     }
 
-    if (!IsSelectableSocket(hSocket))
+    if (fRequireSelectableSockets && !IsSelectableSocket(hSocket))
     {
         LogPrintf("connection from %s dropped: non-selectable socket\n", addr.ToString());
         CloseSocket(hSocket);
@@ -1147,15 +1151,249 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
 
     LogPrint(BCLog::NET, "connection from %s accepted\n", addr.ToString());
 
+    RegisterSocketEvents(pnode);
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
     }
 }
 
+bool ParseSocketEventsMode(const std::string& str, SocketEventsMode& mode)
+{
+    if (str == "select") {
+        mode = SocketEventsMode::SELECT;
+        return true;
+    }
+#ifdef HAVE_EPOLL
+    if (str == "epoll") {
+        mode = SocketEventsMode::EPOLL;
+        return true;
+    }
+#endif
+    return false;
+}
+
+std::string GetSocketEventsModesList()
+{
+#ifdef HAVE_EPOLL
+    return "select, epoll";
+#else
+    return "select";
+#endif
+}
+
+bool CConnman::InitSocketEvents()
+{
+    if (socketEventsMode != SocketEventsMode::EPOLL)
+        return true;
+#ifdef HAVE_EPOLL
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd == -1) {
+        LogPrintf("epoll_create1 failed: %s\n", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    for (const ListenSocket& hListenSocket : vhListenSocket) {
+        // Listening sockets are level-triggered: AcceptConnection takes one
+        // connection at a time and leaves the rest for the next loop.
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (epoll_ctl(epollfd, EPOLL_CTL_ADD, hListenSocket.socket, &event) != 0) {
+            LogPrintf("epoll_ctl failed for listening socket: %s\n", NetworkErrorString(WSAGetLastError()));
+            return false;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CConnman::RegisterSocketEvents(CNode* pnode)
+{
+#ifdef HAVE_EPOLL
+    if (socketEventsMode != SocketEventsMode::EPOLL)
+        return;
+
+    // The registration lives as long as the socket does: closing it in
+    // CloseSocketDisconnect removes it from the epoll set, which happens
+    // before the node can be deleted by the socket handler thread.
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = pnode;
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET)
+        return;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, pnode->hSocket, &event) != 0) {
+        LogPrintf("epoll_ctl failed for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(WSAGetLastError()));
+        pnode->fDisconnect = true;
+    }
+#endif
+}
+
+bool CConnman::SocketEventsSelect()
+{
+    //
+    // Find which sockets have data to receive
+    //
+    struct timeval timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = 50000; // frequency to poll pnode->vSend
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+
+    for (const ListenSocket& hListenSocket : vhListenSocket) {
+        FD_SET(hListenSocket.socket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+        have_fds = true;
+    }
+
+    {
+        LOCK(cs_vNodes);
+        for (CNode* pnode : vNodes)
+        {
+            // Implement the following logic:
+            // * If there is data to send, select() for sending data. As this only
+            //   happens when optimistic write failed, we choose to first drain the
+            //   write buffer in this case before receiving more. This avoids
+            //   needlessly queueing received data, if the remote peer is not themselves
+            //   receiving data. This means properly utilizing TCP flow control signalling.
+            // * Otherwise, if there is space left in the receive buffer, select() for
+            //   receiving data.
+            // * Hand off all complete messages to the processor, to be handled without
+            //   blocking here.
+
+            bool select_recv = !pnode->fPauseRecv;
+            bool select_send;
+            {
+                LOCK(pnode->cs_vSend);
+                select_send = !pnode->vSendMsg.empty();
+            }
+
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+
+            FD_SET(pnode->hSocket, &fdsetError);
+            hSocketMax = std::max(hSocketMax, pnode->hSocket);
+            have_fds = true;
+
+            if (select_send) {
+                FD_SET(pnode->hSocket, &fdsetSend);
+                continue;
+            }
+            if (select_recv) {
+                FD_SET(pnode->hSocket, &fdsetRecv);
+            }
+        }
+    }
+
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (interruptNet)
+        return false;
+
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
+        {
+            int nErr = WSAGetLastError();
+            LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+            for (unsigned int i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
+        }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
+            return false;
+    }
+
+    //
+    // Accept new connections
+    //
+    for (const ListenSocket& hListenSocket : vhListenSocket)
+    {
+        if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+        {
+            AcceptConnection(hListenSocket);
+        }
+    }
+
+    {
+        LOCK(cs_vNodes);
+        for (CNode* pnode : vNodes)
+        {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+            pnode->fHasRecvData = FD_ISSET(pnode->hSocket, &fdsetRecv) || FD_ISSET(pnode->hSocket, &fdsetError);
+            pnode->fCanSendData = FD_ISSET(pnode->hSocket, &fdsetSend);
+        }
+    }
+    return true;
+}
+
+bool CConnman::SocketEventsEpoll(bool fPendingIO)
+{
+#ifdef HAVE_EPOLL
+    // Sockets that still have latched readiness don't need to wait for a new edge.
+    const int nTimeout = fPendingIO ? 0 : 50;
+    struct epoll_event events[256];
+
+    int nEvents = epoll_wait(epollfd, events, ARRAYLEN(events), nTimeout);
+    if (interruptNet)
+        return false;
+
+    if (nEvents == -1) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINTR) {
+            LogPrintf("epoll_wait error %s\n", NetworkErrorString(nErr));
+            if (!interruptNet.sleep_for(std::chrono::milliseconds(nTimeout)))
+                return false;
+        }
+        return true;
+    }
+
+    bool fAccept = false;
+    for (int i = 0; i < nEvents; i++) {
+        CNode* pnode = static_cast<CNode*>(events[i].data.ptr);
+        if (pnode == nullptr) {
+            fAccept = true;
+            continue;
+        }
+        // Errors and hangups are surfaced by the following recv()/send().
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP))
+            pnode->fHasRecvData = true;
+        if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+            pnode->fCanSendData = true;
+    }
+
+    //
+    // Accept new connections
+    //
+    if (fAccept) {
+        for (const ListenSocket& hListenSocket : vhListenSocket) {
+            if (hListenSocket.socket != INVALID_SOCKET)
+                AcceptConnection(hListenSocket);
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 void CConnman::ThreadSocketHandler()
 {
     unsigned int nPrevNodeCount = 0;
+    bool fPendingIO = false;
     while (!interruptNet)
     {
         //
@@ -1228,98 +1466,14 @@ void CConnman::ThreadSocketHandler()
                 clientInterface->NotifyNumConnectionsChanged(nPrevNodeCount);
         }
 
-        //
-        // Find which sockets have data to receive
-        //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
-
-        for (const ListenSocket& hListenSocket : vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
-
-        {
-            LOCK(cs_vNodes);
-            for (CNode* pnode : vNodes)
-            {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
-                {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
-
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
-
-                if (select_send) {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv) {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
-                }
-            }
-        }
-
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        if (interruptNet)
-            return;
-
-        if (nSelect == SOCKET_ERROR)
-        {
-            if (have_fds)
-            {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
+        if (socketEventsMode == SocketEventsMode::EPOLL) {
+            if (!SocketEventsEpoll(fPendingIO))
+                return;
+        } else {
+            if (!SocketEventsSelect())
                 return;
         }
-
-        //
-        // Accept new connections
-        //
-        for (const ListenSocket& hListenSocket : vhListenSocket)
-        {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
-                AcceptConnection(hListenSocket);
-            }
-        }
+        fPendingIO = false;
 
         //
         // Service each socket
@@ -1336,21 +1490,27 @@ void CConnman::ThreadSocketHandler()
             if (interruptNet)
                 return;
 
-            //
-            // Receive
-            //
             bool recvSet = false;
             bool sendSet = false;
-            bool errorSet = false;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
-                sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
-                errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
+            if (socketEventsMode == SocketEventsMode::EPOLL) {
+                // Same policy as the select() path: drain the send buffer
+                // before receiving more from a peer that is not reading.
+                bool fHasSendData;
+                {
+                    LOCK(pnode->cs_vSend);
+                    fHasSendData = !pnode->vSendMsg.empty();
+                }
+                sendSet = fHasSendData && pnode->fCanSendData;
+                recvSet = !fHasSendData && !pnode->fPauseRecv && pnode->fHasRecvData;
+            } else {
+                recvSet = pnode->fHasRecvData.exchange(false);
+                sendSet = pnode->fCanSendData.exchange(false);
             }
-            if (recvSet || errorSet)
+
+            //
+            // Receive
+            //
+            if (recvSet)
             {
                 // typical socket buffer is 8K-64K
                 char pchBuf[0x10000];
@@ -1361,6 +1521,12 @@ void CConnman::ThreadSocketHandler()
                         continue;
                     nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
                 }
+                // A short read means the socket has been drained; a full
+                // one leaves the edge latched so we come back without waiting.
+                if (nBytes < (int)sizeof(pchBuf))
+                    pnode->fHasRecvData = false;
+                else
+                    fPendingIO = true;
                 if (nBytes > 0)
                 {
                     bool notify = false;
@@ -1415,6 +1581,10 @@ void CConnman::ThreadSocketHandler()
                 if (nBytes) {
                     RecordBytesSent(nBytes);
                 }
+                // Anything left over means the kernel buffer is full; wait
+                // for the next writable edge before trying again.
+                if (!pnode->vSendMsg.empty())
+                    pnode->fCanSendData = false;
             }
 
             //
@@ -2222,6 +2392,7 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In) : nSeed0(nSeed0In), nSe
     nSendBufferMaxSize = 0;
     nReceiveFloodSize = 0;
     flagInterruptMsgProc = false;
+    epollfd = -1;
     SetTryNewOutboundPeer(false);
 
     Options connOptions;
@@ -2288,6 +2459,13 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         return false;
     }
 
+    if (!InitSocketEvents()) {
+        LogPrintf("Socket events mode epoll unavailable, falling back to select\n");
+        socketEventsMode = SocketEventsMode::SELECT;
+    }
+    // Only the select() backend is bound by FD_SETSIZE
+    fRequireSelectableSockets = socketEventsMode == SocketEventsMode::SELECT;
+
     for (const auto& strDest : connOptions.vSeedNodes) {
         AddOneShot(strDest);
     }
@@ -2459,6 +2637,12 @@ void CConnman::Stop()
     vNodes.clear();
     vNodesDisconnected.clear();
     vhListenSocket.clear();
+#ifdef HAVE_EPOLL
+    if (epollfd != -1) {
+        close(epollfd);
+        epollfd = -1;
+    }
+#endif
     semOutbound.reset();
     semAddnode.reset();
 }
@@ -2761,6 +2945,8 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     nextSendTimeFeeFilter = 0;
     fPauseRecv = false;
     fPauseSend = false;
+    fHasRecvData = false;
+    fCanSendData = false;
     nProcessQueueSize = 0;
 
     for (const std::string &msg : getAllNetMessageTypes())
@@ -2781,6 +2967,7 @@ CNode::~CNode()
 
 void CNode::AskFor(const CInv& inv)
 {
+    LOCK(cs_askfor);
     if (mapAskFor.size() > MAPASKFOR_MAX_SZ || setAskFor.size() > SETASKFOR_MAX_SZ)
         return;
     // a peer may not have multiple non-responded queue positions for a single inv item
@@ -2964,6 +3151,7 @@ CNode *CConnman::OpenNetworkConnectionImpl(const CAddress &addrConnect, bool fCo
         pnode->m_manual_connection = true;
 
     m_msgproc->InitializeNode(pnode);
+    RegisterSocketEvents(pnode);
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
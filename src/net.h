@@ -63,6 +63,12 @@ static const bool DEFAULT_UPNP = USE_UPNP;
 #else
 static const bool DEFAULT_UPNP = false;
 #endif
+/** -socketevents default */
+#ifdef HAVE_EPOLL
+static const char* const DEFAULT_SOCKETEVENTS = "epoll";
+#else
+static const char* const DEFAULT_SOCKETEVENTS = "select";
+#endif
 /** The maximum number of entries in mapAskFor */
 static const size_t MAPASKFOR_MAX_SZ = MAX_INV_SZ;
 /** The maximum number of entries in setAskFor (larger due to getdata latency)*/
@@ -85,6 +91,15 @@ static const unsigned int DEFAULT_MISBEHAVING_BANTIME = 60 * 60 * 24;  // Defaul
 
 typedef int64_t NodeId;
 
+/** Readiness notification backends for the socket handler thread */
+enum class SocketEventsMode {
+    SELECT,     //!< rebuild fd_sets and select() on every loop, limited to FD_SETSIZE
+    EPOLL,      //!< persistent edge-triggered epoll registrations (Linux only)
+};
+
+bool ParseSocketEventsMode(const std::string& str, SocketEventsMode& mode);
+std::string GetSocketEventsModesList();
+
 struct AddedNodeInfo
 {
     std::string strAddedNode;
@@ -141,6 +156,7 @@ public:
         bool m_use_addrman_outgoing = true;
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
+        SocketEventsMode socketEventsMode = SocketEventsMode::SELECT;
     };
 
     void Init(const Options& connOptions) {
@@ -154,6 +170,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        socketEventsMode = connOptions.socketEventsMode;
         {
             LOCK(cs_totalBytesSent);
             nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
@@ -349,6 +366,10 @@ private:
     void ThreadOpenConnections(std::vector<std::string> connect);
     void ThreadMessageHandler();
     void AcceptConnection(const ListenSocket& hListenSocket);
+    bool InitSocketEvents();
+    void RegisterSocketEvents(CNode* pnode);
+    bool SocketEventsSelect();
+    bool SocketEventsEpoll(bool fPendingIO);
     void ThreadSocketHandler();
     void ThreadDNSAddressSeed();
 
@@ -405,6 +426,9 @@ private:
     unsigned int nReceiveFloodSize;
 
     std::vector<ListenSocket> vhListenSocket;
+    SocketEventsMode socketEventsMode;
+    /** epoll instance holding persistent registrations for all sockets (-1 unless socketEventsMode is EPOLL) */
+    int epollfd;
     std::atomic<bool> fNetworkActive;
     banmap_t setBanned;
     CCriticalSection cs_setBanned;
@@ -693,6 +717,10 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+    // Socket readiness as last reported by the socket events backend. With
+    // edge-triggered epoll these stay latched until a recv/send would block.
+    std::atomic_bool fHasRecvData;
+    std::atomic_bool fCanSendData;
 protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
@@ -721,6 +749,9 @@ public:
     // and in the order requested.
     std::vector<uint256> vInventoryBlockToSend;
     CCriticalSection cs_inventory;
+    // Pending getdata requests. Protected by cs_askfor, as the XSN message
+    // workers update them while the message handler thread drains them
+    CCriticalSection cs_askfor;
     std::set<uint256> setAskFor;
     std::multimap<int64_t, CInv> mapAskFor;
     int64_t nNextInvSend;
@@ -877,6 +908,12 @@ public:
 
     void AskFor(const CInv& inv);
 
+    void RemoveAskFor(const uint256& hash)
+    {
+        LOCK(cs_askfor);
+        setAskFor.erase(hash);
+    }
+
     void CloseSocketDisconnect();
 
     void copyStats(CNodeStats &stats);
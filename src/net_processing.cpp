@@ -2188,7 +2188,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         bool fMissingInputs = false;
         CValidationState state;
 
-        pfrom->setAskFor.erase(inv.hash);
+        pfrom->RemoveAskFor(inv.hash);
         mapAlreadyAskedFor.erase(inv.hash);
 
         std::list<CTransactionRef> lRemovedTxn;
@@ -2960,6 +2960,50 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     return true;
 }
 
+static CCriticalSection cs_messageLatency;
+// Entries are never erased, so a histogram can be recorded to without the lock
+static std::map<std::string, CLatencyHistogram> mapMessageLatency GUARDED_BY(cs_messageLatency);
+
+void RecordMessageLatency(const std::string& strCommand, int64_t nMicros)
+{
+    CLatencyHistogram* phistogram;
+    {
+        LOCK(cs_messageLatency);
+        auto it = mapMessageLatency.find(strCommand);
+        if (it == mapMessageLatency.end()) {
+            // Don't let peers grow the map with made-up commands
+            const std::vector<std::string>& allMessages = getAllNetMessageTypes();
+            bool fKnown = std::find(allMessages.begin(), allMessages.end(), strCommand) != allMessages.end();
+            it = mapMessageLatency.emplace(std::piecewise_construct, std::forward_as_tuple(fKnown ? strCommand : std::string("*other*")), std::forward_as_tuple()).first;
+        }
+        phistogram = &it->second;
+    }
+    phistogram->Record(nMicros);
+}
+
+std::map<std::string, CLatencyHistogram::Snapshot> GetMessageLatencyStats()
+{
+    LOCK(cs_messageLatency);
+    std::map<std::string, CLatencyHistogram::Snapshot> mapStats;
+    for (const auto& entry : mapMessageLatency) {
+        mapStats.emplace(entry.first, entry.second.GetSnapshot());
+    }
+    return mapStats;
+}
+
+std::string MessageLatencyToPrometheusText()
+{
+    static const char* const name = "xsn_message_handling_duration_seconds";
+
+    std::string strText;
+    strText += strprintf("# HELP %s Time spent handling network messages, per command.\n", name);
+    strText += strprintf("# TYPE %s histogram\n", name);
+    for (const auto& entry : GetMessageLatencyStats()) {
+        AppendPrometheusHistogram(strText, name, strprintf("command=\"%s\"", entry.first), entry.second);
+    }
+    return strText;
+}
+
 static bool SendRejectsAndCheckIfBanned(CNode* pnode, CConnman* connman)
 {
     AssertLockHeld(cs_main);
@@ -3063,9 +3107,14 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
 
     // Process message
     bool fRet = false;
+    // Messages handed off to an extension worker are timed there, queueing included
+    const bool fTimed = !net_processing_xsn::IsExtensionOffloaded(strCommand);
+    const int64_t nTimeStart = GetTimeMicros();
     try
     {
         fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+        if (fTimed)
+            RecordMessageLatency(strCommand, GetTimeMicros() - nTimeStart);
         if (interruptMsgProc)
             return false;
         if (!pfrom->vRecvGetData.empty())
@@ -3747,9 +3796,17 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
         //
         // Message: getdata (non-blocks)
         //
-        while (!pto->mapAskFor.empty() && (*pto->mapAskFor.begin()).first <= nNow)
+        std::vector<CInv> vAskForDue;
+        {
+            LOCK(pto->cs_askfor);
+            while (!pto->mapAskFor.empty() && (*pto->mapAskFor.begin()).first <= nNow)
+            {
+                vAskForDue.push_back((*pto->mapAskFor.begin()).second);
+                pto->mapAskFor.erase(pto->mapAskFor.begin());
+            }
+        }
+        for (CInv& inv : vAskForDue)
         {
-            CInv& inv = (*pto->mapAskFor.begin()).second;
             if (!AlreadyHave(inv))
             {
                 LogPrint(BCLog::NET, "Requesting %s peer=%d s:%d r:%d\n", inv.ToString(), pto->GetId(),
@@ -3766,9 +3823,8 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
                 }
             } else {
                 //If we're not going to ask, don't expect a response.
-                pto->setAskFor.erase(inv.hash);
+                pto->RemoveAskFor(inv.hash);
             }
-            pto->mapAskFor.erase(pto->mapAskFor.begin());
         }
         if (!vGetData.empty())
             connman->PushMessage(pto, msgMaker.Make(NetMsgType::GETDATA, vGetData));
@@ -8,6 +8,7 @@
 
 #include <net.h>
 #include <validationinterface.h>
+#include <validationmetrics.h>
 #include <consensus/params.h>
 
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
@@ -92,6 +93,13 @@ struct CNodeStateStats {
     std::vector<int> vHeightInFlight;
 };
 
+/** Record how long it took to handle a message with the given command */
+void RecordMessageLatency(const std::string& strCommand, int64_t nMicros);
+/** Get per-command message handling latency histograms */
+std::map<std::string, CLatencyHistogram::Snapshot> GetMessageLatencyStats();
+/** Message handling latencies in the Prometheus text exposition format */
+std::string MessageLatencyToPrometheusText();
+
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 /** Increase a node's misbehavior score. */
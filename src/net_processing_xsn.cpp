@@ -14,8 +14,16 @@
 #include <tpos/activemerchantnode.h>
 #include <instantx.h>
 #include <init.h>
+#include <inventorycache.h>
+#include <net_processing.h>
+#include <utiltime.h>
 #include <boost/thread.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 namespace LegacyInvMsg {
 enum {
     MSG_TX = 1,
@@ -80,22 +88,16 @@ static const MapSporkHandlers &GetMapGetDataHandlers()
                     });
         ADD_HANDLER(MSG_MASTERNODE_PAYMENT_BLOCK, {
                         BlockMap::iterator mi = mapBlockIndex.find(hash);
-                        LOCK(cs_mapMasternodeBlocks);
-                        if (mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.count(mi->second->nHeight)) {
-                            for(const CMasternodePayee& payee : mnpayments.mapMasternodeBlocks[mi->second->nHeight].vecPayees) {
-                                std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
-                                for(const uint256& hash : vecVoteHashes) {
-                                    if(mnpayments.HasVerifiedPaymentVote(hash)) {
-                                        return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, mnpayments.mapMasternodePaymentVotes[hash]);
-                                    }
-                                }
-                            }
+                        std::vector<CMasternodePaymentVote> vecVotes;
+                        if (mi != mapBlockIndex.end() && mnpayments.GetBlockPaymentVotes(mi->second->nHeight, vecVotes)) {
+                            return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, vecVotes.front());
                         }
                         return {};
                     });
         ADD_HANDLER(MSG_MASTERNODE_PAYMENT_VOTE, {
-                        if(mnpayments.HasVerifiedPaymentVote(hash)) {
-                            return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, mnpayments.mapMasternodePaymentVotes[hash]);
+                        CMasternodePaymentVote vote;
+                        if(mnpayments.GetPaymentVote(hash, vote)) {
+                            return msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, vote);
                         }
                         return {};
                     });
@@ -160,16 +162,66 @@ static const MapSporkHandlers &GetMapGetDataHandlers()
     return sporkHandlers;
 }
 
+/** Recently served XSN objects, shared by all peers */
+static CRelayInventoryCache relayInventoryCache;
+
+/** Whether the answer to a getdata for this type only depends on the hash */
+static bool IsRelayCacheable(int nType)
+{
+    switch(nType)
+    {
+    // a payment block is answered with one of the votes currently known for it
+    case MSG_MASTERNODE_PAYMENT_BLOCK:
+    // announces are sent with the last ping, which is updated in place
+    case MSG_MASTERNODE_ANNOUNCE:
+    case MSG_MERCHANTNODE_ANNOUNCE:
+        return false;
+    }
+    return true;
+}
+
+/** Whether a cached answer means AlreadyHave is true without asking the manager */
+static bool IsRelayCacheAlreadyHave(int nType)
+{
+    switch(nType)
+    {
+    case MSG_TXLOCK_REQUEST:
+    case MSG_TXLOCK_VOTE:
+    case MSG_SPORK:
+    case MSG_MASTERNODE_PAYMENT_VOTE:
+    case MSG_MASTERNODE_PING:
+    case MSG_MERCHANTNODE_PING:
+    case MSG_MASTERNODE_VERIFY:
+    case MSG_MERCHANTNODE_VERIFY:
+        return true;
+    }
+    // announces can be asked for again on recovery, governance keeps track of its requests
+    return false;
+}
+
 bool net_processing_xsn::ProcessGetData(CNode *pfrom, const Consensus::Params &consensusParams, CConnman *connman, const CInv &inv)
 {
     const auto &handlersMap = GetMapGetDataHandlers();
     auto it = handlersMap.find(inv.type);
     if(it != std::end(handlersMap))
     {
-        const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+        const int nSendVersion = pfrom->GetSendVersion();
+        const bool fCacheable = IsRelayCacheable(inv.type);
+
+        CSerializedNetMsg msgCached;
+        if(fCacheable && relayInventoryCache.Get(inv, nSendVersion, msgCached))
+        {
+            connman->PushMessage(pfrom, std::move(msgCached));
+            return true;
+        }
+
+        const CNetMsgMaker msgMaker(nSendVersion);
         auto &&msg = it->second(msgMaker, inv.hash);
         if(!msg.command.empty())
         {
+            if(fCacheable) {
+                relayInventoryCache.Insert(inv, nSendVersion, msg);
+            }
             connman->PushMessage(pfrom, std::move(msg));
             return true;
         }
@@ -178,7 +230,42 @@ bool net_processing_xsn::ProcessGetData(CNode *pfrom, const Consensus::Params &c
     return false;
 }
 
-void net_processing_xsn::ProcessExtension(CNode *pfrom, const std::string &strCommand, CDataStream &vRecv, CConnman *connman)
+/**
+ * XSN side-manager message families. All messages of one family go to the
+ * same worker, so each manager still sees them in arrival order.
+ */
+enum ExtensionSubsystem {
+    SUBSYSTEM_NONE = -1,
+    SUBSYSTEM_MASTERNODE,
+    SUBSYSTEM_MERCHANTNODE,
+    SUBSYSTEM_GOVERNANCE,
+    SUBSYSTEM_INSTANTSEND,
+    SUBSYSTEM_SPORK,
+};
+
+static ExtensionSubsystem GetExtensionSubsystem(const std::string &strCommand)
+{
+    // mnw votes and sync counts depend on the masternode list, keep them on its lane
+    if(strCommand == NetMsgType::MNANNOUNCE || strCommand == NetMsgType::MNPING ||
+            strCommand == NetMsgType::DSEG || strCommand == NetMsgType::MNVERIFY ||
+            strCommand == NetMsgType::MASTERNODEPAYMENTVOTE || strCommand == NetMsgType::MASTERNODEPAYMENTSYNC ||
+            strCommand == NetMsgType::SYNCSTATUSCOUNT)
+        return SUBSYSTEM_MASTERNODE;
+    if(strCommand == NetMsgType::MERCHANTNODEANNOUNCE || strCommand == NetMsgType::MERCHANTNODEPING ||
+            strCommand == NetMsgType::MERCHANTNODESEG || strCommand == NetMsgType::MERCHANTNODEVERIFY ||
+            strCommand == NetMsgType::MERCHANTSYNCSTATUSCOUNT)
+        return SUBSYSTEM_MERCHANTNODE;
+    if(strCommand == NetMsgType::MNGOVERNANCESYNC || strCommand == NetMsgType::MNGOVERNANCEOBJECT ||
+            strCommand == NetMsgType::MNGOVERNANCEOBJECTVOTE)
+        return SUBSYSTEM_GOVERNANCE;
+    if(strCommand == NetMsgType::TXLOCKVOTE)
+        return SUBSYSTEM_INSTANTSEND;
+    if(strCommand == NetMsgType::SPORK || strCommand == NetMsgType::GETSPORKS)
+        return SUBSYSTEM_SPORK;
+    return SUBSYSTEM_NONE;
+}
+
+static void ProcessExtensionInline(CNode *pfrom, const std::string &strCommand, CDataStream &vRecv, CConnman *connman)
 {
     mnodeman.ProcessMessage(pfrom, strCommand, vRecv, *connman);
     mnpayments.ProcessMessage(pfrom, strCommand, vRecv, *connman);
@@ -190,6 +277,132 @@ void net_processing_xsn::ProcessExtension(CNode *pfrom, const std::string &strCo
     governance.ProcessMessage(pfrom, strCommand, vRecv, *connman);
 }
 
+namespace {
+
+/** Maximum number of messages queued on one worker before the message handler falls back to processing them itself */
+static const size_t MAX_EXTENSION_QUEUE_SIZE = 10000;
+
+struct CExtensionJob
+{
+    CNode *pfrom;
+    std::string strCommand;
+    CDataStream vRecv;
+    int64_t nTimeQueued;
+};
+
+class CExtensionWorker
+{
+public:
+    explicit CExtensionWorker(CConnman *connmanIn) : connman(connmanIn) {}
+
+    void Start(int nId)
+    {
+        strThreadName = strprintf("xsnmsg.%d", nId);
+        thread = std::thread(&TraceThread<std::function<void()>>, strThreadName.c_str(), std::function<void()>(std::bind(&CExtensionWorker::Loop, this)));
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fStop = true;
+        }
+        cond.notify_all();
+        if(thread.joinable())
+            thread.join();
+        for(const CExtensionJob &job : queue)
+            job.pfrom->Release();
+        queue.clear();
+    }
+
+    /** Queue a message; returns false if it must be processed by the caller instead */
+    bool Push(CNode *pfrom, const std::string &strCommand, const CDataStream &vRecv)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(fStop || queue.size() >= MAX_EXTENSION_QUEUE_SIZE)
+                return false;
+            pfrom->AddRef();
+            queue.push_back(CExtensionJob{pfrom, strCommand, vRecv, GetTimeMicros()});
+        }
+        cond.notify_one();
+        return true;
+    }
+
+private:
+    void Loop()
+    {
+        while(true)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this] { return fStop || !queue.empty(); });
+            if(fStop)
+                return;
+            CExtensionJob job = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+
+            if(!job.pfrom->fDisconnect) {
+                try {
+                    ProcessExtensionInline(job.pfrom, job.strCommand, job.vRecv, connman);
+                } catch (const std::ios_base::failure& e) {
+                    LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(job.strCommand), job.vRecv.size(), e.what());
+                } catch (const std::exception& e) {
+                    PrintExceptionContinue(&e, "ProcessExtension()");
+                }
+                RecordMessageLatency(job.strCommand, GetTimeMicros() - job.nTimeQueued);
+            }
+            job.pfrom->Release();
+        }
+    }
+
+    CConnman *connman;
+    std::string strThreadName;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<CExtensionJob> queue;
+    bool fStop = false;
+};
+
+std::vector<std::unique_ptr<CExtensionWorker>> vExtensionWorkers;
+
+} // namespace
+
+void net_processing_xsn::StartExtensionWorkers(int nThreads, CConnman *connman)
+{
+    assert(vExtensionWorkers.empty());
+    for(int i = 0; i < nThreads; ++i) {
+        vExtensionWorkers.emplace_back(new CExtensionWorker(connman));
+        vExtensionWorkers.back()->Start(i);
+    }
+    if(nThreads > 0)
+        LogPrintf("Processing XSN side-manager messages on %d worker threads\n", nThreads);
+}
+
+void net_processing_xsn::StopExtensionWorkers()
+{
+    // The workers are kept around: the message handler may still be running
+    // and will process everything inline once they refuse new messages.
+    for(auto &worker : vExtensionWorkers)
+        worker->Stop();
+}
+
+bool net_processing_xsn::IsExtensionOffloaded(const std::string &strCommand)
+{
+    return !vExtensionWorkers.empty() && GetExtensionSubsystem(strCommand) != SUBSYSTEM_NONE;
+}
+
+void net_processing_xsn::ProcessExtension(CNode *pfrom, const std::string &strCommand, CDataStream &vRecv, CConnman *connman)
+{
+    if(IsExtensionOffloaded(strCommand)) {
+        auto &worker = vExtensionWorkers[GetExtensionSubsystem(strCommand) % vExtensionWorkers.size()];
+        if(worker->Push(pfrom, strCommand, vRecv))
+            return;
+    }
+    ProcessExtensionInline(pfrom, strCommand, vRecv, connman);
+}
+
 void net_processing_xsn::ThreadProcessExtensions(CConnman *pConnman)
 {
     if(fLiteMode) return; // disable all XSN specific functionality
@@ -218,6 +431,9 @@ void net_processing_xsn::ThreadProcessExtensions(CConnman *pConnman)
             nTick++;
 
             if(masternodeSync.IsBlockchainSynced()) {
+                // apply broadcasts still waiting for a full batch
+                mnodeman.ProcessPendingMnbs(connman);
+
                 // make sure to check all masternodes first
                 mnodeman.Check();
 
@@ -263,6 +479,10 @@ void net_processing_xsn::ThreadProcessExtensions(CConnman *pConnman)
 
 bool net_processing_xsn::AlreadyHave(const CInv &inv)
 {
+    if(IsRelayCacheAlreadyHave(inv.type) && relayInventoryCache.Contains(inv)) {
+        return true;
+    }
+
     switch(inv.type)
     {
     /*
@@ -284,16 +504,17 @@ bool net_processing_xsn::AlreadyHave(const CInv &inv)
         return mapSporks.count(inv.hash);
 
     case MSG_MASTERNODE_PAYMENT_VOTE:
-        return mnpayments.mapMasternodePaymentVotes.count(inv.hash);
+        return mnpayments.HasPaymentVote(inv.hash);
 
     case MSG_MASTERNODE_PAYMENT_BLOCK:
     {
         BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-        return mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.find(mi->second->nHeight) != mnpayments.mapMasternodeBlocks.end();
+        return mi != mapBlockIndex.end() && mnpayments.HasBlockPayees(mi->second->nHeight);
     }
 
     case MSG_MASTERNODE_ANNOUNCE:
-        return mnodeman.mapSeenMasternodeBroadcast.count(inv.hash) && !mnodeman.IsMnbRecoveryRequested(inv.hash);
+        return (mnodeman.mapSeenMasternodeBroadcast.count(inv.hash) && !mnodeman.IsMnbRecoveryRequested(inv.hash)) ||
+                mnodeman.IsMnbPending(inv.hash);
     case MSG_MERCHANTNODE_ANNOUNCE:
         return merchantnodeman.mapSeenMerchantnodeBroadcast.count(inv.hash) && !merchantnodeman.IsMnbRecoveryRequested(inv.hash);
 
@@ -3,6 +3,13 @@
 
 #include <chainparams.h>
 
+#include <string>
+
+/** Default for -xsnmsgthreads, 0 processes XSN side-manager messages on the message handler thread */
+static const int DEFAULT_XSN_MSG_THREADS = 0;
+/** Maximum number of XSN side-manager message workers */
+static const int MAX_XSN_MSG_THREADS = 8;
+
 class CNode;
 class CInv;
 class CConnman;
@@ -17,6 +24,15 @@ bool ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParams, CCon
 
 void ProcessExtension(CNode* pfrom, const std::string &strCommand, CDataStream& vRecv, CConnman *connman);
 
+/** Start worker threads that handle XSN side-manager messages off the message handler thread */
+void StartExtensionWorkers(int nThreads, CConnman *connman);
+
+/** Stop the extension workers, dropping anything still queued. Must be called before the connection manager is stopped. */
+void StopExtensionWorkers();
+
+/** Whether messages with this command are handed off to an extension worker */
+bool IsExtensionOffloaded(const std::string &strCommand);
+
 bool AlreadyHave(const CInv &inv);
 
 bool TransformInvForLegacyVersion(CInv &inv, CNode *pfrom, bool fForSending);
@@ -19,6 +19,8 @@
 
 extern int nConnectTimeout;
 extern bool fNameLookup;
+//! Whether sockets must fit in an fd_set; cleared when the socket handler does not use select()
+extern bool fRequireSelectableSockets;
 
 //! -timeout default
 static const int DEFAULT_CONNECT_TIMEOUT = 5000;
@@ -80,6 +80,10 @@ public:
     // memory only
     mutable bool fChecked;
     mutable CTransactionRef txTPoSContract;
+    // Outcome of a block signature check done ahead of acceptance, under the
+    // legacy hash and the message signature scheme; -1 if not checked.
+    mutable int8_t nSigCheckLegacy;
+    mutable int8_t nSigCheckMessage;
 
     CBlock()
     {
@@ -110,6 +114,8 @@ public:
         CBlockHeader::SetNull();
         vtx.clear();
         fChecked = false;
+        nSigCheckLegacy = -1;
+        nSigCheckMessage = -1;
 		hashTPoSContractTx.SetNull();
 		vchBlockSig.clear();
     }
@@ -6,15 +6,24 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <governance/governance.h>
+#include <governance/governance-object.h>
 #include <index/txindex.h>
+#include <key_io.h>
+#include <masternode-payments.h>
+#include <masternodeman.h>
+#include <net_processing.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <validation.h>
+#include <validationmetrics.h>
 #include <httpserver.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <streams.h>
 #include <sync.h>
+#include <tpos/merchantnodeman.h>
+#include <tpos/tposutils.h>
 #include <txmempool.h>
 #include <utilstrencodings.h>
 #include <version.h>
@@ -24,6 +33,7 @@
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const size_t REST_CHUNK_SIZE = 64 * 1024; //flush streamed replies in chunks of this size
 
 enum class RetFormat {
     UNDEF,
@@ -318,6 +328,30 @@ static bool rest_mempool_info(HTTPRequest* req, const std::string& strURIPart)
     }
 }
 
+static bool rest_metrics(HTTPRequest* req, const std::string& strURIPart)
+{
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    switch (rf) {
+    case RetFormat::UNDEF: {
+        // Prometheus text exposition format, scraped without a suffix
+        req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+        req->WriteReply(HTTP_OK, validationmetrics.ToPrometheusText() + MessageLatencyToPrometheusText());
+        return true;
+    }
+    case RetFormat::JSON: {
+        std::string strJSON = validationStatsToJSON().write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json, or none for the Prometheus text format)");
+    }
+    }
+}
+
 static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPart)
 {
     if (!CheckWarmup(req))
@@ -573,6 +607,312 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     }
 }
 
+/** Writes a list reply in chunks while it is being produced, so the whole
+ * body never has to be built in memory. Writing blocks while the client is
+ * too far behind, so do not hold locks across calls. JSON lists are written as an array
+ * of objects, binary and hex lists as a compact size count followed by the
+ * serialized entries.
+ */
+class RESTListWriter
+{
+private:
+    HTTPRequest* req;
+    const RetFormat rf;
+    std::string strBuffer;
+    bool fFirst;
+
+    void Append(const std::string& str)
+    {
+        strBuffer += str;
+        if (strBuffer.size() >= REST_CHUNK_SIZE) {
+            req->WriteReplyChunk(strBuffer);
+            strBuffer.clear();
+        }
+    }
+
+    void AppendData(const CDataStream& ss)
+    {
+        Append(rf == RetFormat::HEX ? HexStr(ss.begin(), ss.end()) : ss.str());
+    }
+
+public:
+    RESTListWriter(HTTPRequest* reqIn, RetFormat rfIn, size_t nCount) : req(reqIn), rf(rfIn), fFirst(true)
+    {
+        switch (rf) {
+        case RetFormat::BINARY: req->WriteHeader("Content-Type", "application/octet-stream"); break;
+        case RetFormat::HEX: req->WriteHeader("Content-Type", "text/plain"); break;
+        default: req->WriteHeader("Content-Type", "application/json"); break;
+        }
+        req->WriteReplyStart(HTTP_OK);
+
+        if (rf == RetFormat::JSON) {
+            Append("[");
+        } else {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            WriteCompactSize(ss, nCount);
+            AppendData(ss);
+        }
+    }
+
+    template <typename T>
+    void Write(const T& entry, const UniValue& obj)
+    {
+        if (rf == RetFormat::JSON) {
+            Append(fFirst ? obj.write() : "," + obj.write());
+        } else {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << entry;
+            AppendData(ss);
+        }
+        fFirst = false;
+    }
+
+    bool WantsJSON() const { return rf == RetFormat::JSON; }
+
+    void End()
+    {
+        Append(rf == RetFormat::JSON ? "]\n" : (rf == RetFormat::HEX ? "\n" : ""));
+        req->WriteReplyChunk(strBuffer);
+        req->WriteReplyEnd();
+    }
+};
+
+static bool IsListFormat(RetFormat rf)
+{
+    return rf == RetFormat::BINARY || rf == RetFormat::HEX || rf == RetFormat::JSON;
+}
+
+static bool rest_masternodes(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!IsListFormat(rf) || !param.empty())
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    std::shared_ptr<const CMasternodeListSnapshot> snapshot = mnodeman.GetListSnapshot();
+    RESTListWriter writer(req, rf, snapshot->vMasternodes.size());
+    for (const auto& mnpair : snapshot->vMasternodes) {
+        const CMasternode& mn = mnpair.second;
+        UniValue obj(UniValue::VOBJ);
+        if (writer.WantsJSON()) {
+            obj.pushKV("outpoint", mnpair.first.ToStringShort());
+            obj.pushKV("status", mn.GetStatus());
+            obj.pushKV("protocol", (int64_t)mn.nProtocolVersion);
+            obj.pushKV("payee", CBitcoinAddress(mn.pubKeyCollateralAddress.GetID()).ToString());
+            obj.pushKV("pubkey", HexStr(mn.pubKeyMasternode));
+            obj.pushKV("addr", mn.addr.ToString());
+            obj.pushKV("lastseen", (int64_t)mn.lastPing.sigTime);
+            obj.pushKV("activeseconds", (int64_t)(mn.lastPing.sigTime - mn.sigTime));
+            obj.pushKV("lastpaidtime", mn.GetLastPaidTime());
+            obj.pushKV("lastpaidblock", mn.GetLastPaidBlock());
+        }
+        writer.Write(mn, obj);
+    }
+    writer.End();
+    return true;
+}
+
+static bool rest_merchantnodes(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!IsListFormat(rf) || !param.empty())
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    std::shared_ptr<const CMerchantnodeListSnapshot> snapshot = merchantnodeman.GetListSnapshot();
+    RESTListWriter writer(req, rf, snapshot->vMerchantnodes.size());
+    for (const auto& mnpair : snapshot->vMerchantnodes) {
+        const CMerchantnode& mn = mnpair.second;
+        UniValue obj(UniValue::VOBJ);
+        if (writer.WantsJSON()) {
+            obj.pushKV("pubkey", HexStr(mn.pubKeyMerchantnode));
+            obj.pushKV("status", mn.GetStatus());
+            obj.pushKV("protocol", (int64_t)mn.nProtocolVersion);
+            obj.pushKV("payee", CBitcoinAddress(mn.pubKeyMerchantnode.GetID()).ToString());
+            obj.pushKV("tposcontract", mn.hashTPoSContractTx.ToString());
+            obj.pushKV("addr", mn.addr.ToString());
+            obj.pushKV("lastseen", (int64_t)mn.lastPing.sigTime);
+            obj.pushKV("activeseconds", (int64_t)(mn.lastPing.sigTime - mn.sigTime));
+        }
+        writer.Write(mn, obj);
+    }
+    writer.End();
+    return true;
+}
+
+static bool rest_governance_objects(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!IsListFormat(rf) || !param.empty())
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    // Objects are only valid under governance.cs, but writing a chunk can
+    // block on a slow client. Copy them all under one hold, so the count
+    // written up front matches the entries, and stream with the lock released.
+    std::vector<CGovernanceObject> vObjects;
+    {
+        LOCK(governance.cs);
+        for (const CGovernanceObject* pGovObj : governance.GetAllNewerThan(0))
+            vObjects.push_back(*pGovObj);
+    }
+    RESTListWriter writer(req, rf, vObjects.size());
+    for (CGovernanceObject& govObj : vObjects) {
+        UniValue obj(UniValue::VOBJ);
+        if (writer.WantsJSON()) {
+            obj.pushKV("hash", govObj.GetHash().ToString());
+            obj.pushKV("collateralhash", govObj.GetCollateralHash().ToString());
+            obj.pushKV("objecttype", govObj.GetObjectType());
+            obj.pushKV("creationtime", govObj.GetCreationTime());
+            obj.pushKV("datahex", govObj.GetDataAsHex());
+            const CTxIn& masternodeVin = govObj.GetMasternodeVin();
+            if (masternodeVin != CTxIn()) {
+                obj.pushKV("signingmasternode", masternodeVin.prevout.ToStringShort());
+            }
+            obj.pushKV("absoluteyescount", govObj.GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING));
+            obj.pushKV("yescount", govObj.GetYesCount(VOTE_SIGNAL_FUNDING));
+            obj.pushKV("nocount", govObj.GetNoCount(VOTE_SIGNAL_FUNDING));
+            obj.pushKV("abstaincount", govObj.GetAbstainCount(VOTE_SIGNAL_FUNDING));
+            obj.pushKV("cachedvalid", govObj.IsSetCachedValid());
+            obj.pushKV("cachedfunding", govObj.IsSetCachedFunding());
+            obj.pushKV("cacheddelete", govObj.IsSetCachedDelete());
+            obj.pushKV("cachedendorsed", govObj.IsSetCachedEndorsed());
+        }
+        writer.Write(govObj, obj);
+    }
+    writer.End();
+    return true;
+}
+
+static bool rest_tposcontract(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    CTransactionRef tx;
+    uint256 hashBlock = uint256();
+    if (!GetTransaction(hash, tx, Params().GetConsensus(), hashBlock, true))
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+    if (!TPoSUtils::IsTPoSContract(tx))
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " is not a TPoS contract");
+
+    TPoSContract contract = TPoSContract::FromTPoSContractTx(tx);
+
+    CDataStream ssContract(SER_NETWORK, PROTOCOL_VERSION);
+    ssContract << contract;
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        std::string binaryContract = ssContract.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryContract);
+        return true;
+    }
+
+    case RetFormat::HEX: {
+        std::string strHex = HexStr(ssContract.begin(), ssContract.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RetFormat::JSON: {
+        CTxDestination tposAddress, merchantAddress;
+        ExtractDestination(contract.scriptTPoSAddress, tposAddress);
+        ExtractDestination(contract.scriptMerchantAddress, merchantAddress);
+
+        UniValue objContract(UniValue::VOBJ);
+        objContract.pushKV("txid", hash.GetHex());
+        objContract.pushKV("blockhash", hashBlock.GetHex());
+        objContract.pushKV("valid", contract.IsValid());
+        objContract.pushKV("version", contract.nVersion);
+        objContract.pushKV("tposaddress", EncodeDestination(tposAddress));
+        objContract.pushKV("merchantaddress", EncodeDestination(merchantAddress));
+        objContract.pushKV("commission", contract.nOperatorReward);
+        objContract.pushKV("deprecated", contract.vchSig.empty());
+        std::string strJSON = objContract.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_blockpayees(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string heightStr;
+    const RetFormat rf = ParseDataFormat(heightStr, strURIPart);
+
+    int32_t nHeight;
+    if (!ParseInt32(heightStr, &nHeight) || nHeight < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + heightStr);
+
+    CMasternodeBlockPayees blockPayees;
+    if (!mnpayments.GetBlockPayees(nHeight, blockPayees))
+        return RESTERR(req, HTTP_NOT_FOUND, "No payee votes for block " + heightStr);
+
+    CDataStream ssPayees(SER_NETWORK, PROTOCOL_VERSION);
+    ssPayees << blockPayees;
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        std::string binaryPayees = ssPayees.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryPayees);
+        return true;
+    }
+
+    case RetFormat::HEX: {
+        std::string strHex = HexStr(ssPayees.begin(), ssPayees.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RetFormat::JSON: {
+        UniValue payees(UniValue::VARR);
+        for (const CMasternodePayee& payee : blockPayees.vecPayees) {
+            CTxDestination dest;
+            ExtractDestination(payee.GetPayee(), dest);
+            UniValue objPayee(UniValue::VOBJ);
+            objPayee.pushKV("payee", EncodeDestination(dest));
+            objPayee.pushKV("votes", payee.GetVoteCount());
+            payees.push_back(objPayee);
+        }
+        UniValue objPayees(UniValue::VOBJ);
+        objPayees.pushKV("height", blockPayees.nBlockHeight);
+        objPayees.pushKV("payees", payees);
+        std::string strJSON = objPayees.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -583,8 +923,14 @@ static const struct {
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/info", rest_mempool_info},
       {"/rest/mempool/contents", rest_mempool_contents},
+      {"/rest/metrics", rest_metrics},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/masternodes", rest_masternodes},
+      {"/rest/merchantnodes", rest_merchantnodes},
+      {"/rest/governance/objects", rest_governance_objects},
+      {"/rest/tposcontract/", rest_tposcontract},
+      {"/rest/blockpayees/", rest_blockpayees},
 };
 
 bool StartREST()
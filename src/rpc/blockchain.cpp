@@ -13,6 +13,8 @@
 #include <consensus/validation.h>
 #include <validation.h>
 #include <core_io.h>
+#include <index/addressindex.h>
+#include <jsonwriter.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
@@ -21,10 +23,12 @@
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <utxosnapshot.h>
 #include <util.h>
 #include <utilstrencodings.h>
 #include <hash.h>
 #include <validationinterface.h>
+#include <validationmetrics.h>
 #include <warnings.h>
 
 #include <stdint.h>
@@ -162,6 +166,74 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     return result;
 }
 
+void blockToStream(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, JSONStreamWriter& writer)
+{
+    // Copy what is needed from the index, so that cs_main is not held while
+    // the output is handed to a possibly slow reader
+    uint256 hash, hashPrev, hashNext;
+    int confirmations = -1;
+    int64_t nMedianTimePast;
+    double dDifficulty;
+    std::string strChainWork;
+    {
+        LOCK(cs_main);
+        hash = blockindex->GetBlockHash();
+        // Only report confirmations if the block is on the main chain
+        if (chainActive.Contains(blockindex))
+            confirmations = chainActive.Height() - blockindex->nHeight + 1;
+        nMedianTimePast = blockindex->GetMedianTimePast();
+        dDifficulty = GetDifficulty(blockindex);
+        strChainWork = blockindex->nChainWork.GetHex();
+        if (blockindex->pprev)
+            hashPrev = blockindex->pprev->GetBlockHash();
+        CBlockIndex *pnext = chainActive.Next(blockindex);
+        if (pnext)
+            hashNext = pnext->GetBlockHash();
+    }
+
+    writer.BeginObject();
+    writer.KV("hash", hash.GetHex());
+    writer.KV("confirmations", confirmations);
+    writer.KV("strippedsize", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS));
+    writer.KV("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+    writer.KV("weight", (int)::GetBlockWeight(block));
+    writer.KV("height", blockindex->nHeight);
+    writer.KV("version", block.nVersion);
+    writer.KV("versionHex", strprintf("%08x", block.nVersion));
+    writer.KV("merkleroot", block.hashMerkleRoot.GetHex());
+    writer.Key("tx");
+    writer.BeginArray();
+    for(const auto& tx : block.vtx)
+    {
+        if(txDetails)
+        {
+            writer.BeginObject();
+            TxToStream(*tx, uint256(), writer, true, RPCSerializationFlags());
+            writer.EndObject();
+        }
+        else
+            writer.Value(tx->GetHash().GetHex());
+    }
+    writer.EndArray();
+    writer.KV("time", block.GetBlockTime());
+    writer.KV("mediantime", nMedianTimePast);
+    writer.KV("nonce", (uint64_t)block.nNonce);
+    writer.KV("bits", strprintf("%08x", block.nBits));
+    writer.KV("difficulty", dDifficulty);
+    writer.KV("chainwork", strChainWork);
+
+    if(block.IsTPoSBlock())
+    {
+        writer.KV("tposcontract", block.hashTPoSContractTx.ToString());
+    }
+
+    if (!hashPrev.IsNull())
+        writer.KV("previousblockhash", hashPrev.GetHex());
+    if (!hashNext.IsNull())
+        writer.KV("nextblockhash", hashNext.GetHex());
+    writer.EndObject();
+}
+
 static UniValue getblockcount(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -437,6 +509,78 @@ static void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCK
     info.pushKV("spentby", spent);
 }
 
+/** A mempool entry and what entryToStream looks up about it in the pool,
+ * copied under mempool.cs so that it can be written without the lock */
+struct CMempoolEntrySnapshot
+{
+    CTxMemPoolEntry entry;
+    uint256 wtxid;
+    std::set<std::string> setDepends;
+    std::vector<std::string> vSpentBy;
+
+    explicit CMempoolEntrySnapshot(const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(::mempool.cs) :
+        entry(e),
+        wtxid(mempool.vTxHashes[e.vTxHashesIdx].first)
+    {
+        AssertLockHeld(mempool.cs);
+        const CTransaction& tx = e.GetTx();
+        for (const CTxIn& txin : tx.vin)
+        {
+            if (mempool.exists(txin.prevout.hash))
+                setDepends.insert(txin.prevout.hash.ToString());
+        }
+        const CTxMemPool::txiter &it = mempool.mapTx.find(tx.GetHash());
+        const CTxMemPool::setEntries &setChildren = mempool.GetMemPoolChildren(it);
+        for (const CTxMemPool::txiter &childiter : setChildren) {
+            vSpentBy.push_back(childiter->GetTx().GetHash().ToString());
+        }
+    }
+};
+
+static void entryToStream(JSONStreamWriter& writer, const CMempoolEntrySnapshot& snapshot)
+{
+    const CTxMemPoolEntry& e = snapshot.entry;
+
+    writer.BeginObject();
+    writer.Key("fees");
+    writer.BeginObject();
+    writer.KV("base", ValueFromAmount(e.GetFee()));
+    writer.KV("modified", ValueFromAmount(e.GetModifiedFee()));
+    writer.KV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
+    writer.KV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    writer.EndObject();
+
+    writer.KV("size", (int)e.GetTxSize());
+    writer.KV("fee", ValueFromAmount(e.GetFee()));
+    writer.KV("modifiedfee", ValueFromAmount(e.GetModifiedFee()));
+    writer.KV("time", e.GetTime());
+    writer.KV("height", (int)e.GetHeight());
+    writer.KV("descendantcount", e.GetCountWithDescendants());
+    writer.KV("descendantsize", e.GetSizeWithDescendants());
+    writer.KV("descendantfees", e.GetModFeesWithDescendants());
+    writer.KV("ancestorcount", e.GetCountWithAncestors());
+    writer.KV("ancestorsize", e.GetSizeWithAncestors());
+    writer.KV("ancestorfees", e.GetModFeesWithAncestors());
+    writer.KV("wtxid", snapshot.wtxid.ToString());
+
+    writer.Key("depends");
+    writer.BeginArray();
+    for (const std::string& dep : snapshot.setDepends)
+    {
+        writer.Value(dep);
+    }
+    writer.EndArray();
+
+    writer.Key("spentby");
+    writer.BeginArray();
+    for (const std::string& child : snapshot.vSpentBy)
+    {
+        writer.Value(child);
+    }
+    writer.EndArray();
+    writer.EndObject();
+}
+
 UniValue mempoolToJSON(bool fVerbose)
 {
     if (fVerbose)
@@ -465,6 +609,26 @@ UniValue mempoolToJSON(bool fVerbose)
     }
 }
 
+void mempoolToStream(JSONStreamWriter& writer)
+{
+    // Writing may block on a slow reader, so only copy the entries under the lock
+    std::vector<CMempoolEntrySnapshot> vSnapshots;
+    {
+        LOCK(mempool.cs);
+        vSnapshots.reserve(mempool.mapTx.size());
+        for (const CTxMemPoolEntry& e : mempool.mapTx)
+            vSnapshots.emplace_back(e);
+    }
+
+    writer.BeginObject();
+    for (const CMempoolEntrySnapshot& snapshot : vSnapshots)
+    {
+        writer.Key(snapshot.entry.GetTx().GetHash().ToString());
+        entryToStream(writer, snapshot);
+    }
+    writer.EndObject();
+}
+
 static UniValue getrawmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 1)
@@ -497,6 +661,18 @@ static UniValue getrawmempool(const JSONRPCRequest& request)
     return mempoolToJSON(fVerbose);
 }
 
+static bool getrawmempool_stream(const JSONRPCRequest& request, JSONStreamWriter& writer)
+{
+    if (request.fHelp || request.params.size() > 1)
+        return false;
+
+    if (request.params[0].isNull() || !request.params[0].get_bool())
+        return false;
+
+    mempoolToStream(writer);
+    return true;
+}
+
 static UniValue getmempoolancestors(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2) {
@@ -683,6 +859,50 @@ static UniValue getblockhash(const JSONRPCRequest& request)
     return pblockindex->GetBlockHash().GetHex();
 }
 
+static UniValue getblockhashes(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 2)
+        throw std::runtime_error(
+            "getblockhashes high low\n"
+            "\nReturns hashes of the blocks with a timestamp in [low, high) (requires -timestampindex).\n"
+            "\nArguments:\n"
+            "1. high         (numeric, required) The newer block timestamp, exclusive\n"
+            "2. low          (numeric, required) The older block timestamp, inclusive\n"
+            "\nResult:\n"
+            "[\n"
+            "  \"hash\"       (string) The block hash\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockhashes", "1231614698 1231024505")
+            + HelpExampleRpc("getblockhashes", "1231614698, 1231024505")
+        );
+
+    if (!g_addressindex || !g_addressindex->IsTimestampIndexEnabled()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index not enabled. Start with -timestampindex to use this call");
+    }
+    if (!g_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is still being built, try again later");
+    }
+
+    int64_t nHigh = request.params[0].get_int64();
+    int64_t nLow = request.params[1].get_int64();
+    if (nLow < 0 || nHigh < nLow || nHigh > std::numeric_limits<uint32_t>::max()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid timestamp range");
+    }
+
+    std::vector<uint256> vHashes;
+    if (!g_addressindex->GetTimestampIndex(nHigh, nLow, vHashes)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read timestamp index");
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const uint256& hash : vHashes) {
+        result.push_back(hash.GetHex());
+    }
+    return result;
+}
+
 static UniValue getblockheader(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
@@ -742,6 +962,42 @@ static UniValue getblockheader(const JSONRPCRequest& request)
     return blockheaderToJSON(pblockindex);
 }
 
+static int ParseGetBlockVerbosity(const UniValue& param)
+{
+    int verbosity = 1;
+    if (!param.isNull()) {
+        if(param.isNum())
+            verbosity = param.get_int();
+        else
+            verbosity = param.get_bool() ? 1 : 0;
+    }
+    return verbosity;
+}
+
+static const CBlockIndex* ReadBlockForRPC(const UniValue& paramHash, CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    std::string strHash = paramHash.get_str();
+    uint256 hash(uint256S(strHash));
+
+    const CBlockIndex* pblockindex = LookupBlockIndex(hash);
+    if (!pblockindex) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+    }
+
+    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+
+    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        // Block not found on disk. This could be because we have the block
+        // header in our index but don't have the block (for example if a
+        // non-whitelisted node sends us an unrequested long chain of valid
+        // blocks, we add the headers to our index, but don't accept the
+        // block).
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+
+    return pblockindex;
+}
+
 static UniValue getblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
@@ -794,33 +1050,10 @@ static UniValue getblock(const JSONRPCRequest& request)
 
     LOCK(cs_main);
 
-    std::string strHash = request.params[0].get_str();
-    uint256 hash(uint256S(strHash));
-
-    int verbosity = 1;
-    if (!request.params[1].isNull()) {
-        if(request.params[1].isNum())
-            verbosity = request.params[1].get_int();
-        else
-            verbosity = request.params[1].get_bool() ? 1 : 0;
-    }
-
-    const CBlockIndex* pblockindex = LookupBlockIndex(hash);
-    if (!pblockindex) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-    }
+    int verbosity = ParseGetBlockVerbosity(request.params[1]);
 
     CBlock block;
-    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
-        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
-
-    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
-        // Block not found on disk. This could be because we have the block
-        // header in our index but don't have the block (for example if a
-        // non-whitelisted node sends us an unrequested long chain of valid
-        // blocks, we add the headers to our index, but don't accept the
-        // block).
-        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    const CBlockIndex* pblockindex = ReadBlockForRPC(request.params[0], block);
 
     if (verbosity <= 0)
     {
@@ -833,19 +1066,25 @@ static UniValue getblock(const JSONRPCRequest& request)
     return blockToJSON(block, pblockindex, verbosity >= 2);
 }
 
-struct CCoinsStats
+static bool getblock_stream(const JSONRPCRequest& request, JSONStreamWriter& writer)
 {
-    int nHeight;
-    uint256 hashBlock;
-    uint64_t nTransactions;
-    uint64_t nTransactionOutputs;
-    uint64_t nBogoSize;
-    uint256 hashSerialized;
-    uint64_t nDiskSize;
-    CAmount nTotalAmount;
-
-    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
-};
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        return false;
+
+    int verbosity = ParseGetBlockVerbosity(request.params[1]);
+    if (verbosity <= 0)
+        return false;
+
+    CBlock block;
+    const CBlockIndex* pblockindex;
+    {
+        LOCK(cs_main);
+        pblockindex = ReadBlockForRPC(request.params[0], block);
+    }
+
+    blockToStream(block, pblockindex, verbosity >= 2, writer);
+    return true;
+}
 
 static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
@@ -865,12 +1104,15 @@ static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash,
     ss << VARINT(0u);
 }
 
-//! Calculate statistics about the unspent transaction output set
-static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
+bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
     assert(pcursor);
+    return GetUTXOStats(view, pcursor.get(), stats);
+}
 
+bool GetUTXOStats(CCoinsView *view, CCoinsViewCursor *pcursor, CCoinsStats &stats)
+{
     CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
     stats.hashBlock = pcursor->GetBestBlock();
     {
@@ -995,6 +1237,112 @@ static UniValue gettxoutsetinfo(const JSONRPCRequest& request)
     return ret;
 }
 
+static UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrite the unspent transaction output set at the current tip to a snapshot file,\n"
+            "which a new node can start from with -loadtxoutset.\n"
+            "Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"path\"     (string, required) Path of the snapshot file, relative to the data directory unless absolute\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"coins_written\": n,         (numeric) The number of coins written\n"
+            "  \"base_hash\": \"hash\",        (string) The hash of the block the snapshot was taken at\n"
+            "  \"base_height\": n,           (numeric) The height of that block\n"
+            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash, as reported by gettxoutsetinfo\n"
+            "  \"path\": \"path\"              (string) The absolute path of the snapshot file\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+
+    const fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    // Write to a temporary file, so that a complete snapshot is never confused with a partial one
+    const fs::path pathTemp = fs::absolute(request.params[0].get_str() + ".incomplete", GetDataDir());
+    if (fs::exists(path)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+    }
+
+    CAutoFile file(fsbridge::fopen(pathTemp, "wb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to open " + pathTemp.string() + " for writing");
+    }
+
+    CUTXOSnapshotMetadata metadata;
+    CCoinsStats stats;
+    std::unique_ptr<CCoinsViewCursor> pcursorStats;
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    {
+        // Both cursors read from the state the database is in when they are
+        // created, and nothing writes to it while cs_main is held. The stats
+        // and the coins written are taken from that state after releasing it.
+        LOCK(cs_main);
+        FlushStateToDisk();
+        pcursorStats.reset(pcoinsdbview->Cursor());
+        pcursor.reset(pcoinsdbview->Cursor());
+    }
+
+    uint64_t nCoinsWritten = 0;
+    try {
+        if (!GetUTXOStats(pcoinsdbview.get(), pcursorStats.get(), stats)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        }
+        pcursorStats.reset();
+        const CBlockIndex* pindexBase;
+        {
+            LOCK(cs_main);
+            pindexBase = LookupBlockIndex(stats.hashBlock);
+        }
+        assert(pindexBase);
+        memcpy(metadata.pchMessageStart, Params().MessageStart(), sizeof(metadata.pchMessageStart));
+        metadata.hashBaseBlock = stats.hashBlock;
+        metadata.nBaseHeight = pindexBase->nHeight;
+        metadata.nCoinsCount = stats.nTransactionOutputs;
+        metadata.hashSerialized = stats.hashSerialized;
+        metadata.nMoneySupply = pindexBase->nMoneySupply;
+
+        file << metadata;
+        while (pcursor->Valid()) {
+            boost::this_thread::interruption_point();
+            COutPoint key;
+            Coin coin;
+            if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+            }
+            file << key;
+            file << coin;
+            ++nCoinsWritten;
+            pcursor->Next();
+        }
+    } catch (...) {
+        // Do not leave a partial snapshot behind on errors or interruption
+        file.fclose();
+        fs::remove(pathTemp);
+        throw;
+    }
+    file.fclose();
+
+    if (nCoinsWritten != metadata.nCoinsCount) {
+        fs::remove(pathTemp);
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "UTXO set changed while it was written");
+    }
+    if (!RenameOver(pathTemp, path)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to rename " + pathTemp.string());
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("coins_written", nCoinsWritten);
+    ret.pushKV("base_hash", metadata.hashBaseBlock.GetHex());
+    ret.pushKV("base_height", metadata.nBaseHeight);
+    ret.pushKV("hash_serialized_2", metadata.hashSerialized.GetHex());
+    ret.pushKV("path", path.string());
+    return ret;
+}
+
 UniValue gettxout(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 2 || request.params.size() > 3)
@@ -1430,6 +1778,71 @@ static UniValue getmempoolinfo(const JSONRPCRequest& request)
     return mempoolInfoToJSON();
 }
 
+UniValue validationStatsToJSON()
+{
+    UniValue ret(UniValue::VOBJ);
+    for (size_t i = 0; i < static_cast<size_t>(ValidationStage::COUNT); i++) {
+        const ValidationStage stage = static_cast<ValidationStage>(i);
+        const CLatencyHistogram::Snapshot snapshot = validationmetrics.GetSnapshot(stage);
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("count", (uint64_t) snapshot.nCount);
+        obj.pushKV("total_ms", snapshot.nSumMicros / 1000.0);
+        obj.pushKV("mean_ms", snapshot.nCount == 0 ? 0.0 : snapshot.nSumMicros / 1000.0 / snapshot.nCount);
+        obj.pushKV("max_ms", snapshot.nMaxMicros / 1000.0);
+        obj.pushKV("p50_ms", snapshot.GetQuantile(0.5) / 1000.0);
+        obj.pushKV("p90_ms", snapshot.GetQuantile(0.9) / 1000.0);
+        obj.pushKV("p99_ms", snapshot.GetQuantile(0.99) / 1000.0);
+        UniValue buckets(UniValue::VOBJ);
+        for (size_t j = 0; j + 1 < snapshot.vBuckets.size(); j++) {
+            buckets.pushKV(strprintf("%g", LATENCY_HISTOGRAM_BOUNDS[j] / 1000.0), (uint64_t) snapshot.vBuckets[j]);
+        }
+        buckets.pushKV("+Inf", (uint64_t) snapshot.vBuckets.back());
+        obj.pushKV("buckets", buckets);
+        ret.pushKV(CValidationMetrics::GetStageName(stage), obj);
+    }
+    return ret;
+}
+
+static UniValue getvalidationstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getvalidationstats ( reset )\n"
+            "\nReturns latency histograms of the block validation stages since startup or the last reset.\n"
+            "The same histograms are served in the Prometheus text format at /rest/metrics.\n"
+            "\nArguments:\n"
+            "1. reset      (boolean, optional, default=false) Clear the histograms after reading them\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"stage\": {                (json object) one object per stage, e.g. connect_tip, verify_inputs, proof_of_stake, block_payee\n"
+            "    \"count\": xxxxx,          (numeric) Number of times the stage ran\n"
+            "    \"total_ms\": xxxxx,       (numeric) Total time spent in the stage\n"
+            "    \"mean_ms\": xxxxx,        (numeric) Mean time per run\n"
+            "    \"max_ms\": xxxxx,         (numeric) Longest run\n"
+            "    \"p50_ms\": xxxxx,         (numeric) Median, estimated as the upper bound of its bucket\n"
+            "    \"p90_ms\": xxxxx,         (numeric) 90th percentile, estimated the same way\n"
+            "    \"p99_ms\": xxxxx,         (numeric) 99th percentile, estimated the same way\n"
+            "    \"buckets\": {             (json object) Runs per bucket, keyed by the bucket's upper bound in milliseconds\n"
+            "      \"0.1\": n,\n"
+            "      ...\n"
+            "      \"+Inf\": n\n"
+            "    }\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getvalidationstats", "")
+            + HelpExampleRpc("getvalidationstats", "true")
+        );
+
+    UniValue ret = validationStatsToJSON();
+    if (!request.params[0].isNull() && request.params[0].get_bool()) {
+        validationmetrics.Reset();
+    }
+    return ret;
+}
+
 static UniValue preciousblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -1645,12 +2058,14 @@ static UniValue savemempool(const JSONRPCRequest& request)
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           {"path"} },
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
     { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
     { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
     { "blockchain",         "getblockcount",          &getblockcount,          {} },
     { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"} },
     { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
+    { "blockchain",         "getblockhashes",         &getblockhashes,         {"high","low"} },
     { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           {} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
@@ -1661,6 +2076,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "getvalidationstats",     &getvalidationstats,     {"reset"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
@@ -1676,8 +2092,20 @@ static const CRPCCommand commands[] =
     { "hidden",             "syncwithvalidationinterfacequeue", &syncwithvalidationinterfacequeue, {} },
 };
 
+static const struct {
+    const char* name;
+    rpcstreamfn_type actor;
+} stream_commands[] =
+{ //  name                      actor
+  //  ------------------------  -----------------------
+    { "getblock",               &getblock_stream        },
+    { "getrawmempool",          &getrawmempool_stream   },
+};
+
 void RegisterBlockchainRPCCommands(CRPCTable &t)
 {
     for (unsigned int vcidx = 0; vcidx < ARRAYLEN(commands); vcidx++)
         t.appendCommand(commands[vcidx].name, &commands[vcidx]);
+    for (unsigned int vcidx = 0; vcidx < ARRAYLEN(stream_commands); vcidx++)
+        t.appendStreamActor(stream_commands[vcidx].name, stream_commands[vcidx].actor);
 }
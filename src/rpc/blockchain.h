@@ -5,10 +5,32 @@
 #ifndef BITCOIN_RPC_BLOCKCHAIN_H
 #define BITCOIN_RPC_BLOCKCHAIN_H
 
+#include <amount.h>
+#include <uint256.h>
+
+#include <stdint.h>
+
 class CBlock;
 class CBlockIndex;
+class CCoinsView;
+class CCoinsViewCursor;
+class JSONStreamWriter;
 class UniValue;
 
+struct CCoinsStats
+{
+    int nHeight;
+    uint256 hashBlock;
+    uint64_t nTransactions;
+    uint64_t nTransactionOutputs;
+    uint64_t nBogoSize;
+    uint256 hashSerialized;
+    uint64_t nDiskSize;
+    CAmount nTotalAmount;
+
+    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
+};
+
 /**
  * Get the difficulty of the net wrt to the given block index, or the chain tip if
  * not provided.
@@ -24,12 +46,28 @@ void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
 
+/** Block description written to a JSON stream, same output as blockToJSON.
+ * Takes cs_main only to read the index, not while writing. */
+void blockToStream(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, JSONStreamWriter& writer);
+
 /** Mempool information to JSON */
 UniValue mempoolInfoToJSON();
 
+/** Validation stage latency histograms to JSON */
+UniValue validationStatsToJSON();
+
 /** Mempool to JSON */
 UniValue mempoolToJSON(bool fVerbose = false);
 
+/** Verbose mempool written to a JSON stream, same output as mempoolToJSON(true).
+ * The entries are copied under mempool.cs and written without it. */
+void mempoolToStream(JSONStreamWriter& writer);
+
+/** Calculate statistics about the unspent transaction output set */
+bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats);
+/** Calculate the statistics from a cursor already opened on view, e.g. to match another cursor on the same state */
+bool GetUTXOStats(CCoinsView *view, CCoinsViewCursor *pcursor, CCoinsStats &stats);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* blockindex);
 
@@ -93,6 +93,17 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getblock", 1, "verbosity" },
     { "getblock", 1, "verbose" },
     { "getblockheader", 1, "verbose" },
+    { "getblockhashes", 0, "high" },
+    { "getblockhashes", 1, "low" },
+    { "getaddressbalance", 0, "addresses" },
+    { "getaddressutxos", 0, "addresses" },
+    { "getaddressdeltas", 0, "addresses" },
+    { "getaddressdeltas", 1, "start" },
+    { "getaddressdeltas", 2, "end" },
+    { "getaddresstxids", 0, "addresses" },
+    { "getaddresstxids", 1, "start" },
+    { "getaddresstxids", 2, "end" },
+    { "getspentinfo", 1, "index" },
     { "getchaintxstats", 0, "nblocks" },
     { "gettransaction", 1, "include_watchonly" },
     { "getrawtransaction", 1, "verbose" },
@@ -123,6 +134,10 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "importpubkey", 2, "rescan" },
     { "importmulti", 0, "requests" },
     { "importmulti", 1, "options" },
+    { "getvalidationstats", 0, "reset" },
+    { "getlockstats", 0, "count" },
+    { "getlockstats", 2, "reset" },
+    { "setlockprofiling", 0, "enable" },
     { "verifychain", 0, "checklevel" },
     { "verifychain", 1, "nblocks" },
     { "pruneblockchain", 0, "height" },
@@ -5,9 +5,12 @@
 #include <activemasternode.h>
 #include <key_io.h>
 #include <init.h>
+#include <jsonwriter.h>
 #include <netbase.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <masternode-payments.h>
+#include <masternode-registry.h>
 #include <masternode-sync.h>
 #include <masternodeconfig.h>
 #include <masternodeman.h>
@@ -109,6 +112,41 @@ static UniValue getpoolinfo(const JSONRPCRequest& request)
 }
 #endif
 
+/** Unfiltered masternodelist results per mode, tagged with the list snapshot version they were built from */
+static CCriticalSection cs_masternodelist_cache;
+static std::map<std::string, std::pair<uint64_t, UniValue> > mapMasternodeListCache GUARDED_BY(cs_masternodelist_cache);
+/** Tip the masternode last paid data was last refreshed for by masternodelist */
+static std::atomic<const CBlockIndex*> pindexMasternodeLastPaidUpdate(nullptr);
+
+static void UpdateMasternodeListLastPaid()
+{
+    CBlockIndex* pindex = NULL;
+    {
+        LOCK(cs_main);
+        pindex = chainActive.Tip();
+    }
+    // Last paid data only changes with the tip, don't rescan (and invalidate the
+    // list snapshot) on every poll
+    if (pindexMasternodeLastPaidUpdate.exchange(pindex) != pindex) {
+        mnodeman.UpdateLastPaid(pindex);
+    }
+}
+
+static std::string MasternodeFullString(const CMasternode& mn)
+{
+    std::ostringstream streamFull;
+    streamFull << std::setw(18) <<
+                   mn.GetStatus() << " " <<
+                   mn.nProtocolVersion << " " <<
+                   CBitcoinAddress(mn.pubKeyCollateralAddress.GetID()).ToString() << " " <<
+                   (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
+                   (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " << std::setw(10) <<
+                   mn.GetLastPaidTime() << " "  << std::setw(6) <<
+                   mn.GetLastPaidBlock() << " " <<
+                   mn.addr.ToString();
+    return streamFull.str();
+}
+
 static UniValue masternodelist(const JSONRPCRequest& request)
 {
     std::string strMode = "status";
@@ -152,12 +190,7 @@ static UniValue masternodelist(const JSONRPCRequest& request)
     }
 
     if (strMode == "full" || strMode == "lastpaidtime" || strMode == "lastpaidblock") {
-        CBlockIndex* pindex = NULL;
-        {
-            LOCK(cs_main);
-            pindex = chainActive.Tip();
-        }
-        mnodeman.UpdateLastPaid(pindex);
+        UpdateMasternodeListLastPaid();
     }
 
     UniValue obj(UniValue::VOBJ);
@@ -169,81 +202,112 @@ static UniValue masternodelist(const JSONRPCRequest& request)
             if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
             obj.push_back(Pair(strOutpoint, s.first));
         }
-    } else {
-        std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
-        for (auto& mnpair : mapMasternodes) {
-            CMasternode mn = mnpair.second;
-            std::string strOutpoint = mnpair.first.ToString();
-            if (strMode == "activeseconds") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, (int64_t)(mn.lastPing.sigTime - mn.sigTime)));
-            } else if (strMode == "addr") {
-                std::string strAddress = mn.addr.ToString();
-                if (strFilter !="" && strAddress.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, strAddress));
-            } else if (strMode == "full") {
-                std::ostringstream streamFull;
-                streamFull << std::setw(18) <<
-                               mn.GetStatus() << " " <<
-                               mn.nProtocolVersion << " " <<
-                               CBitcoinAddress(mn.pubKeyCollateralAddress.GetID()).ToString() << " " <<
-                               (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
-                               (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " << std::setw(10) <<
-                               mn.GetLastPaidTime() << " "  << std::setw(6) <<
-                               mn.GetLastPaidBlock() << " " <<
-                               mn.addr.ToString();
-                std::string strFull = streamFull.str();
-                if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, strFull));
-            } else if (strMode == "info") {
-                std::ostringstream streamInfo;
-                streamInfo << std::setw(18) <<
-                               mn.GetStatus() << " " <<
-                               mn.nProtocolVersion << " " <<
-                               CBitcoinAddress(mn.pubKeyCollateralAddress.GetID()).ToString() << " " <<
-                               (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
-                               (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " <<
-                               (mn.lastPing.fSentinelIsCurrent ? "current" : "expired") << " " <<
-                               mn.addr.ToString();
-                std::string strInfo = streamInfo.str();
-                if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, strInfo));
-            } else if (strMode == "lastpaidblock") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, mn.GetLastPaidBlock()));
-            } else if (strMode == "lastpaidtime") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, mn.GetLastPaidTime()));
-            } else if (strMode == "lastseen") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, (int64_t)mn.lastPing.sigTime));
-            } else if (strMode == "payee") {
-                CBitcoinAddress address(mn.pubKeyCollateralAddress.GetID());
-                std::string strPayee = address.ToString();
-                if (strFilter !="" && strPayee.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, strPayee));
-            } else if (strMode == "protocol") {
-                if (strFilter !="" && strFilter != strprintf("%d", mn.nProtocolVersion) &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, (int64_t)mn.nProtocolVersion));
-            } else if (strMode == "pubkey") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, HexStr(mn.pubKeyMasternode)));
-            } else if (strMode == "status") {
-                std::string strStatus = mn.GetStatus();
-                if (strFilter !="" && strStatus.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.push_back(Pair(strOutpoint, strStatus));
-            }
+        return obj;
+    }
+
+    std::shared_ptr<const CMasternodeListSnapshot> snapshot = mnodeman.GetListSnapshot();
+    if (strFilter == "") {
+        LOCK(cs_masternodelist_cache);
+        auto it = mapMasternodeListCache.find(strMode);
+        if (it != mapMasternodeListCache.end() && it->second.first == snapshot->nVersion) {
+            return it->second.second;
         }
     }
+
+    for (auto& mnpair : snapshot->vMasternodes) {
+        const CMasternode& mn = mnpair.second;
+        std::string strOutpoint = mnpair.first.ToString();
+        if (strMode == "activeseconds") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, (int64_t)(mn.lastPing.sigTime - mn.sigTime)));
+        } else if (strMode == "addr") {
+            std::string strAddress = mn.addr.ToString();
+            if (strFilter !="" && strAddress.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, strAddress));
+        } else if (strMode == "full") {
+            std::string strFull = MasternodeFullString(mn);
+            if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, strFull));
+        } else if (strMode == "info") {
+            std::ostringstream streamInfo;
+            streamInfo << std::setw(18) <<
+                           mn.GetStatus() << " " <<
+                           mn.nProtocolVersion << " " <<
+                           CBitcoinAddress(mn.pubKeyCollateralAddress.GetID()).ToString() << " " <<
+                           (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
+                           (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " <<
+                           (mn.lastPing.fSentinelIsCurrent ? "current" : "expired") << " " <<
+                           mn.addr.ToString();
+            std::string strInfo = streamInfo.str();
+            if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, strInfo));
+        } else if (strMode == "lastpaidblock") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, mn.GetLastPaidBlock()));
+        } else if (strMode == "lastpaidtime") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, mn.GetLastPaidTime()));
+        } else if (strMode == "lastseen") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, (int64_t)mn.lastPing.sigTime));
+        } else if (strMode == "payee") {
+            CBitcoinAddress address(mn.pubKeyCollateralAddress.GetID());
+            std::string strPayee = address.ToString();
+            if (strFilter !="" && strPayee.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, strPayee));
+        } else if (strMode == "protocol") {
+            if (strFilter !="" && strFilter != strprintf("%d", mn.nProtocolVersion) &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, (int64_t)mn.nProtocolVersion));
+        } else if (strMode == "pubkey") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, HexStr(mn.pubKeyMasternode)));
+        } else if (strMode == "status") {
+            std::string strStatus = mn.GetStatus();
+            if (strFilter !="" && strStatus.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.push_back(Pair(strOutpoint, strStatus));
+        }
+    }
+
+    if (strFilter == "") {
+        LOCK(cs_masternodelist_cache);
+        mapMasternodeListCache[strMode] = std::make_pair(snapshot->nVersion, obj);
+    }
     return obj;
 }
 
+/** masternodelist full, written straight from the list snapshot without building a UniValue */
+static bool masternodelist_stream(const JSONRPCRequest& request, JSONStreamWriter& writer)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        return false;
+
+    if (request.params[0].get_str() != "full")
+        return false;
+
+    std::string strFilter = "";
+    if (request.params.size() == 2) strFilter = request.params[1].get_str();
+
+    UpdateMasternodeListLastPaid();
+
+    std::shared_ptr<const CMasternodeListSnapshot> snapshot = mnodeman.GetListSnapshot();
+    writer.BeginObject();
+    for (auto& mnpair : snapshot->vMasternodes) {
+        std::string strOutpoint = mnpair.first.ToString();
+        std::string strFull = MasternodeFullString(mnpair.second);
+        if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
+            strOutpoint.find(strFilter) == std::string::npos) continue;
+        writer.KV(strOutpoint, strFull);
+    }
+    writer.EndObject();
+    return true;
+}
+
 UniValue mnsync(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -883,6 +947,76 @@ static UniValue masternodebroadcast(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+static UniValue masternoderegistry(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1) {
+        throw std::runtime_error(
+            "masternoderegistry ( \"filter\" )\n"
+            "\nList the masternode collaterals found in the chain, whether or not their\n"
+            "masternode has been announced to this node. Requires -masternoderegistry.\n"
+            "\nArguments:\n"
+            "1. \"filter\"    (string, optional) Partial match by outpoint or payee\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"height\": n,            (numeric) Height of the block the registry is in sync with\n"
+            "  \"collaterals\": [        (array)\n"
+            "    {\n"
+            "      \"outpoint\": \"xxxx\",      (string) Collateral outpoint\n"
+            "      \"height\": n,               (numeric) Height the collateral confirmed at\n"
+            "      \"confirmations\": n,        (numeric) Number of confirmations\n"
+            "      \"payee\": \"xxxx\",         (string) XSN address the collateral pays to\n"
+            "      \"status\": \"xxxx\"         (string) Status in the masternode list, UNKNOWN if not announced\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("masternoderegistry", "")
+            + HelpExampleRpc("masternoderegistry", "")
+        );
+    }
+
+    std::string strFilter;
+    if (!request.params[0].isNull()) strFilter = request.params[0].get_str();
+
+    if (!mnregistry.IsRunning())
+        throw JSONRPCError(RPC_MISC_ERROR, "The masternode registry is disabled, restart with -masternoderegistry");
+
+    // Make sure the registry has seen every block connected so far
+    SyncWithValidationInterfaceQueue();
+
+    const CBlockIndex* pindexBest = mnregistry.GetBestBlock();
+    if (!pindexBest) {
+        // A block could not be applied, scan the chainstate again
+        if (!mnregistry.Rebuild())
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        pindexBest = mnregistry.GetBestBlock();
+    }
+    const int nHeight = pindexBest ? pindexBest->nHeight : -1;
+
+    UniValue arrCollaterals(UniValue::VARR);
+    for (const auto& pair : mnregistry.GetCollaterals()) {
+        std::string strOutpoint = pair.first.ToStringShort();
+        CTxDestination dest;
+        std::string strPayee = ExtractDestination(pair.second.scriptPubKey, dest) ? EncodeDestination(dest) : "";
+        if (strFilter != "" && strOutpoint.find(strFilter) == std::string::npos &&
+            strPayee.find(strFilter) == std::string::npos) continue;
+
+        CMasternode mn;
+        UniValue objCollateral(UniValue::VOBJ);
+        objCollateral.push_back(Pair("outpoint", strOutpoint));
+        objCollateral.push_back(Pair("height", pair.second.nHeight));
+        objCollateral.push_back(Pair("confirmations", nHeight - pair.second.nHeight + 1));
+        objCollateral.push_back(Pair("payee", strPayee));
+        objCollateral.push_back(Pair("status", mnodeman.Get(pair.first, mn) ? mn.GetStatus() : "UNKNOWN"));
+        arrCollaterals.push_back(objCollateral);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("height", nHeight));
+    obj.push_back(Pair("collaterals", arrCollaterals));
+    return obj;
+}
+
 static UniValue sentinelping(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1) {
@@ -909,12 +1043,24 @@ static const CRPCCommand commands[] =
     { "masternode",            "masternode",            &masternode,            {"command"} }, /* uses wallet if enabled */
     { "masternode",            "masternodelist",        &masternodelist,        {"mode", "filter"} },
     { "masternode",            "masternodebroadcast",   &masternodebroadcast,   {"command"} },
+    { "masternode",            "masternoderegistry",    &masternoderegistry,    {"filter"} },
     { "masternode",            "sentinelping",          &sentinelping,          {"version"} },
     { "masternode",            "mnsync",                &mnsync,                {"command"} },
 };
 
+static const struct {
+    const char* name;
+    rpcstreamfn_type actor;
+} stream_commands[] =
+{ //  name                     actor
+  //  -----------------------  -----------------------
+    { "masternodelist",        &masternodelist_stream  },
+};
+
 void RegisterMasternodeCommands(CRPCTable &t)
 {
     for (unsigned int vcidx = 0; vcidx < ARRAYLEN(commands); vcidx++)
         t.appendCommand(commands[vcidx].name, &commands[vcidx]);
+    for (unsigned int vcidx = 0; vcidx < ARRAYLEN(stream_commands); vcidx++)
+        t.appendStreamActor(stream_commands[vcidx].name, stream_commands[vcidx].actor);
 }
@@ -63,6 +63,10 @@ static UniValue merchantsync(const JSONRPCRequest& request)
 }
 
 
+/** Unfiltered merchantnodelist results per mode, tagged with the list snapshot version they were built from */
+static CCriticalSection cs_merchantnodelist_cache;
+static std::map<std::string, std::pair<uint64_t, UniValue> > mapMerchantnodeListCache GUARDED_BY(cs_merchantnodelist_cache);
+
 static UniValue ListOfMerchantNodes(const UniValue& params, std::set<CService> myMerchantNodesIps, bool showOnlyMine)
 {
     std::string strMode = "status";
@@ -73,14 +77,23 @@ static UniValue ListOfMerchantNodes(const UniValue& params, std::set<CService> m
 
     UniValue obj(UniValue::VOBJ);
 
-    auto mapMerchantnodes = merchantnodeman.GetFullMerchantnodeMap();
-    for (auto& mnpair : mapMerchantnodes) {
+    std::shared_ptr<const CMerchantnodeListSnapshot> snapshot = merchantnodeman.GetListSnapshot();
+    bool fCacheable = !showOnlyMine && strFilter == "";
+    if (fCacheable) {
+        LOCK(cs_merchantnodelist_cache);
+        auto it = mapMerchantnodeListCache.find(strMode);
+        if (it != mapMerchantnodeListCache.end() && it->second.first == snapshot->nVersion) {
+            return it->second.second;
+        }
+    }
+
+    for (auto& mnpair : snapshot->vMerchantnodes) {
 
         if(showOnlyMine && myMerchantNodesIps.count(mnpair.second.addr) == 0) {
             continue;
         }
 
-        CMerchantnode mn = mnpair.second;
+        const CMerchantnode& mn = mnpair.second;
         std::string strOutpoint = HexStr(mnpair.first.GetID().ToString());
         if (strMode == "activeseconds") {
             if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
@@ -142,6 +155,10 @@ static UniValue ListOfMerchantNodes(const UniValue& params, std::set<CService> m
         }
     }
 
+    if (fCacheable) {
+        LOCK(cs_merchantnodelist_cache);
+        mapMerchantnodeListCache[strMode] = std::make_pair(snapshot->nVersion, obj);
+    }
     return obj;
 }
 
@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <blockcache.h>
 #include <chain.h>
 #include <clientversion.h>
 #include <core_io.h>
@@ -11,11 +12,13 @@
 #include <key_io.h>
 #include <validation.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <net.h>
 #include <netbase.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
+#include <sync.h>
 #include <timedata.h>
 #include <util.h>
 #include <utilstrencodings.h>
@@ -33,6 +36,8 @@
 #endif
 #include <warnings.h>
 
+#include <algorithm>
+#include <functional>
 #include <stdint.h>
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
@@ -282,6 +287,20 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCBlockCacheInfo()
+{
+    CBlockCache::Stats stats = blockcache.GetStats();
+    const uint64_t nReads = stats.nHits + stats.nMisses;
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(stats.nEntries));
+    obj.pushKV("usage", uint64_t(stats.nBytes));
+    obj.pushKV("limit", uint64_t(stats.nMaxBytes));
+    obj.pushKV("hits", stats.nHits);
+    obj.pushKV("misses", stats.nMisses);
+    obj.pushKV("hitrate", nReads ? (double)stats.nHits / nReads : 0.0);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -323,6 +342,14 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"blockcache\": {           (json object) Information about the cache of recently used blocks\n"
+            "    \"entries\": xxxxx,       (numeric) Number of cached blocks\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated memory used by the cached blocks, in bytes\n"
+            "    \"limit\": xxxxx,         (numeric) Memory limit set with -blockcachesize, in bytes\n"
+            "    \"hits\": xxxxx,          (numeric) Number of block reads answered from the cache\n"
+            "    \"misses\": xxxxx,        (numeric) Number of block reads that went to disk\n"
+            "    \"hitrate\": x.xxx        (numeric) Fraction of block reads answered from the cache\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -336,6 +363,7 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("blockcache", RPCBlockCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -435,6 +463,111 @@ UniValue logging(const JSONRPCRequest& request)
     return result;
 }
 
+static UniValue setlockprofiling(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "setlockprofiling enable\n"
+            "\nTurns recording of lock wait and hold times on or off, see getlockstats.\n"
+            "Statistics recorded so far are kept when it is turned off.\n"
+            "\nArguments:\n"
+            "1. enable       (boolean, required) Whether to record lock statistics\n"
+            "\nExamples:\n"
+            + HelpExampleCli("setlockprofiling", "true")
+            + HelpExampleRpc("setlockprofiling", "true")
+        );
+
+    g_lock_profiling = request.params[0].get_bool();
+    return NullUniValue;
+}
+
+static UniValue getlockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 3)
+        throw std::runtime_error(
+            "getlockstats ( count \"sortby\" reset )\n"
+            "\nReturns the lock sites that waited for or held their locks the longest while lock profiling was on.\n"
+            "Lock profiling is turned on by -lockprofiling or setlockprofiling.\n"
+            "\nArguments:\n"
+            "1. count        (numeric, optional, default=20) Number of lock sites to return, 0 for all\n"
+            "2. \"sortby\"     (string, optional, default=\"wait\") Order of the sites: \"wait\", \"hold\" or \"count\"\n"
+            "3. reset        (boolean, optional, default=false) Clear the statistics after reading them\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"enabled\": true|false,      (boolean) Whether lock profiling is on\n"
+            "  \"sites\": [\n"
+            "    {\n"
+            "      \"lock\": \"name\",          (string) The lock as passed to LOCK, e.g. cs_main\n"
+            "      \"site\": \"file:line\",     (string) Where it was locked\n"
+            "      \"acquisitions\": n,       (numeric) Number of times it was locked there\n"
+            "      \"contentions\": n,        (numeric) Number of times it had to wait for another thread\n"
+            "      \"wait_ms\": n,            (numeric) Total time spent waiting\n"
+            "      \"max_wait_ms\": n,        (numeric) Longest wait\n"
+            "      \"hold_ms\": n,            (numeric) Total time it was held\n"
+            "      \"max_hold_ms\": n         (numeric) Longest time it was held\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getlockstats", "")
+            + HelpExampleCli("getlockstats", "10 \"hold\"")
+            + HelpExampleRpc("getlockstats", "10, \"hold\", true")
+        );
+
+    size_t nCount = 20;
+    if (!request.params[0].isNull()) {
+        int nCountParam = request.params[0].get_int();
+        if (nCountParam < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+        nCount = nCountParam;
+    }
+
+    std::string strSortBy = "wait";
+    if (!request.params[1].isNull()) {
+        strSortBy = request.params[1].get_str();
+    }
+    std::function<bool(const LockSiteStats&, const LockSiteStats&)> compare;
+    if (strSortBy == "wait") {
+        compare = [](const LockSiteStats& a, const LockSiteStats& b) { return a.nWaitMicros > b.nWaitMicros; };
+    } else if (strSortBy == "hold") {
+        compare = [](const LockSiteStats& a, const LockSiteStats& b) { return a.nHoldMicros > b.nHoldMicros; };
+    } else if (strSortBy == "count") {
+        compare = [](const LockSiteStats& a, const LockSiteStats& b) { return a.nAcquisitions > b.nAcquisitions; };
+    } else {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid sortby, expected wait, hold or count");
+    }
+
+    std::vector<LockSiteStats> vStats = GetLockProfile();
+    if (!request.params[2].isNull() && request.params[2].get_bool()) {
+        ResetLockProfile();
+    }
+    if (nCount == 0 || nCount > vStats.size()) {
+        nCount = vStats.size();
+    }
+    std::partial_sort(vStats.begin(), vStats.begin() + nCount, vStats.end(), compare);
+
+    UniValue sites(UniValue::VARR);
+    for (size_t i = 0; i < nCount; i++) {
+        const LockSiteStats& stats = vStats[i];
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("lock", stats.pszName);
+        obj.pushKV("site", strprintf("%s:%d", stats.pszFile, stats.nLine));
+        obj.pushKV("acquisitions", (uint64_t) stats.nAcquisitions);
+        obj.pushKV("contentions", (uint64_t) stats.nContentions);
+        obj.pushKV("wait_ms", stats.nWaitMicros / 1000.0);
+        obj.pushKV("max_wait_ms", stats.nMaxWaitMicros / 1000.0);
+        obj.pushKV("hold_ms", stats.nHoldMicros / 1000.0);
+        obj.pushKV("max_hold_ms", stats.nMaxHoldMicros / 1000.0);
+        sites.push_back(obj);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("enabled", g_lock_profiling.load());
+    result.pushKV("sites", sites);
+    return result;
+}
+
 static UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -553,17 +686,315 @@ UniValue getstakingstatus(const JSONRPCRequest& request)
     return obj;
 }
 
+static void EnsureAddressIndexReady(bool fEnabled, const std::string& strOption)
+{
+    if (!g_addressindex || !fEnabled) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Index not enabled. Start with %s to use this call", strOption));
+    }
+    if (!g_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is still being built, try again later");
+    }
+}
+
+static std::vector<std::pair<AddressType, uint160>> ParseIndexAddresses(const UniValue& param)
+{
+    std::vector<std::string> vstrAddresses;
+    if (param.isStr()) {
+        vstrAddresses.push_back(param.get_str());
+    } else if (param.isArray()) {
+        for (unsigned int i = 0; i < param.size(); ++i) {
+            vstrAddresses.push_back(param[i].get_str());
+        }
+    } else {
+        throw JSONRPCError(RPC_TYPE_ERROR, "Expected an address or an array of addresses");
+    }
+
+    std::vector<std::pair<AddressType, uint160>> vAddresses;
+    for (const std::string& strAddress : vstrAddresses) {
+        CTxDestination dest = DecodeDestination(strAddress);
+        AddressType type;
+        uint160 hash;
+        if (!IsValidDestination(dest) || !AddressIndex::GetAddressKey(GetScriptForDestination(dest), type, hash)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Invalid or unsupported address: %s", strAddress));
+        }
+        vAddresses.emplace_back(type, hash);
+    }
+    return vAddresses;
+}
+
+static std::string EncodeIndexAddress(AddressType type, const uint160& hash)
+{
+    switch (type) {
+    case AddressType::PUBKEYHASH: return EncodeDestination(CKeyID(hash));
+    case AddressType::SCRIPTHASH: return EncodeDestination(CScriptID(hash));
+    case AddressType::WITNESS_V0_KEYHASH: return EncodeDestination(WitnessV0KeyHash(hash));
+    case AddressType::NONE: break;
+    }
+    return "";
+}
+
+static UniValue getaddressbalance(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getaddressbalance [\"address\",...]\n"
+            "\nReturns the confirmed balance of one or more addresses (requires -addressindex).\n"
+            "Coinstake and TPoS rewards paid to a public key are counted for its address.\n"
+            "\nArguments:\n"
+            "1. \"addresses\"     (string or array, required) The address or a json array of addresses\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"balance\": xxxxx,   (numeric) The current balance in " + CURRENCY_UNIT + "\n"
+            "  \"received\": xxxxx,  (numeric) The total amount received, including change, in " + CURRENCY_UNIT + "\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressbalance", "'[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"]'")
+            + HelpExampleRpc("getaddressbalance", "[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"]")
+        );
+
+    EnsureAddressIndexReady(g_addressindex && g_addressindex->IsAddressIndexEnabled(), "-addressindex");
+
+    CAmount nBalance = 0;
+    CAmount nReceived = 0;
+    for (const auto& address : ParseIndexAddresses(request.params[0])) {
+        std::vector<std::pair<CAddressIndexKey, CAmount>> vAddressIndex;
+        if (!g_addressindex->GetAddressIndex(address.first, address.second, vAddressIndex)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+        for (const auto& entry : vAddressIndex) {
+            if (entry.second > 0) {
+                nReceived += entry.second;
+            }
+            nBalance += entry.second;
+        }
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", ValueFromAmount(nBalance));
+    result.pushKV("received", ValueFromAmount(nReceived));
+    return result;
+}
+
+static UniValue getaddressutxos(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getaddressutxos [\"address\",...]\n"
+            "\nReturns the confirmed unspent outputs of one or more addresses (requires -addressindex).\n"
+            "\nArguments:\n"
+            "1. \"addresses\"     (string or array, required) The address or a json array of addresses\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"address\": \"address\",  (string) The address\n"
+            "    \"txid\": \"hash\",        (string) The output txid\n"
+            "    \"outputIndex\": n,      (numeric) The output index\n"
+            "    \"script\": \"hex\",       (string) The script hex encoded\n"
+            "    \"amount\": xxxxx,       (numeric) The output amount in " + CURRENCY_UNIT + "\n"
+            "    \"height\": n            (numeric) The block height\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressutxos", "'[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"]'")
+            + HelpExampleRpc("getaddressutxos", "[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"]")
+        );
+
+    EnsureAddressIndexReady(g_addressindex && g_addressindex->IsAddressIndexEnabled(), "-addressindex");
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> vUnspent;
+    for (const auto& address : ParseIndexAddresses(request.params[0])) {
+        if (!g_addressindex->GetAddressUnspent(address.first, address.second, vUnspent)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+    }
+
+    std::stable_sort(vUnspent.begin(), vUnspent.end(),
+        [](const std::pair<CAddressUnspentKey, CAddressUnspentValue>& a,
+           const std::pair<CAddressUnspentKey, CAddressUnspentValue>& b) {
+            return a.second.blockHeight < b.second.blockHeight;
+        });
+
+    UniValue result(UniValue::VARR);
+    for (const auto& entry : vUnspent) {
+        UniValue output(UniValue::VOBJ);
+        output.pushKV("address", EncodeIndexAddress(entry.first.type, entry.first.hashBytes));
+        output.pushKV("txid", entry.first.txhash.GetHex());
+        output.pushKV("outputIndex", (int)entry.first.index);
+        output.pushKV("script", HexStr(entry.second.script.begin(), entry.second.script.end()));
+        output.pushKV("amount", ValueFromAmount(entry.second.satoshis));
+        output.pushKV("height", entry.second.blockHeight);
+        result.push_back(output);
+    }
+    return result;
+}
+
+static void ParseHeightRange(const JSONRPCRequest& request, int& nStart, int& nEnd)
+{
+    nStart = request.params.size() > 1 && !request.params[1].isNull() ? request.params[1].get_int() : 0;
+    nEnd = request.params.size() > 2 && !request.params[2].isNull() ? request.params[2].get_int() : 0;
+    if (nStart < 0 || nEnd < 0 || (nEnd > 0 && nEnd < nStart)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+}
+
+static UniValue getaddressdeltas(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddressdeltas [\"address\",...] ( start end )\n"
+            "\nReturns all confirmed balance changes of one or more addresses (requires -addressindex).\n"
+            "\nArguments:\n"
+            "1. \"addresses\"     (string or array, required) The address or a json array of addresses\n"
+            "2. start           (numeric, optional) The first block height to include\n"
+            "3. end             (numeric, optional) The last block height to include\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"amount\": xxxxx,       (numeric) The change in " + CURRENCY_UNIT + ", negative for spends\n"
+            "    \"txid\": \"hash\",        (string) The related txid\n"
+            "    \"index\": n,            (numeric) The related input or output index\n"
+            "    \"blockindex\": n,       (numeric) The position of the transaction in its block\n"
+            "    \"height\": n,           (numeric) The block height\n"
+            "    \"address\": \"address\"   (string) The address\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressdeltas", "'[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"]' 1000 2000")
+            + HelpExampleRpc("getaddressdeltas", "[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"], 1000, 2000")
+        );
+
+    EnsureAddressIndexReady(g_addressindex && g_addressindex->IsAddressIndexEnabled(), "-addressindex");
+
+    int nStart, nEnd;
+    ParseHeightRange(request, nStart, nEnd);
+
+    UniValue result(UniValue::VARR);
+    for (const auto& address : ParseIndexAddresses(request.params[0])) {
+        std::vector<std::pair<CAddressIndexKey, CAmount>> vAddressIndex;
+        if (!g_addressindex->GetAddressIndex(address.first, address.second, vAddressIndex, nStart, nEnd)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+        const std::string strAddress = EncodeIndexAddress(address.first, address.second);
+        for (const auto& entry : vAddressIndex) {
+            UniValue delta(UniValue::VOBJ);
+            delta.pushKV("amount", ValueFromAmount(entry.second));
+            delta.pushKV("txid", entry.first.txhash.GetHex());
+            delta.pushKV("index", (int)entry.first.index);
+            delta.pushKV("blockindex", (int)entry.first.txindex);
+            delta.pushKV("height", entry.first.blockHeight);
+            delta.pushKV("address", strAddress);
+            result.push_back(delta);
+        }
+    }
+    return result;
+}
+
+static UniValue getaddresstxids(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddresstxids [\"address\",...] ( start end )\n"
+            "\nReturns the txids of all confirmed transactions involving one or more addresses,\n"
+            "ordered by block height (requires -addressindex).\n"
+            "\nArguments:\n"
+            "1. \"addresses\"     (string or array, required) The address or a json array of addresses\n"
+            "2. start           (numeric, optional) The first block height to include\n"
+            "3. end             (numeric, optional) The last block height to include\n"
+            "\nResult:\n"
+            "[\n"
+            "  \"transactionid\"  (string) The transaction id\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddresstxids", "'[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"]'")
+            + HelpExampleRpc("getaddresstxids", "[\"XkQzYcDLKzD4nMCz5P5bSHTHZMBzNNmTgt\"]")
+        );
+
+    EnsureAddressIndexReady(g_addressindex && g_addressindex->IsAddressIndexEnabled(), "-addressindex");
+
+    int nStart, nEnd;
+    ParseHeightRange(request, nStart, nEnd);
+
+    // (height, position in block) orders transactions the way they were mined.
+    std::set<std::pair<std::pair<int, unsigned int>, uint256>> setTxids;
+    for (const auto& address : ParseIndexAddresses(request.params[0])) {
+        std::vector<std::pair<CAddressIndexKey, CAmount>> vAddressIndex;
+        if (!g_addressindex->GetAddressIndex(address.first, address.second, vAddressIndex, nStart, nEnd)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+        for (const auto& entry : vAddressIndex) {
+            setTxids.emplace(std::make_pair(entry.first.blockHeight, entry.first.txindex), entry.first.txhash);
+        }
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const auto& entry : setTxids) {
+        result.push_back(entry.second.GetHex());
+    }
+    return result;
+}
+
+static UniValue getspentinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 2)
+        throw std::runtime_error(
+            "getspentinfo \"txid\" index\n"
+            "\nReturns the input spending an output (requires -spentindex).\n"
+            "\nArguments:\n"
+            "1. \"txid\"          (string, required) The id of the transaction holding the output\n"
+            "2. index           (numeric, required) The output index\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"txid\": \"hash\",    (string) The id of the spending transaction\n"
+            "  \"index\": n,        (numeric) The index of the spending input\n"
+            "  \"height\": n        (numeric) The height of the block the output was spent in\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getspentinfo", "\"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\" 0")
+            + HelpExampleRpc("getspentinfo", "\"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", 0")
+        );
+
+    EnsureAddressIndexReady(g_addressindex && g_addressindex->IsSpentIndexEnabled(), "-spentindex");
+
+    uint256 txid = ParseHashV(request.params[0], "txid");
+    int nOutput = request.params[1].get_int();
+    if (nOutput < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid output index");
+    }
+
+    CSpentIndexValue value;
+    if (!g_addressindex->GetSpentInfo(CSpentIndexKey(txid, nOutput), value)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("txid", value.txid.GetHex());
+    result.pushKV("index", (int)value.inputIndex);
+    result.pushKV("height", value.blockHeight);
+    return result;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
+    { "control",            "getlockstats",           &getlockstats,           {"count","sortby","reset"} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
+    { "control",            "setlockprofiling",       &setlockprofiling,       {"enable"} },
     { "util",               "validateaddress",        &validateaddress,        {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys"} },
     { "util",               "verifymessage",          &verifymessage,          {"address","signature","message"} },
     { "util",               "signmessagewithprivkey", &signmessagewithprivkey, {"privkey","message"} },
     { "util",               "getstakingstatus",       &getstakingstatus,       {} },
 
+    { "addressindex",       "getaddressbalance",      &getaddressbalance,      {"addresses"} },
+    { "addressindex",       "getaddressutxos",        &getaddressutxos,        {"addresses"} },
+    { "addressindex",       "getaddressdeltas",       &getaddressdeltas,       {"addresses","start","end"} },
+    { "addressindex",       "getaddresstxids",        &getaddresstxids,        {"addresses","start","end"} },
+    { "addressindex",       "getspentinfo",           &getspentinfo,           {"txid","index"} },
+
 
     /* Not shown in help */
     { "hidden",             "setmocktime",            &setmocktime,            {"timestamp"}},
@@ -449,6 +449,15 @@ static UniValue getnetworkinfo(const JSONRPCRequest& request)
             "  }\n"
             "  ,...\n"
             "  ]\n"
+            "  \"messagelatency\": {                    (json object) message handling latency per command\n"
+            "    \"command\": {\n"
+            "      \"count\": n,                        (numeric) number of messages handled\n"
+            "      \"avg_us\": n,                       (numeric) average latency in microseconds\n"
+            "      \"max_us\": n,                       (numeric) maximum latency in microseconds\n"
+            "      \"histogram\": [ n, ... ]            (array) message counts per bucket, see messagelatencybuckets\n"
+            "    }, ...\n"
+            "  },\n"
+            "  \"messagelatencybuckets\": [ n, ... ]    (array) upper bounds in microseconds of all but the last histogram bucket\n"
             "  \"warnings\": \"...\"                    (string) any network and blockchain warnings\n"
             "}\n"
             "\nExamples:\n"
@@ -485,6 +494,25 @@ static UniValue getnetworkinfo(const JSONRPCRequest& request)
         }
     }
     obj.pushKV("localaddresses", localAddresses);
+    UniValue messageLatency(UniValue::VOBJ);
+    for (const auto& entry : GetMessageLatencyStats())
+    {
+        const CLatencyHistogram::Snapshot& stats = entry.second;
+        UniValue rec(UniValue::VOBJ);
+        rec.pushKV("count", stats.nCount);
+        rec.pushKV("avg_us", stats.nCount ? stats.nSumMicros / (int64_t)stats.nCount : 0);
+        rec.pushKV("max_us", stats.nMaxMicros);
+        UniValue histogram(UniValue::VARR);
+        for (uint64_t nBucketCount : stats.vBuckets)
+            histogram.push_back(nBucketCount);
+        rec.pushKV("histogram", histogram);
+        messageLatency.pushKV(entry.first, rec);
+    }
+    obj.pushKV("messagelatency", messageLatency);
+    UniValue latencyBuckets(UniValue::VARR);
+    for (int64_t nBound : LATENCY_HISTOGRAM_BOUNDS)
+        latencyBuckets.push_back(nBound);
+    obj.pushKV("messagelatencybuckets", latencyBuckets);
     obj.pushKV("warnings",       GetWarnings("statusbar"));
     return obj;
 }
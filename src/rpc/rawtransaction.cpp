@@ -9,6 +9,7 @@
 #include <core_io.h>
 #include <index/txindex.h>
 #include <init.h>
+#include <jsonwriter.h>
 #include <keystore.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -63,6 +64,64 @@ static void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue&
     }
 }
 
+static bool ParseGetRawTransactionVerbose(const UniValue& param)
+{
+    bool fVerbose = false;
+    if (!param.isNull()) {
+        fVerbose = param.isNum() ? (param.get_int() != 0) : param.get_bool();
+    }
+    return fVerbose;
+}
+
+/** Find the transaction asked for by getrawtransaction, throws the RPC error if there is none */
+static CTransactionRef LookupRawTransaction(const JSONRPCRequest& request, uint256& hash_block, CBlockIndex*& blockindex, bool& in_active_chain)
+{
+    in_active_chain = true;
+    uint256 hash = ParseHashV(request.params[0], "parameter 1");
+    blockindex = nullptr;
+
+    if (hash == Params().GenesisBlock().hashMerkleRoot) {
+        // Special exception for the genesis block coinbase transaction
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "The genesis block coinbase is not considered an ordinary transaction and cannot be retrieved");
+    }
+
+    if (!request.params[2].isNull()) {
+        LOCK(cs_main);
+
+        uint256 blockhash = ParseHashV(request.params[2], "parameter 3");
+        blockindex = LookupBlockIndex(blockhash);
+        if (!blockindex) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block hash not found");
+        }
+        in_active_chain = chainActive.Contains(blockindex);
+    }
+
+    bool f_txindex_ready = false;
+    if (g_txindex && !blockindex) {
+        f_txindex_ready = g_txindex->IsSynced();
+    }
+
+    CTransactionRef tx;
+    if (!GetTransaction(hash, tx, Params().GetConsensus(), hash_block, true, blockindex)) {
+        std::string errmsg;
+        if (blockindex) {
+            if (!(blockindex->nStatus & BLOCK_HAVE_DATA)) {
+                throw JSONRPCError(RPC_MISC_ERROR, "Block not available");
+            }
+            errmsg = "No such transaction found in the provided block";
+        } else if (!g_txindex) {
+            errmsg = "No such mempool transaction. Use -txindex to enable blockchain transaction queries";
+        } else if (!f_txindex_ready) {
+            errmsg = "No such mempool transaction. Blockchain transactions are still in the process of being indexed";
+        } else {
+            errmsg = "No such mempool or blockchain transaction";
+        }
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, errmsg + ". Use gettransaction for wallet transactions.");
+    }
+
+    return tx;
+}
+
 static UniValue getrawtransaction(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
@@ -143,55 +202,13 @@ static UniValue getrawtransaction(const JSONRPCRequest& request)
             + HelpExampleCli("getrawtransaction", "\"mytxid\" true \"myblockhash\"")
         );
 
-    bool in_active_chain = true;
-    uint256 hash = ParseHashV(request.params[0], "parameter 1");
-    CBlockIndex* blockindex = nullptr;
-
-    if (hash == Params().GenesisBlock().hashMerkleRoot) {
-        // Special exception for the genesis block coinbase transaction
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "The genesis block coinbase is not considered an ordinary transaction and cannot be retrieved");
-    }
-
     // Accept either a bool (true) or a num (>=1) to indicate verbose output.
-    bool fVerbose = false;
-    if (!request.params[1].isNull()) {
-        fVerbose = request.params[1].isNum() ? (request.params[1].get_int() != 0) : request.params[1].get_bool();
-    }
-
-    if (!request.params[2].isNull()) {
-        LOCK(cs_main);
-
-        uint256 blockhash = ParseHashV(request.params[2], "parameter 3");
-        blockindex = LookupBlockIndex(blockhash);
-        if (!blockindex) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block hash not found");
-        }
-        in_active_chain = chainActive.Contains(blockindex);
-    }
+    bool fVerbose = ParseGetRawTransactionVerbose(request.params[1]);
 
-    bool f_txindex_ready = false;
-    if (g_txindex) {
-        f_txindex_ready = true;
-    }
-
-    CTransactionRef tx;
+    bool in_active_chain;
+    CBlockIndex* blockindex;
     uint256 hash_block;
-    if (!GetTransaction(hash, tx, Params().GetConsensus(), hash_block, true, blockindex)) {
-        std::string errmsg;
-        if (blockindex) {
-            if (!(blockindex->nStatus & BLOCK_HAVE_DATA)) {
-                throw JSONRPCError(RPC_MISC_ERROR, "Block not available");
-            }
-            errmsg = "No such transaction found in the provided block";
-        } else if (!g_txindex) {
-            errmsg = "No such mempool transaction. Use -txindex to enable blockchain transaction queries";
-        } else if (!f_txindex_ready) {
-            errmsg = "No such mempool transaction. Blockchain transactions are still in the process of being indexed";
-        } else {
-            errmsg = "No such mempool or blockchain transaction";
-        }
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, errmsg + ". Use gettransaction for wallet transactions.");
-    }
+    CTransactionRef tx = LookupRawTransaction(request, hash_block, blockindex, in_active_chain);
 
     if (!fVerbose) {
         return EncodeHexTx(*tx, RPCSerializationFlags());
@@ -203,6 +220,55 @@ static UniValue getrawtransaction(const JSONRPCRequest& request)
     return result;
 }
 
+static bool getrawtransaction_stream(const JSONRPCRequest& request, JSONStreamWriter& writer)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        return false;
+
+    if (!ParseGetRawTransactionVerbose(request.params[1]))
+        return false;
+
+    bool in_active_chain;
+    CBlockIndex* blockindex;
+    uint256 hash_block;
+    CTransactionRef tx = LookupRawTransaction(request, hash_block, blockindex, in_active_chain);
+
+    writer.BeginObject();
+    if (blockindex) writer.KV("in_active_chain", in_active_chain);
+    TxToStream(*tx, uint256(), writer, true, RPCSerializationFlags());
+
+    if (!hash_block.IsNull()) {
+        // Look the block up before writing, cs_main is not held while writing
+        bool fHaveIndex = false;
+        int nConfirmations = 0;
+        int64_t nBlockTime = 0;
+        {
+            LOCK(cs_main);
+            CBlockIndex* pindex = LookupBlockIndex(hash_block);
+            if (pindex) {
+                fHaveIndex = true;
+                if (chainActive.Contains(pindex)) {
+                    nConfirmations = 1 + chainActive.Height() - pindex->nHeight;
+                    nBlockTime = pindex->GetBlockTime();
+                }
+            }
+        }
+
+        writer.KV("blockhash", hash_block.GetHex());
+        if (fHaveIndex) {
+            if (nConfirmations > 0) {
+                writer.KV("confirmations", nConfirmations);
+                writer.KV("time", nBlockTime);
+                writer.KV("blocktime", nBlockTime);
+            }
+            else
+                writer.KV("confirmations", 0);
+        }
+    }
+    writer.EndObject();
+    return true;
+}
+
 static UniValue gettxoutproof(const JSONRPCRequest& request)
 {
     if (request.fHelp || (request.params.size() != 1 && request.params.size() != 2))
@@ -1269,8 +1335,19 @@ static const CRPCCommand commands[] =
     { "blockchain",         "verifytxoutproof",             &verifytxoutproof,          {"proof"} },
 };
 
+static const struct {
+    const char* name;
+    rpcstreamfn_type actor;
+} stream_commands[] =
+{ //  name                            actor
+  //  ------------------------------  -----------------------------
+    { "getrawtransaction",            &getrawtransaction_stream     },
+};
+
 void RegisterRawTransactionRPCCommands(CRPCTable &t)
 {
     for (unsigned int vcidx = 0; vcidx < ARRAYLEN(commands); vcidx++)
         t.appendCommand(commands[vcidx].name, &commands[vcidx]);
+    for (unsigned int vcidx = 0; vcidx < ARRAYLEN(stream_commands); vcidx++)
+        t.appendStreamActor(stream_commands[vcidx].name, stream_commands[vcidx].actor);
 }
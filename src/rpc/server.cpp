@@ -6,6 +6,7 @@
 #include <rpc/server.h>
 
 #include <fs.h>
+#include <httpserver.h>
 #include <init.h>
 #include <key_io.h>
 #include <random.h>
@@ -255,6 +256,52 @@ static UniValue uptime(const JSONRPCRequest& jsonRequest)
     return GetTime() - GetStartupTime();
 }
 
+static UniValue getrpcqueueinfo(const JSONRPCRequest& jsonRequest)
+{
+    if (jsonRequest.fHelp || jsonRequest.params.size() > 0)
+        throw std::runtime_error(
+                "getrpcqueueinfo\n"
+                        "\nReturns the state of the HTTP RPC work queues. Requests are dispatched to a queue\n"
+                        "by cost class: \"cheap\" (-rpcthreads), \"heavy\" (-rpcheavythreads) and \"wallet\" (-rpcwalletthreads).\n"
+                        "\nResult:\n"
+                        "[\n"
+                        "  {\n"
+                        "    \"class\": \"xxxx\",          (string) The cost class served by this queue\n"
+                        "    \"threads\": n,             (numeric) Number of worker threads\n"
+                        "    \"depth\": n,               (numeric) Number of requests waiting for a worker\n"
+                        "    \"maxdepth\": n,            (numeric) Depth at which requests are rejected (-rpcworkqueue)\n"
+                        "    \"processed\": n,           (numeric) Number of requests processed\n"
+                        "    \"rejected\": n,            (numeric) Number of requests rejected because the queue was full\n"
+                        "    \"avgwait_us\": n,          (numeric) Average time a request waited in the queue, in microseconds\n"
+                        "    \"maxwait_us\": n,          (numeric) Longest time a request waited in the queue, in microseconds\n"
+                        "    \"avgrun_us\": n,           (numeric) Average time spent handling a request, in microseconds\n"
+                        "    \"maxrun_us\": n            (numeric) Longest time spent handling a request, in microseconds\n"
+                        "  }\n"
+                        "  ,...\n"
+                        "]\n"
+                        "\nExamples:\n"
+                + HelpExampleCli("getrpcqueueinfo", "")
+                + HelpExampleRpc("getrpcqueueinfo", "")
+        );
+
+    UniValue ret(UniValue::VARR);
+    for (const HTTPWorkQueueStats& stats : GetHTTPWorkQueueStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("class", HTTPWorkClassName(stats.workClass));
+        obj.pushKV("threads", stats.nThreads);
+        obj.pushKV("depth", (uint64_t)stats.nDepth);
+        obj.pushKV("maxdepth", (uint64_t)stats.nMaxDepth);
+        obj.pushKV("processed", stats.nProcessed);
+        obj.pushKV("rejected", stats.nRejected);
+        obj.pushKV("avgwait_us", stats.nAvgWaitMicros);
+        obj.pushKV("maxwait_us", stats.nMaxWaitMicros);
+        obj.pushKV("avgrun_us", stats.nAvgRunMicros);
+        obj.pushKV("maxrun_us", stats.nMaxRunMicros);
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 /**
  * Call Table
  */
@@ -265,6 +312,7 @@ static const CRPCCommand vRPCCommands[] =
     { "control",            "help",                   &help,                   {"command"}  },
     { "control",            "stop",                   &stop,                   {}  },
     { "control",            "uptime",                 &uptime,                 {}  },
+    { "control",            "getrpcqueueinfo",        &getrpcqueueinfo,        {}  },
 };
 
 CRPCTable::CRPCTable()
@@ -301,6 +349,15 @@ bool CRPCTable::appendCommand(const std::string& name, const CRPCCommand* pcmd)
     return true;
 }
 
+bool CRPCTable::appendStreamActor(const std::string& name, rpcstreamfn_type actor)
+{
+    if (IsRPCRunning() || !mapCommands.count(name))
+        return false;
+
+    mapStreamActors[name] = actor;
+    return true;
+}
+
 bool StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
@@ -503,6 +560,39 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
     }
 }
 
+bool CRPCTable::executeStream(const JSONRPCRequest &request, JSONStreamWriter& writer) const
+{
+    auto it = mapStreamActors.find(request.strMethod);
+    if (it == mapStreamActors.end())
+        return false;
+
+    // Same checks as in execute()
+    {
+        LOCK(cs_rpcWarmup);
+        if (fRPCInWarmup)
+            throw JSONRPCError(RPC_IN_WARMUP, rpcWarmupStatus);
+    }
+
+    const CRPCCommand *pcmd = tableRPC[request.strMethod];
+    if (!pcmd)
+        throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Method not found");
+
+    g_rpcSignals.PreCommand(*pcmd);
+
+    try
+    {
+        if (request.params.isObject()) {
+            return it->second(transformNamedArguments(request, pcmd->argNames), writer);
+        } else {
+            return it->second(request, writer);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        throw JSONRPCError(RPC_MISC_ERROR, e.what());
+    }
+}
+
 std::vector<std::string> CRPCTable::listCommands() const
 {
     std::vector<std::string> commandList;
@@ -20,6 +20,7 @@
 static const unsigned int DEFAULT_RPC_SERIALIZE_VERSION = 1;
 
 class CRPCCommand;
+class JSONStreamWriter;
 
 namespace RPCServer
 {
@@ -127,6 +128,12 @@ void RPCUnsetTimerInterface(RPCTimerInterface *iface);
 void RPCRunLater(const std::string& name, std::function<void(void)> func, int64_t nSeconds);
 
 typedef UniValue(*rpcfn_type)(const JSONRPCRequest& jsonRequest);
+/** Streaming variant of an RPC method: writes the result into writer instead of
+ * returning it. Returns false, without writing anything, for calls it does not
+ * handle (help, other verbosity levels, ...), which then go to the regular
+ * actor. Like actors it may throw, but only before it has started writing.
+ */
+typedef bool(*rpcstreamfn_type)(const JSONRPCRequest& jsonRequest, JSONStreamWriter& writer);
 
 class CRPCCommand
 {
@@ -144,6 +151,7 @@ class CRPCTable
 {
 private:
     std::map<std::string, const CRPCCommand*> mapCommands;
+    std::map<std::string, rpcstreamfn_type> mapStreamActors;
 public:
     CRPCTable();
     const CRPCCommand* operator[](const std::string& name) const;
@@ -157,6 +165,14 @@ public:
      */
     UniValue execute(const JSONRPCRequest &request) const;
 
+    /**
+     * Execute a method through its streaming variant, if it has one.
+     * @returns false if the call is not handled by a streaming variant and
+     * has to go through execute() instead. Nothing is written in that case.
+     * @throws an exception (UniValue) when an error happens.
+     */
+    bool executeStream(const JSONRPCRequest &request, JSONStreamWriter& writer) const;
+
     /**
     * Returns a list of registered commands
     * @returns List of registered commands.
@@ -179,6 +195,13 @@ public:
      * register different names, types, and numbers of parameters.
      */
     bool appendCommand(const std::string& name, const CRPCCommand* pcmd);
+
+    /**
+     * Registers a streaming variant for an already appended command.
+     *
+     * Returns false if RPC server is already running or the command is unknown.
+     */
+    bool appendStreamActor(const std::string& name, rpcstreamfn_type actor);
 };
 
 bool IsDeprecatedRPCEnabled(const std::string& method);
@@ -8,6 +8,7 @@
 
 #include <support/allocators/zeroafterfree.h>
 #include <serialize.h>
+#include <span.h>
 
 #include <algorithm>
 #include <assert.h>
@@ -142,6 +143,67 @@ private:
     size_t nPos;
 };
 
+/* Minimal stream for reading from memory owned by someone else, such as a
+ * memory mapped block file, without copying it into a buffer first
+ */
+class CSpanReader
+{
+ public:
+
+/*
+ * @param[in]  nTypeIn Serialization Type
+ * @param[in]  nVersionIn Serialization Version (including any flags)
+ * @param[in]  dataIn  Referenced bytes to read from, must outlive the reader
+*/
+    CSpanReader(int nTypeIn, int nVersionIn, Span<const unsigned char> dataIn) : nType(nTypeIn), nVersion(nVersionIn), data(dataIn), nPos(0) {}
+
+    void read(char* pch, size_t nSize)
+    {
+        if (nSize > size()) {
+            throw std::ios_base::failure("CSpanReader::read(): end of data");
+        }
+        memcpy(pch, data.data() + nPos, nSize);
+        nPos += nSize;
+    }
+    void ignore(size_t nSize)
+    {
+        if (nSize > size()) {
+            throw std::ios_base::failure("CSpanReader::ignore(): end of data");
+        }
+        nPos += nSize;
+    }
+    template<typename T>
+    CSpanReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+    int GetVersion() const
+    {
+        return nVersion;
+    }
+    int GetType() const
+    {
+        return nType;
+    }
+    /** Number of bytes left to read */
+    size_t size() const
+    {
+        return data.size() - nPos;
+    }
+    /** Bytes left to read, for passing a part of the data on without copying it */
+    Span<const unsigned char> remaining() const
+    {
+        return Span<const unsigned char>(data.data() + nPos, size());
+    }
+private:
+    const int nType;
+    const int nVersion;
+    const Span<const unsigned char> data;
+    size_t nPos;
+};
+
 /** Double ended buffer combining vector and stream-like interfaces.
  *
  * >> and << read and write unformatted data using the above serialization templates.
@@ -4,8 +4,11 @@
 
 #include <sync.h>
 
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <set>
+#include <tuple>
 #include <util.h>
 #include <utilstrencodings.h>
 
@@ -22,6 +25,148 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+std::atomic<bool> g_lock_profiling(DEFAULT_LOCK_PROFILING);
+
+namespace {
+
+/** Identifies a lock site by the literals passed to LOCK, LOCK2 passes two names at the same line */
+typedef std::tuple<const char*, const char*, int> LockSiteKey;
+
+/** Lock profile of one thread, its mutex is only contended while the profile is read */
+struct LockProfileBuffer
+{
+    std::mutex mutex;
+    std::map<LockSiteKey, LockSiteStats> mapSites;
+};
+
+struct LockProfileData
+{
+    std::mutex mutex;
+    /// Profiles of the running threads
+    std::set<LockProfileBuffer*> setBuffers;
+    /// Profiles of the threads that exited
+    std::map<LockSiteKey, LockSiteStats> mapRetired;
+};
+
+LockProfileData& GetLockProfileData()
+{
+    // Never destroyed, threads may exit after static destructors ran
+    static LockProfileData* data = new LockProfileData();
+    return *data;
+}
+
+void MergeLockSiteStats(LockSiteStats& stats, const LockSiteStats& other)
+{
+    stats.nAcquisitions += other.nAcquisitions;
+    stats.nContentions += other.nContentions;
+    stats.nWaitMicros += other.nWaitMicros;
+    stats.nMaxWaitMicros = std::max(stats.nMaxWaitMicros, other.nMaxWaitMicros);
+    stats.nHoldMicros += other.nHoldMicros;
+    stats.nMaxHoldMicros = std::max(stats.nMaxHoldMicros, other.nMaxHoldMicros);
+}
+
+#ifdef HAVE_THREAD_LOCAL
+/** Registers the thread's buffer for as long as the thread runs */
+struct ThreadLockProfile
+{
+    LockProfileBuffer buffer;
+
+    ThreadLockProfile()
+    {
+        LockProfileData& data = GetLockProfileData();
+        std::lock_guard<std::mutex> lock(data.mutex);
+        data.setBuffers.insert(&buffer);
+    }
+
+    ~ThreadLockProfile()
+    {
+        LockProfileData& data = GetLockProfileData();
+        std::lock_guard<std::mutex> lock(data.mutex);
+        data.setBuffers.erase(&buffer);
+        std::lock_guard<std::mutex> lockBuffer(buffer.mutex);
+        for (const auto& site : buffer.mapSites) {
+            auto it = data.mapRetired.emplace(site.first, site.second);
+            if (!it.second) MergeLockSiteStats(it.first->second, site.second);
+        }
+    }
+};
+
+LockProfileBuffer& GetThreadLockProfileBuffer()
+{
+    static thread_local ThreadLockProfile profile;
+    return profile.buffer;
+}
+#else
+/** Without thread_local all threads share one buffer */
+LockProfileBuffer& GetThreadLockProfileBuffer()
+{
+    static LockProfileBuffer* buffer = []() {
+        LockProfileBuffer* bufferNew = new LockProfileBuffer();
+        LockProfileData& data = GetLockProfileData();
+        std::lock_guard<std::mutex> lock(data.mutex);
+        data.setBuffers.insert(bufferNew);
+        return bufferNew;
+    }();
+    return *buffer;
+}
+#endif
+
+} // namespace
+
+void RecordLockProfile(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWaitMicros, int64_t nHoldMicros)
+{
+    LockProfileBuffer& buffer = GetThreadLockProfileBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    auto it = buffer.mapSites.emplace(LockSiteKey(pszFile, pszName, nLine), LockSiteStats{pszName, pszFile, nLine, 0, 0, 0, 0, 0, 0}).first;
+    LockSiteStats& stats = it->second;
+    stats.nAcquisitions++;
+    if (fContended) stats.nContentions++;
+    stats.nWaitMicros += nWaitMicros;
+    stats.nMaxWaitMicros = std::max(stats.nMaxWaitMicros, nWaitMicros);
+    stats.nHoldMicros += nHoldMicros;
+    stats.nMaxHoldMicros = std::max(stats.nMaxHoldMicros, nHoldMicros);
+}
+
+std::vector<LockSiteStats> GetLockProfile()
+{
+    // The same site in a header can be passed as different literals by different translation units
+    std::map<std::tuple<std::string, std::string, int>, LockSiteStats> mapMerged;
+    auto merge = [&mapMerged](const LockSiteStats& stats) {
+        auto it = mapMerged.emplace(std::make_tuple(std::string(stats.pszFile), std::string(stats.pszName), stats.nLine), stats);
+        if (!it.second) MergeLockSiteStats(it.first->second, stats);
+    };
+
+    LockProfileData& data = GetLockProfileData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    for (const auto& site : data.mapRetired) {
+        merge(site.second);
+    }
+    for (LockProfileBuffer* buffer : data.setBuffers) {
+        std::lock_guard<std::mutex> lockBuffer(buffer->mutex);
+        for (const auto& site : buffer->mapSites) {
+            merge(site.second);
+        }
+    }
+
+    std::vector<LockSiteStats> vStats;
+    vStats.reserve(mapMerged.size());
+    for (const auto& site : mapMerged) {
+        vStats.push_back(site.second);
+    }
+    return vStats;
+}
+
+void ResetLockProfile()
+{
+    LockProfileData& data = GetLockProfileData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.mapRetired.clear();
+    for (LockProfileBuffer* buffer : data.setBuffers) {
+        std::lock_guard<std::mutex> lockBuffer(buffer->mutex);
+        buffer->mapSites.clear();
+    }
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -8,9 +8,13 @@
 
 #include <threadsafety.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <thread>
 #include <mutex>
+#include <stdint.h>
+#include <vector>
 
 // #define DEBUG_LOCKORDER
 
@@ -113,23 +117,84 @@ typedef std::unique_lock<std::mutex> WaitableLock;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/** Default for -lockprofiling */
+static const bool DEFAULT_LOCK_PROFILING = false;
+
+/**
+ * Whether LOCK and TRY_LOCK record how long they waited for and held the
+ * lock, per lock site. Checked once per acquisition, so leaving it off costs
+ * next to nothing.
+ */
+extern std::atomic<bool> g_lock_profiling;
+
+/** Lock profile of one LOCK or TRY_LOCK site, the name and file are the literals passed to the macro */
+struct LockSiteStats
+{
+    const char* pszName;
+    const char* pszFile;
+    int nLine;
+    uint64_t nAcquisitions;
+    uint64_t nContentions;
+    int64_t nWaitMicros;
+    int64_t nMaxWaitMicros;
+    int64_t nHoldMicros;
+    int64_t nMaxHoldMicros;
+};
+
+/** Add one acquisition to the calling thread's lock profile */
+void RecordLockProfile(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWaitMicros, int64_t nHoldMicros);
+/** Lock profiles of all threads, merged per lock site */
+std::vector<LockSiteStats> GetLockProfile();
+void ResetLockProfile();
+
+static inline int64_t GetLockProfileMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 /** Wrapper around std::unique_lock<CCriticalSection> */
 class SCOPED_LOCKABLE CCriticalBlock
 {
 private:
     std::unique_lock<CCriticalSection> lock;
 
+    // Lock profiling, nLockedMicros is 0 unless profiling was on when the lock was taken
+    const char* pszProfileName = nullptr;
+    const char* pszProfileFile = nullptr;
+    int nProfileLine = 0;
+    bool fProfileContended = false;
+    int64_t nProfileWaitMicros = 0;
+    int64_t nLockedMicros = 0;
+
+    void StartProfile(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWaitMicros)
+    {
+        pszProfileName = pszName;
+        pszProfileFile = pszFile;
+        nProfileLine = nLine;
+        fProfileContended = fContended;
+        nProfileWaitMicros = nWaitMicros;
+        nLockedMicros = GetLockProfileMicros();
+    }
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
-#ifdef DEBUG_LOCKCONTENTION
+        const bool fProfile = g_lock_profiling.load(std::memory_order_relaxed);
         if (!lock.try_lock()) {
+#ifdef DEBUG_LOCKCONTENTION
             PrintLockContention(pszName, pszFile, nLine);
 #endif
+            if (fProfile) {
+                const int64_t nWaitStart = GetLockProfileMicros();
+                lock.lock();
+                StartProfile(pszName, pszFile, nLine, true, GetLockProfileMicros() - nWaitStart);
+                return;
+            }
             lock.lock();
-#ifdef DEBUG_LOCKCONTENTION
         }
-#endif
+        if (fProfile) {
+            StartProfile(pszName, pszFile, nLine, false, 0);
+        }
     }
 
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
@@ -138,6 +203,8 @@ private:
         lock.try_lock();
         if (!lock.owns_lock())
             LeaveCritical();
+        else if (g_lock_profiling.load(std::memory_order_relaxed))
+            StartProfile(pszName, pszFile, nLine, false, 0);
         return lock.owns_lock();
     }
 
@@ -163,8 +230,16 @@ public:
 
     ~CCriticalBlock() UNLOCK_FUNCTION()
     {
-        if (lock.owns_lock())
+        if (lock.owns_lock()) {
             LeaveCritical();
+            if (nLockedMicros != 0) {
+                // Record after unlocking, so the bookkeeping is neither done
+                // inside the critical section nor counted as held time
+                const int64_t nHeldMicros = GetLockProfileMicros() - nLockedMicros;
+                lock.unlock();
+                RecordLockProfile(pszProfileName, pszProfileFile, nProfileLine, fProfileContended, nProfileWaitMicros, nHeldMicros);
+            }
+        }
     }
 
     operator bool()
@@ -0,0 +1,115 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/test_xsn.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(addressindex_key_order)
+{
+    // Heights are serialized big endian so LevelDB iterates them in order.
+    uint160 hash;
+    CDataStream low(SER_DISK, CLIENT_VERSION), high(SER_DISK, CLIENT_VERSION);
+    low << CAddressIndexKey(AddressType::PUBKEYHASH, hash, 255, 0, uint256(), 0, false);
+    high << CAddressIndexKey(AddressType::PUBKEYHASH, hash, 256, 0, uint256(), 0, false);
+    BOOST_CHECK(low.str() < high.str());
+
+    CAddressIndexKey key;
+    high >> key;
+    BOOST_CHECK_EQUAL(key.blockHeight, 256);
+    BOOST_CHECK(key.type == AddressType::PUBKEYHASH);
+
+    CDataStream early(SER_DISK, CLIENT_VERSION), late(SER_DISK, CLIENT_VERSION);
+    early << CTimestampIndexKey(0x000000ff, uint256());
+    late << CTimestampIndexKey(0x00000100, uint256());
+    BOOST_CHECK(early.str() < late.str());
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_script_types)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CKeyID keyid = key.GetPubKey().GetID();
+
+    AddressType type;
+    uint160 hash;
+
+    // Pay-to-pubkey, as used by coinstakes, is indexed under the key id.
+    BOOST_CHECK(AddressIndex::GetAddressKey(CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG, type, hash));
+    BOOST_CHECK(type == AddressType::PUBKEYHASH);
+    BOOST_CHECK(hash == keyid);
+
+    BOOST_CHECK(AddressIndex::GetAddressKey(GetScriptForDestination(keyid), type, hash));
+    BOOST_CHECK(type == AddressType::PUBKEYHASH);
+    BOOST_CHECK(hash == keyid);
+
+    BOOST_CHECK(AddressIndex::GetAddressKey(GetScriptForDestination(CScriptID(CScript() << OP_TRUE)), type, hash));
+    BOOST_CHECK(type == AddressType::SCRIPTHASH);
+
+    BOOST_CHECK(AddressIndex::GetAddressKey(GetScriptForDestination(WitnessV0KeyHash(keyid)), type, hash));
+    BOOST_CHECK(type == AddressType::WITNESS_V0_KEYHASH);
+
+    BOOST_CHECK(!AddressIndex::GetAddressKey(CScript() << OP_RETURN, type, hash));
+    BOOST_CHECK(!AddressIndex::GetAddressKey(CScript(), type, hash));
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_initial_sync, TestChain100Setup)
+{
+    AddressIndex index(MakeUnique<AddressIndexDB>(1 << 20, true),
+                       AddressIndex::ADDRESS | AddressIndex::SPENT | AddressIndex::TIMESTAMP);
+    index.Start();
+
+    // Allow the index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CAmount nExpected = 0;
+    size_t nOutputs = 0;
+    for (const auto& txn : m_coinbase_txns) {
+        for (const auto& out : txn->vout) {
+            if (out.scriptPubKey == coinbase_script) {
+                nExpected += out.nValue;
+                ++nOutputs;
+            }
+        }
+    }
+
+    std::vector<std::pair<CAddressIndexKey, CAmount>> vAddressIndex;
+    BOOST_CHECK(index.GetAddressIndex(AddressType::PUBKEYHASH, coinbaseKey.GetPubKey().GetID(), vAddressIndex));
+    BOOST_CHECK_EQUAL(vAddressIndex.size(), nOutputs);
+    CAmount nBalance = 0;
+    for (const auto& entry : vAddressIndex) {
+        nBalance += entry.second;
+    }
+    BOOST_CHECK_EQUAL(nBalance, nExpected);
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> vUnspent;
+    BOOST_CHECK(index.GetAddressUnspent(AddressType::PUBKEYHASH, coinbaseKey.GetPubKey().GetID(), vUnspent));
+    BOOST_CHECK_EQUAL(vUnspent.size(), nOutputs);
+
+    int nHeight;
+    {
+        LOCK(cs_main);
+        nHeight = chainActive.Height();
+    }
+    std::vector<uint256> vHashes;
+    BOOST_CHECK(index.GetTimestampIndex(std::numeric_limits<unsigned int>::max(), 0, vHashes));
+    BOOST_CHECK_EQUAL(vHashes.size(), (size_t)nHeight + 1);
+
+    index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
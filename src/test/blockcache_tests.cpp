@@ -0,0 +1,68 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockcache.h>
+
+#include <core_memusage.h>
+#include <random.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+static std::shared_ptr<const CBlock> MakeBlock(size_t nOutputs)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    tx.vout.resize(nOutputs);
+    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+    pblock->nNonce = InsecureRand32();
+    pblock->vtx.push_back(MakeTransactionRef(tx));
+    return pblock;
+}
+
+BOOST_FIXTURE_TEST_SUITE(blockcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockcache_lru)
+{
+    std::vector<std::shared_ptr<const CBlock>> vBlocks;
+    for (int i = 0; i < 4; i++) {
+        vBlocks.push_back(MakeBlock(100));
+    }
+    const size_t nBlockBytes = RecursiveDynamicUsage(*vBlocks[0]);
+
+    // Room for three of the four blocks
+    CBlockCache cache(nBlockBytes * 3 + nBlockBytes / 2 + 1024);
+    for (int i = 0; i < 3; i++) {
+        cache.Insert(vBlocks[i]->GetHash(), vBlocks[i]);
+    }
+    BOOST_CHECK_EQUAL(cache.GetStats().nEntries, 3U);
+    BOOST_CHECK(cache.Get(vBlocks[0]->GetHash()) == vBlocks[0]);
+
+    // Block 1 is now the least recently used one and makes room for block 3
+    cache.Insert(vBlocks[3]->GetHash(), vBlocks[3]);
+    BOOST_CHECK(!cache.Get(vBlocks[1]->GetHash()));
+    BOOST_CHECK(cache.Get(vBlocks[0]->GetHash()) == vBlocks[0]);
+    BOOST_CHECK(cache.Get(vBlocks[2]->GetHash()) == vBlocks[2]);
+    BOOST_CHECK(cache.Get(vBlocks[3]->GetHash()) == vBlocks[3]);
+
+    CBlockCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nEntries, 3U);
+    BOOST_CHECK(stats.nBytes <= stats.nMaxBytes);
+    BOOST_CHECK_EQUAL(stats.nHits, 4U);
+    BOOST_CHECK_EQUAL(stats.nMisses, 1U);
+
+    cache.Erase(vBlocks[0]->GetHash());
+    BOOST_CHECK_EQUAL(cache.GetStats().nEntries, 2U);
+
+    // A zero limit disables the cache
+    cache.SetMaxBytes(0);
+    BOOST_CHECK_EQUAL(cache.GetStats().nEntries, 0U);
+    BOOST_CHECK_EQUAL(cache.GetStats().nBytes, 0U);
+    cache.Insert(vBlocks[0]->GetHash(), vBlocks[0]);
+    BOOST_CHECK(!cache.Get(vBlocks[0]->GetHash()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
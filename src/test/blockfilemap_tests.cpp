@@ -0,0 +1,91 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockfilemap.h>
+
+#include <chainparams.h>
+#include <clientversion.h>
+#include <streams.h>
+#include <util.h>
+#include <validation.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockfilemap_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockfilemap_read_genesis)
+{
+    CBlockFileMap map;
+    map.SetEnabled(true);
+
+    CDiskBlockPos pos;
+    {
+        LOCK(cs_main);
+        pos = chainActive.Genesis()->GetBlockPos();
+    }
+
+    CBlockFileMap::BlockData blockData;
+#ifndef WIN32
+    BOOST_CHECK(map.GetBlock(pos, blockData));
+    BOOST_CHECK_EQUAL(map.GetMappedFileCount(), 1U);
+
+    CBlock block;
+    CSpanReader reader(SER_DISK, CLIENT_VERSION, blockData.data);
+    reader >> block;
+    BOOST_CHECK_EQUAL(reader.size(), 0U);
+    BOOST_CHECK(block.GetHash() == Params().GenesisBlock().GetHash());
+
+    // Unmapping the file keeps the data alive for readers still holding it
+    map.Close({pos.nFile});
+    BOOST_CHECK_EQUAL(map.GetMappedFileCount(), 0U);
+    CBlock blockAgain;
+    CSpanReader readerAgain(SER_DISK, CLIENT_VERSION, blockData.data);
+    readerAgain >> blockAgain;
+    BOOST_CHECK(blockAgain.GetHash() == block.GetHash());
+#endif
+
+    // Positions without a block behind them, and a disabled map
+    BOOST_CHECK(!map.GetBlock(CDiskBlockPos(pos.nFile, 4), blockData));
+    BOOST_CHECK(!map.GetBlock(CDiskBlockPos(pos.nFile, 1 << 30), blockData));
+    BOOST_CHECK(!map.GetBlock(CDiskBlockPos(pos.nFile + 1, 8), blockData));
+    map.SetEnabled(false);
+    BOOST_CHECK(!map.GetBlock(pos, blockData));
+}
+
+#ifndef WIN32
+BOOST_AUTO_TEST_CASE(blockfilemap_truncated_file)
+{
+    CBlockFileMap map;
+    map.SetEnabled(true);
+
+    CDiskBlockPos pos;
+    {
+        LOCK(cs_main);
+        pos = chainActive.Genesis()->GetBlockPos();
+    }
+    const unsigned int nBlockSize = ::GetSerializeSize(Params().GenesisBlock(), SER_DISK, CLIENT_VERSION);
+
+    CBlockFileMap::BlockData blockData;
+    BOOST_REQUIRE(map.GetBlock(pos, blockData));
+    const size_t nMappedSize = blockData.file->size();
+    BOOST_CHECK_GT(nMappedSize, pos.nPos + nBlockSize);
+
+    // Cut the preallocated space after the block, as finishing a file does.
+    // The file is mapped again at its new size.
+    FILE* file = fsbridge::fopen(GetBlockPosFilename(pos, "blk"), "rb+");
+    BOOST_REQUIRE(file);
+    BOOST_CHECK(TruncateFile(file, pos.nPos + nBlockSize));
+    BOOST_REQUIRE(map.GetBlock(pos, blockData));
+    BOOST_CHECK_EQUAL(blockData.file->size(), pos.nPos + nBlockSize);
+
+    // A block the file no longer covers is not read from the mapping
+    BOOST_CHECK(TruncateFile(file, pos.nPos + nBlockSize - 1));
+    fclose(file);
+    BOOST_CHECK(!map.GetBlock(pos, blockData));
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
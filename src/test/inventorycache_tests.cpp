@@ -0,0 +1,92 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <inventorycache.h>
+
+#include <random.h>
+#include <utiltime.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+static CSerializedNetMsg MakeMsg(const std::string& strCommand, size_t nSize)
+{
+    CSerializedNetMsg msg;
+    msg.command = strCommand;
+    msg.data.resize(nSize, 0x42);
+    return msg;
+}
+
+BOOST_FIXTURE_TEST_SUITE(inventorycache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(inventorycache_get)
+{
+    CRelayInventoryCache cache;
+    CInv inv(MSG_MASTERNODE_PING, InsecureRand256());
+    CInv invOtherType(MSG_MASTERNODE_VERIFY, inv.hash);
+
+    cache.Insert(inv, PROTOCOL_VERSION, MakeMsg("mnp", 100));
+    BOOST_CHECK(cache.Contains(inv));
+    BOOST_CHECK(!cache.Contains(invOtherType));
+
+    CSerializedNetMsg msg;
+    BOOST_CHECK(cache.Get(inv, PROTOCOL_VERSION, msg));
+    BOOST_CHECK_EQUAL(msg.command, "mnp");
+    BOOST_CHECK_EQUAL(msg.data.size(), 100U);
+    // the same object serialized for another version is not reused
+    BOOST_CHECK(!cache.Get(inv, PROTOCOL_VERSION - 1, msg));
+
+    cache.Insert(inv, PROTOCOL_VERSION, MakeMsg("mnp", 50));
+    BOOST_CHECK_EQUAL(cache.Size(), 1U);
+    BOOST_CHECK_EQUAL(cache.GetTotalBytes(), 53U);
+
+    cache.Erase(inv);
+    BOOST_CHECK(!cache.Contains(inv));
+    BOOST_CHECK_EQUAL(cache.GetTotalBytes(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(inventorycache_expiry)
+{
+    SetMockTime(1540000000);
+    CRelayInventoryCache cache(1 << 20, 60);
+    CInv invOld(MSG_SPORK, InsecureRand256());
+    cache.Insert(invOld, PROTOCOL_VERSION, MakeMsg("spork", 10));
+
+    SetMockTime(1540000030);
+    CInv invNew(MSG_SPORK, InsecureRand256());
+    cache.Insert(invNew, PROTOCOL_VERSION, MakeMsg("spork", 10));
+
+    SetMockTime(1540000061);
+    CSerializedNetMsg msg;
+    BOOST_CHECK(!cache.Contains(invOld));
+    BOOST_CHECK(!cache.Get(invOld, PROTOCOL_VERSION, msg));
+    BOOST_CHECK(cache.Contains(invNew));
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(inventorycache_size_limit)
+{
+    // 16 shards of 1000 bytes each
+    CRelayInventoryCache cache(16 * 1000);
+
+    std::vector<CInv> vInv;
+    for (int i = 0; i < 1000; i++) {
+        vInv.emplace_back(MSG_TXLOCK_VOTE, InsecureRand256());
+        cache.Insert(vInv.back(), PROTOCOL_VERSION, MakeMsg("txlvote", 93));
+        BOOST_CHECK(cache.GetTotalBytes() <= 16 * 1000);
+    }
+    // the most recent entry always survives, the oldest ones are gone
+    BOOST_CHECK(cache.Contains(vInv.back()));
+    BOOST_CHECK(!cache.Contains(vInv.front()));
+    BOOST_CHECK(cache.Size() <= 160U);
+
+    // a message that does not fit into a shard is not cached at all
+    CInv invHuge(MSG_GOVERNANCE_OBJECT, InsecureRand256());
+    cache.Insert(invHuge, PROTOCOL_VERSION, MakeMsg("govobj", 2000));
+    BOOST_CHECK(!cache.Contains(invHuge));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
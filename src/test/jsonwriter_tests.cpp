@@ -0,0 +1,202 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <jsonwriter.h>
+
+#include <chainparams.h>
+#include <core_io.h>
+#include <key.h>
+#include <rpc/server.h>
+#include <script/standard.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <univalue.h>
+
+/** Run request through the regular and the streaming path and return both results */
+static std::pair<std::string, std::string> ExecuteBoth(const std::string& strMethod, const UniValue& params)
+{
+    JSONRPCRequest request;
+    request.strMethod = strMethod;
+    request.params = params;
+
+    std::string strStream;
+    JSONStreamWriter writer([&strStream](const std::string& strChunk) { strStream += strChunk; }, 1);
+    BOOST_CHECK(tableRPC.executeStream(request, writer));
+    writer.Flush();
+
+    return std::make_pair(tableRPC.execute(request).write(), strStream);
+}
+
+static CMutableTransaction MakeSpend(const CKey& key)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(2);
+    tx.vin[0].prevout = COutPoint(InsecureRand256(), 1);
+    tx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(71, 0x30) << ToByteVector(key.GetPubKey());
+    tx.vin[1].prevout = COutPoint(InsecureRand256(), 0);
+    tx.vin[1].scriptWitness.stack.push_back(std::vector<unsigned char>(72, 0x30));
+    tx.vin[1].scriptWitness.stack.push_back(ToByteVector(key.GetPubKey()));
+    tx.vout.resize(3);
+    tx.vout[0].nValue = 12345678;
+    tx.vout[0].scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+    tx.vout[1].nValue = -1;
+    tx.vout[1].scriptPubKey = CScript() << OP_RETURN << std::vector<unsigned char>(10, 0x42);
+    tx.vout[2].nValue = 21000000 * COIN;
+    tx.vout[2].scriptPubKey = GetScriptForMultisig(1, {key.GetPubKey(), key.GetPubKey()});
+    return tx;
+}
+
+BOOST_FIXTURE_TEST_SUITE(jsonwriter_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(jsonwriter_matches_univalue)
+{
+    UniValue inner(UniValue::VARR);
+    inner.push_back("tab\tquote\"backslash\\ctrl\x01\x7f");
+    inner.push_back(-42);
+    inner.push_back((uint64_t)18446744073709551615ULL);
+    inner.push_back(0.1);
+    inner.push_back(1e-20);
+    inner.push_back(UniValue(UniValue::VOBJ));
+    inner.push_back(UniValue(UniValue::VARR));
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("a", inner);
+    obj.pushKV("key\n", true);
+    obj.pushKV("n", NullUniValue);
+    obj.pushKV("amount", ValueFromAmount(-150000001));
+
+    JSONStreamWriter writer;
+    writer.BeginObject();
+    writer.Key("a");
+    writer.BeginArray();
+    writer.Value("tab\tquote\"backslash\\ctrl\x01\x7f");
+    writer.Value(-42);
+    writer.Value((uint64_t)18446744073709551615ULL);
+    writer.Value(0.1);
+    writer.Value(1e-20);
+    writer.BeginObject();
+    writer.EndObject();
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndArray();
+    writer.KV("key\n", true);
+    writer.Key("n");
+    writer.Null();
+    writer.KV("amount", ValueFromAmount(-150000001));
+    writer.EndObject();
+
+    BOOST_CHECK_EQUAL(writer.GetBuffer(), obj.write());
+    BOOST_CHECK(!writer.HasFlushed());
+}
+
+BOOST_AUTO_TEST_CASE(jsonwriter_flush)
+{
+    std::vector<std::string> vChunks;
+    JSONStreamWriter writer([&vChunks](const std::string& strChunk) { vChunks.push_back(strChunk); }, 10);
+    writer.BeginArray();
+    for (int i = 0; i < 100; i++)
+        writer.Value(i);
+    writer.EndArray();
+    writer.Flush();
+
+    UniValue arr(UniValue::VARR);
+    for (int i = 0; i < 100; i++)
+        arr.push_back(i);
+
+    std::string strJoined;
+    for (const std::string& strChunk : vChunks) {
+        BOOST_CHECK(!strChunk.empty());
+        strJoined += strChunk;
+    }
+    BOOST_CHECK(vChunks.size() > 1);
+    BOOST_CHECK(writer.HasFlushed());
+    BOOST_CHECK(writer.GetBuffer().empty());
+    BOOST_CHECK_EQUAL(strJoined, arr.write());
+}
+
+BOOST_AUTO_TEST_CASE(tx_stream_matches_univ)
+{
+    CKey key;
+    key.MakeNewKey(true);
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << 1 << OP_0;
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 50 * COIN;
+    coinbase.vout[0].scriptPubKey = GetScriptForDestination(CScriptID(GetScriptForDestination(key.GetPubKey().GetID())));
+
+    for (const CTransactionRef& tx : {MakeTransactionRef(MakeSpend(key)), MakeTransactionRef(coinbase)}) {
+        for (const uint256& hashBlock : {uint256(), InsecureRand256()}) {
+            UniValue entry(UniValue::VOBJ);
+            TxToUniv(*tx, hashBlock, entry, true);
+
+            JSONStreamWriter writer;
+            writer.BeginObject();
+            TxToStream(*tx, hashBlock, writer, true);
+            writer.EndObject();
+
+            BOOST_CHECK_EQUAL(writer.GetBuffer(), entry.write());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rpc_stream_matches_execute)
+{
+    if (RPCIsInWarmup(nullptr))
+        SetRPCWarmupFinished();
+
+    // getblock with every verbosity level that is streamed
+    UniValue params(UniValue::VARR);
+    params.push_back(Params().GenesisBlock().GetHash().GetHex());
+    for (int verbosity = 1; verbosity <= 2; verbosity++) {
+        UniValue paramsVerbosity = params;
+        paramsVerbosity.push_back(verbosity);
+        std::pair<std::string, std::string> results = ExecuteBoth("getblock", paramsVerbosity);
+        BOOST_CHECK_EQUAL(results.first, results.second);
+    }
+
+    // Calls the streaming path does not handle go to the regular actor
+    JSONRPCRequest request;
+    request.strMethod = "getblock";
+    request.params = params;
+    request.params.push_back(0);
+    JSONStreamWriter writer;
+    BOOST_CHECK(!tableRPC.executeStream(request, writer));
+    BOOST_CHECK(writer.GetBuffer().empty());
+
+    // Mempool with a chain of two transactions, then the verbose transaction
+    CKey key;
+    key.MakeNewKey(true);
+    CMutableTransaction txParent = MakeSpend(key);
+    CMutableTransaction txChild = MakeSpend(key);
+    txChild.vin[0].prevout = COutPoint(txParent.GetHash(), 0);
+    TestMemPoolEntryHelper entry;
+    mempool.addUnchecked(txParent.GetHash(), entry.Fee(1000).FromTx(txParent));
+    mempool.addUnchecked(txChild.GetHash(), entry.Fee(2000).FromTx(txChild));
+
+    UniValue paramsMempool(UniValue::VARR);
+    paramsMempool.push_back(true);
+    std::pair<std::string, std::string> results = ExecuteBoth("getrawmempool", paramsMempool);
+    BOOST_CHECK_EQUAL(results.first, results.second);
+
+    UniValue paramsTx(UniValue::VARR);
+    paramsTx.push_back(txChild.GetHash().GetHex());
+    paramsTx.push_back(true);
+    results = ExecuteBoth("getrawtransaction", paramsTx);
+    BOOST_CHECK_EQUAL(results.first, results.second);
+
+    mempool.clear();
+
+    UniValue paramsList(UniValue::VARR);
+    paramsList.push_back("full");
+    results = ExecuteBoth("masternodelist", paramsList);
+    BOOST_CHECK_EQUAL(results.first, results.second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
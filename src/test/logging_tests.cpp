@@ -0,0 +1,101 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <logging.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+struct LoggerTestingSetup : public BasicTestingSetup
+{
+    fs::path pathLog;
+    BCLog::Logger logger;
+
+    LoggerTestingSetup()
+    {
+        pathLog = fs::temp_directory_path() / fs::unique_path("test_xsn_log_%%%%-%%%%");
+        logger.m_file_path = pathLog;
+        logger.m_print_to_file = true;
+        logger.m_log_timestamps = false;
+        BOOST_REQUIRE(logger.OpenDebugLog());
+    }
+
+    ~LoggerTestingSetup()
+    {
+        logger.StopAsyncWriter();
+        fs::remove(pathLog);
+    }
+
+    std::vector<std::string> ReadLines()
+    {
+        std::vector<std::string> vLines;
+        std::ifstream file(pathLog.string());
+        std::string strLine;
+        while (std::getline(file, strLine)) {
+            vLines.push_back(strLine);
+        }
+        return vLines;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(logging_tests, LoggerTestingSetup)
+
+BOOST_AUTO_TEST_CASE(logging_async_writer)
+{
+    logger.StartAsyncWriter();
+    for (int i = 0; i < 1000; i++) {
+        logger.LogPrintStr(strprintf("line %d\n", i));
+    }
+    logger.StopAsyncWriter();
+
+    // Everything is written once the writer stopped, in order
+    std::vector<std::string> vLines = ReadLines();
+    BOOST_REQUIRE_EQUAL(vLines.size(), 1000U);
+    for (int i = 0; i < 1000; i++) {
+        BOOST_CHECK_EQUAL(vLines[i], strprintf("line %d", i));
+    }
+    BOOST_CHECK_EQUAL(logger.GetStats().nDroppedQueueFull, 0U);
+
+    // Back to writing on the calling thread
+    logger.LogPrintStr("sync\n");
+    BOOST_CHECK_EQUAL(ReadLines().back(), "sync");
+}
+
+BOOST_AUTO_TEST_CASE(logging_rate_limit)
+{
+    // 10 bytes per second allows a burst of 100 bytes per category
+    logger.SetRateLimit(10);
+    const std::string strMessage(24, 'x');
+    for (int i = 0; i < 10; i++) {
+        logger.LogPrintStr(strMessage + "\n", BCLog::NET);
+    }
+    // Other categories have their own budget
+    logger.LogPrintStr("mempool\n", BCLog::MEMPOOL);
+    logger.LogPrintStr("uncategorized\n");
+
+    std::vector<std::string> vLines = ReadLines();
+    BOOST_REQUIRE_EQUAL(vLines.size(), 6U);
+    BOOST_CHECK_EQUAL(vLines[3], strMessage);
+    BOOST_CHECK_EQUAL(vLines[4], "mempool");
+    BOOST_CHECK_EQUAL(vLines[5], "uncategorized");
+    BOOST_CHECK_EQUAL(logger.GetStats().nDroppedRateLimit, 6U);
+
+    // Without a limit messages pass unchecked, so the drops are only
+    // reported with the first message after the limit is turned back on
+    logger.SetRateLimit(0);
+    logger.LogPrintStr("after\n", BCLog::NET);
+    vLines = ReadLines();
+    BOOST_CHECK_EQUAL(vLines.back(), "after");
+    logger.SetRateLimit(1000000);
+    logger.LogPrintStr("limited again\n", BCLog::NET);
+    vLines = ReadLines();
+    BOOST_REQUIRE_EQUAL(vLines.size(), 9U);
+    BOOST_CHECK_EQUAL(vLines[7], "Dropped 6 log messages of category net over the rate limit");
+    BOOST_CHECK_EQUAL(vLines[8], "limited again");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
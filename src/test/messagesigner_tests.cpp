@@ -0,0 +1,92 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <messagesigner.h>
+
+#include <key.h>
+#include <random.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(messagesigner_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(messagesigner_verify_cached)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CKey keyOther;
+    keyOther.MakeNewKey(true);
+
+    std::vector<unsigned char> vchSig;
+    std::string strError;
+    BOOST_CHECK(CMessageSigner::SignMessage("message", vchSig, key, CPubKey::InputScriptType::SPENDP2PKH));
+
+    // the second check is answered by the cache and must agree with the first
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(CMessageSigner::VerifyMessage(key.GetPubKey().GetID(), vchSig, "message", strError));
+        BOOST_CHECK(!CMessageSigner::VerifyMessage(keyOther.GetPubKey().GetID(), vchSig, "message", strError));
+        BOOST_CHECK(!CMessageSigner::VerifyMessage(key.GetPubKey().GetID(), vchSig, "other message", strError));
+    }
+
+    std::vector<unsigned char> vchSigBad = vchSig;
+    vchSigBad[10] ^= 0x01;
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(key.GetPubKey().GetID(), vchSigBad, "message", strError));
+}
+
+BOOST_AUTO_TEST_CASE(messagesigner_verify_batch)
+{
+    boost::thread_group threadGroup;
+    for (int i = 0; i < 3; i++) {
+        threadGroup.create_thread(&ThreadMessageSignatureCheck);
+    }
+
+    std::vector<CKey> vKeys(4);
+    for (CKey& key : vKeys) {
+        key.MakeNewKey(true);
+    }
+
+    std::vector<CHashSignatureCheck> vChecks;
+    std::vector<bool> vExpected;
+    for (int i = 0; i < 500; i++) {
+        const CKey& key = vKeys[i % vKeys.size()];
+        uint256 hash = InsecureRand256();
+        std::vector<unsigned char> vchSig;
+        BOOST_CHECK(CHashSigner::SignHash(hash, key, CPubKey::InputScriptType::SPENDP2PKH, vchSig));
+
+        switch (i % 5) {
+        case 0: // signed by another key
+            vChecks.emplace_back(hash, vKeys[(i + 1) % vKeys.size()].GetPubKey().GetID(), vchSig);
+            vExpected.push_back(false);
+            break;
+        case 1: // corrupted signature
+            vchSig[20] ^= 0x80;
+            vChecks.emplace_back(hash, key.GetPubKey().GetID(), vchSig);
+            vExpected.push_back(false);
+            break;
+        case 2: // no signature at all
+            vChecks.emplace_back(hash, key.GetPubKey().GetID(), std::vector<unsigned char>());
+            vExpected.push_back(false);
+            break;
+        default:
+            vChecks.emplace_back(hash, key.GetPubKey().GetID(), vchSig);
+            vExpected.push_back(true);
+        }
+    }
+
+    // run twice, the second time the valid entries come from the cache
+    for (int nRun = 0; nRun < 2; nRun++) {
+        CHashSigner::VerifyHashes(vChecks);
+        for (size_t i = 0; i < vChecks.size(); i++) {
+            BOOST_CHECK_EQUAL(vChecks[i].fValid, vExpected[i]);
+        }
+    }
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-payments.h>
+
+#include <clientversion.h>
+#include <random.h>
+#include <streams.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+static CMasternodePaymentVote MakeVote(int nBlockHeight, const CScript& payee)
+{
+    CMasternodePaymentVote vote(COutPoint(InsecureRand256(), 0), nBlockHeight, payee);
+    vote.vchSig.assign(65, 0x01);
+    return vote;
+}
+
+BOOST_FIXTURE_TEST_SUITE(mnpayments_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(paymentstore_buckets)
+{
+    CMasternodePaymentStore store;
+    CScript payeeA = CScript() << OP_TRUE;
+    CScript payeeB = CScript() << OP_FALSE;
+
+    std::vector<CMasternodePaymentVote> vecVotes;
+    for (int nHeight = 100; nHeight < 110; nHeight++) {
+        for (int i = 0; i < 3; i++) {
+            vecVotes.push_back(MakeVote(nHeight, i ? payeeA : payeeB));
+            BOOST_CHECK(store.AddVote(vecVotes.back(), 50));
+            store.AddPayee(vecVotes.back());
+        }
+    }
+    BOOST_CHECK_EQUAL(store.GetFirstHeight(), 100);
+    BOOST_CHECK_EQUAL(store.GetLastHeight(), 109);
+    BOOST_CHECK_EQUAL(store.GetBlockCount(), 10);
+    BOOST_CHECK_EQUAL(store.GetVoteCount(), 30);
+
+    for (const CMasternodePaymentVote& vote : vecVotes) {
+        const CMasternodePaymentVote* pVote = store.GetVote(vote.GetHash());
+        BOOST_REQUIRE(pVote);
+        BOOST_CHECK(pVote->GetHash() == vote.GetHash());
+    }
+
+    CScript payeeBest;
+    BOOST_REQUIRE(store.GetPayees(105));
+    BOOST_CHECK(store.GetPayees(105)->GetBestPayee(payeeBest));
+    BOOST_CHECK(payeeBest == payeeA);
+    BOOST_CHECK_EQUAL(store.GetBucket(105)->vecVotes.size(), 3U);
+
+    // A vote without payee opens the height, but does not count as a block
+    BOOST_CHECK(store.AddVote(MakeVote(112, payeeA), 50));
+    BOOST_CHECK_EQUAL(store.GetLastHeight(), 112);
+    BOOST_CHECK(store.GetBucket(111));
+    BOOST_CHECK(!store.GetPayees(111));
+    BOOST_CHECK(!store.GetPayees(112));
+    BOOST_CHECK_EQUAL(store.GetBlockCount(), 10);
+
+    // Replacing a stored vote keeps its place
+    CMasternodePaymentVote voteUnverified = vecVotes[0];
+    voteUnverified.MarkAsNotVerified();
+    BOOST_CHECK(store.AddVote(voteUnverified, 50));
+    BOOST_CHECK(!store.GetVote(vecVotes[0].GetHash())->IsVerified());
+    BOOST_CHECK_EQUAL(store.GetVoteCount(), 31);
+
+    // Pruning drops whole heights together with their votes
+    store.Prune(105);
+    BOOST_CHECK_EQUAL(store.GetFirstHeight(), 105);
+    BOOST_CHECK(!store.GetBucket(104));
+    BOOST_CHECK(!store.GetVote(vecVotes[0].GetHash()));
+    BOOST_CHECK(store.GetVote(vecVotes[15].GetHash()));
+    BOOST_CHECK_EQUAL(store.GetBlockCount(), 5);
+    BOOST_CHECK_EQUAL(store.GetVoteCount(), 16);
+}
+
+BOOST_AUTO_TEST_CASE(paymentstore_span)
+{
+    CMasternodePaymentStore store;
+    CScript payee = CScript() << OP_TRUE;
+
+    CMasternodePaymentVote voteFirst = MakeVote(1000, payee);
+    BOOST_CHECK(store.AddVote(voteFirst, 10));
+    store.AddPayee(voteFirst);
+
+    // Older heights are only accepted while they fit into the span
+    BOOST_CHECK(store.AddVote(MakeVote(991, payee), 10));
+    BOOST_CHECK(!store.AddVote(MakeVote(990, payee), 10));
+    BOOST_CHECK_EQUAL(store.GetFirstHeight(), 991);
+
+    // Newer heights push the oldest ones out
+    BOOST_CHECK(store.AddVote(MakeVote(1005, payee), 10));
+    BOOST_CHECK_EQUAL(store.GetFirstHeight(), 996);
+    BOOST_CHECK_EQUAL(store.GetLastHeight(), 1005);
+    BOOST_CHECK_EQUAL(store.GetVoteCount(), 2);
+
+    BOOST_CHECK(store.AddVote(MakeVote(100000, payee), 10));
+    BOOST_CHECK_EQUAL(store.GetFirstHeight(), 100000);
+    BOOST_CHECK_EQUAL(store.GetLastHeight(), 100000);
+    BOOST_CHECK_EQUAL(store.GetBlockCount(), 0);
+    BOOST_CHECK_EQUAL(store.GetVoteCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(paymentstore_serialize)
+{
+    CMasternodePaymentStore store;
+    CScript payee = CScript() << OP_TRUE;
+
+    std::vector<CMasternodePaymentVote> vecVotes;
+    for (int nHeight = 500; nHeight < 520; nHeight += 2) {
+        vecVotes.push_back(MakeVote(nHeight, payee));
+        BOOST_CHECK(store.AddVote(vecVotes.back(), 100));
+        store.AddPayee(vecVotes.back());
+    }
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << store;
+    CMasternodePaymentStore storeLoaded;
+    ss >> storeLoaded;
+
+    BOOST_CHECK_EQUAL(storeLoaded.GetFirstHeight(), 500);
+    BOOST_CHECK_EQUAL(storeLoaded.GetLastHeight(), 518);
+    BOOST_CHECK_EQUAL(storeLoaded.GetBlockCount(), 10);
+    BOOST_CHECK_EQUAL(storeLoaded.GetVoteCount(), 10);
+    for (const CMasternodePaymentVote& vote : vecVotes) {
+        BOOST_CHECK(storeLoaded.GetVote(vote.GetHash()));
+        BOOST_CHECK(storeLoaded.GetPayees(vote.nBlockHeight));
+    }
+    BOOST_CHECK(!storeLoaded.GetPayees(501));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,108 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-registry.h>
+
+#include <chain.h>
+#include <masternode.h>
+#include <random.h>
+#include <validation.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+static CTransactionRef MakeTx(const COutPoint& prevout, const std::vector<CAmount>& vAmounts)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    if (prevout.IsNull()) {
+        tx.vin[0].scriptSig = CScript() << 1 << OP_0;
+    }
+    for (CAmount nAmount : vAmounts) {
+        tx.vout.emplace_back(nAmount, CScript() << OP_TRUE);
+    }
+    return MakeTransactionRef(tx);
+}
+
+BOOST_FIXTURE_TEST_SUITE(mnregistry_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(registry_connect_disconnect)
+{
+    CMasternodeRegistry registry;
+    BOOST_CHECK(registry.Rebuild());
+    const CBlockIndex* pindexGenesis = registry.GetBestBlock();
+    BOOST_CHECK(pindexGenesis == chainActive.Tip());
+    BOOST_CHECK_EQUAL(registry.size(), 0U);
+
+    // Block 1 creates collateral A next to a regular output, and collateral B
+    // which is spent again within the same block
+    CBlock block1;
+    block1.vtx.push_back(MakeTx(COutPoint(), {MASTERNODE_COLLATERAL_AMOUNT, 10 * COIN}));
+    block1.vtx.push_back(MakeTx(COutPoint(InsecureRand256(), 0), {MASTERNODE_COLLATERAL_AMOUNT}));
+    block1.vtx.push_back(MakeTx(COutPoint(block1.vtx[1]->GetHash(), 0), {MASTERNODE_COLLATERAL_AMOUNT - 1}));
+    const COutPoint outpointA(block1.vtx[0]->GetHash(), 0);
+    const COutPoint outpointB(block1.vtx[1]->GetHash(), 0);
+
+    uint256 hashBlock1 = block1.GetHash();
+    CBlockIndex index1;
+    index1.phashBlock = &hashBlock1;
+    index1.pprev = const_cast<CBlockIndex*>(pindexGenesis);
+    index1.nHeight = pindexGenesis->nHeight + 1;
+
+    registry.ConnectBlock(block1, &index1);
+    BOOST_CHECK_EQUAL(registry.size(), 1U);
+    CMasternodeCollateral collateral;
+    BOOST_CHECK(registry.GetCollateral(outpointA, collateral));
+    BOOST_CHECK_EQUAL(collateral.nHeight, index1.nHeight);
+    BOOST_CHECK(collateral.scriptPubKey == CScript() << OP_TRUE);
+    BOOST_CHECK(!registry.Has(outpointB));
+    BOOST_CHECK(registry.GetBestBlock() == &index1);
+
+    // A repeated notification for a block already applied is ignored
+    registry.ConnectBlock(block1, &index1);
+    BOOST_CHECK_EQUAL(registry.size(), 1U);
+
+    // Block 2 spends collateral A
+    CBlock block2;
+    block2.vtx.push_back(MakeTx(COutPoint(), {1 * COIN}));
+    block2.vtx.push_back(MakeTx(outpointA, {MASTERNODE_COLLATERAL_AMOUNT - COIN}));
+    uint256 hashBlock2 = block2.GetHash();
+    CBlockIndex index2;
+    index2.phashBlock = &hashBlock2;
+    index2.pprev = &index1;
+    index2.nHeight = index1.nHeight + 1;
+
+    registry.ConnectBlock(block2, &index2);
+    BOOST_CHECK_EQUAL(registry.size(), 0U);
+
+    // Disconnecting a block that is not the tip of the registry does nothing
+    registry.DisconnectBlock(block1);
+    BOOST_CHECK(registry.GetBestBlock() == &index2);
+
+    registry.DisconnectBlock(block2);
+    BOOST_CHECK(registry.Has(outpointA));
+    BOOST_CHECK(registry.GetBestBlock() == &index1);
+
+    registry.DisconnectBlock(block1);
+    BOOST_CHECK_EQUAL(registry.size(), 0U);
+    BOOST_CHECK(registry.GetBestBlock() == pindexGenesis);
+
+    // A block that does not extend the registry marks it stale until the
+    // next scan
+    registry.ConnectBlock(block1, &index1);
+    BOOST_CHECK(registry.GetBestBlock() == &index1);
+    CBlockIndex index3;
+    index3.phashBlock = &hashBlock2;
+    index3.pprev = &index2;
+    index3.nHeight = index2.nHeight + 1;
+    registry.ConnectBlock(block2, &index3);
+    BOOST_CHECK(registry.GetBestBlock() == nullptr);
+    BOOST_CHECK_EQUAL(registry.size(), 0U);
+    BOOST_CHECK(registry.Rebuild());
+    BOOST_CHECK(registry.GetBestBlock() == chainActive.Tip());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <mpmcqueue.h>
+
+#include <test/test_xsn.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(mpmcqueue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mpmcqueue_single_thread)
+{
+    // capacity is rounded up to a power of two
+    MPMCQueue<int> queue(5);
+    BOOST_CHECK_EQUAL(queue.Capacity(), 8U);
+
+    int value;
+    BOOST_CHECK(!queue.TryPop(value));
+
+    for (int i = 0; i < 8; i++)
+        BOOST_CHECK(queue.TryPush(i));
+    BOOST_CHECK(!queue.TryPush(8));
+
+    // FIFO order, and the ring wraps around
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 8; i++) {
+            BOOST_CHECK(queue.TryPop(value));
+            BOOST_CHECK_EQUAL(value, i);
+        }
+        BOOST_CHECK(!queue.TryPop(value));
+        for (int i = 0; i < 8; i++)
+            BOOST_CHECK(queue.TryPush(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mpmcqueue_multi_thread)
+{
+    static const int PRODUCERS = 4;
+    static const int CONSUMERS = 4;
+    static const int ITEMS_PER_PRODUCER = 10000;
+
+    MPMCQueue<int> queue(64);
+    std::atomic<int> nPopped(0);
+    std::atomic<long> nSum(0);
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([&queue] {
+            for (int i = 1; i <= ITEMS_PER_PRODUCER; i++) {
+                while (!queue.TryPush(i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&] {
+            int value;
+            while (nPopped < PRODUCERS * ITEMS_PER_PRODUCER) {
+                if (queue.TryPop(value)) {
+                    nSum += value;
+                    nPopped++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    // every item was delivered exactly once
+    BOOST_CHECK_EQUAL(nPopped, PRODUCERS * ITEMS_PER_PRODUCER);
+    BOOST_CHECK_EQUAL(nSum, (long)PRODUCERS * ITEMS_PER_PRODUCER * (ITEMS_PER_PRODUCER + 1) / 2);
+    int value;
+    BOOST_CHECK(!queue.TryPop(value));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -71,6 +71,31 @@ BOOST_AUTO_TEST_CASE(streams_vector_writer)
     vch.clear();
 }
 
+BOOST_AUTO_TEST_CASE(streams_span_reader)
+{
+    std::vector<unsigned char> vch = {1, 255, 3, 4, 5, 6};
+
+    CSpanReader reader(SER_NETWORK, INIT_PROTO_VERSION, Span<const unsigned char>(vch.data(), vch.size()));
+    BOOST_CHECK_EQUAL(reader.size(), 6U);
+    unsigned char a;
+    reader >> a;
+    BOOST_CHECK_EQUAL(a, 1);
+    reader.ignore(1);
+    uint16_t b;
+    reader >> b;
+    BOOST_CHECK_EQUAL(b, 0x0403);
+    BOOST_CHECK_EQUAL(reader.size(), 2U);
+    BOOST_CHECK_EQUAL(reader.remaining().data(), vch.data() + 4);
+
+    // Reading past the end throws and leaves the position alone
+    uint32_t c;
+    BOOST_CHECK_THROW(reader >> c, std::ios_base::failure);
+    BOOST_CHECK_THROW(reader.ignore(3), std::ios_base::failure);
+    reader >> b;
+    BOOST_CHECK_EQUAL(b, 0x0605);
+    BOOST_CHECK_EQUAL(reader.size(), 0U);
+}
+
 BOOST_AUTO_TEST_CASE(streams_serializedata_xor)
 {
     std::vector<char> in;
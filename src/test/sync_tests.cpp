@@ -0,0 +1,129 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <sync.h>
+#include <utiltime.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string.h>
+#include <thread>
+
+struct LockProfilingSetup : public BasicTestingSetup
+{
+    LockProfilingSetup()
+    {
+        ResetLockProfile();
+        g_lock_profiling = true;
+    }
+
+    ~LockProfilingSetup()
+    {
+        g_lock_profiling = DEFAULT_LOCK_PROFILING;
+        ResetLockProfile();
+    }
+};
+
+static bool FindLockSite(const char* pszName, LockSiteStats& statsRet)
+{
+    for (const LockSiteStats& stats : GetLockProfile()) {
+        if (strcmp(stats.pszName, pszName) == 0) {
+            statsRet = stats;
+            return true;
+        }
+    }
+    return false;
+}
+
+BOOST_FIXTURE_TEST_SUITE(sync_tests, LockProfilingSetup)
+
+BOOST_AUTO_TEST_CASE(lock_profile_records_sites)
+{
+    CCriticalSection cs_profiled;
+    for (int i = 0; i < 3; i++) {
+        LOCK(cs_profiled);
+    }
+    {
+        TRY_LOCK(cs_profiled, lockProfiled);
+        const bool fLocked = lockProfiled;
+        BOOST_CHECK(fLocked);
+    }
+
+    // The LOCK and the TRY_LOCK are separate sites of the same lock
+    std::vector<LockSiteStats> vStats = GetLockProfile();
+    BOOST_CHECK_EQUAL(vStats.size(), 2U);
+    uint64_t nAcquisitions = 0;
+    for (const LockSiteStats& stats : vStats) {
+        BOOST_CHECK_EQUAL(std::string(stats.pszName), "cs_profiled");
+        BOOST_CHECK_EQUAL(stats.nContentions, 0U);
+        BOOST_CHECK_EQUAL(stats.nWaitMicros, 0);
+        BOOST_CHECK(stats.nMaxHoldMicros <= stats.nHoldMicros);
+        nAcquisitions += stats.nAcquisitions;
+    }
+    BOOST_CHECK_EQUAL(nAcquisitions, 4U);
+
+    // Nothing is recorded while profiling is off
+    g_lock_profiling = false;
+    {
+        LOCK(cs_profiled);
+    }
+    LockSiteStats stats;
+    BOOST_CHECK(FindLockSite("cs_profiled", stats));
+    nAcquisitions = 0;
+    for (const LockSiteStats& site : GetLockProfile()) {
+        nAcquisitions += site.nAcquisitions;
+    }
+    BOOST_CHECK_EQUAL(nAcquisitions, 4U);
+
+    ResetLockProfile();
+    BOOST_CHECK(GetLockProfile().empty());
+}
+
+BOOST_AUTO_TEST_CASE(lock_profile_contention)
+{
+    CCriticalSection cs_contended;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool fLocked = false;
+
+    std::thread thread([&] {
+        LOCK(cs_contended);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fLocked = true;
+        }
+        cond.notify_one();
+        MilliSleep(50);
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return fLocked; });
+    }
+    {
+        LOCK(cs_contended);
+    }
+    thread.join();
+
+    // The exited thread's profile is kept as well
+    uint64_t nAcquisitions = 0;
+    uint64_t nContentions = 0;
+    int64_t nWaitMicros = 0;
+    int64_t nMaxHoldMicros = 0;
+    for (const LockSiteStats& stats : GetLockProfile()) {
+        BOOST_CHECK_EQUAL(std::string(stats.pszName), "cs_contended");
+        nAcquisitions += stats.nAcquisitions;
+        nContentions += stats.nContentions;
+        nWaitMicros += stats.nWaitMicros;
+        nMaxHoldMicros = std::max(nMaxHoldMicros, stats.nMaxHoldMicros);
+    }
+    BOOST_CHECK_EQUAL(nAcquisitions, 2U);
+    BOOST_CHECK_EQUAL(nContentions, 1U);
+    BOOST_CHECK(nWaitMicros > 0);
+    BOOST_CHECK(nMaxHoldMicros >= 40000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
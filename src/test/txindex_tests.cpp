@@ -48,4 +48,66 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_background_sync, TestChain100Setup)
+{
+    // An index enabled on a node that already has the chain back-fills it
+    // in the background.
+    TxIndex txindex(MakeUnique<TxIndexDB>(1 << 20, true));
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+
+    // Transactions are not found before the initial sync.
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(!txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+
+    txindex.Start();
+
+    // Allow tx index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!txindex.IsSynced()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    for (const auto& txn : m_coinbase_txns) {
+        if (!txindex.FindTx(txn->GetHash(), block_hash, tx_disk)) {
+            BOOST_ERROR("FindTx failed");
+        } else if (tx_disk->GetHash() != txn->GetHash()) {
+            BOOST_ERROR("Read incorrect tx");
+        }
+    }
+
+    txindex.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_upgrade_without_locator, TestChain100Setup)
+{
+    // Older versions indexed every connected block without writing a best
+    // block locator. Such an index is taken to be in sync with the tip
+    // instead of being rebuilt.
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+
+    std::unique_ptr<TxIndexDB> db = MakeUnique<TxIndexDB>(1 << 20, true);
+    CBlockLocator locator;
+    BOOST_CHECK(!db->ReadBestBlock(locator));
+    const CTransaction& tx_tip = *m_coinbase_txns.back();
+    CDiskTxPos pos(chainActive.Tip()->GetBlockPos(), GetSizeOfCompactSize(1));
+    BOOST_CHECK(db->WriteTxs({std::make_pair(tx_tip.GetHash(), pos)}));
+
+    TxIndex txindex(std::move(db));
+    txindex.Start();
+
+    // In sync right away and without back-filling older blocks
+    BOOST_CHECK(txindex.IsSynced());
+    BOOST_CHECK(txindex.FindTx(tx_tip.GetHash(), block_hash, tx_disk));
+    BOOST_CHECK(block_hash == chainActive.Tip()->GetBlockHash());
+    BOOST_CHECK(!txindex.FindTx(m_coinbase_txns.front()->GetHash(), block_hash, tx_disk));
+
+    txindex.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <utxosnapshot.h>
+
+#include <chainparams.h>
+#include <clientversion.h>
+#include <coins.h>
+#include <rpc/server.h>
+#include <streams.h>
+#include <util.h>
+#include <validation.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <univalue.h>
+
+static UniValue CallRPC(const std::string& strMethod, const UniValue& params)
+{
+    JSONRPCRequest request;
+    request.strMethod = strMethod;
+    request.params = params;
+    return tableRPC.execute(request);
+}
+
+BOOST_AUTO_TEST_SUITE(utxosnapshot_tests)
+
+BOOST_FIXTURE_TEST_CASE(utxosnapshot_metadata_serialization, BasicTestingSetup)
+{
+    CUTXOSnapshotMetadata metadata;
+    memcpy(metadata.pchMessageStart, Params().MessageStart(), sizeof(metadata.pchMessageStart));
+    metadata.hashBaseBlock = InsecureRand256();
+    metadata.nBaseHeight = 12345;
+    metadata.nCoinsCount = 678;
+    metadata.hashSerialized = InsecureRand256();
+    metadata.nMoneySupply = 42 * COIN;
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << metadata;
+    CUTXOSnapshotMetadata metadataRead;
+    ss >> metadataRead;
+    BOOST_CHECK(metadataRead.hashBaseBlock == metadata.hashBaseBlock);
+    BOOST_CHECK_EQUAL(metadataRead.nBaseHeight, metadata.nBaseHeight);
+    BOOST_CHECK_EQUAL(metadataRead.nCoinsCount, metadata.nCoinsCount);
+    BOOST_CHECK(metadataRead.hashSerialized == metadata.hashSerialized);
+    BOOST_CHECK_EQUAL(metadataRead.nMoneySupply, metadata.nMoneySupply);
+    BOOST_CHECK(memcmp(metadataRead.pchMessageStart, metadata.pchMessageStart, sizeof(metadata.pchMessageStart)) == 0);
+
+    // Anything but a snapshot is rejected
+    ss.clear();
+    ss << metadata;
+    ss[0] = 'x';
+    BOOST_CHECK_THROW(ss >> metadataRead, std::ios_base::failure);
+}
+
+BOOST_FIXTURE_TEST_CASE(utxosnapshot_dump, TestChain100Setup)
+{
+    UniValue params(UniValue::VARR);
+    params.push_back("utxo.dat");
+    UniValue result = CallRPC("dumptxoutset", params);
+    UniValue stats = CallRPC("gettxoutsetinfo", UniValue(UniValue::VARR));
+    BOOST_CHECK_EQUAL(result["coins_written"].get_int64(), stats["txouts"].get_int64());
+    BOOST_CHECK_EQUAL(result["hash_serialized_2"].get_str(), stats["hash_serialized_2"].get_str());
+    BOOST_CHECK_EQUAL(result["base_height"].get_int(), chainActive.Height());
+
+    // An existing snapshot is never overwritten
+    BOOST_CHECK_THROW(CallRPC("dumptxoutset", params), UniValue);
+
+    CAutoFile file(fsbridge::fopen(GetDataDir() / "utxo.dat", "rb"), SER_DISK, CLIENT_VERSION);
+    BOOST_REQUIRE(!file.IsNull());
+    CUTXOSnapshotMetadata metadata;
+    file >> metadata;
+    BOOST_CHECK(metadata.hashBaseBlock == chainActive.Tip()->GetBlockHash());
+    BOOST_CHECK_EQUAL(metadata.nMoneySupply, chainActive.Tip()->nMoneySupply);
+    for (uint64_t i = 0; i < metadata.nCoinsCount; i++) {
+        COutPoint outpoint;
+        Coin coin;
+        file >> outpoint;
+        file >> coin;
+        BOOST_CHECK(pcoinsTip->HaveCoin(outpoint));
+    }
+
+    // The snapshot only goes into an empty chainstate
+    std::string strError;
+    BOOST_CHECK(!LoadUTXOSnapshot(file, metadata, strError));
+    BOOST_CHECK(!strError.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <validationinterface.h>
+
+#include <uint256.h>
+#include <utiltime.h>
+
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <mutex>
+#include <vector>
+
+class InventoryRecorder : public CValidationInterface
+{
+public:
+    explicit InventoryRecorder(std::shared_future<void> releaseIn = std::shared_future<void>()) : release(releaseIn) {}
+
+    std::vector<uint256> GetSeen()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return vSeen;
+    }
+
+protected:
+    void Inventory(const uint256& hash) override
+    {
+        if (release.valid()) release.wait();
+        std::lock_guard<std::mutex> lock(mutex);
+        vSeen.push_back(hash);
+    }
+
+private:
+    std::shared_future<void> release;
+    std::mutex mutex;
+    std::vector<uint256> vSeen;
+};
+
+BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(validationinterface_independent_queues)
+{
+    // A second thread, so the blocked subscriber does not occupy the only one
+    threadGroup.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+
+    std::promise<void> promiseRelease;
+    InventoryRecorder slow(promiseRelease.get_future().share());
+    InventoryRecorder fast;
+    RegisterValidationInterface(&slow);
+    RegisterValidationInterface(&fast);
+
+    std::vector<uint256> vHashes;
+    for (int i = 0; i < 10; i++) {
+        vHashes.push_back(InsecureRand256());
+        GetMainSignals().Inventory(vHashes.back());
+    }
+
+    // The fast subscriber gets all events while the slow one is stuck on the first
+    for (int i = 0; i < 1000 && fast.GetSeen().size() < vHashes.size(); i++) {
+        MilliSleep(10);
+    }
+    BOOST_CHECK(fast.GetSeen() == vHashes);
+    BOOST_CHECK(slow.GetSeen().empty());
+    BOOST_CHECK(GetMainSignals().CallbacksPending() > 0);
+
+    // Syncing waits for every subscriber
+    promiseRelease.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK(slow.GetSeen() == vHashes);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 0U);
+
+    // Unregistered subscribers are not called anymore
+    UnregisterValidationInterface(&slow);
+    UnregisterValidationInterface(&fast);
+    GetMainSignals().Inventory(InsecureRand256());
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(slow.GetSeen().size(), vHashes.size());
+    BOOST_CHECK_EQUAL(fast.GetSeen().size(), vHashes.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
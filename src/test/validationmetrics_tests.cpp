@@ -0,0 +1,93 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <validationmetrics.h>
+
+#include <net_processing.h>
+#include <protocol.h>
+#include <test/test_xsn.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(validationmetrics_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(latency_histogram_buckets)
+{
+    CLatencyHistogram histogram;
+    histogram.Record(-5);       // clamped to 0, first bucket
+    histogram.Record(100);      // bounds are inclusive
+    histogram.Record(101);      // second bucket
+    histogram.Record(2000);     // 2.5ms bucket
+    histogram.Record(60000000); // above the last bound
+
+    CLatencyHistogram::Snapshot snapshot = histogram.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.vBuckets.size(), LATENCY_HISTOGRAM_BUCKETS);
+    BOOST_CHECK_EQUAL(snapshot.vBuckets[0], 2U);
+    BOOST_CHECK_EQUAL(snapshot.vBuckets[1], 1U);
+    BOOST_CHECK_EQUAL(snapshot.vBuckets[4], 1U);
+    BOOST_CHECK_EQUAL(snapshot.vBuckets.back(), 1U);
+    BOOST_CHECK_EQUAL(snapshot.nCount, 5U);
+    BOOST_CHECK_EQUAL(snapshot.nSumMicros, 100 + 101 + 2000 + 60000000);
+    BOOST_CHECK_EQUAL(snapshot.nMaxMicros, 60000000);
+
+    BOOST_CHECK_EQUAL(snapshot.GetQuantile(0.2), 100);
+    BOOST_CHECK_EQUAL(snapshot.GetQuantile(0.5), 250);
+    BOOST_CHECK_EQUAL(snapshot.GetQuantile(0.8), 2500);
+    BOOST_CHECK_EQUAL(snapshot.GetQuantile(1.0), 60000000);
+
+    histogram.Reset();
+    snapshot = histogram.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.nCount, 0U);
+    BOOST_CHECK_EQUAL(snapshot.nMaxMicros, 0);
+    BOOST_CHECK_EQUAL(snapshot.GetQuantile(0.5), 0);
+}
+
+BOOST_AUTO_TEST_CASE(validation_metrics_prometheus)
+{
+    CValidationMetrics metrics;
+    metrics.Record(ValidationStage::CONNECT_TIP, 1500);
+    metrics.Record(ValidationStage::CONNECT_TIP, 30000);
+    metrics.Record(ValidationStage::PROOF_OF_STAKE, 200);
+
+    BOOST_CHECK_EQUAL(metrics.GetSnapshot(ValidationStage::CONNECT_TIP).nCount, 2U);
+    BOOST_CHECK_EQUAL(metrics.GetSnapshot(ValidationStage::BLOCK_PAYEE).nCount, 0U);
+
+    const std::string text = metrics.ToPrometheusText();
+    BOOST_CHECK(text.find("# TYPE xsn_validation_stage_duration_seconds histogram\n") != std::string::npos);
+    // Buckets are cumulative
+    BOOST_CHECK(text.find("xsn_validation_stage_duration_seconds_bucket{stage=\"connect_tip\",le=\"0.001\"} 0\n") != std::string::npos);
+    BOOST_CHECK(text.find("xsn_validation_stage_duration_seconds_bucket{stage=\"connect_tip\",le=\"0.0025\"} 1\n") != std::string::npos);
+    BOOST_CHECK(text.find("xsn_validation_stage_duration_seconds_bucket{stage=\"connect_tip\",le=\"10\"} 2\n") != std::string::npos);
+    BOOST_CHECK(text.find("xsn_validation_stage_duration_seconds_bucket{stage=\"connect_tip\",le=\"+Inf\"} 2\n") != std::string::npos);
+    BOOST_CHECK(text.find("xsn_validation_stage_duration_seconds_sum{stage=\"connect_tip\"} 0.031500\n") != std::string::npos);
+    BOOST_CHECK(text.find("xsn_validation_stage_duration_seconds_count{stage=\"proof_of_stake\"} 1\n") != std::string::npos);
+    BOOST_CHECK(text.find("xsn_validation_stage_duration_seconds_count{stage=\"merchant_payment\"} 0\n") != std::string::npos);
+
+    metrics.Reset();
+    BOOST_CHECK_EQUAL(metrics.GetSnapshot(ValidationStage::CONNECT_TIP).nCount, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(message_latency_histogram)
+{
+    // Message latencies share the histogram layout of the validation stages.
+    // The registry is global, so only look at what this test adds.
+    std::map<std::string, CLatencyHistogram::Snapshot> mapBefore = GetMessageLatencyStats();
+    RecordMessageLatency(NetMsgType::PING, 150);
+    RecordMessageLatency(NetMsgType::PING, 20000000);
+    RecordMessageLatency("notacommand", 50);
+
+    const std::map<std::string, CLatencyHistogram::Snapshot> mapStats = GetMessageLatencyStats();
+    const CLatencyHistogram::Snapshot& ping = mapStats.at(NetMsgType::PING);
+    BOOST_CHECK_EQUAL(ping.vBuckets.size(), LATENCY_HISTOGRAM_BUCKETS);
+    BOOST_CHECK_EQUAL(ping.nCount - mapBefore[NetMsgType::PING].nCount, 2U);
+    BOOST_CHECK_EQUAL(ping.nMaxMicros, 20000000);
+    BOOST_CHECK(!mapStats.count("notacommand"));
+    BOOST_CHECK_EQUAL(mapStats.at("*other*").nCount - mapBefore["*other*"].nCount, 1U);
+
+    const std::string text = MessageLatencyToPrometheusText();
+    BOOST_CHECK(text.find("# TYPE xsn_message_handling_duration_seconds histogram\n") != std::string::npos);
+    BOOST_CHECK(text.find(strprintf("xsn_message_handling_duration_seconds_count{command=\"ping\"} %u\n", ping.nCount)) != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,7 @@
 #include <messagesigner.h>
 #include <script/standard.h>
 #include <util.h>
+#include <validationinterface.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
 #endif // ENABLE_WALLET
@@ -83,10 +84,22 @@ bool CMerchantnode::UpdateFromNewBroadcast(CMerchantnodeBroadcast& mnb, CConnman
     return true;
 }
 
-void CMerchantnode::Check(bool fForce)
+void CMerchantnode::Check(bool fForce, bool fNotify)
 {
     LOCK2(cs_main, cs);
 
+    int nActiveStateOrig = nActiveState;
+    CheckState(fForce);
+    if(fNotify && nActiveState != nActiveStateOrig) {
+        GetMainSignals().NotifyMerchantnodeChanged(pubKeyMerchantnode, GetStatus());
+    }
+}
+
+void CMerchantnode::CheckState(bool fForce)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs);
+
     if(ShutdownRequested()) return;
 
     if(!fForce && (GetTime() - nTimeLastChecked < MERCHANTNODE_CHECK_SECONDS)) return;
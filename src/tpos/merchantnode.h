@@ -128,6 +128,8 @@ private:
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
 
+    void CheckState(bool fForce);
+
 public:
     enum state {
         MERCHANTNODE_PRE_ENABLED,
@@ -174,7 +176,9 @@ public:
 
     bool UpdateFromNewBroadcast(CMerchantnodeBroadcast& mnb, CConnman& connman);
 
-    void Check(bool fForce = false);
+    /// Update nActiveState and, unless fNotify is false (e.g. when checking a
+    /// temporary copy), tell listeners about a state transition.
+    void Check(bool fForce = false, bool fNotify = true);
 
     bool IsBroadcastedWithin(int nSeconds) const { return GetAdjustedTime() - sigTime < nSeconds; }
 
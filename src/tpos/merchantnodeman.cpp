@@ -13,10 +13,13 @@
 #include <messagesigner.h>
 #include <utilstrencodings.h>
 #include <util.h>
+#include <validationinterface.h>
 #include <init.h>
 #include <key_io.h>
 #include <netmessagemaker.h>
 
+#include <tuple>
+
 /** Merchantnode manager */
 CMerchantnodeMan merchantnodeman;
 
@@ -32,6 +35,15 @@ static bool GetBlockHash(uint256 &hash, int nBlockHeight)
     return false;
 }
 
+/** The parts of an entry that change while it is in the list, see CMerchantnodeMan::nListVersion */
+typedef std::tuple<int, int, int64_t, int64_t, int, int, int64_t> merchantnode_list_state_t;
+
+static merchantnode_list_state_t GetListState(const CMerchantnode& mn)
+{
+    return std::make_tuple(mn.nActiveState, mn.nProtocolVersion, mn.sigTime, mn.lastPing.sigTime,
+                           mn.nPoSeBanScore, mn.nPoSeBanHeight, mn.nTimeLastWatchdogVote);
+}
+
 struct CompareByAddr
 
 {
@@ -53,6 +65,8 @@ CMerchantnodeMan::CMerchantnodeMan()
       mMnbRecoveryGoodReplies(),
       listScheduledMnbRequestConnections(),
       nLastWatchdogVoteTime(0),
+      nListVersion(0),
+      listSnapshot(),
       mapSeenMerchantnodeBroadcast(),
       mapSeenMerchantnodePing(),
       nDsqCount(0)
@@ -64,8 +78,11 @@ bool CMerchantnodeMan::Add(CMerchantnode &mn)
 
     if (Has(mn.pubKeyMerchantnode)) return false;
 
+    nListVersion++;
+
     LogPrint(BCLog::MERCHANTNODE, "CMerchantnodeMan::Add -- Adding new Merchantnode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMerchantnodes[mn.pubKeyMerchantnode] = mn;
+    GetMainSignals().NotifyMerchantnodeChanged(mn.pubKeyMerchantnode, mn.GetStatus());
 
     return true;
 }
@@ -106,6 +123,7 @@ bool CMerchantnodeMan::PoSeBan(const CPubKey &pubKeyMerchantnode)
     if (!pmn) {
         return false;
     }
+    nListVersion++;
     pmn->PoSeBan();
 
     return true;
@@ -119,7 +137,11 @@ void CMerchantnodeMan::Check()
     LogPrint(BCLog::MERCHANTNODE, "CMerchantnodeMan::Check -- nLastWatchdogVoteTime=%d, IsWatchdogActive()=%d\n", nLastWatchdogVoteTime, IsWatchdogActive());
 
     for (auto& mnpair : mapMerchantnodes) {
+        const merchantnode_list_state_t stateBefore = GetListState(mnpair.second);
         mnpair.second.Check();
+        if (GetListState(mnpair.second) != stateBefore) {
+            nListVersion++;
+        }
     }
 }
 
@@ -153,7 +175,9 @@ void CMerchantnodeMan::CheckAndRemove(CConnman& connman)
                 mWeAskedForMerchantnodeListEntry.erase(it->first);
 
                 // and finally remove it from the list
+                GetMainSignals().NotifyMerchantnodeChanged(it->first, "REMOVED");
                 mapMerchantnodes.erase(it++);
+                nListVersion++;
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
                         merchantnodeSync.IsSynced() &&
@@ -282,6 +306,7 @@ void CMerchantnodeMan::CheckAndRemove(CConnman& connman)
 void CMerchantnodeMan::Clear()
 {
     LOCK(cs);
+    nListVersion++;
     mapMerchantnodes.clear();
     mAskedUsForMerchantnodeList.clear();
     mWeAskedForMerchantnodeList.clear();
@@ -292,6 +317,30 @@ void CMerchantnodeMan::Clear()
     nLastWatchdogVoteTime = 0;
 }
 
+std::shared_ptr<const CMerchantnodeListSnapshot> CMerchantnodeMan::GetListSnapshot()
+{
+    std::shared_ptr<const CMerchantnodeListSnapshot> snapshot = std::atomic_load(&listSnapshot);
+    if (snapshot && snapshot->nVersion == nListVersion) {
+        return snapshot;
+    }
+
+    LOCK(cs);
+    // version only changes under cs, so it is consistent with the map here
+    uint64_t nVersion = nListVersion;
+    snapshot = std::atomic_load(&listSnapshot);
+    if (snapshot && snapshot->nVersion == nVersion) {
+        // rebuilt by another thread while we were waiting for cs
+        return snapshot;
+    }
+
+    std::shared_ptr<CMerchantnodeListSnapshot> newSnapshot = std::make_shared<CMerchantnodeListSnapshot>();
+    newSnapshot->nVersion = nVersion;
+    newSnapshot->vMerchantnodes.assign(mapMerchantnodes.begin(), mapMerchantnodes.end());
+    snapshot = newSnapshot;
+    std::atomic_store(&listSnapshot, snapshot);
+    return snapshot;
+}
+
 int CMerchantnodeMan::CountMerchantnodes(int nProtocolVersion) const
 {
     LOCK(cs);
@@ -492,7 +541,7 @@ void CMerchantnodeMan::ProcessMessage(CNode* pfrom, const std::string& strComman
         CMerchantnodeBroadcast mnb;
         vRecv >> mnb;
 
-        pfrom->setAskFor.erase(mnb.GetHash());
+        pfrom->RemoveAskFor(mnb.GetHash());
 
         if(!merchantnodeSync.IsBlockchainSynced()) return;
 
@@ -522,7 +571,7 @@ void CMerchantnodeMan::ProcessMessage(CNode* pfrom, const std::string& strComman
 
         uint256 nHash = mnp.GetHash();
 
-        pfrom->setAskFor.erase(nHash);
+        pfrom->RemoveAskFor(nHash);
 
         if(!merchantnodeSync.IsBlockchainSynced()) return;
 
@@ -549,7 +598,11 @@ void CMerchantnodeMan::ProcessMessage(CNode* pfrom, const std::string& strComman
         if(pmn && pmn->IsExpired()) return;
 
         int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        merchantnode_list_state_t stateBefore;
+        if(pmn) stateBefore = GetListState(*pmn);
+        bool fRelayed = mnp.CheckAndUpdate(pmn, false, nDos, connman);
+        if(pmn && GetListState(*pmn) != stateBefore) nListVersion++;
+        if(fRelayed) return;
 
         if(nDos > 0) {
             // if anything significant failed, mark that node
@@ -635,7 +688,7 @@ void CMerchantnodeMan::ProcessMessage(CNode* pfrom, const std::string& strComman
         CMerchantnodeVerification mnv;
         vRecv >> mnv;
 
-        pfrom->setAskFor.erase(mnv.GetHash());
+        pfrom->RemoveAskFor(mnv.GetHash());
 
         if(!merchantnodeSync.IsMerchantnodeListSynced()) return;
 
@@ -805,6 +858,10 @@ void CMerchantnodeMan::CheckSameAddr()
                   pmn->pubKeyMerchantnode.GetID().ToString());
         pmn->IncreasePoSeBanScore();
     }
+    if(!vBan.empty()) {
+        LOCK(cs);
+        nListVersion++;
+    }
 }
 
 bool CMerchantnodeMan::SendVerifyRequest(const CAddress& addr, const std::vector<CMerchantnode*>& vSortedByAddr, CConnman& connman)
@@ -927,6 +984,7 @@ void CMerchantnodeMan::ProcessVerifyReply(CNode* pnode, CMerchantnodeVerificatio
                     prealMerchantnode = &mnpair.second;
                     if(!mnpair.second.IsPoSeVerified()) {
                         mnpair.second.DecreasePoSeBanScore();
+                        nListVersion++;
                     }
                     netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MERCHANTNODEVERIFY)+"-done");
 
@@ -973,6 +1031,7 @@ void CMerchantnodeMan::ProcessVerifyReply(CNode* pnode, CMerchantnodeVerificatio
         // increase ban score for everyone else
         for(CMerchantnode* pmn : vpMerchantnodesToBan) {
             pmn->IncreasePoSeBanScore();
+            nListVersion++;
             LogPrint(BCLog::MERCHANTNODE, "CMerchantnodeMan::ProcessVerifyReply -- increased PoSe ban score for %s addr %s, new score %d\n",
                      prealMerchantnode->pubKeyMerchantnode.GetID().ToString(), pnode->addr.ToString(), pmn->nPoSeBanScore);
         }
@@ -1069,6 +1128,7 @@ void CMerchantnodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMerchantnodeV
 
         if(!pmn1->IsPoSeVerified()) {
             pmn1->DecreasePoSeBanScore();
+            nListVersion++;
         }
         mnv.Relay();
 
@@ -1080,6 +1140,7 @@ void CMerchantnodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMerchantnodeV
         for (auto& mnpair : mapMerchantnodes) {
             if(mnpair.second.addr != mnv.addr || mnpair.first == mnv.pubKeyMerchantnode1) continue;
             mnpair.second.IncreasePoSeBanScore();
+            nListVersion++;
             nCount++;
             LogPrint(BCLog::MERCHANTNODE, "CMerchantnodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
                      mnpair.first.GetID().ToString(), mnpair.second.addr.ToString(), mnpair.second.nPoSeBanScore);
@@ -1106,6 +1167,7 @@ std::string CMerchantnodeMan::ToString() const
 void CMerchantnodeMan::UpdateMerchantnodeList(CMerchantnodeBroadcast mnb, CConnman& connman)
 {
     LOCK2(cs_main, cs);
+    nListVersion++;
     mapSeenMerchantnodePing.insert(std::make_pair(mnb.lastPing.GetHash(), mnb.lastPing));
     mapSeenMerchantnodeBroadcast.insert(std::make_pair(mnb.GetHash(), std::make_pair(GetTime(), mnb)));
 
@@ -1156,7 +1218,7 @@ bool CMerchantnodeMan::CheckMnbAndUpdateMerchantnodeList(CNode* pfrom, CMerchant
                     if(mnb.lastPing.sigTime > mapSeenMerchantnodeBroadcast[hash].second.lastPing.sigTime) {
                         // simulate Check
                         CMerchantnode mnTemp = CMerchantnode(mnb);
-                        mnTemp.Check();
+                        mnTemp.Check(false, false);
                         LogPrint(BCLog::MERCHANTNODE, "CMerchantnodeMan::CheckMnbAndUpdateMerchantnodeList -- mnb=%s seen request, addr=%s, better lastPing: %d min ago, projected mn state: %s\n", hash.ToString(), pfrom->addr.ToString(), (GetAdjustedTime() - mnb.lastPing.sigTime)/60, mnTemp.GetStateString());
                         if(mnTemp.IsValidStateForAutoStart(mnTemp.nActiveState)) {
                             // this node thinks it's a good one
@@ -1188,6 +1250,7 @@ bool CMerchantnodeMan::CheckMnbAndUpdateMerchantnodeList(CNode* pfrom, CMerchant
         CMerchantnode* pmn = Find(mnb.pubKeyMerchantnode);
         if(pmn) {
             CMerchantnodeBroadcast mnbOld = mapSeenMerchantnodeBroadcast[CMerchantnodeBroadcast(*pmn).GetHash()].second;
+            nListVersion++;
             if(!mnb.Update(pmn, nDos, connman)) {
                 LogPrint(BCLog::MERCHANTNODE, "CMerchantnodeMan::CheckMnbAndUpdateMerchantnodeList -- Update() failed, merchantnode=%s\n",
                          mnb.pubKeyMerchantnode.GetID().ToString());
@@ -1236,6 +1299,7 @@ void CMerchantnodeMan::UpdateWatchdogVoteTime(const CPubKey &pubKeyMerchantnode,
     if(!pmn) {
         return;
     }
+    nListVersion++;
     pmn->UpdateWatchdogVoteTime(nVoteTime);
     nLastWatchdogVoteTime = GetTime();
 }
@@ -1252,7 +1316,11 @@ void CMerchantnodeMan::CheckMerchantnode(const CPubKey& pubKeyMerchantnode, bool
     LOCK2(cs_main, cs);
     for (auto& mnpair : mapMerchantnodes) {
         if (mnpair.second.pubKeyMerchantnode == pubKeyMerchantnode) {
+            const merchantnode_list_state_t stateBefore = GetListState(mnpair.second);
             mnpair.second.Check(fForce);
+            if (GetListState(mnpair.second) != stateBefore) {
+                nListVersion++;
+            }
             return;
         }
     }
@@ -1272,6 +1340,7 @@ void CMerchantnodeMan::SetMerchantnodeLastPing(const CPubKey &pubKeyMerchantnode
     if(!pmn) {
         return;
     }
+    nListVersion++;
     pmn->lastPing = mnp;
     // if merchantnode uses sentinel ping instead of watchdog
     // we shoud update nTimeLastWatchdogVote here if sentinel
@@ -8,6 +8,9 @@
 #include <tpos/merchantnode.h>
 #include <sync.h>
 
+#include <atomic>
+#include <memory>
+
 using namespace std;
 
 class CMerchantnodeMan;
@@ -15,6 +18,17 @@ class CConnman;
 
 extern CMerchantnodeMan merchantnodeman;
 
+/** Immutable copy of the merchantnode list. Readers such as the merchantnodelist RPC
+ *  hold on to it without taking CMerchantnodeMan::cs; a new one is only built after
+ *  the list has changed.
+ */
+struct CMerchantnodeListSnapshot
+{
+    /// Value of the list version this snapshot was built from
+    uint64_t nVersion;
+    std::vector<std::pair<CPubKey, CMerchantnode> > vMerchantnodes;
+};
+
 class CMerchantnodeMan
 {
 private:
@@ -62,6 +76,11 @@ private:
 
     int64_t nLastWatchdogVoteTime;
 
+    /// Bumped under cs whenever an entry is added or removed, or one of the fields the list shows changes
+    std::atomic<uint64_t> nListVersion;
+    /// Latest list snapshot, accessed with std::atomic_load/atomic_store
+    std::shared_ptr<const CMerchantnodeListSnapshot> listSnapshot;
+
     friend class CMerchantnodeSync;
     /// Find an entry
     CMerchantnode* Find(const CPubKey &pubKeyMerchantnode);
@@ -91,6 +110,7 @@ public:
         }
 
         READWRITE(mapMerchantnodes);
+        if(ser_action.ForRead()) nListVersion++;
         READWRITE(mAskedUsForMerchantnodeList);
         READWRITE(mWeAskedForMerchantnodeList);
         READWRITE(mWeAskedForMerchantnodeListEntry);
@@ -150,6 +170,8 @@ public:
     bool GetMerchantnodeInfo(const CScript& payee, merchantnode_info_t& mnInfoRet);
 
     std::map<CPubKey, CMerchantnode> GetFullMerchantnodeMap() { return mapMerchantnodes; }
+    /// Return the current list snapshot, rebuilding it first if the list has changed since
+    std::shared_ptr<const CMerchantnodeListSnapshot> GetListSnapshot();
 
     void ProcessMerchantnodeConnections(CConnman& connman);
     std::pair<CService, std::set<uint256> > PopScheduledMnbRequestConnection();
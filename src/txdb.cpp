@@ -31,6 +31,12 @@ static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 
+static const char DB_ADDRESSINDEX = 'a';
+static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_SPENTINDEX = 'p';
+static const char DB_TIMESTAMPINDEX = 's';
+static const char DB_INDEX_FLAGS = 'I';
+
 namespace {
 
 struct CoinEntry {
@@ -609,3 +615,149 @@ bool TxIndexDB::MigrateData(CBlockTreeDB& block_tree_db, const CBlockLocator& be
     LogPrintf("[DONE].\n");
     return true;
 }
+
+AddressIndexDB::AddressIndexDB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    CDBWrapper(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool AddressIndexDB::WriteBlock(const CAddressIndexEntries& entries, bool fConnect)
+{
+    CDBBatch batch(*this);
+    if (fConnect) {
+        for (const auto& entry : entries.vAddress) {
+            batch.Write(std::make_pair(DB_ADDRESSINDEX, entry.first), entry.second);
+        }
+        for (const auto& entry : entries.vUnspent) {
+            const auto key = std::make_pair(DB_ADDRESSUNSPENTINDEX, std::get<0>(entry));
+            if (std::get<2>(entry)) {
+                batch.Write(key, std::get<1>(entry));
+            } else {
+                batch.Erase(key);
+            }
+        }
+        for (const auto& entry : entries.vSpent) {
+            batch.Write(std::make_pair(DB_SPENTINDEX, entry.first), entry.second);
+        }
+        for (const auto& key : entries.vTimestamp) {
+            batch.Write(std::make_pair(DB_TIMESTAMPINDEX, key), '\0');
+        }
+    } else {
+        for (const auto& entry : entries.vAddress) {
+            batch.Erase(std::make_pair(DB_ADDRESSINDEX, entry.first));
+        }
+        // Replay unspent updates backwards so that outputs created and spent
+        // within the block end up removed.
+        for (auto it = entries.vUnspent.rbegin(); it != entries.vUnspent.rend(); ++it) {
+            const auto key = std::make_pair(DB_ADDRESSUNSPENTINDEX, std::get<0>(*it));
+            if (std::get<2>(*it)) {
+                batch.Erase(key);
+            } else {
+                batch.Write(key, std::get<1>(*it));
+            }
+        }
+        for (const auto& entry : entries.vSpent) {
+            batch.Erase(std::make_pair(DB_SPENTINDEX, entry.first));
+        }
+        for (const auto& key : entries.vTimestamp) {
+            batch.Erase(std::make_pair(DB_TIMESTAMPINDEX, key));
+        }
+    }
+    return WriteBatch(batch);
+}
+
+bool AddressIndexDB::ReadAddressIndex(AddressType type, const uint160& hash,
+                                      std::vector<std::pair<CAddressIndexKey, CAmount>>& vAddressIndex,
+                                      int nStart, int nEnd)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    if (nStart > 0) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, hash, nStart)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, hash)));
+    }
+
+    for (; pcursor->Valid(); pcursor->Next()) {
+        std::pair<char, CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX ||
+                key.second.type != type || key.second.hashBytes != hash) {
+            break;
+        }
+        if (nEnd > 0 && key.second.blockHeight > nEnd) {
+            break;
+        }
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue)) {
+            return error("%s: failed to get address index value", __func__);
+        }
+        vAddressIndex.emplace_back(key.second, nValue);
+    }
+    return true;
+}
+
+bool AddressIndexDB::ReadAddressUnspentIndex(AddressType type, const uint160& hash,
+                                             std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& vUnspent)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, hash)));
+
+    for (; pcursor->Valid(); pcursor->Next()) {
+        std::pair<char, CAddressUnspentKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSUNSPENTINDEX ||
+                key.second.type != type || key.second.hashBytes != hash) {
+            break;
+        }
+        CAddressUnspentValue value;
+        if (!pcursor->GetValue(value)) {
+            return error("%s: failed to get address unspent value", __func__);
+        }
+        vUnspent.emplace_back(key.second, value);
+    }
+    return true;
+}
+
+bool AddressIndexDB::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    return Read(std::make_pair(DB_SPENTINDEX, key), value);
+}
+
+bool AddressIndexDB::ReadTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(nLow)));
+
+    for (; pcursor->Valid(); pcursor->Next()) {
+        std::pair<char, CTimestampIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_TIMESTAMPINDEX || key.second.timestamp >= nHigh) {
+            break;
+        }
+        vHashes.push_back(key.second.blockHash);
+    }
+    return true;
+}
+
+bool AddressIndexDB::ReadIndexFlags(uint32_t& nFlags) const
+{
+    return Read(DB_INDEX_FLAGS, nFlags);
+}
+
+bool AddressIndexDB::WriteIndexFlags(uint32_t nFlags)
+{
+    return Write(DB_INDEX_FLAGS, nFlags);
+}
+
+bool AddressIndexDB::ReadBestBlock(CBlockLocator& locator) const
+{
+    bool success = Read(DB_BEST_BLOCK, locator);
+    if (!success) {
+        locator.SetNull();
+    }
+    return success;
+}
+
+bool AddressIndexDB::WriteBestBlock(const CBlockLocator& locator)
+{
+    return Write(DB_BEST_BLOCK, locator);
+}
@@ -6,6 +6,7 @@
 #ifndef BITCOIN_TXDB_H
 #define BITCOIN_TXDB_H
 
+#include <addressindex.h>
 #include <coins.h>
 #include <dbwrapper.h>
 #include <chain.h>
@@ -37,6 +38,8 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/xsn/xsn/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to the address index DB specific cache, if any of -addressindex, -spentindex or -timestampindex (MiB)
+static const int64_t nMaxAddressIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -157,4 +160,48 @@ public:
     bool MigrateData(CBlockTreeDB& block_tree_db, const CBlockLocator& best_locator);
 };
 
+/**
+ * Access to the address index database (indexes/addressindex/)
+ *
+ * Holds the address, spent and timestamp indexes. Which of them are
+ * maintained is recorded in the database, so that a node restarted with a
+ * different selection rebuilds them instead of serving partial results. Like
+ * TxIndexDB it stores the locator of the chain it is synced to.
+ */
+class AddressIndexDB : public CDBWrapper
+{
+public:
+    explicit AddressIndexDB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Apply the entries of a connected block, or undo them for a disconnected one.
+    bool WriteBlock(const CAddressIndexEntries& entries, bool fConnect);
+
+    /// Read the balance changes of an address, optionally limited to a height range.
+    bool ReadAddressIndex(AddressType type, const uint160& hash,
+                          std::vector<std::pair<CAddressIndexKey, CAmount>>& vAddressIndex,
+                          int nStart = 0, int nEnd = 0);
+
+    /// Read the unspent outputs of an address.
+    bool ReadAddressUnspentIndex(AddressType type, const uint160& hash,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& vUnspent);
+
+    /// Read the input spending an output. Returns false if it is unspent or not indexed.
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const;
+
+    /// Read hashes of the blocks with a timestamp in [nLow, nHigh).
+    bool ReadTimestampIndex(unsigned int nHigh, unsigned int nLow, std::vector<uint256>& vHashes);
+
+    /// Read the set of indexes the database was built with.
+    bool ReadIndexFlags(uint32_t& nFlags) const;
+
+    /// Write the set of indexes the database is built with.
+    bool WriteIndexFlags(uint32_t nFlags);
+
+    /// Read block locator of the chain that the address index is in sync with.
+    bool ReadBestBlock(CBlockLocator& locator) const;
+
+    /// Write block locator of the chain that the address index is in sync with.
+    bool WriteBestBlock(const CBlockLocator& locator);
+};
+
 #endif // BITCOIN_TXDB_H
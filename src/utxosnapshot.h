@@ -0,0 +1,74 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTXOSNAPSHOT_H
+#define BITCOIN_UTXOSNAPSHOT_H
+
+#include <amount.h>
+#include <protocol.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <ios>
+#include <string.h>
+
+/** Bytes every UTXO set snapshot starts with */
+static const unsigned char UTXO_SNAPSHOT_MAGIC[5] = {'u', 't', 'x', 'o', 0xff};
+static const uint16_t UTXO_SNAPSHOT_VERSION = 1;
+/** Block tree database flag that is set while a snapshot is being written into the chainstate */
+static const char* const UTXO_SNAPSHOT_LOADING_FLAG = "utxosnapshotloading";
+
+/**
+ * Header of a UTXO set snapshot as written by dumptxoutset.
+ *
+ * It is followed by nCoinsCount (COutPoint, Coin) pairs in the order of the
+ * coins database. hashSerialized is the hash_serialized_2 value
+ * gettxoutsetinfo reports for the same set, so a snapshot can be checked
+ * against any node at the same height. nMoneySupply carries the money supply
+ * of the base block, which is normally computed while connecting blocks and
+ * is needed to connect the blocks following the snapshot.
+ */
+class CUTXOSnapshotMetadata
+{
+public:
+    CMessageHeader::MessageStartChars pchMessageStart;
+    uint256 hashBaseBlock;
+    int nBaseHeight;
+    uint64_t nCoinsCount;
+    uint256 hashSerialized;
+    CAmount nMoneySupply;
+
+    CUTXOSnapshotMetadata()
+    {
+        memset(pchMessageStart, 0, sizeof(pchMessageStart));
+        nBaseHeight = 0;
+        nCoinsCount = 0;
+        nMoneySupply = 0;
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        unsigned char magic[sizeof(UTXO_SNAPSHOT_MAGIC)];
+        memcpy(magic, UTXO_SNAPSHOT_MAGIC, sizeof(magic));
+        READWRITE(magic);
+        if (ser_action.ForRead() && memcmp(magic, UTXO_SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+            throw std::ios_base::failure("Not a UTXO snapshot");
+        }
+        uint16_t nVersion = UTXO_SNAPSHOT_VERSION;
+        READWRITE(nVersion);
+        if (ser_action.ForRead() && nVersion != UTXO_SNAPSHOT_VERSION) {
+            throw std::ios_base::failure("Unsupported UTXO snapshot version");
+        }
+        READWRITE(pchMessageStart);
+        READWRITE(hashBaseBlock);
+        READWRITE(nBaseHeight);
+        READWRITE(nCoinsCount);
+        READWRITE(hashSerialized);
+        READWRITE(nMoneySupply);
+    }
+};
+
+#endif // BITCOIN_UTXOSNAPSHOT_H
@@ -6,6 +6,8 @@
 #include <validation.h>
 
 #include <arith_uint256.h>
+#include <blockcache.h>
+#include <blockfilemap.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
@@ -35,18 +37,25 @@
 #include <txmempool.h>
 #include <ui_interface.h>
 #include <undo.h>
+#include <utxosnapshot.h>
 #include <util.h>
 #include <utilmoneystr.h>
 #include <utilstrencodings.h>
 #include <validationinterface.h>
+#include <validationmetrics.h>
 #include <warnings.h>
 #include <kernel.h>
 #include <masternode-payments.h>
 #include <blocksigner.h>
 #include <tpos/tposutils.h>
 
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -1057,7 +1066,14 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
         }
 
         if (g_txindex) {
-            return g_txindex->FindTx(hash, hashBlock, txOut);
+            if (g_txindex->FindTx(hash, hashBlock, txOut)) {
+                return true;
+            }
+            // The index may still be back-filling older blocks, use the
+            // coin database below rather than reporting a missing tx.
+            if (g_txindex->IsSynced()) {
+                return false;
+            }
         }
 
         if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
@@ -1113,21 +1129,87 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
     return true;
 }
 
+/** Number of idle read-only block file handles kept open between block reads */
+static const size_t MAX_BLOCK_READ_HANDLES = 8;
+
+static CCriticalSection cs_blockReadHandles;
+/** Idle read-only handles to block files, by file number */
+static std::multimap<int, FILE*> mapBlockReadHandles GUARDED_BY(cs_blockReadHandles);
+
+/** Take an idle handle to the block file of pos and seek it to pos, or open a new one */
+static FILE* TakeBlockReadHandle(const CDiskBlockPos& pos)
+{
+    FILE* file = nullptr;
+    {
+        LOCK(cs_blockReadHandles);
+        auto it = mapBlockReadHandles.find(pos.nFile);
+        if (it != mapBlockReadHandles.end()) {
+            file = it->second;
+            mapBlockReadHandles.erase(it);
+        }
+    }
+    if (file) {
+        if (fseek(file, pos.nPos, SEEK_SET) == 0)
+            return file;
+        fclose(file);
+    }
+    return OpenBlockFile(pos, true);
+}
+
+static void ReturnBlockReadHandle(int nFile, FILE* file)
+{
+    {
+        LOCK(cs_blockReadHandles);
+        if (mapBlockReadHandles.size() < MAX_BLOCK_READ_HANDLES) {
+            mapBlockReadHandles.emplace(nFile, file);
+            return;
+        }
+    }
+    fclose(file);
+}
+
+/** Close the idle handles to block files that are about to be removed */
+static void CloseBlockReadHandles(const std::set<int>& setFiles)
+{
+    LOCK(cs_blockReadHandles);
+    for (auto it = mapBlockReadHandles.begin(); it != mapBlockReadHandles.end();) {
+        if (setFiles.count(it->first)) {
+            fclose(it->second);
+            it = mapBlockReadHandles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+    CBlockFileMap::BlockData blockData;
+    if (blockfilemap.GetBlock(pos, blockData)) {
+        // Deserialize straight from the mapped block file
+        try {
+            CSpanReader reader(SER_DISK, CLIENT_VERSION, blockData.data);
+            reader >> block;
+        }
+        catch (const std::exception& e) {
+            return error("%s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein(TakeBlockReadHandle(pos), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
 
-    // Read block
-    try {
-        filein >> block;
-    }
-    catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        // Read block
+        try {
+            filein >> block;
+        }
+        catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+        ReturnBlockReadHandle(pos.nFile, filein.release());
     }
 
     // Check the header
@@ -1137,19 +1219,36 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+bool ReadBlockFromDisk(std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
+    pblock = blockcache.Get(pindex->GetBlockHash());
+    if (pblock)
+        return true;
+
     CDiskBlockPos blockPos;
     {
         LOCK(cs_main);
         blockPos = pindex->GetBlockPos();
     }
 
-    if (!ReadBlockFromDisk(block, blockPos, consensusParams))
+    std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+    if (!ReadBlockFromDisk(*pblockRead, blockPos, consensusParams))
         return false;
-    if (block.GetHash() != pindex->GetBlockHash())
+    if (pblockRead->GetHash() != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
-                     pindex->ToString(), pindex->GetBlockPos().ToString());
+                     pindex->ToString(), blockPos.ToString());
+
+    blockcache.Insert(pindex->GetBlockHash(), pblockRead);
+    pblock = pblockRead;
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+{
+    std::shared_ptr<const CBlock> pblock;
+    if (!ReadBlockFromDisk(pblock, pindex, consensusParams))
+        return false;
+    block = *pblock;
     return true;
 }
 
@@ -1518,7 +1617,27 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+/** Abort with a message */
+static bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
+{
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+                userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
+                "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+    return false;
+}
+
+static bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
+{
+    AbortNode(strMessage, userMessage);
+    return state.Error(strMessage);
+}
+
+} // namespace
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
 {
     CDiskBlockPos pos = pindex->GetUndoPos();
     if (pos.IsNull()) {
@@ -1549,26 +1668,6 @@ static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
     return true;
 }
 
-/** Abort with a message */
-static bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
-{
-    SetMiscWarning(strMessage);
-    LogPrintf("*** %s\n", strMessage);
-    uiInterface.ThreadSafeMessageBox(
-                userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
-                "", CClientUIInterface::MSG_ERROR);
-    StartShutdown();
-    return false;
-}
-
-static bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
-{
-    AbortNode(strMessage, userMessage);
-    return state.Error(strMessage);
-}
-
-} // namespace
-
 /**
  * Restore the UTXO in a Coin at a given COutPoint
  * @param undo The Coin to be restored.
@@ -1674,6 +1773,10 @@ void static FlushBlockFile(bool fFinalize = false)
     CDiskBlockPos posOld(nLastBlockFile, 0);
     bool status = true;
 
+    // A finished file is mapped again at its final size on the next read
+    if (fFinalize)
+        blockfilemap.Close({nLastBlockFile});
+
     FILE *fileOld = OpenBlockFile(posOld);
     if (fileOld) {
         if (fFinalize)
@@ -1825,6 +1928,7 @@ static unsigned int GetBlockScriptFlags(const CBlockIndex* pindex, const Consens
 static bool CheckBlockSignature(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev, bool fCheckContractOutpoint = true)
 {
     if (block.IsProofOfStake()) {
+        CValidationStageTimer timer(ValidationStage::BLOCK_SIGNATURE);
         uint256 hash = block.GetHash();
 
         TPoSContract contract;
@@ -1948,6 +2052,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     }
 
     int64_t nTime1 = GetTimeMicros(); nTimeCheck += nTime1 - nTimeStart;
+    validationmetrics.Record(ValidationStage::SANITY_CHECKS, nTime1 - nTimeStart);
     LogPrint(BCLog::BENCH, "    - Sanity checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime1 - nTimeStart), nTimeCheck * MICRO, nTimeCheck * MILLI / nBlocksTotal);
 
     // Do not allow blocks that contain transactions which 'overwrite' older transactions,
@@ -2050,6 +2155,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     unsigned int flags = GetBlockScriptFlags(pindex, chainparams.GetConsensus());
 
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
+    validationmetrics.Record(ValidationStage::FORKS, nTime2 - nTime1);
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
 
     CBlockUndo blockundo;
@@ -2150,6 +2256,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     pindex->nMint = pindex->nMoneySupply - nMoneySupplyPrev;
 
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
+    validationmetrics.Record(ValidationStage::CONNECT_TRANSACTIONS, nTime3 - nTime2);
     LogPrint(BCLog::BENCH, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(), MILLI * (nTime3 - nTime2), MILLI * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * MICRO, nTimeConnect * MILLI / nBlocksTotal);
 
     // XSN : MODIFIED TO CHECK MASTERNODE PAYMENTS AND SUPERBLOCKS
@@ -2164,17 +2271,30 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                                              chainparams.GetConsensus());
 
     std::string strError = "";
-    if (!IsBlockValueValid(block, pindex->nHeight, expectedReward, pindex->nMint, strError)) {
+    bool fBlockValueValid;
+    {
+        CValidationStageTimer timer(ValidationStage::BLOCK_VALUE);
+        fBlockValueValid = IsBlockValueValid(block, pindex->nHeight, expectedReward, pindex->nMint, strError);
+    }
+    if (!fBlockValueValid) {
         return state.DoS(0, error("ConnectBlock(XSN): %s", strError), REJECT_INVALID, "bad-cb-amount");
     }
 
     const auto& coinbaseTransaction = (pindex->nHeight > Params().GetConsensus().nLastPoWBlock ? block.vtx[1] : block.vtx[0]);
 
-    if(block.IsTPoSBlock() && !TPoSUtils::IsMerchantPaymentValid(state, block, pindex->nHeight, expectedReward, pindex->nMint)) {
-        return false;
+    if(block.IsTPoSBlock()) {
+        CValidationStageTimer timer(ValidationStage::MERCHANT_PAYMENT);
+        if (!TPoSUtils::IsMerchantPaymentValid(state, block, pindex->nHeight, expectedReward, pindex->nMint)) {
+            return false;
+        }
     }
 
-    if (!IsBlockPayeeValid(coinbaseTransaction, pindex->nHeight, expectedReward, pindex->nMint)) {
+    bool fBlockPayeeValid;
+    {
+        CValidationStageTimer timer(ValidationStage::BLOCK_PAYEE);
+        fBlockPayeeValid = IsBlockPayeeValid(coinbaseTransaction, pindex->nHeight, expectedReward, pindex->nMint);
+    }
+    if (!fBlockPayeeValid) {
         //        mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));
         return state.DoS(0, error("ConnectBlock(XSN): couldn't find masternode or superblock payments"),
                          REJECT_INVALID, "bad-cb-payee");
@@ -2185,6 +2305,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
+    validationmetrics.Record(ValidationStage::VERIFY_INPUTS, nTime4 - nTime2);
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
 
     if (fJustCheck)
@@ -2209,9 +2330,11 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     view.SetBestBlock(pindex->GetBlockHash());
 
     int64_t nTime5 = GetTimeMicros(); nTimeIndex += nTime5 - nTime4;
+    validationmetrics.Record(ValidationStage::INDEX_WRITING, nTime5 - nTime4);
     LogPrint(BCLog::BENCH, "    - Index writing: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime5 - nTime4), nTimeIndex * MICRO, nTimeIndex * MILLI / nBlocksTotal);
 
     int64_t nTime6 = GetTimeMicros(); nTimeCallbacks += nTime6 - nTime5;
+    validationmetrics.Record(ValidationStage::CALLBACKS, nTime6 - nTime5);
     LogPrint(BCLog::BENCH, "    - Callbacks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime6 - nTime5), nTimeCallbacks * MICRO, nTimeCallbacks * MILLI / nBlocksTotal);
 
     return true;
@@ -2570,16 +2693,15 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime1 = GetTimeMicros();
     std::shared_ptr<const CBlock> pthisBlock;
     if (!pblock) {
-        std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
-        if (!ReadBlockFromDisk(*pblockNew, pindexNew, chainparams.GetConsensus()))
+        if (!ReadBlockFromDisk(pthisBlock, pindexNew, chainparams.GetConsensus()))
             return AbortNode(state, "Failed to read block");
-        pthisBlock = pblockNew;
     } else {
         pthisBlock = pblock;
     }
     const CBlock& blockConnecting = *pthisBlock;
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
+    validationmetrics.Record(ValidationStage::READ_BLOCK, nTime2 - nTime1);
     int64_t nTime3;
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
     {
@@ -2591,17 +2713,22 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
                 InvalidBlockFound(pindexNew, state);
             return error("ConnectTip(): ConnectBlock %s failed", pindexNew->GetBlockHash().ToString());
         }
+        // Keep the block around for the managers and RPC calls that read the tip
+        blockcache.Insert(pindexNew->GetBlockHash(), pthisBlock);
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
+        validationmetrics.Record(ValidationStage::CONNECT_BLOCK, nTime3 - nTime2);
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
         bool flushed = view.Flush();
         assert(flushed);
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
+    validationmetrics.Record(ValidationStage::FLUSH_VIEW, nTime4 - nTime3);
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(chainparams, state, FlushStateMode::IF_NEEDED))
         return false;
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
+    validationmetrics.Record(ValidationStage::FLUSH_CHAINSTATE, nTime5 - nTime4);
     LogPrint(BCLog::BENCH, "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime5 - nTime4) * MILLI, nTimeChainState * MICRO, nTimeChainState * MILLI / nBlocksTotal);
     // Remove conflicting transactions from the mempool.;
     mempool.removeForBlock(blockConnecting.vtx, pindexNew->nHeight);
@@ -2611,6 +2738,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     UpdateTip(pindexNew, chainparams);
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
+    validationmetrics.Record(ValidationStage::POST_CONNECT, nTime6 - nTime5);
+    validationmetrics.Record(ValidationStage::CONNECT_TIP, nTime6 - nTime1);
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO, nTimePostConnect * MILLI / nBlocksTotal);
     LogPrint(BCLog::BENCH, "- Connect block: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime1) * MILLI, nTimeTotal * MICRO, nTimeTotal * MILLI / nBlocksTotal);
 
@@ -3757,7 +3886,12 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CVali
 
     if(block.IsProofOfStake())
     {
-        if(!CheckProofOfStake(pindex->pprev, block, hashProofOfStake, chainparams.GetConsensus())) {
+        bool fProofOfStakeValid;
+        {
+            CValidationStageTimer timer(ValidationStage::PROOF_OF_STAKE);
+            fProofOfStakeValid = CheckProofOfStake(pindex->pprev, block, hashProofOfStake, chainparams.GetConsensus());
+        }
+        if(!fProofOfStakeValid) {
             return state.DoS(100, error("AcceptBlock(): check proof-of-stake failed for block %s\n", hash.ToString().c_str()),
                              REJECT_INVALID);
         }
@@ -3915,6 +4049,8 @@ void PruneOneBlockFile(const int fileNumber)
 
 void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
+    CloseBlockReadHandles(setFilesToPrune);
+    blockfilemap.Close(setFilesToPrune);
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
         fs::remove(GetBlockPosFilename(pos, "blk"));
@@ -4223,6 +4359,83 @@ bool LoadChainTip(const CChainParams& chainparams)
     return true;
 }
 
+bool LoadUTXOSnapshot(CAutoFile& file, const CUTXOSnapshotMetadata& metadata, std::string& strError)
+{
+    LOCK(cs_main);
+
+    if (!pcoinsTip->GetBestBlock().IsNull()) {
+        strError = _("The chainstate is not empty, restart with -reindex-chainstate to load a UTXO snapshot");
+        return false;
+    }
+    CBlockIndex* pindexBase = LookupBlockIndex(metadata.hashBaseBlock);
+    if (!pindexBase || pindexBase->nHeight != metadata.nBaseHeight) {
+        strError = strprintf(_("The base block %s of the UTXO snapshot is not in the block index"), metadata.hashBaseBlock.ToString());
+        return false;
+    }
+    // The blocks after the snapshot are validated as usual, and the stake
+    // checks read the transactions of earlier blocks, so the blocks up to the
+    // snapshot have to be on disk already
+    for (const CBlockIndex* pindex = pindexBase; pindex; pindex = pindex->pprev) {
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA) || !pindex->IsValid(BLOCK_VALID_TRANSACTIONS)) {
+            strError = strprintf(_("Block %s below the UTXO snapshot is missing or invalid"), pindex->GetBlockHash().ToString());
+            return false;
+        }
+    }
+
+    // Until the caller verified the result, a restart has to rebuild the chainstate
+    if (!pblocktree->WriteFlag(UTXO_SNAPSHOT_LOADING_FLAG, true)) {
+        strError = _("Failed to write to block index database");
+        return false;
+    }
+
+    const int64_t nStart = GetTimeMillis();
+    pcoinsTip->SetBestBlock(metadata.hashBaseBlock);
+    try {
+        for (uint64_t nCoin = 0; nCoin < metadata.nCoinsCount; nCoin++) {
+            COutPoint outpoint;
+            Coin coin;
+            file >> outpoint;
+            file >> coin;
+            if (coin.IsSpent() || coin.nHeight > (uint32_t)metadata.nBaseHeight) {
+                strError = strprintf(_("Invalid coin %s in UTXO snapshot"), outpoint.ToString());
+                return false;
+            }
+            // Duplicates overwrite each other and are caught by the hash check
+            pcoinsTip->AddCoin(outpoint, std::move(coin), true);
+
+            if (nCoin % 100000 == 0) {
+                if (ShutdownRequested()) {
+                    strError = _("Loading the UTXO snapshot was interrupted");
+                    return false;
+                }
+                uiInterface.ShowProgress(_("Loading UTXO snapshot..."), (int)(nCoin * 100 / metadata.nCoinsCount), false);
+                if (pcoinsTip->DynamicMemoryUsage() > (size_t)nCoinCacheUsage && !pcoinsTip->Flush()) {
+                    strError = _("Failed to write to coin database");
+                    return false;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        strError = strprintf(_("Unable to read UTXO snapshot: %s"), e.what());
+        return false;
+    }
+    uiInterface.ShowProgress("", 100, false);
+
+    if (!pcoinsTip->Flush()) {
+        strError = _("Failed to write to coin database");
+        return false;
+    }
+
+    // Connecting the next block needs the money supply of its parent, which
+    // is otherwise only computed while connecting blocks
+    pindexBase->nMoneySupply = metadata.nMoneySupply;
+    setDirtyBlockIndex.insert(pindexBase);
+
+    LogPrintf("%s: loaded %u coins at block %s (height %d) in %dms\n", __func__, metadata.nCoinsCount,
+              metadata.hashBaseBlock.ToString(), metadata.nBaseHeight, GetTimeMillis() - nStart);
+    return true;
+}
+
 CVerifyDB::CVerifyDB()
 {
     uiInterface.ShowProgress(_("Verifying blocks..."), 0, false);
@@ -4617,20 +4830,99 @@ bool LoadGenesisBlock(const CChainParams& chainparams)
     return g_chainstate.LoadGenesisBlock(chainparams);
 }
 
-bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
+namespace {
+
+/** Number of blocks the reindex reader may run ahead of the connect stage. */
+static const unsigned int REINDEX_PIPELINE_WINDOW = 128;
+
+/** A block record found in a block file. */
+struct ReindexBlock
 {
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
-    int64_t nStart = GetTimeMillis();
+    std::vector<char> vRaw;
+    CDiskBlockPos pos;
+    std::shared_ptr<CBlock> pblock; //!< null if the record failed to deserialize
+    uint256 hash;
+};
 
-    int nLoaded = 0;
-    try {
-        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
-        CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
-        uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
-            boost::this_thread::interruption_point();
+/**
+ * Staged pipeline used by LoadExternalBlockFile. A reader thread splits the
+ * file into raw block records, a pool of workers deserializes and hashes them
+ * and runs the context-free checks (CheckBlock and, for plain PoS blocks, the
+ * block signature) out of order, and the caller takes the blocks back in
+ * file order to accept and connect them. Without workers everything runs on
+ * the calling thread.
+ */
+class ReindexPipeline
+{
+public:
+    ReindexPipeline(const CChainParams& chainparamsIn, CBufferedFile& blkdatIn, const CDiskBlockPos* dbp, int nWorkers) :
+        chainparams(chainparamsIn), blkdat(blkdatIn), posFile(dbp ? *dbp : CDiskBlockPos()), nRewind(blkdatIn.GetPos())
+    {
+        if (nWorkers <= 0)
+            return;
+        threads.emplace_back(&ReindexPipeline::ThreadRead, this);
+        for (int i = 0; i < nWorkers; ++i)
+            threads.emplace_back(&ReindexPipeline::ThreadParse, this);
+    }
+
+    ~ReindexPipeline()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fStop = true;
+        }
+        condReader.notify_all();
+        condWorker.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    /** Take the next block in file order. Returns false at the end of the file. */
+    bool Next(ReindexBlock& item)
+    {
+        item = ReindexBlock();
+        if (threads.empty()) {
+            if (!ReadRecord(item))
+                return false;
+            Parse(item);
+            return true;
+        }
 
+        std::unique_lock<std::mutex> lock(mutex);
+        condConsumer.wait(lock, [this] { return mapParsed.count(nConsumed) || (fReadDone && nConsumed == nRead); });
+        auto it = mapParsed.find(nConsumed);
+        if (it == mapParsed.end())
+            return false;
+        item = std::move(it->second);
+        mapParsed.erase(it);
+        ++nConsumed;
+        lock.unlock();
+        condReader.notify_one();
+        return true;
+    }
+
+private:
+    const CChainParams& chainparams;
+    CBufferedFile& blkdat;
+    const CDiskBlockPos posFile;
+    uint64_t nRewind;
+
+    std::mutex mutex;
+    std::condition_variable condReader;
+    std::condition_variable condWorker;
+    std::condition_variable condConsumer;
+    std::deque<std::pair<uint64_t, ReindexBlock>> queueRaw;
+    std::map<uint64_t, ReindexBlock> mapParsed;
+    uint64_t nRead{0};
+    uint64_t nConsumed{0};
+    bool fReadDone{false};
+    bool fStop{false};
+    std::vector<std::thread> threads;
+
+    /** Locate the next block record in the file and copy it out. Returns false at the end of the file. */
+    bool ReadRecord(ReindexBlock& item)
+    {
+        while (!blkdat.eof()) {
             blkdat.SetPos(nRewind);
             nRewind++; // start one byte further next time, in case of failure
             blkdat.SetLimit(); // remove former limit
@@ -4648,22 +4940,130 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                 if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
                     continue;
             } catch (const std::exception&) {
-                // no valid block header found; don't complain
-                break;
+                // no valid header found; don't complain
+                return false;
             }
             try {
                 // read block
                 uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
+                item.pos = posFile;
+                item.pos.nPos = nBlockPos;
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos);
-                std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
+                item.vRaw.resize(nSize);
+                blkdat.read(item.vRaw.data(), nSize);
                 nRewind = blkdat.GetPos();
+                return true;
+            } catch (const std::exception& e) {
+                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            }
+        }
+        return false;
+    }
+
+    /** Deserialize, hash and pre-check a block record. Safe to run out of order. */
+    void Parse(ReindexBlock& item)
+    {
+        try {
+            CDataStream ss(item.vRaw.data(), item.vRaw.data() + item.vRaw.size(), SER_DISK, CLIENT_VERSION);
+            auto pblock = std::make_shared<CBlock>();
+            ss >> *pblock;
+            item.hash = pblock->GetHash();
+            item.pblock = std::move(pblock);
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            return;
+        }
+        std::vector<char>().swap(item.vRaw);
+
+        // Both results are cached in the block and reused by AcceptBlock; a
+        // failure here is reported again by the in-order stage.
+        CValidationState state;
+        CheckBlock(*item.pblock, state, chainparams.GetConsensus());
+        CBlockSigner::PrecheckBlockSignature(*item.pblock);
+    }
+
+    void ThreadRead()
+    {
+        RenameThread("xsn-reindexread");
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condReader.wait(lock, [this] { return fStop || nRead - nConsumed < REINDEX_PIPELINE_WINDOW; });
+                if (fStop)
+                    break;
+            }
+            ReindexBlock item;
+            if (!ReadRecord(item))
+                break;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queueRaw.emplace_back(nRead++, std::move(item));
+            }
+            condWorker.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fReadDone = true;
+        }
+        condWorker.notify_all();
+        condConsumer.notify_all();
+    }
+
+    void ThreadParse()
+    {
+        RenameThread("xsn-reindexparse");
+        while (true) {
+            std::pair<uint64_t, ReindexBlock> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condWorker.wait(lock, [this] { return fStop || fReadDone || !queueRaw.empty(); });
+                if (fStop || queueRaw.empty())
+                    return;
+                job = std::move(queueRaw.front());
+                queueRaw.pop_front();
+            }
+            Parse(job.second);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                mapParsed.emplace(job.first, std::move(job.second));
+            }
+            condConsumer.notify_one();
+        }
+    }
+};
+
+} // namespace
+
+bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
+{
+    // Map of disk positions for blocks with unknown parent (only used for reindex)
+    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+    int64_t nStart = GetTimeMillis();
+
+    int nLoaded = 0;
+    try {
+        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
+        CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
+        // Reading, deserializing and hashing run ahead on their own threads,
+        // only accepting and connecting blocks stays on this one.
+        ReindexPipeline pipeline(chainparams, blkdat, dbp, nScriptCheckThreads);
+        ReindexBlock item;
+        while (true) {
+            boost::this_thread::interruption_point();
+
+            if (!pipeline.Next(item))
+                break;
+            if (!item.pblock)
+                continue;
+            if (dbp)
+                *dbp = item.pos;
+
+            try {
+                std::shared_ptr<CBlock> pblock = item.pblock;
+                CBlock& block = *pblock;
 
-                uint256 hash = block.GetHash();
+                const uint256& hash = item.hash;
                 {
                     LOCK(cs_main);
                     // detect out of order blocks, and store them for later
@@ -4692,8 +5092,10 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                 }
 
                 {
+                    // Hand the block over so connecting it reuses the parsed
+                    // copy and its cached checks instead of reading it back.
                     CValidationState state;
-                    if (!ActivateBestChain(state, chainparams)) {
+                    if (!ActivateBestChain(state, chainparams, pblock)) {
                         break;
                     }
                 }
@@ -5,44 +5,93 @@
 
 #include <validationinterface.h>
 
+#include <governance/governance-object.h>
+#include <governance/governance-vote.h>
 #include <init.h>
 #include <primitives/block.h>
+#include <pubkey.h>
 #include <scheduler.h>
 #include <sync.h>
 #include <txmempool.h>
 #include <util.h>
 #include <validation.h>
 
-#include <list>
+#include <algorithm>
 #include <atomic>
 #include <future>
+#include <mutex>
+#include <vector>
 
-#include <boost/signals2/signal.hpp>
+#include <boost/bind.hpp>
+
+/** A registered CValidationInterface with its own queue of background callbacks */
+struct ValidationInterfaceSubscriber {
+    CValidationInterface* const callbacks;
+    std::atomic<bool> fActive;
+    SingleThreadedSchedulerClient queue;
+
+    ValidationInterfaceSubscriber(CValidationInterface* callbacksIn, CScheduler* pscheduler) : callbacks(callbacksIn), fActive(true), queue(pscheduler) {}
+};
 
 struct MainSignalsInstance {
-    boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> UpdatedBlockTip;
-    boost::signals2::signal<void (const CTransactionRef &)> TransactionAddedToMempool;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::vector<CTransactionRef>&)> BlockConnected;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &)> BlockDisconnected;
-    boost::signals2::signal<void (const CTransactionRef &)> TransactionRemovedFromMempool;
-    boost::signals2::signal<void (const CBlockLocator &)> ChainStateFlushed;
-    boost::signals2::signal<void (const uint256 &)> Inventory;
-    boost::signals2::signal<void (int64_t nBestBlockTime, CConnman* connman)> Broadcast;
-    boost::signals2::signal<void (const CBlock&, const CValidationState&)> BlockChecked;
-    boost::signals2::signal<void (const CBlockIndex *, const std::shared_ptr<const CBlock>&)> NewPoWValidBlock;
-    /** Notifies listeners of an updated transaction lock without new data. */
-    boost::signals2::signal<void (const CTransactionRef &)> NotifyTransactionLock;
-    /** Notifies listeners of updated block header tip */
-    boost::signals2::signal<void (const CBlockIndex *, bool fInitialDownload)> NotifyHeaderTip;
-    /** Notifies listeners of accepted block header */
-    boost::signals2::signal<void (const CBlockIndex *)> AcceptedBlockHeader;
-
-    // We are not allowed to assume the scheduler only runs in one thread,
-    // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
+    CScheduler* const m_pscheduler;
+
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<ValidationInterfaceSubscriber>> m_subscribers;
+    // Unregistered subscribers stay around until shutdown, their queue may
+    // still be scheduled and holds the callbacks that were pending for them.
+    std::vector<std::shared_ptr<ValidationInterfaceSubscriber>> m_retired;
+
+    // Every subscriber processes its background callbacks in order on its own
+    // queue, so a slow subscriber only delays itself. Queues run in parallel
+    // when the scheduler has more than one thread. This queue carries the
+    // functions that have to wait for all subscribers, see
+    // CallFunctionInValidationInterfaceQueue.
     SingleThreadedSchedulerClient m_schedulerClient;
 
-    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+    explicit MainSignalsInstance(CScheduler *pscheduler) : m_pscheduler(pscheduler), m_schedulerClient(pscheduler) {}
+
+    std::vector<std::shared_ptr<ValidationInterfaceSubscriber>> GetSubscribers()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_subscribers;
+    }
+
+    std::vector<SingleThreadedSchedulerClient*> GetQueues(bool fIncludeRetired)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<SingleThreadedSchedulerClient*> vQueues{&m_schedulerClient};
+        for (const auto& subscriber : m_subscribers) {
+            vQueues.push_back(&subscriber->queue);
+        }
+        if (fIncludeRetired) {
+            for (const auto& subscriber : m_retired) {
+                vQueues.push_back(&subscriber->queue);
+            }
+        }
+        return vQueues;
+    }
+
+    /** Queue a callback for every subscriber, it is skipped for subscribers unregistered in the meantime */
+    template <typename Callback>
+    void Enqueue(const Callback& callback)
+    {
+        for (const auto& subscriber : GetSubscribers()) {
+            ValidationInterfaceSubscriber* psubscriber = subscriber.get();
+            psubscriber->queue.AddToProcessQueue([psubscriber, callback] {
+                if (psubscriber->fActive) callback(*psubscriber->callbacks);
+            });
+        }
+    }
+
+    /** Call every subscriber on the calling thread */
+    template <typename Callback>
+    void Call(const Callback& callback)
+    {
+        for (const auto& subscriber : GetSubscribers()) {
+            if (subscriber->fActive) callback(*subscriber->callbacks);
+        }
+    }
 };
 
 static CMainSignals g_signals;
@@ -58,13 +107,20 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
-        m_internals->m_schedulerClient.EmptyQueue();
+        for (SingleThreadedSchedulerClient* queue : m_internals->GetQueues(true)) {
+            queue->EmptyQueue();
+        }
     }
 }
 
 size_t CMainSignals::CallbacksPending() {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    // The slowest subscriber is the one validation has to wait for
+    size_t nPending = 0;
+    for (SingleThreadedSchedulerClient* queue : m_internals->GetQueues(false)) {
+        nPending = std::max(nPending, queue->CallbacksPending());
+    }
+    return nPending;
 }
 
 void CMainSignals::RegisterWithMempoolSignals(CTxMemPool& pool) {
@@ -81,59 +137,49 @@ CMainSignals& GetMainSignals()
 }
 
 void RegisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->TransactionAddedToMempool.connect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.m_internals->BlockConnected.connect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.connect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.m_internals->TransactionRemovedFromMempool.connect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
-    g_signals.m_internals->ChainStateFlushed.connect(boost::bind(&CValidationInterface::ChainStateFlushed, pwalletIn, _1));
-    g_signals.m_internals->Inventory.connect(boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
-    g_signals.m_internals->Broadcast.connect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.m_internals->BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.m_internals->NewPoWValidBlock.connect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyTransactionLock.connect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1));
-    g_signals.m_internals->NotifyHeaderTip.connect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
-    g_signals.m_internals->AcceptedBlockHeader.connect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
+    MainSignalsInstance& internals = *g_signals.m_internals;
+    std::lock_guard<std::mutex> lock(internals.m_mutex);
+    internals.m_subscribers.push_back(std::make_shared<ValidationInterfaceSubscriber>(pwalletIn, internals.m_pscheduler));
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.m_internals->Broadcast.disconnect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.m_internals->Inventory.disconnect(boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
-    g_signals.m_internals->ChainStateFlushed.disconnect(boost::bind(&CValidationInterface::ChainStateFlushed, pwalletIn, _1));
-    g_signals.m_internals->TransactionAddedToMempool.disconnect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.m_internals->BlockConnected.disconnect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.disconnect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
-    g_signals.m_internals->UpdatedBlockTip.disconnect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->NewPoWValidBlock.disconnect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyTransactionLock.disconnect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1));
-    g_signals.m_internals->NotifyHeaderTip.disconnect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
-    g_signals.m_internals->AcceptedBlockHeader.disconnect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
-
+    MainSignalsInstance& internals = *g_signals.m_internals;
+    std::lock_guard<std::mutex> lock(internals.m_mutex);
+    for (auto it = internals.m_subscribers.begin(); it != internals.m_subscribers.end(); ) {
+        if ((*it)->callbacks == pwalletIn) {
+            (*it)->fActive = false;
+            internals.m_retired.push_back(*it);
+            it = internals.m_subscribers.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void UnregisterAllValidationInterfaces() {
     if (!g_signals.m_internals) {
         return;
     }
-    g_signals.m_internals->BlockChecked.disconnect_all_slots();
-    g_signals.m_internals->Broadcast.disconnect_all_slots();
-    g_signals.m_internals->Inventory.disconnect_all_slots();
-    g_signals.m_internals->ChainStateFlushed.disconnect_all_slots();
-    g_signals.m_internals->TransactionAddedToMempool.disconnect_all_slots();
-    g_signals.m_internals->BlockConnected.disconnect_all_slots();
-    g_signals.m_internals->BlockDisconnected.disconnect_all_slots();
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect_all_slots();
-    g_signals.m_internals->UpdatedBlockTip.disconnect_all_slots();
-    g_signals.m_internals->NewPoWValidBlock.disconnect_all_slots();
-    g_signals.m_internals->NotifyTransactionLock.disconnect_all_slots();
-    g_signals.m_internals->NotifyHeaderTip.disconnect_all_slots();
-    g_signals.m_internals->AcceptedBlockHeader.disconnect_all_slots();
+    MainSignalsInstance& internals = *g_signals.m_internals;
+    std::lock_guard<std::mutex> lock(internals.m_mutex);
+    for (const auto& subscriber : internals.m_subscribers) {
+        subscriber->fActive = false;
+        internals.m_retired.push_back(subscriber);
+    }
+    internals.m_subscribers.clear();
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void ()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    // Every queue gets a marker, the last queue to reach its marker has
+    // finished all the callbacks queued before it and calls func
+    std::vector<SingleThreadedSchedulerClient*> vQueues = g_signals.m_internals->GetQueues(false);
+    auto nRemaining = std::make_shared<std::atomic<size_t>>(vQueues.size());
+    auto pfunc = std::make_shared<std::function<void ()>>(std::move(func));
+    for (SingleThreadedSchedulerClient* queue : vQueues) {
+        queue->AddToProcessQueue([nRemaining, pfunc] {
+            if (--(*nRemaining) == 0) (*pfunc)();
+        });
+    }
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -148,8 +194,8 @@ void SyncWithValidationInterfaceQueue() {
 
 void CMainSignals::MempoolEntryRemoved(CTransactionRef ptx, MemPoolRemovalReason reason) {
     if (reason != MemPoolRemovalReason::BLOCK && reason != MemPoolRemovalReason::CONFLICT) {
-        m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
-            m_internals->TransactionRemovedFromMempool(ptx);
+        m_internals->Enqueue([ptx](CValidationInterface& callbacks) {
+            callbacks.TransactionRemovedFromMempool(ptx);
         });
     }
 }
@@ -159,64 +205,115 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    m_internals->Enqueue([pindexNew, pindexFork, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     });
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef &ptx) {
-    m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
-        m_internals->TransactionAddedToMempool(ptx);
+    m_internals->Enqueue([ptx](CValidationInterface& callbacks) {
+        callbacks.TransactionAddedToMempool(ptx);
     });
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>>& pvtxConflicted) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindex, pvtxConflicted, this] {
-        m_internals->BlockConnected(pblock, pindex, *pvtxConflicted);
+    m_internals->Enqueue([pblock, pindex, pvtxConflicted](CValidationInterface& callbacks) {
+        callbacks.BlockConnected(pblock, pindex, *pvtxConflicted);
     });
 }
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, this] {
-        m_internals->BlockDisconnected(pblock);
+    m_internals->Enqueue([pblock](CValidationInterface& callbacks) {
+        callbacks.BlockDisconnected(pblock);
     });
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    m_internals->m_schedulerClient.AddToProcessQueue([locator, this] {
-        m_internals->ChainStateFlushed(locator);
+    m_internals->Enqueue([locator](CValidationInterface& callbacks) {
+        callbacks.ChainStateFlushed(locator);
     });
 }
 
 void CMainSignals::Inventory(const uint256 &hash) {
-    m_internals->m_schedulerClient.AddToProcessQueue([hash, this] {
-        m_internals->Inventory(hash);
+    m_internals->Enqueue([hash](CValidationInterface& callbacks) {
+        callbacks.Inventory(hash);
     });
 }
 
 void CMainSignals::Broadcast(int64_t nBestBlockTime, CConnman* connman) {
-    m_internals->Broadcast(nBestBlockTime, connman);
+    m_internals->Call([nBestBlockTime, connman](CValidationInterface& callbacks) {
+        callbacks.ResendWalletTransactions(nBestBlockTime, connman);
+    });
 }
 
 void CMainSignals::BlockChecked(const CBlock& block, const CValidationState& state) {
-    m_internals->BlockChecked(block, state);
+    m_internals->Call([&block, &state](CValidationInterface& callbacks) {
+        callbacks.BlockChecked(block, state);
+    });
 }
 
 void CMainSignals::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock> &block) {
-    m_internals->NewPoWValidBlock(pindex, block);
+    m_internals->Call([pindex, &block](CValidationInterface& callbacks) {
+        callbacks.NewPoWValidBlock(pindex, block);
+    });
 }
 
 void CMainSignals::NotifyTransactionLock(const CTransactionRef &tx)
 {
-    m_internals->NotifyTransactionLock(tx);
+    m_internals->Enqueue([tx](CValidationInterface& callbacks) {
+        callbacks.NotifyTransactionLock(tx);
+    });
 }
 
 void CMainSignals::NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload)
 {
-    m_internals->NotifyHeaderTip(pindexNew, fInitialDownload);
+    m_internals->Call([pindexNew, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.NotifyHeaderTip(pindexNew, fInitialDownload);
+    });
 }
 
 void CMainSignals::AcceptedBlockHeader(const CBlockIndex *pindexNew)
 {
-    m_internals->AcceptedBlockHeader(pindexNew);
+    m_internals->Call([pindexNew](CValidationInterface& callbacks) {
+        callbacks.AcceptedBlockHeader(pindexNew);
+    });
+}
+
+// Masternode, merchantnode and governance notifications are queued like the
+// chain notifications above, so listeners such as the ZMQ publishers see them
+// in order and never run under the managers' locks. The lists are also
+// modified before the scheduler is set up (and by tools that never set one
+// up), in which case there is nobody to notify.
+
+void CMainSignals::NotifyMasternodeChanged(const COutPoint &outpoint, const std::string &strStatus)
+{
+    if (!m_internals) return;
+    m_internals->Enqueue([outpoint, strStatus](CValidationInterface& callbacks) {
+        callbacks.NotifyMasternodeChanged(outpoint, strStatus);
+    });
+}
+
+void CMainSignals::NotifyMerchantnodeChanged(const CPubKey &pubKeyMerchantnode, const std::string &strStatus)
+{
+    if (!m_internals) return;
+    m_internals->Enqueue([pubKeyMerchantnode, strStatus](CValidationInterface& callbacks) {
+        callbacks.NotifyMerchantnodeChanged(pubKeyMerchantnode, strStatus);
+    });
+}
+
+void CMainSignals::NotifyGovernanceObject(const CGovernanceObject &govobj)
+{
+    if (!m_internals) return;
+    auto pgovobj = std::make_shared<const CGovernanceObject>(govobj);
+    m_internals->Enqueue([pgovobj](CValidationInterface& callbacks) {
+        callbacks.NotifyGovernanceObject(*pgovobj);
+    });
+}
+
+void CMainSignals::NotifyGovernanceVote(const CGovernanceVote &vote)
+{
+    if (!m_internals) return;
+    m_internals->Enqueue([vote](CValidationInterface& callbacks) {
+        callbacks.NotifyGovernanceVote(vote);
+    });
 }
@@ -10,12 +10,16 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 
 class CBlock;
 class CBlockIndex;
 struct CBlockLocator;
 class CBlockIndex;
 class CConnman;
+class CGovernanceObject;
+class CGovernanceVote;
+class CPubKey;
 class CReserveScript;
 class CValidationInterface;
 class CValidationState;
@@ -132,12 +136,42 @@ protected:
      * Notifies listeners that a block which builds directly on our current tip
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) {}
+    /**
+     * Notifies listeners that an InstantSend lock on a transaction completed.
+     *
+     * Called on a background thread.
+     */
     virtual void NotifyTransactionLock(const CTransactionRef &tx) {}
     virtual void NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload) {}
     virtual void AcceptedBlockHeader(const CBlockIndex *pindexNew) {}
-    friend void ::RegisterValidationInterface(CValidationInterface*);
-    friend void ::UnregisterValidationInterface(CValidationInterface*);
-    friend void ::UnregisterAllValidationInterfaces();
+    /**
+     * Notifies listeners that a masternode was added to the list, changed
+     * state or was removed from it, in which case strStatus is "REMOVED".
+     *
+     * Called on a background thread.
+     */
+    virtual void NotifyMasternodeChanged(const COutPoint &outpoint, const std::string &strStatus) {}
+    /**
+     * Notifies listeners that a merchantnode was added to the list, changed
+     * state or was removed from it, in which case strStatus is "REMOVED".
+     *
+     * Called on a background thread.
+     */
+    virtual void NotifyMerchantnodeChanged(const CPubKey &pubKeyMerchantnode, const std::string &strStatus) {}
+    /**
+     * Notifies listeners of a governance object accepted into the governance
+     * manager.
+     *
+     * Called on a background thread.
+     */
+    virtual void NotifyGovernanceObject(const CGovernanceObject &govobj) {}
+    /**
+     * Notifies listeners of a governance vote accepted on a known object.
+     *
+     * Called on a background thread.
+     */
+    virtual void NotifyGovernanceVote(const CGovernanceVote &vote) {}
+    friend class CMainSignals;
 };
 
 struct MainSignalsInstance;
@@ -179,6 +213,10 @@ public:
     void NotifyTransactionLock(const CTransactionRef &tx);
     void NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload);
     void AcceptedBlockHeader(const CBlockIndex *pindexNew);
+    void NotifyMasternodeChanged(const COutPoint &outpoint, const std::string &strStatus);
+    void NotifyMerchantnodeChanged(const CPubKey &pubKeyMerchantnode, const std::string &strStatus);
+    void NotifyGovernanceObject(const CGovernanceObject &govobj);
+    void NotifyGovernanceVote(const CGovernanceVote &vote);
 };
 
 CMainSignals& GetMainSignals();
@@ -0,0 +1,137 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <validationmetrics.h>
+
+#include <tinyformat.h>
+#include <utiltime.h>
+
+#include <algorithm>
+#include <cmath>
+
+CValidationMetrics validationmetrics;
+
+int64_t CLatencyHistogram::Snapshot::GetQuantile(double q) const
+{
+    if (nCount == 0) {
+        return 0;
+    }
+    const uint64_t nRank = std::max<uint64_t>(1, std::ceil(q * nCount));
+    uint64_t nSeen = 0;
+    for (size_t i = 0; i + 1 < vBuckets.size(); i++) {
+        nSeen += vBuckets[i];
+        if (nSeen >= nRank) {
+            return std::min(LATENCY_HISTOGRAM_BOUNDS[i], nMaxMicros);
+        }
+    }
+    return nMaxMicros;
+}
+
+CLatencyHistogram::CLatencyHistogram()
+{
+    Reset();
+}
+
+void CLatencyHistogram::Record(int64_t nMicros)
+{
+    if (nMicros < 0) nMicros = 0;
+    const int64_t* pbound = std::lower_bound(std::begin(LATENCY_HISTOGRAM_BOUNDS), std::end(LATENCY_HISTOGRAM_BOUNDS), nMicros);
+    buckets[pbound - std::begin(LATENCY_HISTOGRAM_BOUNDS)].fetch_add(1, std::memory_order_relaxed);
+    nCount.fetch_add(1, std::memory_order_relaxed);
+    nSumMicros.fetch_add(nMicros, std::memory_order_relaxed);
+    int64_t nMax = nMaxMicros.load(std::memory_order_relaxed);
+    while (nMicros > nMax && !nMaxMicros.compare_exchange_weak(nMax, nMicros, std::memory_order_relaxed)) {}
+}
+
+CLatencyHistogram::Snapshot CLatencyHistogram::GetSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.vBuckets.reserve(LATENCY_HISTOGRAM_BUCKETS);
+    for (const auto& bucket : buckets) {
+        snapshot.vBuckets.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    snapshot.nCount = nCount.load(std::memory_order_relaxed);
+    snapshot.nSumMicros = nSumMicros.load(std::memory_order_relaxed);
+    snapshot.nMaxMicros = nMaxMicros.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void CLatencyHistogram::Reset()
+{
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    nCount.store(0, std::memory_order_relaxed);
+    nSumMicros.store(0, std::memory_order_relaxed);
+    nMaxMicros.store(0, std::memory_order_relaxed);
+}
+
+void CValidationMetrics::Reset()
+{
+    for (auto& histogram : histograms) {
+        histogram.Reset();
+    }
+}
+
+void AppendPrometheusHistogram(std::string& strText, const std::string& strName, const std::string& strLabels, const CLatencyHistogram::Snapshot& snapshot)
+{
+    // Prometheus buckets are cumulative
+    uint64_t nCumulative = 0;
+    for (size_t j = 0; j + 1 < snapshot.vBuckets.size(); j++) {
+        nCumulative += snapshot.vBuckets[j];
+        strText += strprintf("%s_bucket{%s,le=\"%g\"} %u\n", strName, strLabels, LATENCY_HISTOGRAM_BOUNDS[j] / 1e6, nCumulative);
+    }
+    strText += strprintf("%s_bucket{%s,le=\"+Inf\"} %u\n", strName, strLabels, snapshot.nCount);
+    strText += strprintf("%s_sum{%s} %.6f\n", strName, strLabels, snapshot.nSumMicros / 1e6);
+    strText += strprintf("%s_count{%s} %u\n", strName, strLabels, snapshot.nCount);
+}
+
+std::string CValidationMetrics::ToPrometheusText() const
+{
+    static const char* const name = "xsn_validation_stage_duration_seconds";
+
+    std::string strText;
+    strText += strprintf("# HELP %s Time spent in each stage of block validation.\n", name);
+    strText += strprintf("# TYPE %s histogram\n", name);
+    for (size_t i = 0; i < static_cast<size_t>(ValidationStage::COUNT); i++) {
+        const char* stage = GetStageName(static_cast<ValidationStage>(i));
+        AppendPrometheusHistogram(strText, name, strprintf("stage=\"%s\"", stage), histograms[i].GetSnapshot());
+    }
+    return strText;
+}
+
+const char* CValidationMetrics::GetStageName(ValidationStage stage)
+{
+    switch (stage) {
+    case ValidationStage::READ_BLOCK: return "read_block";
+    case ValidationStage::CONNECT_BLOCK: return "connect_block";
+    case ValidationStage::FLUSH_VIEW: return "flush_view";
+    case ValidationStage::FLUSH_CHAINSTATE: return "flush_chainstate";
+    case ValidationStage::POST_CONNECT: return "post_connect";
+    case ValidationStage::CONNECT_TIP: return "connect_tip";
+    case ValidationStage::SANITY_CHECKS: return "sanity_checks";
+    case ValidationStage::FORKS: return "forks";
+    case ValidationStage::CONNECT_TRANSACTIONS: return "connect_transactions";
+    case ValidationStage::VERIFY_INPUTS: return "verify_inputs";
+    case ValidationStage::INDEX_WRITING: return "index_writing";
+    case ValidationStage::CALLBACKS: return "callbacks";
+    case ValidationStage::PROOF_OF_STAKE: return "proof_of_stake";
+    case ValidationStage::BLOCK_SIGNATURE: return "block_signature";
+    case ValidationStage::BLOCK_VALUE: return "block_value";
+    case ValidationStage::BLOCK_PAYEE: return "block_payee";
+    case ValidationStage::MERCHANT_PAYMENT: return "merchant_payment";
+    case ValidationStage::COUNT: break;
+    }
+    return "unknown";
+}
+
+CValidationStageTimer::CValidationStageTimer(ValidationStage stageIn) :
+    stage(stageIn),
+    nTimeStart(GetTimeMicros())
+{}
+
+CValidationStageTimer::~CValidationStageTimer()
+{
+    validationmetrics.Record(stage, GetTimeMicros() - nTimeStart);
+}
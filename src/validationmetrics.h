@@ -0,0 +1,138 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_VALIDATIONMETRICS_H
+#define BITCOIN_VALIDATIONMETRICS_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** Timed stages of block validation */
+enum class ValidationStage
+{
+    // ConnectTip
+    READ_BLOCK,
+    CONNECT_BLOCK,
+    FLUSH_VIEW,
+    FLUSH_CHAINSTATE,
+    POST_CONNECT,
+    CONNECT_TIP,
+    // ConnectBlock
+    SANITY_CHECKS,
+    FORKS,
+    CONNECT_TRANSACTIONS,
+    VERIFY_INPUTS,
+    INDEX_WRITING,
+    CALLBACKS,
+    // XSN
+    PROOF_OF_STAKE,
+    BLOCK_SIGNATURE,
+    BLOCK_VALUE,
+    BLOCK_PAYEE,
+    MERCHANT_PAYMENT,
+
+    COUNT
+};
+
+/** Upper bounds of the latency histogram buckets in microseconds, the last
+ * bucket takes everything above. Shared by the validation stages and the
+ * network message handling latencies. */
+static const int64_t LATENCY_HISTOGRAM_BOUNDS[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+static const size_t LATENCY_HISTOGRAM_BUCKETS = sizeof(LATENCY_HISTOGRAM_BOUNDS) / sizeof(LATENCY_HISTOGRAM_BOUNDS[0]) + 1;
+
+/**
+ * Latency histogram with fixed buckets.
+ *
+ * Recording a sample is a handful of relaxed atomic operations, so it can be
+ * done on the validation hot path without taking a lock. A snapshot taken
+ * while samples are recorded may be off by the samples in flight.
+ */
+class CLatencyHistogram
+{
+public:
+    struct Snapshot
+    {
+        /// Samples per bucket, not cumulative
+        std::vector<uint64_t> vBuckets;
+        uint64_t nCount = 0;
+        int64_t nSumMicros = 0;
+        int64_t nMaxMicros = 0;
+
+        /** Estimated quantile (0..1) in microseconds, the upper bound of the bucket it falls into */
+        int64_t GetQuantile(double q) const;
+    };
+
+    CLatencyHistogram();
+
+    void Record(int64_t nMicros);
+    Snapshot GetSnapshot() const;
+    void Reset();
+
+private:
+    std::atomic<uint64_t> buckets[LATENCY_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> nCount;
+    std::atomic<int64_t> nSumMicros;
+    std::atomic<int64_t> nMaxMicros;
+};
+
+/** Append the samples of one histogram of a Prometheus histogram family, e.g.
+ * with strLabels stage="connect_tip" */
+void AppendPrometheusHistogram(std::string& strText, const std::string& strName, const std::string& strLabels, const CLatencyHistogram::Snapshot& snapshot);
+
+/**
+ * Registry of the validation stage latencies.
+ *
+ * ConnectTip and ConnectBlock used to report their per-stage times only
+ * through the bench log category. They are recorded here as well, together
+ * with the proof-of-stake, block signature and payment checks, and exposed
+ * by the getvalidationstats RPC and the /rest/metrics endpoint.
+ */
+class CValidationMetrics
+{
+public:
+    void Record(ValidationStage stage, int64_t nMicros)
+    {
+        histograms[static_cast<size_t>(stage)].Record(nMicros);
+    }
+
+    CLatencyHistogram::Snapshot GetSnapshot(ValidationStage stage) const
+    {
+        return histograms[static_cast<size_t>(stage)].GetSnapshot();
+    }
+
+    void Reset();
+
+    /** All stages in the Prometheus text exposition format */
+    std::string ToPrometheusText() const;
+
+    static const char* GetStageName(ValidationStage stage);
+
+private:
+    CLatencyHistogram histograms[static_cast<size_t>(ValidationStage::COUNT)];
+};
+
+extern CValidationMetrics validationmetrics;
+
+/** Records the time from its construction to its destruction for a stage */
+class CValidationStageTimer
+{
+public:
+    explicit CValidationStageTimer(ValidationStage stageIn);
+    ~CValidationStageTimer();
+
+    CValidationStageTimer(const CValidationStageTimer&) = delete;
+    CValidationStageTimer& operator=(const CValidationStageTimer&) = delete;
+
+private:
+    const ValidationStage stage;
+    const int64_t nTimeStart;
+};
+
+#endif // BITCOIN_VALIDATIONMETRICS_H
@@ -9,6 +9,7 @@
 #include <hash.h>
 #include <protocol.h>
 #include <utilstrencodings.h>
+#include <wallet/ldb.h>
 #include <wallet/walletutil.h>
 
 #include <stdint.h>
@@ -79,6 +80,126 @@ BerkeleyEnvironment* GetWalletEnv(const fs::path& wallet_path, std::string& data
     return &g_dbenvs.emplace(std::piecewise_construct, std::forward_as_tuple(env_directory.string()), std::forward_as_tuple(env_directory)).first->second;
 }
 
+bool ParseWalletBackend(const std::string& str, WalletBackend& backend)
+{
+    if (str == "bdb") {
+        backend = WalletBackend::BDB;
+    } else if (str == "leveldb") {
+        backend = WalletBackend::LEVELDB;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string FormatWalletBackend(WalletBackend backend)
+{
+    switch (backend) {
+    case WalletBackend::BDB: return "bdb";
+    case WalletBackend::LEVELDB: return "leveldb";
+    default: assert(false);
+    }
+}
+
+fs::path GetWalletBerkeleyPath(const fs::path& wallet_path)
+{
+    // Same as GetWalletEnv, without opening an environment. A data file in
+    // -walletdir that was migrated to LevelDB keeps its name.
+    const fs::path legacy_ldb_path = wallet_path.parent_path() / (wallet_path.filename().string() + ".ldb");
+    if (fs::is_regular_file(wallet_path) || fs::is_directory(legacy_ldb_path)) {
+        return wallet_path;
+    }
+    return wallet_path / "wallet.dat";
+}
+
+fs::path GetWalletLevelDBPath(const fs::path& wallet_path)
+{
+    // Wallets given as the name of a data file in -walletdir keep their
+    // LevelDB database next to that file
+    const fs::path legacy_path = wallet_path.parent_path() / (wallet_path.filename().string() + ".ldb");
+    if (fs::is_regular_file(wallet_path) || fs::is_directory(legacy_path)) {
+        return legacy_path;
+    }
+    return wallet_path / "wallet.ldb";
+}
+
+WalletBackend GetWalletBackend(const fs::path& wallet_path)
+{
+    if (fs::is_directory(GetWalletLevelDBPath(wallet_path))) {
+        return WalletBackend::LEVELDB;
+    }
+    if (fs::exists(GetWalletBerkeleyPath(wallet_path))) {
+        return WalletBackend::BDB;
+    }
+    WalletBackend backend = DEFAULT_WALLET_BACKEND;
+    ParseWalletBackend(gArgs.GetArg("-walletbackend", FormatWalletBackend(DEFAULT_WALLET_BACKEND)), backend);
+    return backend;
+}
+
+/** Append the backups of db_path named like <filename>.<time>.bak, as made by Recover and migration */
+static void FindDatedBackups(const fs::path& db_path, std::vector<fs::path>& vRet)
+{
+    const fs::path dir = db_path.parent_path();
+    const std::string prefix = db_path.filename().string() + ".";
+    const std::string suffix = ".bak";
+    if (!fs::is_directory(dir)) {
+        return;
+    }
+    for (fs::directory_iterator it(dir); it != fs::directory_iterator(); ++it) {
+        const std::string name = it->path().filename().string();
+        if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        const std::string time = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        if (time.find_first_not_of("0123456789") == std::string::npos) {
+            vRet.push_back(it->path());
+        }
+    }
+}
+
+std::vector<fs::path> GetWalletUnusedCopies(const fs::path& wallet_path)
+{
+    std::vector<fs::path> vRet;
+    try {
+        if (GetWalletBackend(wallet_path) == WalletBackend::LEVELDB) {
+            const fs::path path = GetWalletBerkeleyPath(wallet_path);
+            if (fs::exists(path)) {
+                vRet.push_back(path);
+            }
+            FindDatedBackups(path, vRet);
+        } else {
+            FindDatedBackups(GetWalletLevelDBPath(wallet_path), vRet);
+        }
+    } catch (const fs::filesystem_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+    }
+    return vRet;
+}
+
+std::unique_ptr<WalletDatabase> WalletDatabase::Create(const fs::path& path)
+{
+    if (GetWalletBackend(path) == WalletBackend::LEVELDB) {
+        return MakeUnique<LevelDBDatabase>(GetWalletLevelDBPath(path));
+    }
+    return MakeUnique<BerkeleyDatabase>(path);
+}
+
+std::unique_ptr<WalletDatabase> WalletDatabase::CreateDummy()
+{
+    return MakeUnique<BerkeleyDatabase>();
+}
+
+std::unique_ptr<WalletDatabase> WalletDatabase::CreateMock()
+{
+    return MakeUnique<BerkeleyDatabase>("", true /* mock */);
+}
+
+void WalletDatabase::IncrementUpdateCounter()
+{
+    ++nUpdateCounter;
+}
+
 //
 // BerkeleyBatch
 //
@@ -439,7 +560,7 @@ void BerkeleyEnvironment::CheckpointLSN(const std::string& strFile)
 }
 
 
-BerkeleyBatch::BerkeleyBatch(BerkeleyDatabase& database, const char* pszMode, bool fFlushOnCloseIn) : pdb(nullptr), activeTxn(nullptr)
+BerkeleyBatch::BerkeleyBatch(BerkeleyDatabase& database, const char* pszMode, bool fFlushOnCloseIn) : pdb(nullptr), activeTxn(nullptr), pcursor(nullptr)
 {
     fReadOnly = (!strchr(pszMode, '+') && !strchr(pszMode, 'w'));
     fFlushOnClose = fFlushOnCloseIn;
@@ -518,6 +639,172 @@ BerkeleyBatch::BerkeleyBatch(BerkeleyDatabase& database, const char* pszMode, bo
     }
 }
 
+bool BerkeleyBatch::ReadKey(CDataStream&& ssKey, CDataStream& ssValue)
+{
+    if (!pdb)
+        return false;
+
+    Dbt datKey(ssKey.data(), ssKey.size());
+
+    // Read
+    Dbt datValue;
+    datValue.set_flags(DB_DBT_MALLOC);
+    int ret = pdb->get(activeTxn, &datKey, &datValue, 0);
+    memory_cleanse(datKey.get_data(), datKey.get_size());
+    if (datValue.get_data() != nullptr) {
+        ssValue.write((char*)datValue.get_data(), datValue.get_size());
+
+        // Clear and free memory
+        memory_cleanse(datValue.get_data(), datValue.get_size());
+        free(datValue.get_data());
+        return ret == 0;
+    }
+    return false;
+}
+
+bool BerkeleyBatch::WriteKey(CDataStream&& ssKey, CDataStream&& ssValue, bool fOverwrite)
+{
+    if (!pdb)
+        return true;
+    if (fReadOnly)
+        assert(!"Write called on database in read-only mode");
+
+    Dbt datKey(ssKey.data(), ssKey.size());
+    Dbt datValue(ssValue.data(), ssValue.size());
+
+    // Write
+    int ret = pdb->put(activeTxn, &datKey, &datValue, (fOverwrite ? 0 : DB_NOOVERWRITE));
+
+    // Clear memory in case it was a private key
+    memory_cleanse(datKey.get_data(), datKey.get_size());
+    memory_cleanse(datValue.get_data(), datValue.get_size());
+    return (ret == 0);
+}
+
+bool BerkeleyBatch::EraseKey(CDataStream&& ssKey)
+{
+    if (!pdb)
+        return false;
+    if (fReadOnly)
+        assert(!"Erase called on database in read-only mode");
+
+    Dbt datKey(ssKey.data(), ssKey.size());
+
+    // Erase
+    int ret = pdb->del(activeTxn, &datKey, 0);
+
+    // Clear memory
+    memory_cleanse(datKey.get_data(), datKey.get_size());
+    return (ret == 0 || ret == DB_NOTFOUND);
+}
+
+bool BerkeleyBatch::HasKey(CDataStream&& ssKey)
+{
+    if (!pdb)
+        return false;
+
+    Dbt datKey(ssKey.data(), ssKey.size());
+
+    // Exists
+    int ret = pdb->exists(activeTxn, &datKey, 0);
+
+    // Clear memory
+    memory_cleanse(datKey.get_data(), datKey.get_size());
+    return (ret == 0);
+}
+
+bool BerkeleyBatch::StartCursor()
+{
+    assert(!pcursor);
+    if (!pdb)
+        return false;
+    int ret = pdb->cursor(nullptr, &pcursor, 0);
+    if (ret != 0) {
+        pcursor = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool BerkeleyBatch::ReadAtCursor(CDataStream& ssKey, CDataStream& ssValue, bool& complete, bool setRange)
+{
+    complete = false;
+    if (pcursor == nullptr)
+        return false;
+
+    // Read at cursor
+    Dbt datKey;
+    unsigned int fFlags = DB_NEXT;
+    if (setRange) {
+        datKey.set_data(ssKey.data());
+        datKey.set_size(ssKey.size());
+        fFlags = DB_SET_RANGE;
+    }
+    Dbt datValue;
+    datKey.set_flags(DB_DBT_MALLOC);
+    datValue.set_flags(DB_DBT_MALLOC);
+    int ret = pcursor->get(&datKey, &datValue, fFlags);
+    if (ret == DB_NOTFOUND) {
+        complete = true;
+    }
+    if (ret != 0)
+        return false;
+    else if (datKey.get_data() == nullptr || datValue.get_data() == nullptr)
+        return false;
+
+    // Convert to streams
+    ssKey.SetType(SER_DISK);
+    ssKey.clear();
+    ssKey.write((char*)datKey.get_data(), datKey.get_size());
+    ssValue.SetType(SER_DISK);
+    ssValue.clear();
+    ssValue.write((char*)datValue.get_data(), datValue.get_size());
+
+    // Clear and free memory
+    memory_cleanse(datKey.get_data(), datKey.get_size());
+    memory_cleanse(datValue.get_data(), datValue.get_size());
+    free(datKey.get_data());
+    free(datValue.get_data());
+    return true;
+}
+
+void BerkeleyBatch::CloseCursor()
+{
+    if (!pcursor)
+        return;
+    pcursor->close();
+    pcursor = nullptr;
+}
+
+bool BerkeleyBatch::TxnBegin()
+{
+    if (!pdb || activeTxn)
+        return false;
+    DbTxn* ptxn = env->TxnBegin();
+    if (!ptxn)
+        return false;
+    activeTxn = ptxn;
+    return true;
+}
+
+bool BerkeleyBatch::TxnCommit()
+{
+    if (!pdb || !activeTxn)
+        return false;
+    int ret = activeTxn->commit(0);
+    activeTxn = nullptr;
+    return (ret == 0);
+}
+
+bool BerkeleyBatch::TxnAbort()
+{
+    if (!pdb || !activeTxn)
+        return false;
+    int ret = activeTxn->abort();
+    activeTxn = nullptr;
+    return (ret == 0);
+}
+
 void BerkeleyBatch::Flush()
 {
     if (activeTxn)
@@ -531,15 +818,11 @@ void BerkeleyBatch::Flush()
     env->dbenv->txn_checkpoint(nMinutes ? gArgs.GetArg("-dblogsize", DEFAULT_WALLET_DBLOGSIZE) * 1024 : 0, nMinutes, 0);
 }
 
-void BerkeleyDatabase::IncrementUpdateCounter()
-{
-    ++nUpdateCounter;
-}
-
 void BerkeleyBatch::Close()
 {
     if (!pdb)
         return;
+    CloseCursor();
     if (activeTxn)
         activeTxn->abort();
     activeTxn = nullptr;
@@ -602,17 +885,17 @@ bool BerkeleyBatch::Rewrite(BerkeleyDatabase& database, const char* pszSkip)
                         fSuccess = false;
                     }
 
-                    Dbc* pcursor = db.GetCursor();
-                    if (pcursor)
+                    if (db.StartCursor())
                         while (fSuccess) {
                             CDataStream ssKey(SER_DISK, CLIENT_VERSION);
                             CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-                            int ret1 = db.ReadAtCursor(pcursor, ssKey, ssValue);
-                            if (ret1 == DB_NOTFOUND) {
-                                pcursor->close();
+                            bool complete;
+                            bool ret1 = db.ReadAtCursor(ssKey, ssValue, complete);
+                            if (complete) {
+                                db.CloseCursor();
                                 break;
-                            } else if (ret1 != 0) {
-                                pcursor->close();
+                            } else if (!ret1) {
+                                db.CloseCursor();
                                 fSuccess = false;
                                 break;
                             }
@@ -740,6 +1023,16 @@ bool BerkeleyBatch::PeriodicFlush(BerkeleyDatabase& database)
     return ret;
 }
 
+std::unique_ptr<DatabaseBatch> BerkeleyDatabase::MakeBatch(const char* pszMode, bool fFlushOnClose)
+{
+    return MakeUnique<BerkeleyBatch>(*this, pszMode, fFlushOnClose);
+}
+
+bool BerkeleyDatabase::PeriodicFlush()
+{
+    return BerkeleyBatch::PeriodicFlush(*this);
+}
+
 bool BerkeleyDatabase::Rewrite(const char* pszSkip)
 {
     return BerkeleyBatch::Rewrite(*this, pszSkip);
@@ -71,6 +71,7 @@ void WalletInit::AddWalletOptions() const
     gArgs.AddArg("-txconfirmtarget=<n>", strprintf("If paytxfee is not set, include enough fee so transactions begin confirmation on average within n blocks (default: %u)", DEFAULT_TX_CONFIRM_TARGET), false, OptionsCategory::WALLET);
     gArgs.AddArg("-upgradewallet", "Upgrade wallet to latest format on startup", false, OptionsCategory::WALLET);
     gArgs.AddArg("-wallet=<path>", "Specify wallet database path. Can be specified multiple times to load multiple wallets. Path is interpreted relative to <walletdir> if it is not absolute, and will be created if it does not exist (as a directory containing a wallet.dat file and log files). For backwards compatibility this will also accept names of existing data files in <walletdir>.)", false, OptionsCategory::WALLET);
+    gArgs.AddArg("-walletbackend=<backend>", strprintf("Database backend for new wallets (\"bdb\" or \"leveldb\", default: \"%s\"). With leveldb, existing Berkeley DB wallets are copied into a LevelDB database on startup and their wallet.dat is renamed to a dated .bak file. Set to bdb explicitly to move LevelDB wallets back the same way. Otherwise wallets are opened with the backend they are stored in", FormatWalletBackend(DEFAULT_WALLET_BACKEND)), false, OptionsCategory::WALLET);
     gArgs.AddArg("-walletbroadcast",  strprintf("Make the wallet broadcast transactions (default: %u)", DEFAULT_WALLETBROADCAST), false, OptionsCategory::WALLET);
     gArgs.AddArg("-walletdir=<dir>", "Specify directory to hold wallets (default: <datadir>/wallets if it exists, otherwise <datadir>)", false, OptionsCategory::WALLET);
     gArgs.AddArg("-walletnotify=<cmd>", "Execute command when a wallet transaction changes (%s in cmd is replaced by TxID)", false, OptionsCategory::WALLET);
@@ -97,6 +98,11 @@ bool WalletInit::ParameterInteraction() const
     gArgs.SoftSetArg("-wallet", "");
     const bool is_multiwallet = gArgs.GetArgs("-wallet").size() > 1;
 
+    WalletBackend backend;
+    if (!ParseWalletBackend(gArgs.GetArg("-walletbackend", FormatWalletBackend(DEFAULT_WALLET_BACKEND)), backend)) {
+        return InitError(strprintf(_("Unknown wallet backend -walletbackend=%s"), gArgs.GetArg("-walletbackend", "")));
+    }
+
     if (gArgs.GetBoolArg("-blocksonly", DEFAULT_BLOCKSONLY) && gArgs.SoftSetBoolArg("-walletbroadcast", false)) {
         LogPrintf("%s: parameter interaction: -blocksonly=1 -> setting -walletbroadcast=0\n", __func__);
     }
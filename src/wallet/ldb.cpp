@@ -0,0 +1,624 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/ldb.h>
+
+#include <clientversion.h>
+#include <util.h>
+#include <utiltime.h>
+
+#include <string.h>
+
+#include <leveldb/db.h>
+
+namespace {
+/** Takes the remaining bytes of a serialized key or value as they are */
+class RawRecord
+{
+public:
+    explicit RawRecord(CDataStream& ssIn) : ss(ssIn) {}
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        ss.write(s.data(), s.size());
+        s.ignore(s.size());
+    }
+
+private:
+    CDataStream& ss;
+};
+
+/** Stream holding the bytes of a record */
+CDataStream RecordStream(const CSerializeData& data)
+{
+    return CDataStream(data.begin(), data.end(), SER_DISK, CLIENT_VERSION);
+}
+
+/** Copy the records of source that filter accepts into dest, in batches */
+bool CopyRecords(CDBWrapper& source, CDBWrapper& dest, void *callbackDataIn, bool (*recoverKVcallback)(void* callbackData, CDataStream ssKey, CDataStream ssValue), size_t& nRecordsRet)
+{
+    nRecordsRet = 0;
+    CDBBatch batch(dest);
+    std::unique_ptr<CDBIterator> pcursor(source.NewIterator());
+    for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        RawRecord rawKey(ssKey);
+        RawRecord rawValue(ssValue);
+        if (!pcursor->GetKey(rawKey) || !pcursor->GetValue(rawValue)) {
+            return false;
+        }
+        if (recoverKVcallback && !(*recoverKVcallback)(callbackDataIn, ssKey, ssValue)) {
+            continue;
+        }
+        batch.Write(ssKey, ssValue);
+        ++nRecordsRet;
+        if (batch.SizeEstimate() > WALLET_LEVELDB_COPY_BATCH_SIZE) {
+            dest.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    return dest.WriteBatch(batch, true);
+}
+} // namespace
+
+//
+// LevelDBBatch
+//
+
+LevelDBBatch::LevelDBBatch(LevelDBDatabase& database, const char* pszMode, bool fFlushOnCloseIn) :
+    db(database.GetDB()),
+    fCursorPositioned(false),
+    fFlushOnClose(fFlushOnCloseIn),
+    fUnsynced(false),
+    fTxn(false)
+{
+    fReadOnly = (!strchr(pszMode, '+') && !strchr(pszMode, 'w'));
+
+    if (strchr(pszMode, 'c') != nullptr && !Exists(std::string("version"))) {
+        bool fTmp = fReadOnly;
+        fReadOnly = false;
+        WriteVersion(CLIENT_VERSION);
+        fReadOnly = fTmp;
+    }
+}
+
+bool LevelDBBatch::ReadKey(CDataStream&& ssKey, CDataStream& ssValue)
+{
+    if (!db)
+        return false;
+
+    if (fTxn) {
+        const CSerializeData key(ssKey.begin(), ssKey.end());
+        if (setTxnErases.count(key)) {
+            return false;
+        }
+        auto it = mapTxnWrites.find(key);
+        if (it != mapTxnWrites.end()) {
+            ssValue.write(it->second.data(), it->second.size());
+            return true;
+        }
+    }
+
+    RawRecord rawValue(ssValue);
+    try {
+        return db->Read(ssKey, rawValue);
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        return false;
+    }
+}
+
+bool LevelDBBatch::WriteKey(CDataStream&& ssKey, CDataStream&& ssValue, bool fOverwrite)
+{
+    if (!db)
+        return true;
+    if (fReadOnly)
+        assert(!"Write called on database in read-only mode");
+
+    if (!fOverwrite && HasKey(CDataStream(ssKey))) {
+        return false;
+    }
+
+    if (fTxn) {
+        const CSerializeData key(ssKey.begin(), ssKey.end());
+        setTxnErases.erase(key);
+        mapTxnWrites[key] = CSerializeData(ssValue.begin(), ssValue.end());
+        return true;
+    }
+
+    try {
+        fUnsynced = true;
+        return db->Write(ssKey, ssValue);
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        return false;
+    }
+}
+
+bool LevelDBBatch::EraseKey(CDataStream&& ssKey)
+{
+    if (!db)
+        return false;
+    if (fReadOnly)
+        assert(!"Erase called on database in read-only mode");
+
+    if (fTxn) {
+        const CSerializeData key(ssKey.begin(), ssKey.end());
+        mapTxnWrites.erase(key);
+        setTxnErases.insert(key);
+        return true;
+    }
+
+    try {
+        fUnsynced = true;
+        return db->Erase(ssKey);
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        return false;
+    }
+}
+
+bool LevelDBBatch::HasKey(CDataStream&& ssKey)
+{
+    if (!db)
+        return false;
+
+    if (fTxn) {
+        const CSerializeData key(ssKey.begin(), ssKey.end());
+        if (setTxnErases.count(key)) {
+            return false;
+        }
+        if (mapTxnWrites.count(key)) {
+            return true;
+        }
+    }
+
+    try {
+        return db->Exists(ssKey);
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        return false;
+    }
+}
+
+void LevelDBBatch::Flush()
+{
+    // Writes are in the LevelDB log already, make sure it reached the disk
+    if (!db || fReadOnly || !fUnsynced)
+        return;
+    try {
+        db->Sync();
+        fUnsynced = false;
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+    }
+}
+
+void LevelDBBatch::Close()
+{
+    if (!db)
+        return;
+    CloseCursor();
+    TxnAbort();
+    if (fFlushOnClose)
+        Flush();
+    db.reset();
+}
+
+bool LevelDBBatch::StartCursor()
+{
+    assert(!pcursor);
+    if (!db)
+        return false;
+    pcursor.reset(db->NewIterator());
+    fCursorPositioned = false;
+    return true;
+}
+
+bool LevelDBBatch::ReadAtCursor(CDataStream& ssKey, CDataStream& ssValue, bool& complete, bool setRange)
+{
+    complete = false;
+    if (!pcursor)
+        return false;
+
+    if (setRange) {
+        pcursor->Seek(ssKey);
+    } else if (!fCursorPositioned) {
+        pcursor->SeekToFirst();
+    } else {
+        pcursor->Next();
+    }
+    fCursorPositioned = true;
+    if (!pcursor->Valid()) {
+        complete = true;
+        return false;
+    }
+
+    ssKey.SetType(SER_DISK);
+    ssKey.clear();
+    ssValue.SetType(SER_DISK);
+    ssValue.clear();
+    RawRecord rawKey(ssKey);
+    RawRecord rawValue(ssValue);
+    return pcursor->GetKey(rawKey) && pcursor->GetValue(rawValue);
+}
+
+void LevelDBBatch::CloseCursor()
+{
+    pcursor.reset();
+}
+
+bool LevelDBBatch::TxnBegin()
+{
+    if (!db || fTxn)
+        return false;
+    fTxn = true;
+    return true;
+}
+
+bool LevelDBBatch::TxnCommit()
+{
+    if (!db || !fTxn)
+        return false;
+
+    CDBBatch batch(*db);
+    for (const CSerializeData& key : setTxnErases) {
+        batch.Erase(RecordStream(key));
+    }
+    for (const auto& record : mapTxnWrites) {
+        batch.Write(RecordStream(record.first), RecordStream(record.second));
+    }
+    mapTxnWrites.clear();
+    setTxnErases.clear();
+    fTxn = false;
+
+    try {
+        return db->WriteBatch(batch, true);
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        return false;
+    }
+}
+
+bool LevelDBBatch::TxnAbort()
+{
+    if (!db || !fTxn)
+        return false;
+    mapTxnWrites.clear();
+    setTxnErases.clear();
+    fTxn = false;
+    return true;
+}
+
+//
+// LevelDBDatabase
+//
+
+std::shared_ptr<CDBWrapper> LevelDBDatabase::GetDB()
+{
+    LOCK(cs_db);
+    if (!db) {
+        db = std::make_shared<CDBWrapper>(path, WALLET_LEVELDB_CACHE_SIZE);
+    }
+    return db;
+}
+
+std::unique_ptr<DatabaseBatch> LevelDBDatabase::MakeBatch(const char* pszMode, bool fFlushOnClose)
+{
+    return MakeUnique<LevelDBBatch>(*this, pszMode, fFlushOnClose);
+}
+
+bool LevelDBDatabase::Rewrite(const char* pszSkip)
+{
+    LogPrintf("LevelDBDatabase::Rewrite: Rewriting %s...\n", path.string());
+    try {
+        std::shared_ptr<CDBWrapper> pdb = GetDB();
+        CDBBatch batch(*pdb);
+        if (pszSkip) {
+            const size_t nSkipSize = strlen(pszSkip);
+            CDataStream ssSkip(pszSkip, pszSkip + nSkipSize, SER_DISK, CLIENT_VERSION);
+            std::unique_ptr<CDBIterator> pcursor(pdb->NewIterator());
+            for (pcursor->Seek(ssSkip); pcursor->Valid(); pcursor->Next()) {
+                CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+                RawRecord rawKey(ssKey);
+                if (!pcursor->GetKey(rawKey) || ssKey.size() < nSkipSize || memcmp(ssKey.data(), pszSkip, nSkipSize) != 0) {
+                    break;
+                }
+                batch.Erase(ssKey);
+            }
+        }
+        batch.Write(std::string("version"), CLIENT_VERSION);
+        pdb->WriteBatch(batch, true);
+
+        // Compacting all keys also rewrites the log and the tables that
+        // still held the erased records. No key starts with 0xff, as that
+        // would be the size of a type string longer than 2^32 bytes.
+        CDataStream ssBegin(SER_DISK, CLIENT_VERSION);
+        CDataStream ssEnd(SER_DISK, CLIENT_VERSION);
+        ssEnd << uint8_t(0xff);
+        pdb->CompactRange(ssBegin, ssEnd);
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("LevelDBDatabase::Rewrite: Failed to rewrite database %s: %s\n", path.string(), e.what());
+        return false;
+    }
+    return true;
+}
+
+bool LevelDBDatabase::Backup(const std::string& strDest)
+{
+    fs::path pathDest(strDest);
+    if (fs::is_directory(pathDest) && !fs::exists(pathDest / "CURRENT")) {
+        // A directory that is not a LevelDB database itself
+        pathDest /= path.filename();
+    }
+    const fs::path pathTmp = pathDest.string() + ".tmp";
+
+    try {
+        if (fs::exists(pathDest) && fs::equivalent(path, pathDest)) {
+            LogPrintf("cannot backup to wallet source database %s\n", pathDest.string());
+            return false;
+        }
+        if (fs::exists(pathDest) && !fs::exists(pathDest / "CURRENT")) {
+            LogPrintf("cannot backup to %s, it is not a LevelDB database\n", pathDest.string());
+            return false;
+        }
+
+        fs::remove_all(pathTmp);
+        size_t nRecords;
+        {
+            std::shared_ptr<CDBWrapper> pdb = GetDB();
+            CDBWrapper dbDest(pathTmp, WALLET_LEVELDB_CACHE_SIZE);
+            if (!CopyRecords(*pdb, dbDest, nullptr, nullptr, nRecords)) {
+                LogPrintf("error reading %s\n", path.string());
+                return false;
+            }
+        }
+        fs::remove_all(pathDest);
+        fs::rename(pathTmp, pathDest);
+        LogPrintf("copied %u records of %s to %s\n", nRecords, path.string(), pathDest.string());
+        return true;
+    } catch (const std::exception& e) {
+        LogPrintf("error copying %s to %s - %s\n", path.string(), pathDest.string(), e.what());
+        return false;
+    }
+}
+
+void LevelDBDatabase::Flush(bool shutdown)
+{
+    LOCK(cs_db);
+    if (!db) {
+        return;
+    }
+    try {
+        db->Sync();
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("LevelDBDatabase::Flush: %s\n", e.what());
+    }
+    if (shutdown) {
+        db.reset();
+    }
+}
+
+bool LevelDBDatabase::PeriodicFlush()
+{
+    std::shared_ptr<CDBWrapper> pdb;
+    {
+        LOCK(cs_db);
+        pdb = db;
+    }
+    if (!pdb) {
+        return true;
+    }
+
+    LogPrint(BCLog::DB, "Flushing %s\n", path.string());
+    int64_t nStart = GetTimeMillis();
+    try {
+        pdb->Sync();
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("LevelDBDatabase::PeriodicFlush: %s\n", e.what());
+        return false;
+    }
+    LogPrint(BCLog::DB, "Flushed %s %dms\n", path.string(), GetTimeMillis() - nStart);
+    return true;
+}
+
+bool LevelDBDatabase::Verify(const fs::path& path, std::string& warningStr, std::string& errorStr)
+{
+    LogPrintf("Using LevelDB wallet %s\n", path.string());
+    if (!fs::exists(path)) {
+        return true;
+    }
+
+    try {
+        CDBWrapper db(path, WALLET_LEVELDB_CACHE_SIZE);
+        return true;
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("LevelDBDatabase::Verify: %s, repairing %s\n", e.what(), path.string());
+    }
+
+    leveldb::Status status = leveldb::RepairDB(path.string(), leveldb::Options());
+    if (!status.ok()) {
+        LogPrintf("LevelDBDatabase::Verify: %s\n", status.ToString());
+        errorStr = strprintf(_("%s corrupt, salvage failed"), path.string());
+        return false;
+    }
+    warningStr = strprintf(_("Warning: Wallet database %s corrupt, data salvaged!"
+                             " If your balance or transactions are incorrect you should"
+                             " restore from a backup."),
+                           path.string());
+    return true;
+}
+
+bool LevelDBDatabase::Recover(const fs::path& path, void *callbackDataIn, bool (*recoverKVcallback)(void* callbackData, CDataStream ssKey, CDataStream ssValue), std::string& out_backup_filename)
+{
+    // Move the database aside, under a name like wallet.ldb.<time>.bak,
+    // and copy the records that pass the filter into a new one
+    int64_t now = GetTime();
+    out_backup_filename = strprintf("%s.%d.bak", path.filename().string(), now);
+    const fs::path pathBackup = path.parent_path() / out_backup_filename;
+
+    try {
+        fs::rename(path, pathBackup);
+        LogPrintf("Renamed %s to %s\n", path.string(), pathBackup.string());
+    } catch (const fs::filesystem_error& e) {
+        LogPrintf("Failed to rename %s to %s: %s\n", path.string(), pathBackup.string(), e.what());
+        return false;
+    }
+
+    try {
+        CDBWrapper dbBackup(pathBackup, WALLET_LEVELDB_CACHE_SIZE);
+        CDBWrapper db(path, WALLET_LEVELDB_CACHE_SIZE);
+        size_t nRecords;
+        bool fSuccess = CopyRecords(dbBackup, db, callbackDataIn, recoverKVcallback, nRecords);
+        LogPrintf("Recovered %u records of %s\n", nRecords, pathBackup.string());
+        return fSuccess;
+    } catch (const dbwrapper_error& e) {
+        LogPrintf("Cannot recover %s: %s\n", pathBackup.string(), e.what());
+        return false;
+    }
+}
+
+bool LevelDBDatabase::MigrateFromBerkeley(const fs::path& wallet_path, const fs::path& path, std::string& errorStr)
+{
+    const fs::path pathBerkeley = GetWalletBerkeleyPath(wallet_path);
+    const fs::path pathTmp = path.string() + ".tmp";
+    LogPrintf("Migrating wallet %s to LevelDB database %s...\n", pathBerkeley.string(), path.string());
+    int64_t nStart = GetTimeMillis();
+
+    try {
+        fs::remove_all(pathTmp);
+        BerkeleyDatabase database(wallet_path);
+        size_t nRecords = 0;
+        {
+            BerkeleyBatch batchBerkeley(database, "r", false);
+            CDBWrapper db(pathTmp, WALLET_LEVELDB_CACHE_SIZE);
+            CDBBatch batch(db);
+            if (!batchBerkeley.StartCursor()) {
+                errorStr = strprintf(_("Error reading %s"), pathBerkeley.string());
+                return false;
+            }
+            while (true) {
+                CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+                CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+                bool complete;
+                bool ret = batchBerkeley.ReadAtCursor(ssKey, ssValue, complete);
+                if (complete) {
+                    break;
+                } else if (!ret) {
+                    errorStr = strprintf(_("Error reading %s"), pathBerkeley.string());
+                    return false;
+                }
+                batch.Write(ssKey, ssValue);
+                ++nRecords;
+                if (batch.SizeEstimate() > WALLET_LEVELDB_COPY_BATCH_SIZE) {
+                    db.WriteBatch(batch);
+                    batch.Clear();
+                }
+            }
+            db.WriteBatch(batch, true);
+        }
+        // Close wallet.dat and leave it self-contained, it is not written to anymore
+        database.Flush(false);
+
+        // The database only shows up under its final name once complete
+        fs::rename(pathTmp, path);
+        LogPrintf("Migrated %u records to %s in %dms\n", nRecords, path.string(), GetTimeMillis() - nStart);
+    } catch (const std::exception& e) {
+        errorStr = strprintf(_("Error migrating %s to LevelDB: %s"), pathBerkeley.string(), e.what());
+        return false;
+    }
+
+    // Move wallet.dat aside under a dated name, like BerkeleyBatch::Recover
+    // does. It still holds the keys as they were before the migration, see
+    // GetWalletUnusedCopies.
+    std::string strFile;
+    BerkeleyEnvironment* env = GetWalletEnv(wallet_path, strFile);
+    const std::string strBackup = strprintf("%s.%d.bak", strFile, GetTime());
+    if (env->dbenv->dbrename(nullptr, strFile.c_str(), nullptr, strBackup.c_str(), DB_AUTO_COMMIT) == 0) {
+        LogPrintf("Renamed %s to %s\n", strFile, strBackup);
+    } else {
+        LogPrintf("Failed to rename %s to %s, it is not used anymore\n", strFile, strBackup);
+    }
+    return true;
+}
+
+bool LevelDBDatabase::MigrateToBerkeley(const fs::path& wallet_path, const fs::path& path, std::string& errorStr)
+{
+    const fs::path pathBerkeley = GetWalletBerkeleyPath(wallet_path);
+    const std::string strFile = pathBerkeley.filename().string();
+    LogPrintf("Migrating LevelDB database %s to Berkeley DB wallet %s...\n", path.string(), pathBerkeley.string());
+    int64_t nStart = GetTimeMillis();
+
+    if (fs::exists(pathBerkeley)) {
+        errorStr = strprintf(_("Cannot migrate %s back to Berkeley DB, %s already exists"), path.string(), pathBerkeley.string());
+        return false;
+    }
+
+    size_t nRecords = 0;
+    try {
+        // The environment of the directory the data file goes into, which
+        // GetWalletEnv cannot find from wallet_path while the file is missing
+        std::string strUnused;
+        BerkeleyEnvironment* env = GetWalletEnv(pathBerkeley.parent_path(), strUnused);
+        if (!env->Open(true)) {
+            errorStr = strprintf(_("Error initializing wallet database environment %s!"), env->Directory().string());
+            return false;
+        }
+
+        std::unique_ptr<Db> pdbCopy = MakeUnique<Db>(env->dbenv.get(), 0);
+        if (pdbCopy->open(nullptr, strFile.c_str(), "main", DB_BTREE, DB_CREATE | DB_EXCL, 0) != 0) {
+            errorStr = strprintf(_("Cannot create database file %s"), pathBerkeley.string());
+            return false;
+        }
+
+        bool fSuccess = true;
+        DbTxn* ptxn = env->TxnBegin();
+        {
+            CDBWrapper db(path, WALLET_LEVELDB_CACHE_SIZE);
+            std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+            for (pcursor->SeekToFirst(); fSuccess && pcursor->Valid(); pcursor->Next()) {
+                CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+                CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+                RawRecord rawKey(ssKey);
+                RawRecord rawValue(ssValue);
+                if (!pcursor->GetKey(rawKey) || !pcursor->GetValue(rawValue)) {
+                    fSuccess = false;
+                    break;
+                }
+                Dbt datKey(ssKey.data(), ssKey.size());
+                Dbt datValue(ssValue.data(), ssValue.size());
+                fSuccess = ptxn && pdbCopy->put(ptxn, &datKey, &datValue, DB_NOOVERWRITE) == 0;
+                ++nRecords;
+            }
+        }
+        if (ptxn && fSuccess) {
+            fSuccess = ptxn->commit(0) == 0;
+        } else if (ptxn) {
+            ptxn->abort();
+        }
+        pdbCopy->close(0);
+
+        if (!fSuccess) {
+            env->dbenv->dbremove(nullptr, strFile.c_str(), nullptr, DB_AUTO_COMMIT);
+            errorStr = strprintf(_("Error migrating %s to Berkeley DB"), path.string());
+            return false;
+        }
+        // Move the log data into the data file, so it is self-contained
+        env->CheckpointLSN(strFile);
+
+        // From now on the wallet is opened from the data file. The LevelDB
+        // database is kept under a dated name, like LevelDBDatabase::Recover
+        // does.
+        const fs::path pathBackup = strprintf("%s.%d.bak", path.string(), GetTime());
+        fs::rename(path, pathBackup);
+        LogPrintf("Migrated %u records to %s in %dms, renamed %s to %s\n", nRecords, pathBerkeley.string(),
+                  GetTimeMillis() - nStart, path.string(), pathBackup.string());
+    } catch (const std::exception& e) {
+        errorStr = strprintf(_("Error migrating %s to Berkeley DB: %s"), path.string(), e.what());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2018 The XSN developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_LDB_H
+#define BITCOIN_WALLET_LDB_H
+
+#include <dbwrapper.h>
+#include <fs.h>
+#include <streams.h>
+#include <sync.h>
+#include <wallet/db.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+/** LevelDB cache of a wallet database */
+static const size_t WALLET_LEVELDB_CACHE_SIZE = 8 << 20;
+/** Size of the batches records are copied in by migration, backup and recovery */
+static const size_t WALLET_LEVELDB_COPY_BATCH_SIZE = 16 << 20;
+
+/**
+ * A wallet database stored in LevelDB, see -walletbackend.
+ *
+ * Records are stored under the same keys and with the same values as in a
+ * Berkeley DB wallet.dat, so one can be copied into the other record by
+ * record. Writes are appended to the LevelDB log, which is synced when a
+ * batch that wrote records is flushed, by default when it is closed, just
+ * like a BerkeleyBatch checkpoints on close. Records written between TxnBegin
+ * and TxnCommit are written as one atomic batch, which is synced right away.
+ */
+class LevelDBDatabase : public WalletDatabase
+{
+    friend class LevelDBBatch;
+public:
+    explicit LevelDBDatabase(const fs::path& pathIn) : path(pathIn) {}
+
+    std::unique_ptr<DatabaseBatch> MakeBatch(const char* pszMode = "r+", bool fFlushOnClose = true) override;
+
+    /** Erase the records whose key starts with pszSkip and compact the whole database, so nothing is left of them on disk */
+    bool Rewrite(const char* pszSkip=nullptr) override;
+    /** Copy all records into a new LevelDB database at strDest */
+    bool Backup(const std::string& strDest) override;
+    void Flush(bool shutdown) override;
+    bool PeriodicFlush() override;
+
+    /* verifies the database at path can be opened, repairing it if it cannot */
+    static bool Verify(const fs::path& path, std::string& warningStr, std::string& errorStr);
+    /* moves the database at path aside and copies the records recoverKVcallback accepts into a new one */
+    static bool Recover(const fs::path& path, void *callbackDataIn, bool (*recoverKVcallback)(void* callbackData, CDataStream ssKey, CDataStream ssValue), std::string& out_backup_filename);
+    /* copies all records of the Berkeley DB wallet at wallet_path into a new database at path, then renames the data file to a dated backup */
+    static bool MigrateFromBerkeley(const fs::path& wallet_path, const fs::path& path, std::string& errorStr);
+    /* copies all records of the database at path into a new Berkeley DB data file for wallet_path, then renames the database to a dated backup */
+    static bool MigrateToBerkeley(const fs::path& wallet_path, const fs::path& path, std::string& errorStr);
+
+private:
+    const fs::path path;
+    CCriticalSection cs_db;
+    /** Opened by the first batch and shared with the open batches, so Flush(true) can close it while a batch is still around */
+    std::shared_ptr<CDBWrapper> db;
+
+    std::shared_ptr<CDBWrapper> GetDB();
+};
+
+/** RAII class that provides access to a LevelDB wallet database */
+class LevelDBBatch : public DatabaseBatch
+{
+private:
+    std::shared_ptr<CDBWrapper> db;
+    std::unique_ptr<CDBIterator> pcursor;
+    bool fCursorPositioned;
+    bool fReadOnly;
+    bool fFlushOnClose;
+    /** Records were written or erased outside a transaction since the last sync */
+    bool fUnsynced;
+    /** Records written and erased since TxnBegin, reads see them before the database */
+    bool fTxn;
+    std::map<CSerializeData, CSerializeData> mapTxnWrites;
+    std::set<CSerializeData> setTxnErases;
+
+    bool ReadKey(CDataStream&& ssKey, CDataStream& ssValue) override;
+    bool WriteKey(CDataStream&& ssKey, CDataStream&& ssValue, bool fOverwrite = true) override;
+    bool EraseKey(CDataStream&& ssKey) override;
+    bool HasKey(CDataStream&& ssKey) override;
+
+public:
+    explicit LevelDBBatch(LevelDBDatabase& database, const char* pszMode = "r+", bool fFlushOnCloseIn = true);
+    ~LevelDBBatch() override { Close(); }
+
+    void Flush() override;
+    void Close() override;
+
+    /** Cursors only see records that have been committed */
+    bool StartCursor() override;
+    bool ReadAtCursor(CDataStream& ssKey, CDataStream& ssValue, bool& complete, bool setRange = false) override;
+    void CloseCursor() override;
+
+    bool TxnBegin() override;
+    bool TxnCommit() override;
+    bool TxnAbort() override;
+};
+
+#endif // BITCOIN_WALLET_LDB_H
@@ -2728,6 +2728,14 @@ static UniValue encryptwallet(const JSONRPCRequest& request)
                 "encryptwallet <passphrase>\n"
                 "Encrypts the wallet with <passphrase>.");
 
+    std::string strCopies;
+    for (const fs::path& path : GetWalletUnusedCopies(fs::absolute(pwallet->GetName(), GetWalletDir()))) {
+        strCopies += (strCopies.empty() ? "" : ", ") + path.string();
+    }
+    if (!strCopies.empty()) {
+        throw JSONRPCError(RPC_WALLET_ENCRYPTION_FAILED, "Error: " + strCopies + " may still hold the unencrypted keys of this wallet. Move them somewhere safe or delete them before encrypting the wallet.");
+    }
+
     if (!pwallet->EncryptWallet(strWalletPass)) {
         throw JSONRPCError(RPC_WALLET_ENCRYPTION_FAILED, "Error: Failed to encrypt the wallet.");
     }